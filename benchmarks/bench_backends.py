@@ -0,0 +1,422 @@
+#!/usr/bin/env python3
+"""
+解析后端基准测试
+
+对每个可用后端（regex / tree-sitter / clang）在多个数据集上测量：
+- 吞吐：MB/s、functions/s
+- 精度：有 ground-truth 清单的数据集（合成语料）上函数、调用边、结构体字段的召回率 / 精确率
+- 单文件延迟分位数：p50 / p90 / p99 / max
+- 峰值 RSS（每个 后端×数据集 组合在独立子进程中运行，互不污染）
+- 内存分配：tracemalloc 峰值和解析结果存活的分配块数（单独一轮，避免干扰计时）
+
+结果写成 JSON，可与保存的基线对比，检出吞吐/延迟回退。
+
+使用方法:
+    python benchmarks/bench_backends.py -o bench_result.json
+    python benchmarks/bench_backends.py --baseline benchmarks/baseline.json
+    python benchmarks/bench_backends.py --backends regex --synth-files 50 --synth-size 256K
+"""
+
+import argparse
+import json
+import math
+import multiprocessing
+import os
+import platform
+import queue as queue_module
+import resource
+import sys
+import time
+import tracemalloc
+from datetime import datetime, timezone
+from typing import Callable, Dict, List, Optional, Tuple
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+PROJECT_DIR = os.path.dirname(BENCH_DIR)
+sys.path.insert(0, os.path.join(PROJECT_DIR, 'src'))
+sys.path.insert(0, BENCH_DIR)
+
+from synth_corpus import generate_driver, parse_size
+
+
+EXAMPLES = [
+    'examples/usb_serial/usb_serial_example.c',
+    'examples/async_demo/async_demo_example.c',
+    'examples/advanced_features/advanced_driver.c',
+]
+
+
+# ==================== 数据集 ====================
+
+def load_dataset(spec: Dict) -> List[Tuple[str, str]]:
+    """
+    根据描述加载数据集（在子进程中调用）
+
+    spec:
+        {"kind": "files", "paths": [...]}                  已有文件
+        {"kind": "synth", "files": N, "size": B, "seed": S}  合成语料（内存中生成）
+
+    Returns:
+        [(文件名, 源码), ...]
+    """
+    if spec["kind"] == "files":
+        items = []
+        for path in spec["paths"]:
+            with open(path, 'r', encoding='utf-8', errors='ignore') as f:
+                items.append((path, f.read()))
+        return items
+    return [
+        (f"synth_{i:05d}.c", generate_driver(spec["seed"] + i, spec["size"])[0])
+        for i in range(spec["files"])
+    ]
+
+
+def load_truth(spec: Dict) -> Dict[str, Dict]:
+    """
+    数据集的 ground-truth 清单 {文件名: 清单}
+
+    合成语料由生成器给出；目录数据集读取 synth_corpus.py 写出的 manifest.json。
+    没有清单的数据集返回空字典（不计算精度）。
+    """
+    if spec["kind"] == "synth":
+        return {f"synth_{i:05d}.c": generate_driver(spec["seed"] + i, spec["size"])[1]
+                for i in range(spec["files"])}
+    if spec.get("manifest"):
+        with open(spec["manifest"], 'r', encoding='utf-8') as f:
+            return json.load(f)["files"]
+    return {}
+
+
+def corpus_dataset(path: str) -> Dict:
+    """把 synth_corpus.py 生成的目录（或任意 .c 目录）转为数据集描述"""
+    paths = sorted(
+        os.path.join(path, name) for name in os.listdir(path)
+        if name.endswith(('.c', '.h'))
+    )
+    spec = {"kind": "files", "paths": paths}
+    manifest = os.path.join(path, 'manifest.json')
+    if os.path.isfile(manifest):
+        spec["manifest"] = manifest
+    return spec
+
+
+# ==================== 测量 ====================
+
+def percentile(values: List[float], pct: float) -> float:
+    """最近秩法分位数"""
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    rank = max(math.ceil(pct / 100.0 * len(ordered)) - 1, 0)
+    return ordered[min(rank, len(ordered) - 1)]
+
+
+def accuracy(backend, items: List[Tuple[str, str]], truth: Dict[str, Dict]) -> Dict:
+    """
+    相对 ground-truth 清单的召回率 / 精确率
+
+    - functions: 函数定义
+    - calls: 清单中函数的 (调用者, 被调用) 边
+    - fields: 清单中结构体的 (结构体, 字段) 对
+    """
+    # 类别 -> [命中, 期望, 找到]
+    counts = {key: [0, 0, 0] for key in ("functions", "calls", "fields")}
+
+    def tally(key: str, expected: set, found: set) -> None:
+        counts[key][0] += len(expected & found)
+        counts[key][1] += len(expected)
+        counts[key][2] += len(found)
+
+    for name, src in items:
+        manifest = truth.get(os.path.basename(name))
+        if not manifest:
+            continue
+        result = backend.parse(src, name)
+        defined = {f for f, d in result.functions.items() if "declaration" not in d.attributes}
+        tally("functions", set(manifest["functions"]), defined)
+        expected_calls, found_calls = set(), set()
+        for func, info in manifest["functions"].items():
+            expected_calls.update((func, c) for c in info["calls"])
+            if func in result.functions:
+                found_calls.update((func, c) for c in result.functions[func].calls)
+        tally("calls", expected_calls, found_calls)
+        expected_fields, found_fields = set(), set()
+        for struct, fields in manifest["structs"].items():
+            expected_fields.update((struct, f) for f in fields)
+            if struct in result.structs:
+                found_fields.update((struct, f.name) for f in result.structs[struct].fields)
+        tally("fields", expected_fields, found_fields)
+
+    return {
+        key: {"recall": round(hit / expected, 4) if expected else 0.0,
+              "precision": round(hit / found, 4) if found else 0.0}
+        for key, (hit, expected, found) in counts.items() if expected
+    }
+
+
+def _rss_mb() -> float:
+    """当前 RSS（MB），非 Linux 平台返回 0"""
+    try:
+        with open('/proc/self/status') as f:
+            for line in f:
+                if line.startswith('VmRSS:'):
+                    return int(line.split()[1]) / 1024.0
+    except OSError:
+        pass
+    return 0.0
+
+
+def _peak_rss_mb() -> float:
+    peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    # Linux 单位 KB，macOS 单位字节
+    return peak / (1024.0 * 1024.0) if sys.platform == 'darwin' else peak / 1024.0
+
+
+def run_case(backend_name: str, spec: Dict, repeat: int) -> Dict:
+    """
+    在当前进程中测量一个 后端×数据集 组合（由子进程调用）
+    """
+    from backends import get_backend
+
+    items = load_dataset(spec)
+    backend = get_backend(backend_name)
+    total_bytes = sum(len(src.encode('utf-8')) for _, src in items)
+
+    # 预热（tree-sitter 首次创建 parser 等一次性开销不计入）
+    backend.parse(items[0][1], items[0][0])
+    rss_start = _rss_mb()
+
+    best_seconds = None
+    latencies: List[float] = []
+    functions = 0
+    for _ in range(repeat):
+        run_latencies = []
+        run_functions = 0
+        start = time.perf_counter()
+        for name, src in items:
+            t0 = time.perf_counter()
+            result = backend.parse(src, name)
+            run_latencies.append((time.perf_counter() - t0) * 1000.0)
+            run_functions += len(result.functions)
+        elapsed = time.perf_counter() - start
+        if best_seconds is None or elapsed < best_seconds:
+            best_seconds, latencies, functions = elapsed, run_latencies, run_functions
+    peak_rss = _peak_rss_mb()
+
+    # 分配统计单独一轮：tracemalloc 会显著拖慢解析
+    tracemalloc.start()
+    retained = []
+    for name, src in items:
+        retained.append(backend.parse(src, name))
+    snapshot = tracemalloc.take_snapshot()
+    _, alloc_peak = tracemalloc.get_traced_memory()
+    tracemalloc.stop()
+    alloc_blocks = sum(stat.count for stat in snapshot.statistics('filename'))
+    del retained
+
+    seconds = max(best_seconds, 1e-9)
+    report = {
+        "backend": backend_name,
+        "files": len(items),
+        "bytes": total_bytes,
+        "functions": functions,
+        "seconds": round(seconds, 6),
+        "mb_per_s": round(total_bytes / 1024.0 / 1024.0 / seconds, 3),
+        "functions_per_s": round(functions / seconds, 1),
+        "latency_ms": {
+            "p50": round(percentile(latencies, 50), 3),
+            "p90": round(percentile(latencies, 90), 3),
+            "p99": round(percentile(latencies, 99), 3),
+            "max": round(max(latencies), 3),
+        },
+        "peak_rss_mb": round(peak_rss, 1),
+        "rss_growth_mb": round(max(peak_rss - rss_start, 0.0), 1),
+        "alloc_peak_mb": round(alloc_peak / 1024.0 / 1024.0, 2),
+        "alloc_blocks": alloc_blocks,
+    }
+    # 精度单独一轮，不计入计时
+    truth = load_truth(spec)
+    if truth:
+        report["accuracy"] = accuracy(backend, items, truth)
+    return report
+
+
+def _case_entry(queue, backend_name: str, spec: Dict, repeat: int) -> None:
+    try:
+        queue.put(run_case(backend_name, spec, repeat))
+    except Exception as e:  # 后端异常不应让整个基准崩溃
+        queue.put({"backend": backend_name, "error": f"{type(e).__name__}: {e}"})
+
+
+def run_isolated(backend_name: str, spec: Dict, repeat: int, timeout: float = 0,
+                 entry: Callable = _case_entry) -> Dict:
+    """
+    在全新子进程（spawn）中运行一个组合，保证峰值 RSS 互不影响
+
+    子进程崩溃（如 native 扩展段错误）或超过 timeout 秒（0 为不限）时记为该后端的错误行。
+    entry 为子进程入口，签名同 _case_entry（测试中替换为会崩溃 / 挂起的入口）。
+    """
+    ctx = multiprocessing.get_context('spawn')
+    queue = ctx.Queue()
+    proc = ctx.Process(target=entry, args=(queue, backend_name, spec, repeat))
+    proc.start()
+    deadline = time.monotonic() + timeout if timeout > 0 else None
+    result = None
+    while result is None:
+        try:
+            result = queue.get(timeout=1.0)
+        except queue_module.Empty:
+            if not proc.is_alive():
+                # 结果可能在退出前刚写入，再取一次
+                try:
+                    result = queue.get(timeout=1.0)
+                except queue_module.Empty:
+                    result = {"backend": backend_name,
+                              "error": f"子进程异常退出 (exitcode {proc.exitcode})"}
+            elif deadline is not None and time.monotonic() > deadline:
+                proc.terminate()
+                result = {"backend": backend_name, "error": f"超时 ({timeout:g}s)"}
+    proc.join()
+    return result
+
+
+# ==================== 报告 ====================
+
+def compare(current: Dict, baseline: Dict, threshold: float) -> List[Dict]:
+    """
+    与基线对比
+
+    吞吐下降或 p99 延迟上升超过 threshold（比例）记为回退。
+    """
+    base_index = {(r["backend"], r["dataset"]): r for r in baseline.get("results", [])
+                  if "error" not in r}
+    rows = []
+    for r in current["results"]:
+        base = base_index.get((r["backend"], r["dataset"]))
+        if not base or "error" in r:
+            continue
+        speed = r["mb_per_s"] / base["mb_per_s"] if base["mb_per_s"] else 0.0
+        p99 = (r["latency_ms"]["p99"] / base["latency_ms"]["p99"]
+               if base["latency_ms"]["p99"] else 1.0)
+        rows.append({
+            "backend": r["backend"],
+            "dataset": r["dataset"],
+            "mb_per_s_ratio": round(speed, 3),
+            "p99_ratio": round(p99, 3),
+            "rss_delta_mb": round(r["peak_rss_mb"] - base["peak_rss_mb"], 1),
+            "regression": speed < 1.0 - threshold or p99 > 1.0 + threshold,
+        })
+    return rows
+
+
+def print_report(report: Dict) -> None:
+    """打印 Markdown 表格"""
+    print()
+    print("| 后端 | 数据集 | 文件 | MB/s | 函数/s | p50 ms | p99 ms | 峰值RSS MB | 分配峰值 MB |")
+    print("|------|--------|------|------|--------|--------|--------|-----------|-------------|")
+    for r in report["results"]:
+        if "error" in r:
+            print(f"| {r['backend']} | {r['dataset']} | - | 错误: {r['error']} | | | | | |")
+            continue
+        lat = r["latency_ms"]
+        print(f"| {r['backend']} | {r['dataset']} | {r['files']} | {r['mb_per_s']:.2f} | "
+              f"{r['functions_per_s']:.0f} | {lat['p50']:.2f} | {lat['p99']:.2f} | "
+              f"{r['peak_rss_mb']:.1f} | {r['alloc_peak_mb']:.2f} |")
+
+    scored = [r for r in report["results"] if r.get("accuracy")]
+    if scored:
+        print()
+        print("| 后端 | 数据集 | 函数 召回/精确 | 调用边 召回/精确 | 字段 召回/精确 |")
+        print("|------|--------|----------------|------------------|----------------|")
+        for r in scored:
+            cells = []
+            for key in ("functions", "calls", "fields"):
+                acc = r["accuracy"].get(key)
+                cells.append(f"{acc['recall']:.3f} / {acc['precision']:.3f}" if acc else "-")
+            print(f"| {r['backend']} | {r['dataset']} | " + " | ".join(cells) + " |")
+
+    if report.get("comparison"):
+        print()
+        print("| 后端 | 数据集 | 吞吐比 | p99 比 | RSS 变化 MB | 回退 |")
+        print("|------|--------|--------|--------|-------------|------|")
+        for c in report["comparison"]:
+            flag = "❌" if c["regression"] else "✅"
+            print(f"| {c['backend']} | {c['dataset']} | {c['mb_per_s_ratio']:.2f}x | "
+                  f"{c['p99_ratio']:.2f}x | {c['rss_delta_mb']:+.1f} | {flag} |")
+
+
+def main():
+    parser = argparse.ArgumentParser(description='解析后端基准测试')
+    parser.add_argument('-o', '--output', default='bench_result.json',
+                        help='结果 JSON 路径 (默认: bench_result.json)')
+    parser.add_argument('-b', '--backends', default=None,
+                        help='逗号分隔的后端列表 (默认: 全部可用后端)')
+    parser.add_argument('--corpus', action='append', default=[],
+                        help='额外的语料目录（可多次指定）')
+    parser.add_argument('--synth-files', type=int, default=20,
+                        help='合成语料文件数 (默认: 20)')
+    parser.add_argument('--synth-size', default='64K',
+                        help='合成语料单文件大小 (默认: 64K)')
+    parser.add_argument('--seed', type=int, default=0, help='合成语料种子')
+    parser.add_argument('--no-examples', action='store_true', help='跳过 examples/ 数据集')
+    parser.add_argument('-r', '--repeat', type=int, default=3,
+                        help='重复次数，取最快一轮 (默认: 3)')
+    parser.add_argument('--timeout', type=float, default=0,
+                        help='单个 后端×数据集 组合的超时秒数，超时记为错误 (默认: 0 不限)')
+    parser.add_argument('--baseline', default=None, help='对比的基线 JSON')
+    parser.add_argument('--threshold', type=float, default=0.10,
+                        help='回退判定阈值 (默认: 0.10 即 10%%)')
+    parser.add_argument('--fail-on-regression', action='store_true',
+                        help='存在回退时返回非零退出码')
+    args = parser.parse_args()
+
+    from backends import list_backends
+    backends = args.backends.split(',') if args.backends else list_backends()
+
+    datasets: Dict[str, Dict] = {}
+    if not args.no_examples:
+        datasets["examples"] = {"kind": "files",
+                                "paths": [os.path.join(PROJECT_DIR, p) for p in EXAMPLES]}
+    if args.synth_files > 0:
+        datasets[f"synth-{args.synth_files}x{args.synth_size}"] = {
+            "kind": "synth", "files": args.synth_files,
+            "size": parse_size(args.synth_size), "seed": args.seed,
+        }
+    for path in args.corpus:
+        datasets[os.path.basename(os.path.normpath(path))] = corpus_dataset(path)
+
+    report = {
+        "meta": {
+            "timestamp": datetime.now(timezone.utc).isoformat(timespec='seconds'),
+            "python": platform.python_version(),
+            "platform": platform.platform(),
+            "cpu_count": os.cpu_count(),
+            "repeat": args.repeat,
+        },
+        "results": [],
+    }
+    for dataset_name, spec in datasets.items():
+        for backend_name in backends:
+            print(f"⏳ {backend_name} @ {dataset_name} ...", flush=True)
+            result = run_isolated(backend_name, spec, args.repeat, args.timeout)
+            result["dataset"] = dataset_name
+            report["results"].append(result)
+
+    if args.baseline:
+        with open(args.baseline, 'r', encoding='utf-8') as f:
+            report["comparison"] = compare(report, json.load(f), args.threshold)
+
+    with open(args.output, 'w', encoding='utf-8') as f:
+        json.dump(report, f, ensure_ascii=False, indent=2)
+
+    print_report(report)
+    print(f"\n结果已保存到: {args.output}")
+
+    regressions = [c for c in report.get("comparison", []) if c["regression"]]
+    if regressions and args.fail_on_regression:
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
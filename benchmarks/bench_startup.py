@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""
+CLI 启动时间基准测试
+
+pre-commit 钩子里 `analyzer.py --list-backends` 和单个小文件的分析几乎全部时间都花在
+解释器启动和模块导入上。本脚本在全新子进程中重复运行以下场景，报告墙钟时间的最小值 / 中位数：
+
+- python        空解释器（基准线）
+- import        `import backends`（只注册描述符，不应导入任何后端模块）
+- list-backends `analyzer.py --list-backends`（只探测依赖）
+- small-file    `analyzer.py <示例驱动> -b regex`（单个小文件的完整分析）
+
+每个场景另外用 `-X importtime` 跑一次，记录导入耗时最多的模块；
+import 场景同时报告导入了哪些后端 / 重量级模块（应为空）。
+
+使用方法:
+    python benchmarks/bench_startup.py
+    python benchmarks/bench_startup.py -r 20 -o startup.json
+"""
+
+import argparse
+import json
+import os
+import platform
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from datetime import datetime, timezone
+from typing import Dict, List
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+PROJECT_DIR = os.path.dirname(BENCH_DIR)
+SRC_DIR = os.path.join(PROJECT_DIR, 'src')
+ANALYZER = os.path.join(SRC_DIR, 'core', 'analyzer.py')
+SMALL_FILE = os.path.join(PROJECT_DIR, 'examples', 'usb_serial', 'usb_serial_example.c')
+
+# import 场景中不应出现的模块
+HEAVY_MODULES = (
+    'backends.regex_backend', 'backends.native_backend', 'backends.treesitter_backend',
+    'backends.clang_backend', 'tree_sitter', 'clang', 'analysis', 'concurrent.futures',
+)
+
+IMPORT_PROBE = (
+    "import sys; sys.path.insert(0, {src!r}); import backends; "
+    "print(','.join(m for m in {heavy!r} if m in sys.modules))"
+)
+
+
+def scenarios(output_path: str) -> Dict[str, List[str]]:
+    """场景名 -> 命令行（均在 PROJECT_DIR 下运行）"""
+    return {
+        "python": [sys.executable, '-c', 'pass'],
+        "import": [sys.executable, '-c', IMPORT_PROBE.format(src=SRC_DIR, heavy=HEAVY_MODULES)],
+        "list-backends": [sys.executable, ANALYZER, '--list-backends'],
+        "small-file": [sys.executable, ANALYZER, SMALL_FILE, '-b', 'regex', '-o', output_path],
+    }
+
+
+def time_command(argv: List[str], repeat: int) -> Dict:
+    """重复运行命令，返回墙钟时间统计（毫秒）"""
+    samples = []
+    for _ in range(repeat):
+        start = time.perf_counter()
+        subprocess.run(argv, cwd=PROJECT_DIR, stdout=subprocess.DEVNULL,
+                       stderr=subprocess.DEVNULL, check=True)
+        samples.append((time.perf_counter() - start) * 1000)
+    return {
+        "min_ms": round(min(samples), 2),
+        "median_ms": round(statistics.median(samples), 2),
+        "max_ms": round(max(samples), 2),
+    }
+
+
+def top_imports(argv: List[str], count: int) -> List[Dict]:
+    """用 -X importtime 运行一次，返回累计导入耗时最多的顶层模块"""
+    proc = subprocess.run([argv[0], '-X', 'importtime', *argv[1:]], cwd=PROJECT_DIR,
+                          stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True)
+    rows = []
+    for line in proc.stderr.splitlines():
+        # import time: self [us] | cumulative | imported package
+        if not line.startswith('import time:') or 'cumulative' in line:
+            continue
+        _, cumulative, name = line[len('import time:'):].split('|')
+        if name.startswith('  '):
+            continue        # 只看顶层导入，嵌套导入已计入其父模块
+        rows.append({"module": name.strip(), "cumulative_ms": int(cumulative) / 1000})
+    rows.sort(key=lambda r: r["cumulative_ms"], reverse=True)
+    return rows[:count]
+
+
+def print_report(report: Dict) -> None:
+    """打印 Markdown 表格"""
+    base = report["results"]["python"]["min_ms"]
+    print()
+    print("| 场景 | 最小 ms | 中位 ms | 最大 ms | 扣除解释器 ms | 导入最慢的模块 |")
+    print("|------|---------|---------|---------|---------------|----------------|")
+    for name, r in report["results"].items():
+        slowest = ", ".join(f"{m['module']} {m['cumulative_ms']:.0f}ms" for m in r["top_imports"][:3])
+        print(f"| {name} | {r['min_ms']:.1f} | {r['median_ms']:.1f} | {r['max_ms']:.1f} | "
+              f"{r['min_ms'] - base:.1f} | {slowest or '-'} |")
+    leaked = report["results"]["import"].get("heavy_modules")
+    print()
+    print(f"import backends 导入的后端 / 重量级模块: {', '.join(leaked) if leaked else '无'}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description='CLI 启动时间基准测试')
+    parser.add_argument('-o', '--output', default=None, help='结果 JSON 路径 (默认: 只打印)')
+    parser.add_argument('-r', '--repeat', type=int, default=10,
+                        help='每个场景的运行次数 (默认: 10)')
+    parser.add_argument('--top', type=int, default=5,
+                        help='每个场景记录的最慢导入数 (默认: 5)')
+    args = parser.parse_args()
+
+    report = {
+        "meta": {
+            "timestamp": datetime.now(timezone.utc).isoformat(timespec='seconds'),
+            "python": platform.python_version(),
+            "platform": platform.platform(),
+            "repeat": args.repeat,
+        },
+        "results": {},
+    }
+    with tempfile.TemporaryDirectory() as tmp:
+        for name, argv in scenarios(os.path.join(tmp, 'result.json')).items():
+            print(f"⏳ {name} ...", flush=True)
+            result = time_command(argv, args.repeat)
+            result["top_imports"] = top_imports(argv, args.top)
+            if name == "import":
+                out = subprocess.run(argv, cwd=PROJECT_DIR, capture_output=True, text=True)
+                result["heavy_modules"] = [m for m in out.stdout.strip().split(',') if m]
+            report["results"][name] = result
+
+    print_report(report)
+    if args.output:
+        with open(args.output, 'w', encoding='utf-8') as f:
+            json.dump(report, f, ensure_ascii=False, indent=2)
+        print(f"\n结果已保存到: {args.output}")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,344 @@
+#!/usr/bin/env python3
+"""
+跨后端结果对账
+
+一遍读取语料，每个文件在同一个 worker 中依次交给每个后端解析，按名称和位置对齐结果：
+- functions: 函数定义（名称；同名但起始行不同记为 moved）
+- calls: (调用者, 被调用) 边
+- fields: (结构体/联合体, 字段) 对
+- enums: (枚举, 枚举常量) 对
+以更精确的后端为参照（列表中靠前的：clang > tree-sitter > regex > native），
+对每一对后端统计候选后端缺少（missing）和多出（extra）的条目、召回率 / 精确率，
+同时统计每个后端的吞吐（解析 + 访问全部结果，native 的懒解码也计入），
+输出机器可读的 精度 / 速度 矩阵，用于判断更快的后端在 CI 中丢掉了什么。
+
+使用方法:
+    python benchmarks/reconcile_backends.py -o reconcile.json
+    python benchmarks/reconcile_backends.py --backends tree-sitter,native -j 8 --corpus ~/linux/drivers/net
+    python benchmarks/reconcile_backends.py examples/advanced_features/advanced_driver.c --details
+"""
+
+import argparse
+import json
+import os
+import platform
+import sys
+import time
+from concurrent.futures import ProcessPoolExecutor
+from datetime import datetime, timezone
+from itertools import combinations
+from typing import Dict, List, Set, Tuple
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+PROJECT_DIR = os.path.dirname(BENCH_DIR)
+sys.path.insert(0, os.path.join(PROJECT_DIR, 'src'))
+sys.path.insert(0, BENCH_DIR)
+
+from bench_backends import EXAMPLES, corpus_dataset, load_dataset
+from synth_corpus import parse_size
+
+# 参照优先级：靠前的作为参照（native 与 regex 语义相同，以 regex 为参照时"加速"即 native 的收益）
+PRECISION_ORDER = ['clang', 'tree-sitter', 'regex', 'native']
+CATEGORIES = ("functions", "calls", "fields", "enums")
+
+
+# ==================== 对齐 ====================
+
+def index_result(result) -> Dict[str, Set]:
+    """
+    把 ParseResult 展开为可比较的集合
+
+    Returns:
+        {"functions": {名称}, "calls": {(调用者, 被调用)}, "fields": {(记录, 字段)},
+         "enums": {(枚举, 常量)}, "lines": {名称: 起始行}}
+    """
+    functions = {name: f for name, f in result.functions.items()
+                 if "declaration" not in f.attributes}
+    calls = {(name, callee) for name, f in functions.items() for callee in f.calls}
+    fields = set()
+    for table in (result.structs, result.unions):
+        for record, definition in table.items():
+            fields.update((record, f.name) for f in definition.fields)
+    enums = {(name, v.name) for name, e in result.enums.items() for v in e.values}
+    lines = {name: f.location.line if f.location else 0 for name, f in functions.items()}
+    return {"functions": set(functions), "calls": calls, "fields": fields, "enums": enums,
+            "lines": lines}
+
+
+def align(reference: Dict[str, Set], candidate: Dict[str, Set]) -> Dict:
+    """
+    对齐两个后端对同一文件的结果
+
+    Returns:
+        {类别: {"common", "missing": [...], "extra": [...]}, "moved": [(名称, 参照行, 候选行)]}
+    """
+    diff = {}
+    for key in CATEGORIES:
+        ref, cand = reference[key], candidate[key]
+        diff[key] = {
+            "common": len(ref & cand),
+            "missing": sorted(ref - cand),
+            "extra": sorted(cand - ref),
+        }
+    ref_lines, cand_lines = reference["lines"], candidate["lines"]
+    diff["moved"] = sorted((name, ref_lines[name], cand_lines[name])
+                           for name in reference["functions"] & candidate["functions"]
+                           if ref_lines[name] and cand_lines[name]
+                           and ref_lines[name] != cand_lines[name])
+    return diff
+
+
+# ==================== worker ====================
+
+_backends: Dict = {}
+
+
+def _init_worker(names: List[str]) -> None:
+    """每个 worker 创建一次后端，并预热（tree-sitter parser、libclang Index 等一次性开销不计入）"""
+    from backends import get_backend
+    _backends.clear()
+    for name in names:
+        backend = get_backend(name)
+        _materialize(backend.parse("int warmup(void) { return 0; }\n", "warmup.c"))
+        _backends[name] = backend
+
+
+def _materialize(result) -> None:
+    """访问全部结果（native 等懒解码的后端在此付出解码代价）"""
+    result.functions, result.structs, result.unions, result.typedefs, result.enums
+
+
+def reconcile_file(item: Tuple[str, str], pairs: List[Tuple[str, str]]) -> Dict:
+    """
+    用每个后端解析一个文件并两两对齐
+
+    Returns:
+        {"file", "bytes", "seconds": {后端: 秒}, "errors": {后端: 信息}, "pairs": {"参照|候选": diff}}
+    """
+    name, source = item
+    indexed, seconds, errors = {}, {}, {}
+    for backend_name, backend in _backends.items():
+        start = time.perf_counter()
+        try:
+            result = backend.parse(source, name)
+            _materialize(result)
+        except Exception as e:  # 单个后端异常只影响该后端的该文件
+            errors[backend_name] = f"{type(e).__name__}: {e}"
+            continue
+        seconds[backend_name] = time.perf_counter() - start
+        indexed[backend_name] = index_result(result)
+    return {
+        "file": name,
+        "bytes": len(source.encode('utf-8')),
+        "seconds": seconds,
+        "errors": errors,
+        "pairs": {f"{ref}|{cand}": align(indexed[ref], indexed[cand])
+                  for ref, cand in pairs if ref in indexed and cand in indexed},
+    }
+
+
+def _reconcile_chunk(items: List[Tuple[str, str]], pairs: List[Tuple[str, str]]) -> List[Dict]:
+    return [reconcile_file(item, pairs) for item in items]
+
+
+# ==================== 汇总 ====================
+
+def _ratio(numerator: int, denominator: int) -> float:
+    return round(numerator / denominator, 4) if denominator else 1.0
+
+
+def build_matrix(file_reports: List[Dict], backends: List[str], pairs: List[Tuple[str, str]],
+                 examples: int) -> Dict:
+    """
+    汇总为 速度 / 精度 矩阵
+
+    speed: 每个后端的文件数、字节数、解析秒数、MB/s、出错文件数
+    accuracy: 每对 (参照, 候选) 每个类别的 common / missing / extra / recall / precision，
+              以及最多 examples 个 "文件: 条目" 样例
+    """
+    speed = {}
+    for name in backends:
+        ok = [r for r in file_reports if name in r["seconds"]]
+        total_bytes = sum(r["bytes"] for r in ok)
+        total_seconds = sum(r["seconds"][name] for r in ok)
+        speed[name] = {
+            "files": len(ok),
+            "bytes": total_bytes,
+            "seconds": round(total_seconds, 6),
+            "mb_per_s": round(total_bytes / 1024.0 / 1024.0 / total_seconds, 3) if total_seconds else 0.0,
+            "errors": sum(1 for r in file_reports if name in r["errors"]),
+        }
+
+    accuracy = []
+    for ref, cand in pairs:
+        key = f"{ref}|{cand}"
+        entry = {"reference": ref, "candidate": cand, "files": 0, "moved": 0,
+                 "examples": {"moved": []}}
+        for category in CATEGORIES:
+            entry[category] = {"common": 0, "missing": 0, "extra": 0}
+            entry["examples"][category] = {"missing": [], "extra": []}
+        for report in file_reports:
+            diff = report["pairs"].get(key)
+            if diff is None:
+                continue
+            entry["files"] += 1
+            base = os.path.basename(report["file"])
+            for category in CATEGORIES:
+                counts, samples = entry[category], entry["examples"][category]
+                counts["common"] += diff[category]["common"]
+                for side in ("missing", "extra"):
+                    counts[side] += len(diff[category][side])
+                    room = examples - len(samples[side])
+                    samples[side].extend(f"{base}: {_label(category, item)}"
+                                         for item in diff[category][side][:max(room, 0)])
+            entry["moved"] += len(diff["moved"])
+            room = examples - len(entry["examples"]["moved"])
+            entry["examples"]["moved"].extend(f"{base}: {n} {a}->{b}"
+                                              for n, a, b in diff["moved"][:max(room, 0)])
+        for category in CATEGORIES:
+            counts = entry[category]
+            counts["recall"] = _ratio(counts["common"], counts["common"] + counts["missing"])
+            counts["precision"] = _ratio(counts["common"], counts["common"] + counts["extra"])
+        ref_speed, cand_speed = speed[ref]["mb_per_s"], speed[cand]["mb_per_s"]
+        entry["speedup"] = round(cand_speed / ref_speed, 2) if ref_speed else 0.0
+        accuracy.append(entry)
+    return {"speed": speed, "accuracy": accuracy}
+
+
+def _label(category: str, item) -> str:
+    if category == "calls":
+        return f"{item[0]}->{item[1]}"
+    if category in ("fields", "enums"):
+        return f"{item[0]}.{item[1]}"
+    return item
+
+
+def print_report(matrix: Dict) -> None:
+    """打印 Markdown 表格"""
+    print()
+    print("| 后端 | 文件 | MB/s | 出错 |")
+    print("|------|------|------|------|")
+    for name, s in matrix["speed"].items():
+        print(f"| {name} | {s['files']} | {s['mb_per_s']:.2f} | {s['errors']} |")
+    print()
+    print("| 参照 → 候选 | 加速 | 函数 召回/精确 | 调用边 召回/精确 | 字段 召回/精确 | 枚举常量 召回/精确 | 行号不一致 |")
+    print("|-------------|------|----------------|------------------|----------------|--------------------|------------|")
+    for e in matrix["accuracy"]:
+        cells = [f"{e[c]['recall']:.3f} / {e[c]['precision']:.3f}" for c in CATEGORIES]
+        print(f"| {e['reference']} → {e['candidate']} | {e['speedup']:.2f}x | "
+              + " | ".join(cells) + f" | {e['moved']} |")
+    for e in matrix["accuracy"]:
+        lines = []
+        for category in CATEGORIES:
+            for side in ("missing", "extra"):
+                samples = e["examples"][category][side]
+                if samples:
+                    lines.append(f"  {category} {side} ({e[category][side]}): {', '.join(samples[:5])}")
+        if lines:
+            print(f"\n{e['candidate']} 相对 {e['reference']}:")
+            print("\n".join(lines))
+
+
+# ==================== 入口 ====================
+
+def _collect_items(args) -> List[Tuple[str, str]]:
+    """命令行给出的文件 / 目录、--corpus、examples、合成语料"""
+    paths = []
+    for path in args.paths:
+        if os.path.isdir(path):
+            for root, _, names in os.walk(path):
+                paths.extend(os.path.join(root, n) for n in sorted(names) if n.endswith(('.c', '.h')))
+        else:
+            paths.append(path)
+    for path in args.corpus:
+        paths.extend(corpus_dataset(path)["paths"])
+    if not args.paths and not args.corpus and not args.no_examples:
+        paths.extend(os.path.join(PROJECT_DIR, p) for p in EXAMPLES)
+    items = load_dataset({"kind": "files", "paths": paths}) if paths else []
+    if args.synth_files > 0 and not args.paths:
+        items += load_dataset({"kind": "synth", "files": args.synth_files,
+                               "size": parse_size(args.synth_size), "seed": args.seed})
+    return items
+
+
+def reconcile(items: List[Tuple[str, str]], backends: List[str], jobs: int = 1,
+              examples: int = 20) -> Tuple[Dict, List[Dict]]:
+    """
+    对账入口
+
+    Returns:
+        (矩阵, 每个文件的报告)
+    """
+    backends = sorted(backends, key=lambda n: PRECISION_ORDER.index(n)
+                      if n in PRECISION_ORDER else len(PRECISION_ORDER))
+    pairs = list(combinations(backends, 2))
+    if jobs <= 1 or len(items) <= 1:
+        _init_worker(backends)
+        file_reports = _reconcile_chunk(items, pairs)
+    else:
+        # 按文件分块，块数为 worker 数的 4 倍，兼顾负载均衡和 IPC 次数
+        size = max(1, len(items) // (jobs * 4))
+        chunks = [items[i:i + size] for i in range(0, len(items), size)]
+        file_reports = []
+        with ProcessPoolExecutor(max_workers=jobs, initializer=_init_worker,
+                                 initargs=(backends,)) as pool:
+            for reports in pool.map(_reconcile_chunk, chunks, [pairs] * len(chunks)):
+                file_reports.extend(reports)
+    return build_matrix(file_reports, backends, pairs, examples), file_reports
+
+
+def main():
+    parser = argparse.ArgumentParser(description='跨后端结果对账（精度 / 速度矩阵）')
+    parser.add_argument('paths', nargs='*', help='源文件或目录（默认: examples/ 和合成语料）')
+    parser.add_argument('-o', '--output', default='reconcile.json',
+                        help='结果 JSON 路径 (默认: reconcile.json)')
+    parser.add_argument('-b', '--backends', default=None,
+                        help='逗号分隔的后端列表 (默认: 全部可用后端)')
+    parser.add_argument('-j', '--jobs', type=int, default=1, help='worker 进程数 (默认: 1)')
+    parser.add_argument('--corpus', action='append', default=[],
+                        help='额外的语料目录（可多次指定）')
+    parser.add_argument('--synth-files', type=int, default=10,
+                        help='合成语料文件数，给出 paths 时不生成 (默认: 10)')
+    parser.add_argument('--synth-size', default='32K',
+                        help='合成语料单文件大小 (默认: 32K)')
+    parser.add_argument('--seed', type=int, default=0, help='合成语料种子')
+    parser.add_argument('--no-examples', action='store_true', help='跳过 examples/')
+    parser.add_argument('--examples', type=int, default=20,
+                        help='每个类别保留的差异样例数 (默认: 20)')
+    parser.add_argument('--details', action='store_true',
+                        help='JSON 中附带每个文件的完整差异')
+    args = parser.parse_args()
+
+    from backends import list_backends
+    backends = args.backends.split(',') if args.backends else list_backends()
+    if len(backends) < 2:
+        parser.error(f"至少需要两个可用后端，当前: {', '.join(backends)}")
+
+    items = _collect_items(args)
+    if not items:
+        parser.error('没有可对账的文件')
+    print(f"⏳ {len(items)} 个文件 × {', '.join(backends)} ...", flush=True)
+    matrix, file_reports = reconcile(items, backends, args.jobs, args.examples)
+
+    report = {
+        "meta": {
+            "timestamp": datetime.now(timezone.utc).isoformat(timespec='seconds'),
+            "python": platform.python_version(),
+            "platform": platform.platform(),
+            "files": len(items),
+            "jobs": args.jobs,
+        },
+        **matrix,
+    }
+    if args.details:
+        report["files"] = file_reports
+    with open(args.output, 'w', encoding='utf-8') as f:
+        json.dump(report, f, ensure_ascii=False, indent=2)
+
+    print_report(matrix)
+    print(f"\n结果已保存到: {args.output}")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -14,9 +14,13 @@ Linux Driver Analyzer - Setup Script
     
     # 开发安装
     pip install -e ".[dev]"
+    
+    # 只编译 native 后端的 C++ 扩展（原地，供 src/ 下直接运行）
+    python setup.py build_ext --inplace
 """
 
-from setuptools import setup, find_packages
+from setuptools import setup, find_packages, Extension
+from setuptools.command.build_ext import build_ext
 from pathlib import Path
 
 # 读取 README
@@ -26,6 +30,30 @@ long_description = readme_path.read_text(encoding="utf-8") if readme_path.exists
 # 读取版本
 VERSION = "0.2.0"
 
+
+class OptionalBuildExt(build_ext):
+    """native 后端的扩展是可选的：没有 C++ 编译器时跳过，安装继续（自动回退到 regex 后端）"""
+    
+    def run(self):
+        try:
+            super().run()
+        except Exception as e:
+            print(f"warning: 跳过 native 扩展: {e}")
+    
+    def build_extension(self, ext):
+        try:
+            super().build_extension(ext)
+        except Exception as e:
+            print(f"warning: 跳过 {ext.name}: {e}")
+
+
+NATIVE_EXTENSION = Extension(
+    "backends._lda_scan",
+    sources=["src/backends/native/lda_scan.cpp"],
+    language="c++",
+    extra_compile_args=["-O2", "-std=c++11"],
+)
+
 setup(
     name="linux-driver-analyzer",
     version=VERSION,
@@ -58,6 +86,8 @@ setup(
     ],
     package_dir={"": "src"},
     packages=find_packages(where="src"),
+    ext_modules=[NATIVE_EXTENSION],
+    cmdclass={"build_ext": OptionalBuildExt},
     python_requires=">=3.8",
     
     # 核心功能无外部依赖
@@ -76,7 +106,7 @@ setup(
             "tree-sitter>=0.23.0",
             "tree-sitter-c>=0.23.0",
         ],
-        # libclang 后端（计划中）
+        # libclang 后端
         "clang": [
             "libclang>=16.0.0",
         ],
@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""
+Linux Driver Analyzer - 专项分析
+
+在解析结果之上运行的性能/正确性分析 pass，按名字选择：
+
+    python src/core/analyzer.py driver.c -a layout --arch arm64
+
+使用示例：
+    from analysis import AnalysisContext, run_analyses
+
+    ctx = AnalysisContext(parse_result, options={"arch": "x86_64"})
+    results = run_analyses(["layout"], ctx)
+"""
+
+from .base import (
+    AnalysisContext,
+    AnalysisPass,
+    AnalysisRegistry,
+    required_capabilities,
+    run_analyses,
+)
+from .consteval import ConstantTable, eval_int
+
+# 导入并注册分析 pass
+from .layout import LayoutEngine, LayoutPass, format_pahole, get_abi
+from .false_sharing import FalseSharingPass
+from .hot_path import HotPathPass
+from .sleep import SleepInAtomicPass
+from .critical_sections import CriticalSectionPass
+from .busy_wait import BusyWaitPass
+from .io_alloc import IoAllocPass
+from .rearm import RearmPass
+from .mmio import MmioPass
+from .lock_order import LockOrderPass, merge_lock_order
+from .napi import NapiPass
+from .counters import CounterPass
+from .constants import DefinePass, EnumPass, constant_table, project_constants, resolve_offset
+
+
+def list_analyses() -> list:
+    """列出所有已注册的分析"""
+    return AnalysisRegistry.names()
+
+
+__all__ = [
+    'AnalysisContext',
+    'AnalysisPass',
+    'AnalysisRegistry',
+    'run_analyses',
+    'required_capabilities',
+    'list_analyses',
+    'eval_int',
+    'ConstantTable',
+    'LayoutEngine',
+    'LayoutPass',
+    'format_pahole',
+    'get_abi',
+    'FalseSharingPass',
+    'HotPathPass',
+    'SleepInAtomicPass',
+    'CriticalSectionPass',
+    'BusyWaitPass',
+    'IoAllocPass',
+    'RearmPass',
+    'MmioPass',
+    'LockOrderPass',
+    'merge_lock_order',
+    'NapiPass',
+    'CounterPass',
+    'EnumPass',
+    'DefinePass',
+    'resolve_offset',
+    'constant_table',
+    'project_constants',
+]
@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""
+分析 pass 抽象基类
+
+在后端解析结果和统一分析器识别出的信息（异步处理函数、操作表、知识库）之上，
+运行面向性能/正确性的专项分析（结构体布局、热路径、锁……）。
+
+每个 pass 声明名字和依赖，注册到 AnalysisRegistry；
+派生数据（调用图、入口点等）通过 AnalysisContext.cached 按需计算，多个 pass 共享。
+"""
+
+import json
+import os
+from abc import ABC, abstractmethod
+from typing import Any, Callable, Dict, FrozenSet, List, Optional, Tuple
+
+from backends import BackendCapability, ParseResult
+
+
+# 内置知识库（分析器未加载知识库时使用）
+DEFAULT_KB_PATH = os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))),
+                               'core', 'knowledge_base.json')
+_default_kb: Optional[Dict] = None
+
+
+class AnalysisContext:
+    """单个文件的分析上下文"""
+
+    def __init__(self, parse_result: ParseResult, source: str = "", filepath: str = "",
+                 async_handlers: Optional[List[Any]] = None,
+                 struct_ops: Optional[List[Dict]] = None,
+                 knowledge_base: Optional[Dict] = None,
+                 options: Optional[Dict[str, Any]] = None):
+        self.parse_result = parse_result
+        self.source = source
+        self.filepath = filepath
+        self.async_handlers = async_handlers or []
+        self.struct_ops = struct_ops or []
+        self.knowledge_base = knowledge_base or {}
+        self.options = options or {}
+        # 已运行 pass 的结果（依赖的 pass 先运行）
+        self.results: Dict[str, Dict] = {}
+        self._cache: Dict[str, Any] = {}
+
+    def option(self, name: str, default: Any = None) -> Any:
+        return self.options.get(name, default)
+
+    def cached(self, key: str, factory: Callable[[], Any]) -> Any:
+        """按 key 缓存派生数据，第一次访问时调用 factory 计算"""
+        if key not in self._cache:
+            self._cache[key] = factory()
+        return self._cache[key]
+
+    @property
+    def kb(self) -> Dict:
+        """知识库；未传入时使用内置的 core/knowledge_base.json"""
+        global _default_kb
+        if self.knowledge_base:
+            return self.knowledge_base
+        if _default_kb is None:
+            with open(DEFAULT_KB_PATH, 'r', encoding='utf-8') as f:
+                _default_kb = json.load(f)
+        return _default_kb
+
+
+class AnalysisPass(ABC):
+    """分析 pass 基类"""
+
+    name: str = ""
+    description: str = ""
+    # 依赖的其它 pass（先运行，结果在 ctx.results 中）
+    requires: Tuple[str, ...] = ()
+    # 需要后端提供的解析能力（auto 策略按此逐文件选择后端）
+    needs: FrozenSet[BackendCapability] = frozenset({
+        BackendCapability.PARSE_FUNCTIONS, BackendCapability.PARSE_CALLS})
+
+    @abstractmethod
+    def run(self, ctx: AnalysisContext) -> Dict:
+        """
+        运行分析
+
+        Returns:
+            可 JSON 序列化的结果
+        """
+        pass
+
+    def format_text(self, result: Dict) -> str:
+        """命令行输出的文本报告（默认无）"""
+        return ""
+
+
+class AnalysisRegistry:
+    """分析 pass 注册中心"""
+
+    _passes: Dict[str, type] = {}
+    _instances: Dict[str, AnalysisPass] = {}
+
+    @classmethod
+    def register(cls, pass_class: type) -> type:
+        """注册 pass 类（可作装饰器使用）"""
+        cls._passes[pass_class.name] = pass_class
+        return pass_class
+
+    @classmethod
+    def get(cls, name: str) -> Optional[AnalysisPass]:
+        if name not in cls._instances and name in cls._passes:
+            cls._instances[name] = cls._passes[name]()
+        return cls._instances.get(name)
+
+    @classmethod
+    def names(cls) -> List[str]:
+        return list(cls._passes)
+
+    @classmethod
+    def resolve(cls, names: List[str]) -> List[str]:
+        """
+        展开依赖并排序（依赖在前）
+
+        'all' 表示全部已注册的 pass。
+
+        Raises:
+            ValueError: 未知的 pass 或循环依赖
+        """
+        if 'all' in names:
+            names = cls.names()
+        order: List[str] = []
+        visiting = set()
+
+        def visit(name: str) -> None:
+            if name in order:
+                return
+            if name not in cls._passes:
+                raise ValueError(f"未知的分析: '{name}'。可用分析: {', '.join(cls.names())}")
+            if name in visiting:
+                raise ValueError(f"分析依赖成环: {name}")
+            visiting.add(name)
+            for dep in cls._passes[name].requires:
+                visit(dep)
+            visiting.discard(name)
+            order.append(name)
+
+        for name in names:
+            visit(name)
+        return order
+
+
+def required_capabilities(names: List[str]) -> FrozenSet[BackendCapability]:
+    """一组 pass（含依赖）需要的后端能力之和"""
+    needs = frozenset()
+    for name in AnalysisRegistry.resolve(names):
+        needs |= AnalysisRegistry._passes[name].needs
+    return needs
+
+
+def run_analyses(names: List[str], ctx: AnalysisContext,
+                 stage: Optional[Callable[[str], Any]] = None) -> Dict[str, Dict]:
+    """
+    按依赖顺序运行分析
+
+    Args:
+        names: 要运行的 pass 名称（依赖自动加入）
+        ctx: 分析上下文
+        stage: 可选的阶段上下文管理器工厂（UnifiedAnalyzer._stage），每个 pass 一个阶段
+
+    Returns:
+        pass 名称 -> 结果
+    """
+    for name in AnalysisRegistry.resolve(names):
+        analysis = AnalysisRegistry.get(name)
+        if stage:
+            with stage(f"analysis.{name}"):
+                ctx.results[name] = analysis.run(ctx)
+        else:
+            ctx.results[name] = analysis.run(ctx)
+    return ctx.results
@@ -0,0 +1,235 @@
+#!/usr/bin/env python3
+"""
+延迟敏感路径上的忙等待
+
+从不可睡眠的入口（硬中断、tasklet、定时器、hrtimer、NAPI poll、ndo_start_xmit）
+沿文件内调用图可达的函数中，找出：
+- mdelay / udelay / ndelay 调用
+- read*_poll_timeout_atomic / readx_poll_timeout_atomic / regmap_read_poll_timeout_atomic
+  （以及会睡眠的非 _atomic 版本）
+- 手写的寄存器轮询循环: while (!(readl(...) & BIT(n))); 以及循环内只有 MMIO 读、
+  cpu_relax、udelay 等的 for / while 循环
+
+参数为常量时给出最坏情况的忙等待时间（微秒）：延迟 × 外层循环的迭代次数，
+poll 宏取 timeout_us（为 0 表示不超时）。计数上限无法确定的轮询循环记为无界。
+"""
+
+import re
+from typing import Dict, List, Optional, Tuple
+
+from .base import AnalysisContext, AnalysisPass, AnalysisRegistry
+from .callgraph import call_chain, entry_points, function_body, reachable
+from .consteval import eval_int
+from .metrics import CallSite, Loop, body_metrics, matching, split_args
+
+
+# 忙等待函数 -> 参数换算为微秒的系数
+DELAY_CALLS = {"mdelay": 1000.0, "udelay": 1.0, "ndelay": 0.001}
+
+# poll 宏 -> timeout_us 参数的位置
+_POLL = re.compile(r'^(?:(readx|regmap_read)|read|read[bwlq](?:_relaxed)?|ioread(?:8|16|32))'
+                   r'_poll_timeout(_atomic)?$')
+
+# 轮询循环中允许出现的调用（除 MMIO 读外）
+RELAX_CALLS = {"cpu_relax", "barrier", "rmb", "mb", "udelay", "ndelay", "mdelay",
+               "cpu_relax_lowlatency"}
+
+# 带计数的循环条件: i < N / --timeout / timeout--
+_COUNT_LT = re.compile(r'\b(\w+)\s*(<=?)\s*([^;&|)]+)')
+_COUNT_DEC = re.compile(r'--\s*(\w+)|\b(\w+)\s*--')
+_TIME_BOUND = re.compile(r'\b(?:time_(?:before|after)\w*|ktime_\w+|jiffies)\b')
+
+# 最坏情况（微秒）达到该值为高风险 / 中风险
+HIGH_US = 100.0
+MEDIUM_US = 10.0
+
+
+def loop_condition(text: str, loop: Loop) -> Tuple[int, int]:
+    """循环条件在函数体文本中的范围（for 为整个括号内）"""
+    if loop.kind == 'do':
+        tail = text.rfind('while', loop.start, loop.end)
+        paren = text.find('(', tail) if tail >= 0 else -1
+    else:
+        paren = text.find('(', loop.start)
+    if paren < 0 or paren >= loop.end:
+        return loop.start, loop.start
+    return paren + 1, matching(text, paren, '(', ')')
+
+
+def loop_iterations(text: str, loop: Loop) -> Optional[int]:
+    """循环次数上限（只认常量计数：for (i = 0; i < N; i++) / while (--timeout) 等）"""
+    lo, hi = loop_condition(text, loop)
+    cond = text[lo:hi]
+    if loop.kind == 'for':
+        parts = cond.split(';')
+        if len(parts) == 3:
+            m = _COUNT_LT.search(parts[1])
+            start = re.search(r'=\s*([^,]+)$', parts[0].strip())
+            if m:
+                bound = eval_int(m.group(3))
+                first = eval_int(start.group(1)) if start else 0
+                if bound is not None and first is not None:
+                    return max(bound - first + (m.group(2) == '<='), 0)
+        return None
+    m = _COUNT_DEC.search(cond)
+    if not m:
+        return None
+    var = m.group(1) or m.group(2)
+    inits = list(re.finditer(rf'\b{re.escape(var)}\s*=\s*([^;,=][^;,]*)[;,]', text[:loop.start]))
+    return eval_int(inits[-1].group(1)) if inits else None
+
+
+def delay_us(site: CallSite) -> Optional[float]:
+    """delay 调用的延迟（微秒，参数不是常量返回 None）"""
+    args = split_args(site.args)
+    value = eval_int(args[0]) if args else None
+    return None if value is None else value * DELAY_CALLS[site.name]
+
+
+def poll_timeout_us(site: CallSite) -> Tuple[Optional[float], bool]:
+    """poll 宏的超时（微秒）和是否会睡眠"""
+    m = _POLL.match(site.name)
+    index = 5 if m.group(1) else 4
+    args = split_args(site.args)
+    timeout = eval_int(args[index]) if len(args) > index else None
+    return (None if timeout is None else float(timeout)), not m.group(2)
+
+
+def _polling_loops(loops: List[Loop], calls: List[CallSite]) -> List[Tuple[Loop, List[CallSite]]]:
+    """只有 MMIO 读和 cpu_relax / udelay 等调用、且至少读一次寄存器的循环（取最内层）"""
+    found = []
+    for loop in loops:
+        inside = [c for c in calls if loop.start <= c.pos < loop.end]
+        if any(c.is_mmio_read for c in inside) and \
+                all(c.is_mmio_read or c.name in RELAX_CALLS for c in inside):
+            found.append((loop, inside))
+    return [(l, c) for l, c in found
+            if not any(o is not l and l.start <= o.start and o.end <= l.end for o, _ in found)]
+
+
+def function_waits(ctx: AnalysisContext, func: str) -> List[Dict]:
+    """函数中的忙等待（缓存）"""
+    cache = ctx.cached("busy_wait.functions", dict)
+    if func in cache:
+        return cache[func]
+    text = function_body(ctx, func)
+    metrics = body_metrics(ctx, func)
+    waits = []
+
+    def scale(loop_list: List[Loop], value: Optional[float]) -> Tuple[Optional[float], bool]:
+        """乘以外层循环的迭代次数；有循环的次数无法确定时返回 (None, False)"""
+        for loop in loop_list:
+            n = loop_iterations(text, loop)
+            if n is None:
+                return None, False
+            if value is not None:
+                value *= n
+        return value, True
+
+    polling = _polling_loops(metrics.loops, metrics.calls)
+    in_polling = set()
+    for loop, inside in polling:
+        in_polling.update(id(c) for c in inside)
+        iterations = loop_iterations(text, loop)
+        lo, hi = loop_condition(text, loop)
+        time_bound = bool(_TIME_BOUND.search(text[lo:hi]) or
+                          _TIME_BOUND.search(text[loop.start:loop.end]))
+        # 每次迭代的延迟；循环内没有 delay 时无法换算为时间
+        delays = [delay_us(c) for c in inside if c.name in DELAY_CALLS]
+        per_iteration = sum(delays) if delays and None not in delays else None
+        worst = None
+        if iterations is not None and per_iteration is not None:
+            worst, _ = scale([l for l in metrics.loops_at(loop.start) if l is not loop],
+                             iterations * per_iteration)
+        waits.append({
+            "kind": "polling_loop",
+            "call": next(c.name for c in inside if c.is_mmio_read),
+            "line": loop.line,
+            "loop": loop.kind,
+            "iterations": iterations,
+            "bounded": iterations is not None or time_bound,
+            "worst_case_us": worst,
+        })
+
+    for site in metrics.calls:
+        if id(site) in in_polling:
+            continue
+        if site.name in DELAY_CALLS:
+            value = delay_us(site)
+            worst, known = scale(metrics.loops_at(site.pos), value)
+            waits.append({"kind": "delay", "call": site.name, "line": site.line,
+                          "delay_us": value, "bounded": True,
+                          "worst_case_us": worst if known else None})
+        elif _POLL.match(site.name):
+            timeout, sleeps = poll_timeout_us(site)
+            worst, known = scale(metrics.loops_at(site.pos), timeout)
+            waits.append({"kind": "poll_sleeping" if sleeps else "poll_atomic",
+                          "call": site.name, "line": site.line, "timeout_us": timeout,
+                          "bounded": timeout != 0,
+                          "worst_case_us": worst if known and timeout else None})
+    cache[func] = waits
+    return waits
+
+
+def severity(wait: Dict) -> str:
+    """无界轮询、会睡眠的 poll 和最坏 >= HIGH_US 为高风险；时间未知的为中风险"""
+    worst = wait["worst_case_us"]
+    if not wait["bounded"] or wait["kind"] == "poll_sleeping" or (worst or 0) >= HIGH_US:
+        return "high"
+    if worst is None or worst >= MEDIUM_US:
+        return "medium"
+    return "low"
+
+
+@AnalysisRegistry.register
+class BusyWaitPass(AnalysisPass):
+    """不可睡眠入口可达的忙等待和寄存器轮询"""
+
+    name = "busy-wait"
+    description = "延迟敏感路径上的忙等待：mdelay/udelay、poll_timeout_atomic、手写寄存器轮询循环"
+
+    def run(self, ctx: AnalysisContext) -> Dict:
+        findings: Dict[Tuple[str, int, str], Dict] = {}
+        entries = [e for e in entry_points(ctx) if e.atomic]
+        for entry in entries:
+            for func in reachable(ctx, entry.func):
+                for wait in function_waits(ctx, func):
+                    key = (func, wait["line"], wait["call"])
+                    record = findings.get(key)
+                    if record is None:
+                        record = findings[key] = dict(wait, func=func, severity=severity(wait),
+                                                      reached_from=[])
+                    record["reached_from"].append({
+                        "entry": entry.label,
+                        "path": call_chain(ctx, entry.func, func) + [wait["call"]],
+                    })
+        rank = {"high": 0, "medium": 1, "low": 2}
+        result = sorted(findings.values(), key=lambda f: (
+            rank[f["severity"]], -(f["worst_case_us"] or 0), f["func"], f["line"]))
+        for record in result:
+            record["reached_from"].sort(key=lambda r: (len(r["path"]), r["entry"]))
+        known = [f["worst_case_us"] for f in result if f["worst_case_us"] is not None]
+        return {
+            "entries": [e.label for e in entries],
+            "findings": result,
+            "summary": {
+                "findings": len(result),
+                "high": sum(1 for f in result if f["severity"] == "high"),
+                "unbounded": sum(1 for f in result if not f["bounded"]),
+                "max_worst_case_us": max(known, default=0),
+            },
+        }
+
+    def format_text(self, result: Dict) -> str:
+        summary = result["summary"]
+        out = [f"\n⏳ 忙等待: {summary['findings']} 处 (高风险 {summary['high']}, "
+               f"无界 {summary['unbounded']}, 最坏 {summary['max_worst_case_us']:g} us)"]
+        marks = {"high": "❌", "medium": "⚠️", "low": "  "}
+        for f in result["findings"]:
+            worst = "无界" if not f["bounded"] else \
+                f"{f['worst_case_us']:g} us" if f["worst_case_us"] is not None else "未知"
+            out.append(f"   {marks[f['severity']]} {f['func']}() 行 {f['line']}  "
+                       f"{f['kind']} {f['call']}  最坏 {worst}")
+            first = f["reached_from"][0]
+            out.append(f"        {first['entry']}: {' -> '.join(first['path'])}")
+        return "\n".join(out)
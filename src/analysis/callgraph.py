@@ -0,0 +1,257 @@
+#!/usr/bin/env python3
+"""
+调用图与执行上下文
+
+多个分析共享的派生数据（均通过 AnalysisContext.cached 每个文件只计算一次）：
+- 文件内调用图（只保留文件内定义的被调函数）
+- 入口点：异步处理函数（irq / tasklet / timer / work ...）、NAPI poll 和操作表回调
+- 每个函数可从哪些入口点到达（即可能在哪些执行上下文中运行）
+- 去掉注释、保留行号的函数体文本
+"""
+
+import re
+from collections import deque
+from dataclasses import dataclass
+from typing import Dict, List, Optional, Tuple
+
+from backends import FunctionDef, LineIndex
+
+from .base import AnalysisContext
+
+
+# 不可睡眠的异步上下文（与 UnifiedAnalyzer.ASYNC_PATTERNS 的 context 描述一致）
+ATOMIC_KINDS = {"irq", "tasklet", "timer", "hrtimer", "napi", "urb"}
+
+# 在关闭下半部的上下文中调用的操作表回调（知识库中标注"不可睡眠"的回调同样视为原子上下文）
+ATOMIC_OPS = {"ndo_start_xmit"}
+
+# 延迟敏感的入口：硬中断、NAPI poll，以及下列操作表回调
+HOT_KINDS = {"irq", "napi"}
+HOT_OPS = {
+    ("net_device_ops", "ndo_start_xmit"),
+    ("file_operations", "read"),
+    ("file_operations", "write"),
+    ("file_operations", "read_iter"),
+    ("file_operations", "write_iter"),
+}
+
+# 只在初始化/卸载/电源管理时调用的操作表回调，不视为并发执行上下文
+COLD_OPS = {"probe", "remove", "disconnect", "shutdown", "suspend", "resume",
+            "open", "release", "ndo_open", "ndo_stop", "ndo_init", "ndo_uninit",
+            "port_probe", "port_remove", "attach", "release_port",
+            "init_hctx", "exit_hctx", "init_request", "exit_request"}
+
+_COMMENT = re.compile(r'/\*.*?\*/|//[^\n]*', re.S)
+# netif_napi_add(dev, &napi, poll) / netif_napi_add_weight(dev, &napi, poll, weight)
+_NAPI_ADD = re.compile(r'\bnetif_(?:napi_add\w*|tx_napi_add)\s*\([^,]+,\s*[^,]+,\s*(\w+)')
+
+
+@dataclass(frozen=True)
+class EntryPoint:
+    """执行上下文的入口函数"""
+    func: str
+    kind: str       # 异步类型（irq / work / napi ...）或 "ops"
+    label: str      # 显示名: "irq:demo_isr" / "net_device_ops.ndo_start_xmit"
+    line: int = 0
+    atomic: bool = False    # 不可睡眠的上下文
+    hot: bool = False       # 延迟敏感的入口
+
+    def to_dict(self) -> Dict:
+        return {"func": self.func, "kind": self.kind, "label": self.label,
+                "atomic": self.atomic, "hot": self.hot}
+
+
+def strip_comments(text: str) -> str:
+    """去掉注释，保留换行（行号不变）"""
+    return _COMMENT.sub(lambda m: '\n' * m.group(0).count('\n') or ' ', text)
+
+
+def body_line(func: FunctionDef) -> int:
+    """函数体起始 '{' 所在行"""
+    if not func.location:
+        return 0
+    end = func.location.end_line or func.location.line
+    return max(end - func.body.count('\n'), func.location.line)
+
+
+def function_body(ctx: AnalysisContext, name: str) -> str:
+    """去掉注释的函数体（缓存）"""
+    bodies = ctx.cached("callgraph.bodies", dict)
+    if name not in bodies:
+        func = ctx.parse_result.functions.get(name)
+        bodies[name] = strip_comments(func.body) if func else ""
+    return bodies[name]
+
+
+def call_graph(ctx: AnalysisContext) -> Dict[str, List[str]]:
+    """函数 -> 文件内定义的被调函数（保持调用顺序，去重）"""
+    def build() -> Dict[str, List[str]]:
+        functions = ctx.parse_result.functions
+        return {name: [c for c in dict.fromkeys(func.calls) if c in functions and c != name]
+                for name, func in functions.items()}
+    return ctx.cached("callgraph.graph", build)
+
+
+def entry_points(ctx: AnalysisContext) -> List[EntryPoint]:
+    """文件内定义的异步处理函数、NAPI poll 和（非冷路径的）操作表回调"""
+    def build() -> List[EntryPoint]:
+        functions = ctx.parse_result.functions
+        entries: Dict[str, EntryPoint] = {}
+
+        def add(func: str, kind: str, label: str, line: int, atomic: bool, hot: bool) -> None:
+            if func in functions:
+                entries.setdefault(label, EntryPoint(func, kind, label, line, atomic, hot))
+
+        for handler in ctx.async_handlers:
+            kind = handler.handler_type
+            add(handler.func_name, kind, f"{kind}:{handler.func_name}", handler.line,
+                kind in ATOMIC_KINDS, kind in HOT_KINDS)
+        if ctx.source:
+            lines = LineIndex(ctx.source)
+            for m in _NAPI_ADD.finditer(ctx.source):
+                add(m.group(1), "napi", f"napi:{m.group(1)}", lines.line_of(m.start()),
+                    True, True)
+        for ops in ctx.struct_ops:
+            kb_entries = ctx.kb.get(ops['struct_type'], {}).get('entry_points', {})
+            for field_name, func in ops["mappings"].items():
+                if field_name not in COLD_OPS:
+                    kb_context = kb_entries.get(field_name, {}).get('context', '')
+                    atomic = field_name in ATOMIC_OPS or '不可睡眠' in kb_context
+                    add(func, "ops", f"{ops['struct_type']}.{field_name}", ops.get("line", 0),
+                        atomic, (ops['struct_type'], field_name) in HOT_OPS)
+        return list(entries.values())
+    return ctx.cached("callgraph.entries", build)
+
+
+def _bfs(ctx: AnalysisContext, root: str) -> Tuple[Dict[str, int], Dict[str, str]]:
+    """从 root 出发的 BFS：(函数 -> 调用深度, 函数 -> BFS 树中的调用者)"""
+    cache = ctx.cached("callgraph.bfs", dict)
+    if root not in cache:
+        graph = call_graph(ctx)
+        depth = {root: 0}
+        parent: Dict[str, str] = {}
+        queue = deque([root])
+        while queue:
+            func = queue.popleft()
+            for callee in graph.get(func, ()):
+                if callee not in depth:
+                    depth[callee] = depth[func] + 1
+                    parent[callee] = func
+                    queue.append(callee)
+        cache[root] = (depth, parent)
+    return cache[root]
+
+
+def reachable(ctx: AnalysisContext, root: str) -> Dict[str, int]:
+    """从 root 可到达的文件内函数 -> 调用深度（BFS，root 深度为 0）"""
+    return _bfs(ctx, root)[0]
+
+
+def contexts_by_function(ctx: AnalysisContext) -> Dict[str, List[EntryPoint]]:
+    """函数 -> 可到达它的入口点（函数可能运行的执行上下文）"""
+    def build() -> Dict[str, List[EntryPoint]]:
+        result: Dict[str, List[EntryPoint]] = {}
+        for entry in entry_points(ctx):
+            for func in reachable(ctx, entry.func):
+                result.setdefault(func, []).append(entry)
+        return result
+    return ctx.cached("callgraph.contexts", build)
+
+
+def call_chain(ctx: AnalysisContext, root: str, target: str) -> Optional[List[str]]:
+    """root 到 target 的一条最短调用链（不可达返回 None）"""
+    depth, parent = _bfs(ctx, root)
+    if target not in depth:
+        return None
+    chain = [target]
+    while chain[-1] != root:
+        chain.append(parent[chain[-1]])
+    return chain[::-1]
+
+
+class Condensation:
+    """
+    调用图的强连通分量缩点（DAG）
+
+    sccs 按拓扑序排列（调用者在前），scc_of 为函数 -> 分量编号，succ 为分量间的边。
+    在 DAG 上按拓扑序传播位集合（Python int），整体为 O((V + E) · 位数 / 字长)。
+    """
+
+    def __init__(self, graph: Dict[str, List[str]]):
+        index: Dict[str, int] = {}
+        low: Dict[str, int] = {}
+        on_stack = set()
+        stack: List[str] = []
+        components: List[List[str]] = []
+
+        # 迭代版 Tarjan，避免深调用链触发递归上限
+        for root in graph:
+            if root in index:
+                continue
+            work = [(root, iter(graph.get(root, ())))]
+            index[root] = low[root] = len(index)
+            stack.append(root)
+            on_stack.add(root)
+            while work:
+                node, children = work[-1]
+                advanced = False
+                for child in children:
+                    if child not in index:
+                        index[child] = low[child] = len(index)
+                        stack.append(child)
+                        on_stack.add(child)
+                        work.append((child, iter(graph.get(child, ()))))
+                        advanced = True
+                        break
+                    if child in on_stack:
+                        low[node] = min(low[node], index[child])
+                if advanced:
+                    continue
+                work.pop()
+                if work:
+                    parent = work[-1][0]
+                    low[parent] = min(low[parent], low[node])
+                if low[node] == index[node]:
+                    component = []
+                    while True:
+                        member = stack.pop()
+                        on_stack.discard(member)
+                        component.append(member)
+                        if member == node:
+                            break
+                    components.append(component)
+
+        # Tarjan 先完成被调用者，反转后调用者在前
+        self.sccs: List[List[str]] = components[::-1]
+        self.scc_of: Dict[str, int] = {f: i for i, comp in enumerate(self.sccs) for f in comp}
+        self.succ: List[set] = [set() for _ in self.sccs]
+        for func, callees in graph.items():
+            for callee in callees:
+                a, b = self.scc_of[func], self.scc_of[callee]
+                if a != b:
+                    self.succ[a].add(b)
+
+    def propagate(self, seeds: Dict[str, int]) -> List[int]:
+        """
+        沿调用方向传播位集合
+
+        Args:
+            seeds: 函数 -> 初始位集合
+
+        Returns:
+            每个分量可到达它的种子位集合
+        """
+        bits = [0] * len(self.sccs)
+        for func, value in seeds.items():
+            if func in self.scc_of:
+                bits[self.scc_of[func]] |= value
+        for i in range(len(self.sccs)):
+            if bits[i]:
+                for j in self.succ[i]:
+                    bits[j] |= bits[i]
+        return bits
+
+
+def condensation(ctx: AnalysisContext) -> Condensation:
+    """文件内调用图的缩点（缓存）"""
+    return ctx.cached("callgraph.condensation", lambda: Condensation(call_graph(ctx)))
@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+"""
+命名常量：枚举常量和 #define 宏常量求值与值 -> 名字反查
+
+- 每个枚举常量求出整数值：隐式值按前一个 + 1，显式值支持字面量、前面的常量、
+  BIT() / GENMASK() 和移位等（consteval.eval_int）
+- 对象式宏（#define REG_CTRL 0x04）按同样的规则求值，可以引用其它宏和枚举常量；
+  函数式宏、字符串等无法求值的记入 unresolved
+- 项目级常量表：-I 收集的头文件中的宏和枚举每个进程只求值一次，各文件的常量表以它为父表
+- 反查索引：寄存器解码 / 状态机视图按 (枚举, 值) 取名字，位掩码按单个位的常量分解
+- MMIO 地址拆分：writel(val, base + REG_CTRL) 的地址拆成基址和常量偏移（resolve_offset）
+
+后端没有提取枚举时（regex / native 的完整解析不提取枚举），用头文件模式
+（parse_declarations）从源码中补提。
+"""
+
+from typing import Any, Dict, List, Optional, Tuple
+
+from backends import EnumDef
+
+from .base import AnalysisContext, AnalysisPass, AnalysisRegistry
+from .consteval import DEFINE_GROUP, ConstantTable, _IDENT
+
+
+# 项目级常量表，按 headers 选项对象缓存（worker 进程内跨文件共享）
+_project: Tuple[Any, Optional[ConstantTable]] = (None, None)
+
+
+def project_constants(headers: Any = None) -> ConstantTable:
+    """项目级常量表：头文件（HeaderIndex）中的宏和枚举常量；同一个 headers 只构建一次"""
+    global _project
+    cached_headers, table = _project
+    if table is None or cached_headers is not headers:
+        table = ConstantTable()
+        if headers is not None:
+            table.add_macros(getattr(headers, "macros", {}))
+            for enum in headers.enums.values():
+                table.add_enum(enum)
+        _project = (headers, table)
+    return table
+
+
+def file_enums(ctx: AnalysisContext) -> Dict[str, EnumDef]:
+    """本文件的枚举定义（后端没有提取时用 regex 后端的头文件模式补提）"""
+    def extract() -> Dict[str, EnumDef]:
+        if ctx.parse_result.enums or 'enum' not in ctx.source:
+            return ctx.parse_result.enums
+        from backends import RegexBackend
+        return RegexBackend().parse_declarations(ctx.source, ctx.filepath).enums
+    return ctx.cached("constants.enums", extract)
+
+
+def file_defines(ctx: AnalysisContext) -> Dict[str, str]:
+    """本文件的对象式宏：名字 -> 替换文本"""
+    def extract() -> Dict[str, str]:
+        if 'define' not in ctx.source:
+            return {}
+        from backends.regex_backend import extract_defines
+        return extract_defines(ctx.source)
+    return ctx.cached("constants.defines", extract)
+
+
+def constant_table(ctx: AnalysisContext) -> ConstantTable:
+    """本文件的常量表（父表为项目级常量表），上下文共享；宏先于枚举加入"""
+    def build() -> ConstantTable:
+        table = ConstantTable(project_constants(ctx.option("headers")))
+        table.add_macros(file_defines(ctx))
+        for enum in file_enums(ctx).values():
+            table.add_enum(enum)
+        return table
+    return ctx.cached("constants.table", build)
+
+
+def _split_plus(expr: str) -> List[str]:
+    """按顶层 '+' 拆分地址表达式"""
+    terms, depth, start = [], 0, 0
+    for i, c in enumerate(expr):
+        if c in '([':
+            depth += 1
+        elif c in ')]':
+            depth -= 1
+        elif c == '+' and depth == 0:
+            terms.append(expr[start:i].strip())
+            start = i + 1
+    terms.append(expr[start:].strip())
+    return [t for t in terms if t]
+
+
+def resolve_offset(table: ConstantTable, expr: str) -> Tuple[str, Optional[int], List[str]]:
+    """
+    把 MMIO 地址表达式拆成 (基址, 常量偏移, 作为加数出现的常量名)
+
+    能求值的顶层加数（REG_CTRL、0x10、REG_Q0 * 4）求和为偏移，其余（priv->base、
+    REG_Q(i)）拼回基址；整体加括号的加数展开一层。没有常量加数时偏移为 None。
+        resolve_offset(table, "priv->base + REG_CTRL")  # ("priv->base", 4, ["REG_CTRL"])
+    """
+    base, offset, names = [], None, []
+    terms = _split_plus(expr)
+    while terms:
+        term = terms.pop(0)
+        value = table.evaluate(term)
+        if value is None:
+            inner = _split_plus(term[1:-1]) if term.startswith('(') and term.endswith(')') else []
+            if len(inner) > 1:
+                terms[:0] = inner
+            else:
+                base.append(term)
+            continue
+        offset = (offset or 0) + value
+        if _IDENT.fullmatch(term):
+            names.append(term)
+    return " + ".join(base), offset, names
+
+
+def register_label(table: ConstantTable, offset: int, names: List[str]) -> str:
+    """寄存器显示名：REG_CTRL / REG_TX_BASE+0x4 / 0x108"""
+    rest = offset - sum(table.get(n) for n in names)
+    label = "+".join(names)
+    if rest or not label:
+        label = f"{label}+{rest:#x}" if label else f"{offset:#x}"
+    return label
+
+
+@AnalysisRegistry.register
+class EnumPass(AnalysisPass):
+    """枚举常量求值"""
+
+    name = "enums"
+    description = "枚举常量求值（BIT / GENMASK / 移位 / 前项引用）与值 -> 名字反查表"
+    needs = frozenset()
+
+    def run(self, ctx: AnalysisContext) -> Dict:
+        table = constant_table(ctx)
+        enums = {}
+        unresolved_total = 0
+        for name, enum in file_enums(ctx).items():
+            values = {item.name: table.get(item.name) for item in enum.values}
+            resolved = [v for v in values.values() if v is not None]
+            by_value: Dict[str, list] = {}
+            for const, value in values.items():
+                if value is not None:
+                    by_value.setdefault(str(value), []).append(const)
+            unresolved = [c for c, v in values.items() if v is None]
+            unresolved_total += len(unresolved)
+            enums[name] = {
+                "line": enum.location.line if enum.location else 0,
+                "typedef_name": enum.typedef_name,
+                "values": values,
+                "by_value": by_value,
+                # 全部是单个位（可按位分解）的枚举
+                "flags": len(resolved) > 1 and all(v > 0 and v & (v - 1) == 0 for v in resolved),
+                "unresolved": unresolved,
+            }
+        return {
+            "enums": enums,
+            "summary": {
+                "enums": len(enums),
+                "constants": sum(len(e["values"]) for e in enums.values()),
+                "unresolved": unresolved_total,
+                "project_constants": len(table.parent) if table.parent else 0,
+            },
+        }
+
+    def format_text(self, result: Dict) -> str:
+        s = result["summary"]
+        out = [f"\n🔢 枚举常量: {s['enums']} 个枚举, {s['constants']} 个常量"
+               f"（{s['unresolved']} 个无法求值），头文件常量 {s['project_constants']} 个"]
+        for name, enum in result["enums"].items():
+            if enum["unresolved"]:
+                shown = ', '.join(enum["unresolved"][:5])
+                more = f" 等 {len(enum['unresolved'])} 个" if len(enum["unresolved"]) > 5 else ""
+                out.append(f"   ⚠️ {name} (行 {enum['line']}): 无法求值 {shown}{more}")
+        return "\n".join(out)
+
+
+@AnalysisRegistry.register
+class DefinePass(AnalysisPass):
+    """#define 宏常量求值"""
+
+    name = "defines"
+    description = "对象式宏（寄存器偏移 / 位掩码）求值，按名字和值索引"
+    needs = frozenset()
+
+    def run(self, ctx: AnalysisContext) -> Dict:
+        table = constant_table(ctx)
+        macros = file_defines(ctx)
+        values: Dict[str, int] = {}
+        by_value: Dict[str, List[str]] = {}
+        unresolved: Dict[str, str] = {}
+        for name, text in macros.items():
+            value = table.get(name)
+            if value is not None:
+                values[name] = value
+                by_value.setdefault(str(value), []).append(name)
+            elif text:
+                unresolved[name] = table.unresolved.get(name, text)
+        return {
+            "values": values,
+            "by_value": by_value,
+            "unresolved": unresolved,
+            "summary": {
+                "defines": len(macros),
+                "constants": len(values),
+                "unresolved": len(unresolved),
+                "empty": len(macros) - len(values) - len(unresolved),
+                "project_constants": len(table.parent) if table.parent else 0,
+            },
+        }
+
+    def format_text(self, result: Dict) -> str:
+        s = result["summary"]
+        out = [f"\n#️⃣ 宏常量: {s['defines']} 个对象式宏, {s['constants']} 个可求值"
+               f"（{s['unresolved']} 个无法求值, {s['empty']} 个空宏），头文件常量 {s['project_constants']} 个"]
+        shown = list(result["values"].items())[:10]
+        for name, value in shown:
+            out.append(f"   {name:<32} = {value:#x}")
+        if len(result["values"]) > len(shown):
+            out.append(f"   ... 共 {len(result['values'])} 个")
+        return "\n".join(out)
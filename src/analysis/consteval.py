@@ -0,0 +1,415 @@
+#!/usr/bin/env python3
+"""
+C 整数常量表达式求值
+
+只接受整数字面量、已知名字、整数类型强制转换和 C 的整数运算符，按 LP64 下 C 的整数语义求值：
+字面量按后缀定类型，常用算术转换，无符号 / 有符号结果按类型位宽截断，除法向零取整。
+无法确定的表达式返回 None，从不执行任意代码。
+
+内核的位操作宏 BIT() / BIT_ULL() / GENMASK() / GENMASK_ULL() / _BITUL() / _UL() 等按定义直接求值。
+
+ConstantTable 是命名常量（枚举常量、#define 宏）的表：名字 -> 值，以及值 -> 名字的反查索引。
+
+使用方法:
+    eval_int("4 * ETH_ALEN", {"ETH_ALEN": 6})   # 24
+    eval_int("1UL << 3")                        # 8
+    eval_int("GENMASK(7, 4) | BIT(0)")          # 0xf1
+    eval_int("~0U")                             # 0xffffffff
+"""
+
+import ast
+import re
+from collections import ChainMap
+from typing import Dict, List, Mapping, Optional, Tuple
+
+from backends import EnumDef
+
+
+# 整数字面量（含 U/L/UL/ULL 后缀），按 C 的规则定类型
+_INT_LITERAL = re.compile(r'\b(0[xX][0-9a-fA-F]+|\d+)([uUlL]*)\b')
+# 整数类型强制转换 (u32) / (unsigned long)
+_CAST = re.compile(r'\(\s*((?:(?:unsigned|signed|const|long|short|int|char|size_t|'
+                   r'(?:__)?[us](?:8|16|32|64)|u?int(?:8|16|32|64)_t)\s*)+)\)')
+_IDENT = re.compile(r'\b[A-Za-z_]\w*\b')
+_OPEN_PAREN = re.compile(r'\s*\(')
+# 纯整数字面量 / 单个名字：不经过 ast（生成的大枚举头文件里绝大多数值是这两种）
+_LITERAL = re.compile(r'\s*(0[xX][0-9a-fA-F]+|[1-9]\d*|0[0-7]*)[uUlL]*\s*')
+_NAME = re.compile(r'\s*([A-Za-z_]\w*)\s*')
+
+# 表达式改写后的占位名：_K<n> 是第 n 个字面量，_T<u|s><位数> 是强制转换
+_LIT_PREFIX = "_K"
+_CAST_PREFIX = "_T"
+
+# 宏常量的分组名（枚举常量的分组是枚举名）
+DEFINE_GROUP = "#define"
+
+
+def _c_div(a: int, b: int) -> int:
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b >= 0) else -q
+
+
+def _c_mod(a: int, b: int) -> int:
+    return a - _c_div(a, b) * b
+
+
+_BINOPS = {
+    ast.Add: lambda a, b: a + b,
+    ast.Sub: lambda a, b: a - b,
+    ast.Mult: lambda a, b: a * b,
+    ast.Div: _c_div,
+    ast.FloorDiv: _c_div,
+    ast.Mod: _c_mod,
+    ast.LShift: lambda a, b: a << b,
+    ast.RShift: lambda a, b: a >> b,
+    ast.BitAnd: lambda a, b: a & b,
+    ast.BitOr: lambda a, b: a | b,
+    ast.BitXor: lambda a, b: a ^ b,
+}
+
+_UNARYOPS = {
+    ast.USub: lambda a: -a,
+    ast.UAdd: lambda a: a,
+    ast.Invert: lambda a: ~a,
+}
+
+# 带类型的值：(值, 位数 32 / 64, 是否无符号)；LP64，int 为 32 位，long / long long 为 64 位
+Typed = Tuple[int, int, bool]
+
+
+def _wrap(value: int, bits: int, unsigned: bool) -> int:
+    """按位数截断为无符号值或补码有符号值"""
+    value &= (1 << bits) - 1
+    if not unsigned and value >> (bits - 1):
+        value -= 1 << bits
+    return value
+
+
+def _fits(value: int, bits: int, unsigned: bool) -> bool:
+    if unsigned:
+        return 0 <= value < 1 << bits
+    return -(1 << (bits - 1)) <= value < 1 << (bits - 1)
+
+
+def _typed_literal(value: int, suffix: str, decimal: bool) -> Typed:
+    """字面量的类型：按 C 的规则取第一个能放下的 int / unsigned int / long / unsigned long"""
+    suffix = suffix.lower()
+    unsigned = 'u' in suffix
+    for bits in ((64,) if 'l' in suffix else (32, 64)):
+        # 十进制无后缀的字面量不会变成无符号
+        for u in ((True,) if unsigned else (False,) if decimal else (False, True)):
+            if _fits(value, bits, u):
+                return value, bits, u
+    if value < 1 << 64:
+        return value, 64, True
+    raise ValueError("literal too large")
+
+
+def _typed_name(value: int) -> Typed:
+    """已知名字的值没有记录类型：按十六进制字面量的规则取类型（~0U 存为 0xffffffff 仍是 unsigned int）"""
+    if value < 0:
+        return value, (32 if _fits(value, 32, False) else 64), False
+    return _typed_literal(value, "", False)
+
+
+def _cast_name(words: str) -> str:
+    """强制转换的类型 -> 占位名 _T<u|s><位数>"""
+    parts = words.replace('__', '').split()
+    parts = [w for w in parts if w != 'const']
+    unsigned = 'unsigned' in parts or 'size_t' in parts or \
+        any(re.fullmatch(r'u(?:int)?\d+(?:_t)?', w) for w in parts)
+    if 'char' in parts:
+        bits = 8
+    elif 'short' in parts:
+        bits = 16
+    elif 'long' in parts or 'size_t' in parts:
+        bits = 64
+    else:
+        sized = [int(n) for w in parts for n in re.findall(r'\d+', w)]
+        bits = sized[0] if sized else 32
+    return f"{_CAST_PREFIX}{'u' if unsigned else 's'}{bits}"
+
+
+def _cast(name: str, value: Typed) -> Typed:
+    unsigned = name[len(_CAST_PREFIX)] == 'u'
+    bits = int(name[len(_CAST_PREFIX) + 1:])
+    result = _wrap(value[0], bits, unsigned)
+    if bits < 32:
+        # 整数提升：窄类型的值转为 int
+        return result, 32, False
+    return result, bits, unsigned
+
+
+def _common(a: Typed, b: Typed) -> Tuple[int, bool]:
+    """常用算术转换：位数取大者；位数相同时有一个无符号即为无符号"""
+    if a[1] == b[1]:
+        return a[1], a[2] or b[2]
+    wider = a if a[1] > b[1] else b
+    return wider[1], wider[2]
+
+
+def _bit(n: Typed) -> Typed:
+    if not 0 <= n[0] < 64:
+        raise ValueError("bit out of range")
+    return 1 << n[0], 64, True
+
+
+def _genmask(high: Typed, low: Typed) -> Typed:
+    if not 0 <= low[0] <= high[0] < 64:
+        raise ValueError("bad GENMASK")
+    return ((1 << (high[0] - low[0] + 1)) - 1) << low[0], 64, True
+
+
+def _unsigned_long(x: Typed) -> Typed:
+    return _wrap(x[0], 64, True), 64, True
+
+
+# 函数式宏 -> 求值函数（BIT() 等展开为 unsigned long）
+_INT_FUNCS = {
+    'BIT': _bit,
+    'BIT_ULL': _bit,
+    '_BITUL': _bit,
+    '_BITULL': _bit,
+    'GENMASK': _genmask,
+    'GENMASK_ULL': _genmask,
+    '_UL': _unsigned_long,
+    '_ULL': _unsigned_long,
+    'UL': _unsigned_long,
+    'ULL': _unsigned_long,
+}
+
+
+def _eval(node: ast.AST, literals: List[Typed]) -> Typed:
+    if isinstance(node, ast.Expression):
+        return _eval(node.body, literals)
+    if isinstance(node, ast.Name) and node.id.startswith(_LIT_PREFIX):
+        return literals[int(node.id[len(_LIT_PREFIX):])]
+    if isinstance(node, ast.BinOp) and isinstance(node.op, ast.Pow) \
+            and isinstance(node.left, ast.Name) and node.left.id.startswith(_CAST_PREFIX):
+        return _cast(node.left.id, _eval(node.right, literals))
+    if isinstance(node, ast.BinOp) and type(node.op) in _BINOPS:
+        left, right = _eval(node.left, literals), _eval(node.right, literals)
+        if isinstance(node.op, (ast.LShift, ast.RShift)):
+            # 结果类型是左操作数的类型；移位数超出位宽是未定义行为
+            bits, unsigned = left[1], left[2]
+            if not 0 <= right[0] < bits:
+                raise ValueError("shift out of range")
+            return _wrap(_BINOPS[type(node.op)](left[0], right[0]), bits, unsigned), bits, unsigned
+        bits, unsigned = _common(left, right)
+        a, b = _wrap(left[0], bits, unsigned), _wrap(right[0], bits, unsigned)
+        if isinstance(node.op, (ast.Div, ast.FloorDiv, ast.Mod)) and b == 0:
+            raise ValueError("division by zero")
+        return _wrap(_BINOPS[type(node.op)](a, b), bits, unsigned), bits, unsigned
+    if isinstance(node, ast.UnaryOp) and type(node.op) in _UNARYOPS:
+        value, bits, unsigned = _eval(node.operand, literals)
+        return _wrap(_UNARYOPS[type(node.op)](value), bits, unsigned), bits, unsigned
+    if isinstance(node, ast.Call) and isinstance(node.func, ast.Name) \
+            and node.func.id in _INT_FUNCS and not node.keywords:
+        return _INT_FUNCS[node.func.id](*[_eval(arg, literals) for arg in node.args])
+    raise ValueError(f"unsupported: {ast.dump(node)}")
+
+
+def eval_int(expr: str, names: Optional[Mapping[str, int]] = None) -> Optional[int]:
+    """
+    求值 C 整数常量表达式
+
+    按 LP64 的 C 类型规则求值：字面量按后缀和大小定为 int / unsigned int / long / unsigned long，
+    (u32) 等强制转换截断到对应位宽，~、-、<< 的结果按类型位宽截断，
+    所以 ~0U == 0xffffffff、(u32)~0 == 0xffffffff、~0UL == 0xffffffffffffffff。
+
+    Args:
+        expr: 表达式文本
+        names: 已知名字 -> 值（宏、枚举常量等）
+
+    Returns:
+        整数值；含未知名字、不支持的语法或未定义行为（移位数超出位宽）时返回 None
+    """
+    if not expr or not expr.strip():
+        return None
+    names = names or {}
+    simple = _LITERAL.fullmatch(expr)
+    if simple:
+        digits = simple.group(1)
+        octal = len(digits) > 1 and digits[0] == '0' and digits[1] not in 'xX'
+        return int(digits, 8 if octal else 0)
+    simple = _NAME.fullmatch(expr)
+    if simple:
+        return names.get(simple.group(1))
+    # 强制转换改写为右结合、优先级高于二元运算符的 **：(u32)~0 + 1 -> (_Tu32 ** ~0) + 1
+    text = _CAST.sub(lambda m: f" {_cast_name(m.group(1))} ** ", expr)
+    unknown = False
+
+    def substitute(match) -> str:
+        nonlocal unknown
+        name = match.group(0)
+        if name in names:
+            value = names[name]
+            return f"(0x{value:x})" if value >= 0 else f"(-0x{-value:x})"
+        if name.startswith(_CAST_PREFIX) or \
+                (name in _INT_FUNCS and _OPEN_PAREN.match(match.string, match.end())):
+            return name
+        unknown = True
+        return name
+
+    text = _IDENT.sub(substitute, text)
+    if unknown:
+        return None
+    literals: List[Typed] = []
+
+    def literal(match) -> str:
+        digits, suffix = match.group(1), match.group(2)
+        octal = len(digits) > 1 and digits[0] == '0' and digits[1] not in 'xX'
+        try:
+            value = int(digits, 8 if octal else 0)
+        except ValueError:
+            value = None
+        literals.append(None if value is None else
+                        _typed_literal(value, suffix, digits[0] != '0' or digits == '0'))
+        return f"{_LIT_PREFIX}{len(literals) - 1}"
+
+    try:
+        text = _INT_LITERAL.sub(literal, text)
+        if None in literals:
+            return None
+        text = text.replace('/', '//').replace('////', '//')
+        return _eval(ast.parse(text.strip(), mode='eval'), literals)[0]
+    except (SyntaxError, ValueError, TypeError, RecursionError, IndexError):
+        return None
+
+
+class ConstantTable:
+    """
+    命名整数常量表
+
+    - values: 名字 -> 值；按 (分组, 值) 和值建反查索引，把寄存器 / 状态数值映射回名字是 O(1)
+    - 分组是枚举名（枚举常量）或 DEFINE_GROUP（#define 宏）
+    - parent: 项目级的共享表（-I 收集的头文件中的常量）；本表没有的名字到父表查找，父表只读
+    - 同名常量以先加入的为准，已知的名字不再求值：同一枚举在多个文件 / 头文件中出现时只算一次
+    """
+
+    def __init__(self, parent: Optional['ConstantTable'] = None):
+        self.parent = parent
+        self.values: Dict[str, int] = {}
+        self.group_of: Dict[str, str] = {}
+        self.unresolved: Dict[str, str] = {}    # 名字 -> 无法求值的表达式
+        # 求值时使用的名字表（本表 + 父表，不拷贝）
+        self.names: Mapping[str, int] = ChainMap(self.values, parent.names) if parent else self.values
+        self._by_value: Dict[int, List[str]] = {}
+        self._by_group: Dict[Tuple[str, int], List[str]] = {}
+        self._bits: Dict[str, Dict[int, str]] = {}   # 分组 -> 单个位的值 -> 名字
+
+    def __len__(self) -> int:
+        return len(self.values)
+
+    def __contains__(self, name: str) -> bool:
+        return name in self.names
+
+    def get(self, name: str) -> Optional[int]:
+        return self.names.get(name)
+
+    def add(self, name: str, value: int, group: str = "") -> bool:
+        """加入一个常量；名字已存在（本表或父表）时忽略并返回 False"""
+        if name in self.names:
+            return False
+        self.values[name] = value
+        self.group_of[name] = group
+        self._by_value.setdefault(value, []).append(name)
+        self._by_group.setdefault((group, value), []).append(name)
+        if value > 0 and value & (value - 1) == 0:
+            self._bits.setdefault(group, {}).setdefault(value, name)
+        return True
+
+    def evaluate(self, expr: str) -> Optional[int]:
+        """用表中的常量求值表达式"""
+        return eval_int(expr, self.names)
+
+    def add_enum(self, enum: EnumDef) -> List[Tuple[str, Optional[int]]]:
+        """
+        求值并加入一个枚举的全部常量（线性时间）
+
+        隐式值 = 前一个常量 + 1（第一个为 0）；显式值可以引用前面的常量和表中已有的常量。
+        前一个常量无法求值时，其后的隐式值也无法求值（记入 unresolved）。
+
+        Returns:
+            [(常量名, 值或 None)]，按定义顺序
+        """
+        out = []
+        prev: Optional[int] = -1
+        prev_name = ""
+        for item in enum.values:
+            value = self.names.get(item.name)
+            if value is None:
+                if item.value is None:
+                    value = None if prev is None else prev + 1
+                else:
+                    value = self.evaluate(item.value)
+                if value is None:
+                    self.unresolved.setdefault(item.name, item.value or f"{prev_name} + 1")
+                else:
+                    self.add(item.name, value, enum.name)
+            out.append((item.name, value))
+            prev, prev_name = value, item.name
+        return out
+
+    def add_macros(self, macros: Mapping[str, str], group: str = DEFINE_GROUP) -> int:
+        """
+        求值并加入一组对象式宏（名字 -> 替换文本），返回新加入的常量数
+
+        宏可以引用后定义的宏：求值前先（用显式栈）求出它引用的、还没求值的宏，
+        每个宏只求值一次，总时间与宏文本总长成线性；循环引用的宏记入 unresolved。
+        空宏（#define CONFIG_FOO）不是常量，直接忽略。
+        """
+        pending = {name: text for name, text in macros.items() if text and name not in self.names}
+        added = 0
+        for root in list(pending):
+            if root not in pending:
+                continue
+            # 出栈前不在 pending 里：自引用 / 循环引用不会再次入栈
+            stack = [(root, pending.pop(root))]
+            while stack:
+                name, text = stack[-1]
+                dep = next((d for d in _IDENT.findall(text) if d in pending), None)
+                if dep is not None:
+                    stack.append((dep, pending.pop(dep)))
+                    continue
+                stack.pop()
+                value = self.evaluate(text)
+                if value is None:
+                    self.unresolved.setdefault(name, text)
+                elif self.add(name, value, group):
+                    added += 1
+        return added
+
+    def names_for(self, value: int, group: Optional[str] = None) -> List[str]:
+        """值 -> 常量名（group 为 None 时不限分组），本表在前、父表在后"""
+        local = self._by_value.get(value, []) if group is None else self._by_group.get((group, value), [])
+        return local + self.parent.names_for(value, group) if self.parent else list(local)
+
+    def name_for(self, value: int, group: Optional[str] = None) -> Optional[str]:
+        """值 -> 第一个（最先定义的）常量名"""
+        names = self.names_for(value, group)
+        return names[0] if names else None
+
+    def decode_flags(self, value: int, group: str) -> Tuple[List[str], int]:
+        """
+        按分组中的单个位常量分解位掩码（用于寄存器解码）
+
+        Returns:
+            (按位从低到高的常量名, 没有对应常量的剩余位)
+        """
+        flags, rest, bit = [], 0, 1
+        while bit <= value:
+            if value & bit:
+                name = self._bit_name(group, bit)
+                if name:
+                    flags.append(name)
+                else:
+                    rest |= bit
+            bit <<= 1
+        return flags, rest
+
+    def _bit_name(self, group: str, bit: int) -> Optional[str]:
+        name = self._bits.get(group, {}).get(bit)
+        if name is None and self.parent:
+            return self.parent._bit_name(group, bit)
+        return name
@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+"""
+Per-CPU / 原子计数器热点
+
+找出热路径上更新的统计计数器和共享状态，并分为三类：
+- shared_atomic: 共享的原子计数（atomic_inc(&priv->drops)、atomic64_add(...)）
+- plain_shared:  普通共享写（dev->stats.tx_packets++、priv->last_rx = jiffies、
+                 全局变量自增、对非 per-CPU 对象的 u64_stats_inc / add）
+- per_cpu:       已经是 per-CPU 的更新（this_cpu_inc / __this_cpu_add、local_inc、
+                 对 this_cpu_ptr / per_cpu_ptr 取得的指针做的写）
+
+共享的两类按到热入口（硬中断、NAPI poll、ndo_start_xmit、URB 完成、queue_rq 等，
+见 callgraph.HOT_KINDS / io_alloc.is_per_io）的调用图距离排序：距离越近，越确定每个包都会执行，
+越适合改为 per-CPU 计数（读取时对各 CPU 求和）。
+"""
+
+import re
+from typing import Dict, List, Tuple
+
+from backends import BackendCapability, LineIndex
+
+from .base import AnalysisContext, AnalysisPass, AnalysisRegistry
+from .callgraph import body_line, contexts_by_function, entry_points, function_body, reachable
+from .fields import field_writes, var_types
+from .io_alloc import is_per_io
+from .metrics import body_metrics, split_args
+
+
+# 计数类原子操作（位操作、refcount / kref 是状态和生命周期，不是统计计数）
+ATOMIC_COUNTER = re.compile(r'^(?:arch_)?atomic(?:64|_long)?_(?:fetch_)?(?:inc|dec|add|sub)\w*$')
+# 已经是 per-CPU 的更新
+PER_CPU_CALL = re.compile(r'^(?:(?:__)?this_cpu|raw_cpu)_(?:inc|dec|add|sub|write|xchg|cmpxchg)\w*$|'
+                          r'^local(?:64)?_(?:inc|dec|add|sub)\w*$')
+U64_STATS = re.compile(r'^u64_stats_(?:inc|add|set)$')
+# 取得 per-CPU 指针: stats = this_cpu_ptr(priv->stats);
+_PER_CPU_PTR = re.compile(r'\b(\w+)\s*=\s*(?:this_cpu_ptr|raw_cpu_ptr|per_cpu_ptr|get_cpu_ptr)\s*\(')
+# 文件作用域的标量 / 原子变量
+_SCALAR_GLOBAL = re.compile(
+    r'^(?:static\s+)?(?:volatile\s+)?(?:(?:unsigned|signed)\s+)?'
+    r'(?:long\s+long|long|int|short|char|u8|u16|u32|u64|s8|s16|s32|s64|size_t|'
+    r'atomic_t|atomic64_t|atomic_long_t)\s+(\w+)\s*(?:=[^;]*)?;', re.M)
+_STAT_NAME = re.compile(r'stat|count|cnt|packets|bytes|err|drop|overrun|missed|total|num_', re.I)
+
+CLASSES = ("shared_atomic", "plain_shared", "per_cpu")
+
+ADVICE = {
+    "shared_atomic": "原子计数在各 CPU 间争用同一缓存行；改为 per-CPU 计数（this_cpu_inc，"
+                     "或 this_cpu_ptr + u64_stats），读取时对各 CPU 求和",
+    "plain_shared": "多个 CPU 写同一对象（并发自增还会丢失更新）；统计计数改为 per-CPU，"
+                    "状态字段按写入上下文分到不同缓存行",
+}
+
+
+def scalar_globals(ctx: AnalysisContext) -> set:
+    """文件作用域的标量 / 原子变量名"""
+    return ctx.cached("counters.globals", lambda: set(_SCALAR_GLOBAL.findall(ctx.source)))
+
+
+def per_cpu_vars(ctx: AnalysisContext, func: str) -> set:
+    """函数中指向 per-CPU 数据的局部指针"""
+    return set(_PER_CPU_PTR.findall(function_body(ctx, func)))
+
+
+def target_name(ctx: AnalysisContext, func: str, expr: str) -> Tuple[str, str]:
+    """
+    更新对象的表达式 -> (显示名, 基变量)
+
+    &priv->stats.rx_drops（priv 为 struct nic_priv *）-> "nic_priv.stats.rx_drops"
+    """
+    text = re.sub(r'\s+', '', expr).lstrip('&')
+    m = re.match(r'^(\w+)((?:->|\.)\S*)?$', text)
+    if not m:
+        return text, ""
+    var, rest = m.group(1), m.group(2) or ""
+    struct = var_types(ctx, func).get(var)
+    if struct and rest:
+        return struct + '.' + rest[2 if rest.startswith('->') else 1:], var
+    return text, var
+
+
+def function_updates(ctx: AnalysisContext, func: str) -> List[Dict]:
+    """函数中的计数 / 共享状态更新（缓存）"""
+    cache = ctx.cached("counters.updates", dict)
+    if func in cache:
+        return cache[func]
+    per_cpu = per_cpu_vars(ctx, func)
+    globals_ = scalar_globals(ctx)
+    updates = []
+
+    def add(cls: str, target: str, line: int, op: str, call: str = "") -> None:
+        updates.append({"class": cls, "target": target, "line": line, "op": op, "call": call})
+
+    # 字段写: priv->x++ / dev->stats.tx_packets += len / atomic_inc(&priv->drops)
+    for access in field_writes(ctx).get(func, []):
+        target = f"{access.struct}.{access.field}" if access.struct else f"{access.var}->{access.field}"
+        if access.var in per_cpu:
+            if access.kind in ("write", "rmw"):
+                add("per_cpu", target, access.line, access.kind)
+        elif access.kind in ("write", "rmw"):
+            add("plain_shared", target, access.line, access.kind)
+        elif access.kind == "atomic" and ATOMIC_COUNTER.match(access.call):
+            add("shared_atomic", target, access.line, "atomic", access.call)
+
+    # 调用形式的更新: this_cpu_inc(...)、u64_stats_inc(&stats->rx)、atomic_inc(&global)
+    for site in body_metrics(ctx, func).calls:
+        args = split_args(site.args)
+        if not args:
+            continue
+        if PER_CPU_CALL.match(site.name):
+            add("per_cpu", target_name(ctx, func, args[0])[0], site.line, "call", site.name)
+        elif U64_STATS.match(site.name):
+            target, var = target_name(ctx, func, args[0])
+            add("per_cpu" if var in per_cpu else "plain_shared", target, site.line, "u64_stats",
+                site.name)
+        elif ATOMIC_COUNTER.match(site.name):
+            target, var = target_name(ctx, func, args[0])
+            if target == var and var in globals_:
+                add("shared_atomic", target, site.line, "atomic", site.name)
+
+    # 全局标量: drops++ / total += len / last = jiffies
+    if globals_:
+        body = function_body(ctx, func)
+        definition = ctx.parse_result.functions[func]
+        locals_ = {p.name for p in definition.params}
+        base = body_line(definition) - 1
+        lines = LineIndex(body)
+        names = '|'.join(re.escape(g) for g in sorted(globals_ - locals_))
+        if names:
+            pattern = rf'(?<![\w.>])(?:(?:\+\+|--)\s*({names})\b|({names})\s*(\+\+|--|[-+|&^]?=(?!=)))'
+            for m in re.finditer(pattern, body):
+                name = m.group(1) or m.group(2)
+                op = "write" if m.group(3) == "=" else "rmw"
+                add("plain_shared", name, base + lines.line_of(m.start()), op)
+    cache[func] = updates
+    return updates
+
+
+def hot_entries(ctx: AnalysisContext) -> list:
+    """硬中断、NAPI、发送/接收等每个包都会执行的入口"""
+    return [e for e in entry_points(ctx) if e.hot or is_per_io(e) or e.kind == "irq"]
+
+
+@AnalysisRegistry.register
+class CounterPass(AnalysisPass):
+    """热路径上的共享计数器与 per-CPU 候选"""
+
+    name = "counters"
+    description = "计数器热点：共享原子 / 普通共享写 / per-CPU 分类，共享的按到中断/收发入口的距离排序"
+    needs = AnalysisPass.needs | {BackendCapability.PARSE_STRUCTS, BackendCapability.PARSE_UNIONS,
+                                  BackendCapability.PARSE_TYPEDEFS}
+
+    def run(self, ctx: AnalysisContext) -> Dict:
+        contexts = contexts_by_function(ctx)
+        hot = hot_entries(ctx)
+        # 函数 -> (到最近热入口的距离, 可到达它的热入口)
+        distance: Dict[str, Tuple[int, List[str]]] = {}
+        for entry in hot:
+            for func, depth in reachable(ctx, entry.func).items():
+                best, labels = distance.setdefault(func, (depth, []))
+                labels.append(entry.label)
+                if depth < best:
+                    distance[func] = (depth, labels)
+
+        counters: Dict[Tuple[str, str], Dict] = {}
+        for func in ctx.parse_result.functions:
+            for update in function_updates(ctx, func):
+                key = (update["class"], update["target"])
+                record = counters.get(key)
+                if record is None:
+                    record = counters[key] = {
+                        "target": update["target"], "class": update["class"],
+                        "stat": bool(_STAT_NAME.search(update["target"].rsplit('.', 1)[-1])),
+                        "sites": [], "contexts": [], "hot_entries": [], "distance": None,
+                    }
+                record["sites"].append(dict(update, func=func))
+                for entry in contexts.get(func, []):
+                    if entry.label not in record["contexts"]:
+                        record["contexts"].append(entry.label)
+                if func in distance:
+                    depth, labels = distance[func]
+                    if record["distance"] is None or depth < record["distance"]:
+                        record["distance"] = depth
+                    record["hot_entries"].extend(l for l in labels if l not in record["hot_entries"])
+
+        for record in counters.values():
+            for site in record["sites"]:
+                del site["class"], site["target"]
+            record["multi_context"] = len(record["contexts"]) > 1
+            if record["class"] in ADVICE:
+                record["advice"] = ADVICE[record["class"]]
+
+        def rank(r: Dict) -> tuple:
+            return (r["class"] == "per_cpu", r["distance"] is None, r["distance"] or 0,
+                    not r["stat"], -len(r["hot_entries"]), -len(r["sites"]), r["target"])
+
+        ranked = sorted(counters.values(), key=rank)
+        candidates = [r for r in ranked if r["class"] != "per_cpu" and r["distance"] is not None]
+        summary = {cls: sum(1 for r in ranked if r["class"] == cls) for cls in CLASSES}
+        summary.update(candidates=len(candidates), hot_entries=len(hot))
+        return {
+            "hot_entries": [e.label for e in hot],
+            "counters": ranked,
+            "candidates": [r["target"] for r in candidates],
+            "summary": summary,
+        }
+
+    def format_text(self, result: Dict) -> str:
+        s = result["summary"]
+        out = [f"\n🧮 计数器: 共享原子 {s['shared_atomic']}, 普通共享写 {s['plain_shared']}, "
+               f"per-CPU {s['per_cpu']}；热路径上的 per-CPU 候选 {s['candidates']} 个"]
+        for r in result["counters"]:
+            if r["class"] == "per_cpu" or r["distance"] is None:
+                continue
+            first = r["sites"][0]
+            stat = " stat" if r["stat"] else ""
+            out.append(f"   [{r['class']}{stat}] {r['target']}  距离 {r['distance']}  "
+                       f"{first['func']}() 行 {first['line']}  ({', '.join(r['hot_entries'])})")
+        return "\n".join(out)
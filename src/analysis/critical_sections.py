@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""
+临界区范围分析
+
+对每个加锁区间（spin_lock / _irq / _irqsave / _bh、raw_spin_lock、read/write_lock、
+mutex_lock 等，见 locks.py）报告持锁期间做了什么：
+- 区间大小：行数、调用点数
+- 区间内的调用，以及经文件内调用图传递到达的被调函数和内核 API
+- 区间内的循环（及被调函数中的循环数）、MMIO 访问
+- 静态开销（权重同 hot-path，只计区间内的循环嵌套）
+
+关中断的区间（_irq / _irqsave、local_irq_save / disable）排在最前，
+其中有循环、MMIO 读或开销超过阈值的标为高风险。
+"""
+
+from typing import Dict, List
+
+from .base import AnalysisContext, AnalysisPass, AnalysisRegistry
+from .callgraph import reachable
+from .hot_path import CostModel
+from .locks import LockRegion, lock_regions
+from .metrics import body_metrics
+
+
+# 关中断区间的开销超过该值即视为高风险
+LONG_HOLD_COST = 64
+
+
+def region_record(ctx: AnalysisContext, model: CostModel, region: LockRegion) -> Dict:
+    """单个临界区的报告"""
+    functions = ctx.parse_result.functions
+    metrics = body_metrics(ctx, region.func)
+    lock_site = next((c for c in metrics.calls if c.pos == region.start), None)
+    base_depth = lock_site.loop_depth if lock_site else 0
+
+    loops = [l for l in metrics.loops if region.start < l.start < region.end]
+    direct = list(dict.fromkeys(c.name for c in region.calls))
+    callees: Dict[str, int] = {}
+    for site in region.calls:
+        if site.name in functions and site.name != region.func:
+            for func, depth in reachable(ctx, site.name).items():
+                if func != region.func and depth + 1 < callees.get(func, depth + 2):
+                    callees[func] = depth + 1
+
+    external = {c.name for c in region.calls if c.name not in functions}
+    mmio_reads = sum(1 for c in region.calls if c.is_mmio_read)
+    mmio_writes = sum(1 for c in region.calls if c.is_mmio_write)
+    callee_loops = 0
+    for func in callees:
+        callee_metrics = body_metrics(ctx, func)
+        external.update(c.name for c in callee_metrics.calls if c.name not in functions)
+        mmio_reads += callee_metrics.mmio_reads
+        mmio_writes += callee_metrics.mmio_writes
+        callee_loops += len(callee_metrics.loops)
+
+    cost = sum(model.site_cost(c, max(c.loop_depth - base_depth, 0)) for c in region.calls)
+    long_hold = bool(loops or callee_loops or mmio_reads or cost > LONG_HOLD_COST)
+    return {
+        "func": region.func,
+        "lock_call": region.lock_call,
+        "unlock_call": region.unlock_call,
+        "lock": region.lock,
+        "kind": region.kind,
+        "irqs_off": region.irqs_off,
+        "atomic": region.atomic,
+        "line": region.line,
+        "end_line": region.end_line,
+        "lines": region.end_line - region.line + 1,
+        "call_sites": len(region.calls),
+        "unlocks": region.unlocks,
+        "pairing": region.pairing,
+        "calls": direct,
+        "callees": sorted(callees, key=lambda f: (callees[f], f)),
+        "external_calls": sorted(external),
+        "loops": [{"kind": l.kind, "line": l.line, "depth": l.depth - base_depth, "empty": l.empty}
+                  for l in loops],
+        "callee_loops": callee_loops,
+        "mmio_reads": mmio_reads,
+        "mmio_writes": mmio_writes,
+        "cost": cost,
+        "severity": "high" if region.irqs_off and long_hold else
+                    "medium" if region.atomic and long_hold else "low",
+    }
+
+
+@AnalysisRegistry.register
+class CriticalSectionPass(AnalysisPass):
+    """加锁区间内的调用、循环和开销"""
+
+    name = "critical-sections"
+    description = "临界区范围：持锁区间的大小、区间内（含传递）的调用和循环，关中断区间优先"
+
+    def run(self, ctx: AnalysisContext) -> Dict:
+        model = CostModel(ctx)
+        records: List[Dict] = []
+        for regions in lock_regions(ctx).values():
+            records.extend(region_record(ctx, model, r) for r in regions)
+        severity = {"high": 0, "medium": 1, "low": 2}
+        records.sort(key=lambda r: (severity[r["severity"]], not r["irqs_off"], -r["cost"],
+                                    r["func"], r["line"]))
+        return {
+            "regions": records,
+            "summary": {
+                "regions": len(records),
+                "irqs_off": sum(1 for r in records if r["irqs_off"]),
+                "high": sum(1 for r in records if r["severity"] == "high"),
+                "with_loops": sum(1 for r in records if r["loops"] or r["callee_loops"]),
+                "max_cost": max((r["cost"] for r in records), default=0),
+                "pairing": sorted({r["pairing"] for r in records}),
+            },
+        }
+
+    def format_text(self, result: Dict) -> str:
+        summary = result["summary"]
+        out = [f"\n🔒 临界区: {summary['regions']} 个 (关中断 {summary['irqs_off']}, "
+               f"高风险 {summary['high']}, 含循环 {summary['with_loops']})"]
+        marks = {"high": "❌", "medium": "⚠️", "low": "  "}
+        for r in result["regions"]:
+            out.append(f"   {marks[r['severity']]} {r['func']}() 行 {r['line']}-{r['end_line']}  "
+                       f"{r['lock_call']}({r['lock']})  开销 {r['cost']}  调用 {r['call_sites']}  "
+                       f"循环 {len(r['loops'])}+{r['callee_loops']}  MMIO 读/写 "
+                       f"{r['mmio_reads']}/{r['mmio_writes']}")
+            if r["callees"]:
+                out.append(f"        经由: {', '.join(r['callees'])}")
+        return "\n".join(out)
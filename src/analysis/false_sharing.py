@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+"""
+伪共享候选检测
+
+结合三类信息：
+- 执行上下文：异步处理函数（irq / tasklet / timer / work / kthread ...）和操作表回调，
+  以及从它们可到达的文件内函数
+- 字段写操作：priv->field = / ++ / += / atomic_*(&priv->field) / spin_lock(&priv->lock)
+- 结构体布局：字段所在的 64 字节缓存行
+
+同一结构体中位于同一缓存行、却由不同执行上下文写入的两个不同字段即为伪共享候选
+（例如中断处理函数里自增的计数器紧挨着工作队列更新的状态字段），
+这会导致缓存行在 CPU 之间来回迁移。同一字段被多个上下文写入属于真共享，单独列出；
+字节范围重叠的两次写（整个内嵌结构体与其子成员）同样是真共享，不作为候选对。
+"""
+
+from typing import Dict, List, Optional, Set, Tuple
+
+from .base import AnalysisContext, AnalysisPass, AnalysisRegistry
+from .callgraph import contexts_by_function, entry_points
+from .fields import field_writes
+from .layout import LayoutEngine, MemberLayout, RecordLayout, layout_engine
+
+
+def _nested_members(engine: LayoutEngine, member: MemberLayout) -> List[MemberLayout]:
+    """成员的子成员：内联定义的直接取，按值内嵌的具名结构体（struct my_stats stats;）查布局"""
+    if member.members:
+        return member.members
+    if member.count != 1 or member.estimated or '*' in member.type_name:
+        return []
+    nested = engine.layout(member.type_name)
+    return nested.members if nested else []
+
+
+def _locate(engine: LayoutEngine, layout: RecordLayout,
+            path: List[str]) -> Optional[Tuple[str, int, int]]:
+    """字段路径 -> (显示名, 偏移, 大小)；内嵌结构体按路径细化到子成员，偏移逐层累加"""
+    members = layout.members
+    offset = 0
+    names: List[str] = []
+    found: Optional[MemberLayout] = None
+    for depth, part in enumerate(path):
+        match = next((m for m in members if m.name == part), None)
+        if match is None:
+            # 匿名内嵌 struct/union 的成员直接挂在外层名字下
+            for m in members:
+                if not m.name and m.members:
+                    match = next((s for s in m.members if s.name == part), None)
+                    if match:
+                        offset += m.offset
+                        break
+        if match is None:
+            break
+        found = match
+        offset += match.offset
+        names.append(part)
+        if depth + 1 == len(path):
+            break
+        members = _nested_members(engine, match)
+        if not members:
+            break
+    if found is None:
+        return None
+    return '.'.join(names), offset, max(found.size, 1)
+
+
+@AnalysisRegistry.register
+class FalseSharingPass(AnalysisPass):
+    """同一缓存行上被不同执行上下文写入的字段"""
+
+    name = "false-sharing"
+    description = "伪共享候选：同一缓存行中由不同执行上下文写入的字段"
+    requires = ("layout",)
+
+    def run(self, ctx: AnalysisContext) -> Dict:
+        engine = layout_engine(ctx)
+        cacheline = engine.abi.cacheline
+        contexts = contexts_by_function(ctx)
+
+        # (结构体, 字段) -> {上下文标签: [写操作]}
+        writers: Dict[Tuple[str, str], Dict[str, List[Dict]]] = {}
+        spans: Dict[Tuple[str, str], Tuple[int, int]] = {}
+        atomic_labels: Set[str] = {e.label for e in entry_points(ctx) if e.atomic}
+        for func, accesses in field_writes(ctx).items():
+            for access in accesses:
+                if not access.struct or func not in contexts:
+                    continue
+                layout = engine.layout(access.struct)
+                located = layout and _locate(engine, layout, access.path)
+                if not located:
+                    continue
+                field_name, offset, size = located
+                key = (access.struct, field_name)
+                spans[key] = (offset, size)
+                for entry in contexts[func]:
+                    writers.setdefault(key, {}).setdefault(entry.label, []).append(
+                        {"func": func, "line": access.line, "kind": access.kind})
+
+        # 按 (结构体, 缓存行) 分组
+        lines: Dict[Tuple[str, int], List[Tuple[str, str]]] = {}
+        for key, (offset, size) in spans.items():
+            for line in range(offset // cacheline, (offset + size - 1) // cacheline + 1):
+                lines.setdefault((key[0], line), []).append(key)
+
+        candidates = []
+        for (struct, line), keys in sorted(lines.items()):
+            keys.sort(key=lambda k: spans[k][0])
+            pairs = []
+            for i, a in enumerate(keys):
+                for b in keys[i + 1:]:
+                    if _overlaps(a[1], spans[a], b[1], spans[b]):
+                        continue
+                    ctx_a, ctx_b = set(writers[a]), set(writers[b])
+                    if any(x != y for x in ctx_a for y in ctx_b):
+                        pairs.append((a[1], b[1]))
+            if not pairs:
+                continue
+            involved = sorted({n for p in pairs for n in p}, key=lambda n: spans[(struct, n)][0])
+            labels = {label for n in involved for label in writers[(struct, n)]}
+            candidates.append({
+                "struct": struct,
+                "cacheline": line,
+                "severity": "high" if labels & atomic_labels else "medium",
+                "contexts": sorted(labels),
+                "pairs": [list(p) for p in pairs],
+                "fields": [{
+                    "name": n,
+                    "offset": spans[(struct, n)][0],
+                    "size": spans[(struct, n)][1],
+                    "writers": [{"context": label, **w}
+                                for label, ws in sorted(writers[(struct, n)].items())
+                                for w in _dedupe(ws)],
+                } for n in involved],
+            })
+        candidates.sort(key=lambda c: (c["severity"] != "high", c["struct"], c["cacheline"]))
+
+        true_sharing = [{"struct": s, "field": f, "contexts": sorted(w)}
+                        for (s, f), w in sorted(writers.items()) if len(w) > 1]
+        return {
+            "cacheline": cacheline,
+            "entry_points": [e.to_dict() for e in entry_points(ctx)],
+            "candidates": candidates,
+            "true_sharing": true_sharing,
+            "summary": {
+                "candidates": len(candidates),
+                "high": sum(1 for c in candidates if c["severity"] == "high"),
+                "fields_written": len(spans),
+                "true_sharing": len(true_sharing),
+            },
+        }
+
+    def format_text(self, result: Dict) -> str:
+        summary = result["summary"]
+        out = [f"\n🔀 伪共享候选: {summary['candidates']} 个缓存行 "
+               f"(高风险 {summary['high']}), 多上下文写同一字段 {summary['true_sharing']} 个"]
+        for c in result["candidates"]:
+            icon = "🔴" if c["severity"] == "high" else "🟡"
+            out.append(f"   {icon} struct {c['struct']} 缓存行 {c['cacheline']}:")
+            for f in c["fields"]:
+                contexts = ", ".join(sorted({w["context"] for w in f["writers"]}))
+                out.append(f"       +{f['offset']:<5} {f['name']:<24} ← {contexts}")
+            out.append("       建议: 按写入上下文分组字段，或用 ____cacheline_aligned_in_smp 分到不同缓存行")
+        return "\n".join(out)
+
+
+def _overlaps(name_a: str, span_a: Tuple[int, int], name_b: str, span_b: Tuple[int, int]) -> bool:
+    """
+    两次写是否落在相同字节上（priv->stats 与 priv->stats.rx_packets）
+
+    这是真共享而不是伪共享，不构成候选对。
+    """
+    if name_b.startswith(name_a + '.') or name_a.startswith(name_b + '.'):
+        return True
+    (off_a, size_a), (off_b, size_b) = span_a, span_b
+    return off_a < off_b + size_b and off_b < off_a + size_a
+
+
+def _dedupe(writes: List[Dict]) -> List[Dict]:
+    """同一函数同一行的重复写只保留一次"""
+    seen = set()
+    result = []
+    for w in writes:
+        key = (w["func"], w["line"])
+        if key not in seen:
+            seen.add(key)
+            result.append(w)
+    return result
@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""
+结构体字段访问提取
+
+从函数体中找出对结构体字段的写操作：
+- 赋值 / 复合赋值: priv->state = x; priv->stats.rx_bytes += len;
+- 自增自减:       priv->tx_count++; --priv->pending;
+- 原子/位操作和加锁（传入字段地址）: atomic_inc(&priv->refs); spin_lock(&priv->lock);
+
+变量的结构体类型取自函数参数、局部指针声明和文件作用域的结构体变量。
+经过第二个 '->' 的访问写的是另一个对象，不计入本变量的结构体。
+"""
+
+import re
+from dataclasses import dataclass
+from typing import Dict, List, Optional
+
+from backends import LineIndex
+
+from .base import AnalysisContext
+from .callgraph import body_line, function_body
+
+
+# 以字段地址为参数、会写该字段所在缓存行的调用
+WRITE_CALLS = re.compile(
+    r'^(?:atomic(?:64|_long)?_(?:inc|dec|add|sub|set|xchg|cmpxchg|and|or|andnot|fetch_\w+|'
+    r'\w+_return|\w+_and_test|try_cmpxchg)\w*'
+    r'|(?:__)?(?:set|clear|change)_bit|test_and_\w+_bit'
+    r'|refcount_(?:inc|dec|add|sub|set)\w*|kref_(?:get|put)\w*'
+    r'|(?:raw_)?spin_(?:lock|unlock|trylock)\w*|(?:read|write)_(?:lock|unlock)\w*'
+    r'|mutex_(?:lock|unlock|trylock)\w*|down|up|down_\w+|up_\w+'
+    r'|u64_stats_update_\w+|u64_stats_(?:inc|add|set)'
+    r'|this_cpu_(?:inc|dec|add|sub|write)\w*|local_(?:inc|dec|add|sub)\w*)$'
+)
+
+LOCK_CALLS = re.compile(r'(?:spin_|read_|write_|mutex_|^down|^up)')
+
+# 变量.字段[.字段...] 或 变量->字段[.字段...]，字段可带下标
+_ACCESS = re.compile(
+    r'(?P<pre>\+\+|--)?\s*(?P<addr>&\s*)?\b(?P<var>[A-Za-z_]\w*)'
+    r'(?P<path>(?:\s*(?:->|\.)\s*[A-Za-z_]\w*(?:\s*\[[^\[\]]*\])*)+)'
+    r'(?=\s*(?P<op>\+\+|--|[-+*/%&|^]?=(?!=)|<<=|>>=)?)'
+)
+_HOP = re.compile(r'\s*(->|\.)\s*([A-Za-z_]\w*)')
+_CALL_BEFORE = re.compile(r'(\w+)\s*\((?:[^()]*,)?\s*$')
+_STRUCT_GLOBAL = re.compile(
+    r'^(?:static\s+)?(?:struct|union)\s+(\w+)\s+(\w+)\s*(?:\[[^\]]*\])?\s*;', re.M)
+
+
+@dataclass
+class FieldAccess:
+    """一次字段写操作"""
+    func: str
+    var: str
+    struct: str         # 变量的结构体类型名（未知时为空）
+    path: List[str]     # 字段路径: ["stats", "rx_packets"]
+    kind: str           # "write" / "rmw"（自增、复合赋值）/ "atomic" / "lock"
+    line: int
+    call: str = ""      # atomic / lock 时的调用名
+
+    @property
+    def field(self) -> str:
+        return '.'.join(self.path)
+
+    def to_dict(self) -> Dict:
+        result = {"func": self.func, "var": self.var, "struct": self.struct,
+                  "field": self.field, "kind": self.kind, "line": self.line}
+        if self.call:
+            result["call"] = self.call
+        return result
+
+
+def _type_names(ctx: AnalysisContext) -> Dict[str, str]:
+    """typedef 名 -> 结构体名（typedef struct {...} foo_t）"""
+    def build() -> Dict[str, str]:
+        names = {}
+        for table in (ctx.parse_result.structs, ctx.parse_result.unions):
+            for name, record in table.items():
+                if record.typedef_name:
+                    names[record.typedef_name] = name
+        for alias, typedef in ctx.parse_result.typedefs.items():
+            m = re.match(r'(?:struct|union)\s+(\w+)$', typedef.original.strip())
+            if m:
+                names.setdefault(alias, m.group(1))
+        return names
+    return ctx.cached("fields.type_names", build)
+
+
+def struct_of_type(ctx: AnalysisContext, type_name: str) -> Optional[str]:
+    """'const struct foo *' / 'foo_t *' -> 'foo'"""
+    m = re.search(r'\b(?:struct|union)\s+(\w+)', type_name)
+    if m:
+        return m.group(1)
+    for word in re.findall(r'\w+', type_name):
+        if word in _type_names(ctx):
+            return _type_names(ctx)[word]
+    return None
+
+
+def global_vars(ctx: AnalysisContext) -> Dict[str, str]:
+    """文件作用域的结构体变量 -> 结构体名（不含带初始化的操作表）"""
+    return ctx.cached("fields.globals", lambda: {
+        m.group(2): m.group(1) for m in _STRUCT_GLOBAL.finditer(ctx.source)})
+
+
+def var_types(ctx: AnalysisContext, func_name: str) -> Dict[str, str]:
+    """函数内变量 -> 结构体名（参数、局部指针、全局结构体变量）"""
+    cache = ctx.cached("fields.var_types", dict)
+    if func_name in cache:
+        return cache[func_name]
+    func = ctx.parse_result.functions[func_name]
+    types = dict(global_vars(ctx))
+    for param in func.params:
+        struct = struct_of_type(ctx, param.type_name)
+        if struct and '*' in param.type_name:
+            types[param.name] = struct
+    aliases = '|'.join(re.escape(a) for a in _type_names(ctx))
+    type_re = r'(?:struct|union)\s+\w+' + (f'|\\b(?:{aliases})' if aliases else '')
+    for m in re.finditer(rf'({type_re})\s*\*\s*(\w+)\s*[=;,)]', function_body(ctx, func_name)):
+        struct = struct_of_type(ctx, m.group(1))
+        if struct:
+            types[m.group(2)] = struct
+    cache[func_name] = types
+    return types
+
+
+def field_writes(ctx: AnalysisContext) -> Dict[str, List[FieldAccess]]:
+    """函数 -> 字段写操作（缓存）"""
+    def build() -> Dict[str, List[FieldAccess]]:
+        return {name: _scan_writes(ctx, name) for name in ctx.parse_result.functions}
+    return ctx.cached("fields.writes", build)
+
+
+def _scan_writes(ctx: AnalysisContext, func_name: str) -> List[FieldAccess]:
+    body = function_body(ctx, func_name)
+    if not body:
+        return []
+    types = var_types(ctx, func_name)
+    base = body_line(ctx.parse_result.functions[func_name]) - 1
+    lines = LineIndex(body)
+    writes = []
+    for m in _ACCESS.finditer(body):
+        var = m.group('var')
+        hops = _HOP.findall(m.group('path'))
+        # 只保留同一对象内的字段路径（第一个 hop 之后遇到 '->' 截断）
+        path = [hops[0][1]]
+        for op, name in hops[1:]:
+            if op == '->':
+                path = None
+                break
+            path.append(name)
+        if path is None:
+            continue
+
+        kind, call = None, ""
+        if m.group('addr'):
+            call_match = _CALL_BEFORE.search(body, max(0, m.start() - 160), m.start())
+            if call_match and WRITE_CALLS.match(call_match.group(1)):
+                call = call_match.group(1)
+                kind = "lock" if LOCK_CALLS.search(call) and 'bit' not in call else "atomic"
+        elif m.group('pre'):
+            kind = "rmw"
+        else:
+            op = m.group('op')
+            if op in ('++', '--') or (op and op != '='):
+                kind = "rmw"
+            elif op == '=':
+                kind = "write"
+        if kind is None:
+            continue
+        writes.append(FieldAccess(func=func_name, var=var, struct=types.get(var, ""),
+                                  path=path, kind=kind, line=base + lines.line_of(m.start()),
+                                  call=call))
+    return writes
@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+"""
+热路径静态开销估算
+
+从延迟敏感的入口（硬中断处理函数、NAPI poll、ndo_start_xmit、
+file_operations.read / write）沿文件内调用图展开，为每个函数估算静态开销：
+
+    自身开销 = Σ 调用点权重 × LOOP_FACTOR ^ 循环嵌套深度
+    累计开销 = 自身开销 + Σ 文件内调用点 × LOOP_FACTOR ^ 深度 × 被调函数累计开销
+
+调用点权重：MMIO 读 10（非 posted，需要等待设备）、MMIO 写 3、内核 API 调用 2、
+文件内函数调用 1。循环按 LOOP_FACTOR 次迭代估算。递归调用只计一次。
+
+数值只用于在同一驱动内排序、挑出优先审查的路径，不对应具体的时间。
+"""
+
+from typing import Dict, List, Optional, Set
+
+from .base import AnalysisContext, AnalysisPass, AnalysisRegistry
+from .callgraph import entry_points, reachable
+from .metrics import BodyMetrics, body_metrics
+
+
+WEIGHTS = {
+    "mmio_read": 10,
+    "mmio_write": 3,
+    "external_call": 2,
+    "internal_call": 1,
+}
+LOOP_FACTOR = 8
+TOP_FUNCTIONS = 10
+
+
+def _site_weight(site, internal: bool) -> int:
+    if internal:
+        return WEIGHTS["internal_call"]
+    if site.is_mmio_read:
+        return WEIGHTS["mmio_read"]
+    if site.is_mmio_write:
+        return WEIGHTS["mmio_write"]
+    return WEIGHTS["external_call"]
+
+
+class CostModel:
+    """按函数缓存自身/累计开销"""
+
+    def __init__(self, ctx: AnalysisContext):
+        self.ctx = ctx
+        self.functions = ctx.parse_result.functions
+        self._self: Dict[str, int] = {}
+        self._inclusive: Dict[str, int] = {}
+        self._active: Set[str] = set()
+
+    def metrics(self, func: str) -> BodyMetrics:
+        return body_metrics(self.ctx, func)
+
+    def self_cost(self, func: str) -> int:
+        if func not in self._self:
+            self._self[func] = sum(
+                _site_weight(c, c.name in self.functions) * LOOP_FACTOR ** c.loop_depth
+                for c in self.metrics(func).calls)
+        return self._self[func]
+
+    def inclusive(self, func: str) -> int:
+        """累计开销（递归调用的回边按 0 计）"""
+        if func in self._inclusive:
+            return self._inclusive[func]
+        if func in self._active:
+            return 0
+        self._active.add(func)
+        total = self.self_cost(func)
+        for site in self.metrics(func).calls:
+            if site.name in self.functions and site.name != func:
+                total += LOOP_FACTOR ** site.loop_depth * self.inclusive(site.name)
+        self._active.discard(func)
+        self._inclusive[func] = total
+        return total
+
+    def site_cost(self, site, loop_depth: Optional[int] = None) -> int:
+        """
+        一个调用点的累计开销（文件内函数含被调函数的累计开销）
+
+        Args:
+            loop_depth: 计入的循环嵌套深度（默认为调用点在函数内的深度）
+        """
+        internal = site.name in self.functions
+        cost = _site_weight(site, internal)
+        if internal:
+            cost += self.inclusive(site.name)
+        depth = site.loop_depth if loop_depth is None else loop_depth
+        return LOOP_FACTOR ** depth * cost
+
+    def heaviest_path(self, root: str) -> List[str]:
+        """每一步选累计开销贡献最大的被调函数"""
+        path = [root]
+        seen = {root}
+        while True:
+            best, best_cost = None, 0
+            for site in self.metrics(path[-1]).calls:
+                if site.name in self.functions and site.name not in seen:
+                    cost = LOOP_FACTOR ** site.loop_depth * self.inclusive(site.name)
+                    if cost > best_cost:
+                        best, best_cost = site.name, cost
+            if best is None:
+                return path
+            path.append(best)
+            seen.add(best)
+
+    def function_record(self, func: str, depth: Optional[int] = None) -> Dict:
+        metrics = self.metrics(func)
+        loc = self.functions[func].location
+        record = {
+            "func": func,
+            "line": loc.line if loc else 0,
+            "self_cost": self.self_cost(func),
+            "inclusive_cost": self.inclusive(func),
+            "loops": len(metrics.loops),
+            "max_loop_depth": metrics.max_loop_depth,
+            "external_calls": sum(1 for c in metrics.calls if c.name not in self.functions),
+            "mmio_reads": metrics.mmio_reads,
+            "mmio_writes": metrics.mmio_writes,
+        }
+        if depth is not None:
+            record["depth"] = depth
+        return record
+
+
+@AnalysisRegistry.register
+class HotPathPass(AnalysisPass):
+    """延迟敏感入口的静态开销排名"""
+
+    name = "hot-path"
+    description = "热路径开销估算：从 IRQ / NAPI / xmit / read / write 入口展开的排名"
+
+    def run(self, ctx: AnalysisContext) -> Dict:
+        model = CostModel(ctx)
+        entries = []
+        on_hot_path: Dict[str, Dict] = {}
+        for entry in entry_points(ctx):
+            if not entry.hot:
+                continue
+            depths = reachable(ctx, entry.func)
+            records = [model.function_record(f, d) for f, d in depths.items()]
+            for r in records:
+                agg = on_hot_path.setdefault(r["func"], dict(r, entries=[]))
+                agg["entries"].append(entry.label)
+                agg["depth"] = min(agg["depth"], r["depth"])
+            records.sort(key=lambda r: (-r["self_cost"], r["depth"], r["func"]))
+            entries.append({
+                "entry": entry.label,
+                "kind": entry.kind,
+                "func": entry.func,
+                "cost": model.inclusive(entry.func),
+                "call_depth": max(depths.values()),
+                "functions": len(depths),
+                "max_loop_depth": max(r["max_loop_depth"] for r in records),
+                "external_calls": sum(r["external_calls"] for r in records),
+                "mmio_reads": sum(r["mmio_reads"] for r in records),
+                "mmio_writes": sum(r["mmio_writes"] for r in records),
+                "heaviest_path": model.heaviest_path(entry.func),
+                "hot_functions": records[:TOP_FUNCTIONS],
+            })
+        entries.sort(key=lambda e: (-e["cost"], e["entry"]))
+        ranking = sorted(on_hot_path.values(),
+                         key=lambda r: (-r["self_cost"] * len(r["entries"]), r["depth"], r["func"]))
+        return {
+            "weights": dict(WEIGHTS, loop_factor=LOOP_FACTOR),
+            "entries": entries,
+            "ranking": ranking,
+            "summary": {
+                "entries": len(entries),
+                "functions_on_hot_paths": len(ranking),
+                "max_cost": entries[0]["cost"] if entries else 0,
+            },
+        }
+
+    def format_text(self, result: Dict) -> str:
+        out = [f"\n🔥 热路径开销 ({result['summary']['entries']} 个入口, "
+               f"{result['summary']['functions_on_hot_paths']} 个函数):"]
+        for e in result["entries"]:
+            out.append(f"   {e['entry']:<36} 开销 {e['cost']:>8}  深度 {e['call_depth']}  "
+                       f"循环嵌套 {e['max_loop_depth']}  API {e['external_calls']}  "
+                       f"MMIO 读/写 {e['mmio_reads']}/{e['mmio_writes']}")
+            out.append(f"     最重路径: {' -> '.join(e['heaviest_path'])}")
+        if result["ranking"]:
+            out.append("   优先审查的函数:")
+            for r in result["ranking"][:TOP_FUNCTIONS]:
+                out.append(f"     {r['func']:<32} 自身 {r['self_cost']:>6}  累计 {r['inclusive_cost']:>8}"
+                           f"  ({', '.join(r['entries'])})")
+        return "\n".join(out)
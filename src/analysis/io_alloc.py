@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""
+每次 I/O 的 DMA 映射与内存分配
+
+从每次 I/O 都会执行的入口出发（ndo_start_xmit、NAPI poll、URB 完成回调、
+usb_serial_driver.write、blk_mq_ops.queue_rq / complete、tty_operations.write），
+沿文件内调用图找出分配/映射及其释放：
+
+| 类别 | 获取 | 释放 |
+|------|------|------|
+| dma_map | dma_map_single / page / sg | dma_unmap_* |
+| dma_alloc | dma_alloc_coherent、dma_pool_alloc | dma_free_coherent、dma_pool_free |
+| kmalloc | kmalloc / kzalloc / kcalloc / kmemdup | kfree |
+| slab | kmem_cache_alloc / zalloc | kmem_cache_free |
+| skb | alloc_skb / netdev_alloc_skb / napi_alloc_skb ... | kfree_skb / consume_skb ... |
+| page | alloc_pages / dev_alloc_pages / __get_free_pages | __free_pages / put_page |
+| urb | usb_alloc_urb | usb_free_urb |
+
+模式表 PATTERNS 是声明式的，新增类别只需加一行。结果按到入口的调用深度排序
+（离入口越近，越确定是每次 I/O 都执行），同一 I/O 路径上既分配又释放的标为 churn，
+提示可以改为预分配 / 对象池 / 预映射的环形缓冲区。
+"""
+
+import re
+from dataclasses import dataclass
+from typing import Dict, List, Optional, Tuple
+
+from .base import AnalysisContext, AnalysisPass, AnalysisRegistry
+from .callgraph import EntryPoint, call_chain, entry_points, reachable
+from .metrics import body_metrics
+
+
+@dataclass(frozen=True)
+class ResourcePattern:
+    """一类资源的获取/释放调用"""
+    category: str
+    acquire: 're.Pattern'
+    release: 're.Pattern'
+    advice: str
+
+
+def _names(pattern: str) -> 're.Pattern':
+    return re.compile(rf'^(?:{pattern})$')
+
+
+PATTERNS: List[ResourcePattern] = [
+    ResourcePattern("dma_map",
+                    _names(r'dma_map_(?:single|page|sg|resource)(?:_attrs)?|skb_frag_dma_map|'
+                           r'pci_map_(?:single|page|sg)'),
+                    _names(r'dma_unmap_(?:single|page|sg|resource)(?:_attrs)?|pci_unmap_(?:single|page|sg)'),
+                    "流式 DMA 映射每次 I/O 一次；可改为预映射的环形缓冲区或 page_pool（复用映射）"),
+    ResourcePattern("dma_alloc",
+                    _names(r'dma_(?:z)?alloc_(?:coherent|attrs|noncoherent)|dmam_alloc_coherent|'
+                           r'dma_pool_(?:z)?alloc'),
+                    _names(r'dma_free_(?:coherent|attrs|noncoherent)|dma_pool_free'),
+                    "一致性 DMA 内存分配代价高，应在 probe / open 时预分配"),
+    ResourcePattern("kmalloc",
+                    _names(r'k[mz]alloc(?:_node)?|kcalloc(?:_node)?|kmalloc_array(?:_node)?|krealloc|'
+                           r'kmemdup|kstrdup'),
+                    _names(r'kfree|kfree_sensitive|kvfree'),
+                    "固定大小的对象可改用 kmem_cache 或预分配"),
+    ResourcePattern("slab",
+                    _names(r'kmem_cache_(?:z)?alloc(?:_node)?'),
+                    _names(r'kmem_cache_free'),
+                    "已使用 slab 缓存；确认对象数量有上限"),
+    ResourcePattern("skb",
+                    _names(r'(?:__)?alloc_skb(?:_ip_align)?|(?:__)?(?:netdev|napi|dev)_alloc_skb(?:_ip_align)?|'
+                           r'skb_copy(?:_expand)?|pskb_copy|skb_clone|build_skb|napi_build_skb'),
+                    _names(r'(?:dev_)?kfree_skb(?:_any|_irq)?|consume_skb|napi_consume_skb|'
+                           r'dev_consume_skb_(?:any|irq)'),
+                    "接收路径可用 napi_alloc_skb / build_skb + page_pool 复用缓冲区"),
+    ResourcePattern("page",
+                    _names(r'alloc_pages?(?:_node)?|__get_free_pages?|get_zeroed_page|dev_alloc_pages?|'
+                           r'page_pool_(?:dev_)?alloc_pages?'),
+                    _names(r'__free_pages?|free_pages?|put_page|page_pool_(?:put|recycle)\w*'),
+                    "按页分配可改用 page_pool"),
+    ResourcePattern("urb",
+                    _names(r'usb_alloc_urb'),
+                    _names(r'usb_free_urb'),
+                    "URB 可在 open / probe 时预分配成池（usb_anchor 管理在途 URB）"),
+]
+
+# 每次 I/O 都会调用的操作表回调
+PER_IO_OPS = {
+    ("net_device_ops", "ndo_start_xmit"),
+    ("usb_serial_driver", "write"),
+    ("usb_serial_driver", "read_bulk_callback"),
+    ("usb_serial_driver", "write_bulk_callback"),
+    ("usb_serial_driver", "read_int_callback"),
+    ("blk_mq_ops", "queue_rq"),
+    ("blk_mq_ops", "complete"),
+    ("tty_operations", "write"),
+}
+# 每次 I/O 都会运行的异步上下文
+PER_IO_KINDS = {"napi", "urb"}
+
+TOP_SITES = 10
+
+
+def is_per_io(entry: EntryPoint) -> bool:
+    if entry.kind in PER_IO_KINDS:
+        return True
+    return entry.kind == "ops" and tuple(entry.label.split('.', 1)) in PER_IO_OPS
+
+
+def match_site(name: str) -> Optional[Tuple[ResourcePattern, str]]:
+    """调用名 -> (模式, "acquire" / "release")"""
+    for pattern in PATTERNS:
+        if pattern.acquire.match(name):
+            return pattern, "acquire"
+        if pattern.release.match(name):
+            return pattern, "release"
+    return None
+
+
+def resource_sites(ctx: AnalysisContext, func: str) -> List[Dict]:
+    """函数中的获取/释放调用点（缓存）"""
+    cache = ctx.cached("io_alloc.sites", dict)
+    if func not in cache:
+        sites = []
+        for site in body_metrics(ctx, func).calls:
+            hit = match_site(site.name)
+            if hit:
+                sites.append({"call": site.name, "category": hit[0].category, "op": hit[1],
+                              "line": site.line, "loop_depth": site.loop_depth})
+        cache[func] = sites
+    return cache[func]
+
+
+@AnalysisRegistry.register
+class IoAllocPass(AnalysisPass):
+    """每次 I/O 路径上的分配与 DMA 映射"""
+
+    name = "io-alloc"
+    description = "每次 I/O 的 DMA 映射与内存分配（xmit / NAPI / URB 完成 / queue_rq），按到入口的距离排序"
+
+    def run(self, ctx: AnalysisContext) -> Dict:
+        advice = {p.category: p.advice for p in PATTERNS}
+        entries = [e for e in entry_points(ctx) if is_per_io(e)]
+        sites: Dict[Tuple[str, int, str], Dict] = {}
+        released: Dict[str, set] = {}     # 入口 -> 路径上释放的类别
+        for entry in entries:
+            freed = released.setdefault(entry.label, set())
+            for func, depth in reachable(ctx, entry.func).items():
+                for site in resource_sites(ctx, func):
+                    if site["op"] == "release":
+                        freed.add(site["category"])
+                        continue
+                    key = (func, site["line"], site["call"])
+                    record = sites.get(key)
+                    if record is None:
+                        record = sites[key] = dict(site, func=func, depth=depth, entries=[],
+                                                   path=call_chain(ctx, entry.func, func) + [site["call"]],
+                                                   advice=advice[site["category"]])
+                        del record["op"]
+                    elif depth < record["depth"]:
+                        record["depth"] = depth
+                        record["path"] = call_chain(ctx, entry.func, func) + [site["call"]]
+                    record["entries"].append(entry.label)
+
+        # 同一类别在任一每次 I/O 路径上被释放：每次 I/O 都分配再释放
+        freed_anywhere = set().union(*released.values()) if released else set()
+        for record in sites.values():
+            record["churn"] = record["category"] in freed_anywhere
+        ranked = sorted(sites.values(), key=lambda r: (
+            r["depth"], -r["loop_depth"], not r["churn"], -len(r["entries"]), r["func"], r["line"]))
+
+        by_category: Dict[str, int] = {}
+        for r in ranked:
+            by_category[r["category"]] = by_category.get(r["category"], 0) + 1
+        return {
+            "entries": [e.label for e in entries],
+            "sites": ranked,
+            "released_on_path": {label: sorted(cats) for label, cats in released.items()},
+            "by_category": by_category,
+            "summary": {
+                "entries": len(entries),
+                "sites": len(ranked),
+                "churn": sum(1 for r in ranked if r["churn"]),
+                "in_loops": sum(1 for r in ranked if r["loop_depth"]),
+                "categories": sorted(by_category),
+            },
+        }
+
+    def format_text(self, result: Dict) -> str:
+        summary = result["summary"]
+        out = [f"\n♻️  每次 I/O 的分配/映射: {summary['sites']} 处 (分配又释放 {summary['churn']}, "
+               f"循环内 {summary['in_loops']}), 入口 {summary['entries']} 个"]
+        for r in result["sites"][:TOP_SITES]:
+            churn = " churn" if r["churn"] else ""
+            out.append(f"   [{r['category']}{churn}] {r['func']}() 行 {r['line']} {r['call']}  "
+                       f"深度 {r['depth']}  ({', '.join(r['entries'])})")
+            out.append(f"        {' -> '.join(r['path'])}")
+            out.append(f"        💡 {r['advice']}")
+        return "\n".join(out)
@@ -0,0 +1,616 @@
+#!/usr/bin/env python3
+"""
+结构体内存布局引擎
+
+直接从源码（无需带调试信息的内核构建）计算结构体/联合体的 ABI 布局：
+字段偏移、大小、对齐、空洞、尾部填充和 64 字节缓存行边界，输出 pahole 风格的报告。
+
+- 支持 x86_64 与 arm64（两者都是 LP64，基本类型布局相同，缓存行 64 字节）
+- 内核常用类型按非调试配置（无 lockdep / spinlock 调试）内置大小
+- 遵循 __packed / __aligned(N) / ____cacheline_aligned / __attribute__((...))
+- 位域按 SysV / AAPCS64 规则放置（不跨越声明类型的存储单元）
+- 文件内未定义的类型先到 headers 选项（-I 收集的头文件类型表，见 backends/headers.py）中查找；
+  仍未知、也不在内置表中的类型按指针大小估算并标记 exact=false，
+  可通过 type_sizes 选项（JSON: {"struct device": [size, align]}）补充
+
+使用方法:
+    engine = LayoutEngine(parse_result, arch="arm64")
+    layout = engine.layout("my_priv")
+    print(format_pahole(layout))
+"""
+
+import re
+from collections import ChainMap
+from dataclasses import dataclass, field
+from typing import Dict, List, Mapping, Optional, Tuple, Union
+
+from backends import BackendCapability, ParseResult, StructDef, StructField, UnionDef
+
+from .base import AnalysisContext, AnalysisPass, AnalysisRegistry
+from .consteval import eval_int
+
+
+@dataclass(frozen=True)
+class ABI:
+    """目标架构的 ABI 参数"""
+    name: str
+    pointer_size: int = 8
+    long_size: int = 8
+    cacheline: int = 64
+    max_align: int = 16                     # __attribute__((aligned)) 不带参数
+    long_double: Tuple[int, int] = (16, 16)
+
+
+ARCHES: Dict[str, ABI] = {
+    "x86_64": ABI("x86_64"),
+    "arm64": ABI("arm64"),
+}
+ARCH_ALIASES = {"amd64": "x86_64", "x86-64": "x86_64", "aarch64": "arm64"}
+
+
+def get_abi(arch: str) -> ABI:
+    """按名称获取 ABI（支持 amd64 / aarch64 等别名）"""
+    name = ARCH_ALIASES.get(arch, arch)
+    if name not in ARCHES:
+        raise ValueError(f"不支持的架构 '{arch}'。可用: {', '.join(ARCHES)}")
+    return ARCHES[name]
+
+
+# 固定宽度的标量类型（大小 = 对齐）
+_FIXED_SIZES: Dict[str, int] = {}
+for _size, _names in {
+    1: "u8 s8 __u8 __s8 uint8_t int8_t bool _Bool",
+    2: "u16 s16 __u16 __s16 __le16 __be16 uint16_t int16_t __sum16",
+    4: "u32 s32 __u32 __s32 __le32 __be32 uint32_t int32_t __wsum gfp_t fmode_t "
+       "pid_t uid_t gid_t kuid_t kgid_t dev_t umode_t slab_flags_t irqreturn_t "
+       "atomic_t refcount_t seqcount_t",
+    8: "u64 s64 __u64 __s64 __le64 __be64 uint64_t int64_t __aligned_u64 loff_t ktime_t "
+       "time64_t sector_t blkcnt_t dma_addr_t phys_addr_t resource_size_t "
+       "netdev_features_t atomic64_t",
+}.items():
+    for _name in _names.split():
+        _FIXED_SIZES[_name] = _size
+
+# 与 long 同宽的类型
+_LONG_SIZED = set("size_t ssize_t uintptr_t intptr_t ptrdiff_t atomic_long_t "
+                  "cpumask_var_t".split())
+
+# 内核结构体/锁类型（非调试配置下 64 位内核的 大小, 对齐）
+KERNEL_TYPES: Dict[str, Tuple[int, int]] = {
+    "spinlock_t": (4, 4),
+    "raw_spinlock_t": (4, 4),
+    "arch_spinlock_t": (4, 4),
+    "rwlock_t": (8, 4),
+    "seqlock_t": (8, 4),
+    "struct kref": (4, 4),
+    "struct list_head": (16, 8),
+    "struct hlist_head": (8, 8),
+    "struct hlist_node": (16, 8),
+    "struct llist_head": (8, 8),
+    "struct llist_node": (8, 8),
+    "struct rb_node": (24, 8),
+    "struct rb_root": (8, 8),
+    "struct callback_head": (16, 8),
+    "struct rcu_head": (16, 8),
+    "struct mutex": (32, 8),
+    "struct semaphore": (24, 8),
+    "struct rw_semaphore": (40, 8),
+    "wait_queue_head_t": (24, 8),
+    "struct wait_queue_head": (24, 8),
+    "struct completion": (32, 8),
+    "struct work_struct": (32, 8),
+    "struct delayed_work": (88, 8),
+    "struct timer_list": (40, 8),
+    "struct hrtimer": (64, 8),
+    "struct tasklet_struct": (40, 8),
+    "struct u64_stats_sync": (0, 1),
+    "struct sk_buff_head": (24, 8),
+    "struct net_device_stats": (184, 8),
+    "struct timespec64": (16, 8),
+    "struct xarray": (16, 8),
+}
+
+# 常见内核常量（数组维度、对齐表达式中使用）
+KERNEL_CONSTANTS: Dict[str, int] = {
+    "ETH_ALEN": 6,
+    "ETH_HLEN": 14,
+    "ETH_DATA_LEN": 1500,
+    "ETH_FRAME_LEN": 1514,
+    "IFNAMSIZ": 16,
+    "TASK_COMM_LEN": 16,
+    "MAX_ADDR_LEN": 32,
+    "BITS_PER_BYTE": 8,
+    "BITS_PER_LONG": 64,
+    "PAGE_SIZE": 4096,
+}
+
+# 不影响布局的类型修饰
+_QUALIFIERS = {"const", "volatile", "__iomem", "__rcu", "__user", "__percpu", "__force",
+               "__kernel", "register", "static", "restrict", "__restrict", "extern"}
+
+_SIZEOF = re.compile(r'sizeof\s*\(\s*([^()]*?)\s*\)')
+
+
+def normalize_type(type_name: str) -> str:
+    """去掉限定符、规整空白: 'const struct foo  __iomem *' -> 'struct foo *'"""
+    tokens = re.findall(r'\w+|\*', type_name)
+    return ' '.join(t for t in tokens if t not in _QUALIFIERS)
+
+
+def _align_up(value: int, align: int) -> int:
+    return (value + align - 1) // align * align if align > 1 else value
+
+
+@dataclass
+class MemberLayout:
+    """字段布局"""
+    name: str
+    type_name: str
+    offset: int
+    size: int
+    align: int
+    hole_before: int = 0
+    count: int = 1                      # 数组元素个数
+    bit_offset: Optional[int] = None    # 位域在存储单元内的位偏移
+    bit_width: Optional[int] = None
+    estimated: bool = False             # 类型大小未知，按指针估算
+    line: int = 0
+    members: List['MemberLayout'] = field(default_factory=list)
+    nested_kind: str = ""
+
+    def to_dict(self, cacheline: int) -> Dict:
+        result = {
+            "name": self.name,
+            "type": self.type_name,
+            "offset": self.offset,
+            "size": self.size,
+            "align": self.align,
+            "cacheline": self.offset // cacheline,
+            "hole_before": self.hole_before,
+            "line": self.line,
+        }
+        if self.count != 1:
+            result["count"] = self.count
+        if self.bit_width is not None:
+            result["bit_offset"] = self.bit_offset
+            result["bit_width"] = self.bit_width
+        if self.estimated:
+            result["estimated"] = True
+        if self.members:
+            result["members"] = [m.to_dict(cacheline) for m in self.members]
+        return result
+
+
+@dataclass
+class RecordLayout:
+    """结构体/联合体布局"""
+    name: str
+    kind: str
+    size: int
+    align: int
+    members: List[MemberLayout]
+    padding: int = 0
+    attributes: List[str] = field(default_factory=list)
+    unknown_types: List[str] = field(default_factory=list)
+    reorder_size: Optional[int] = None  # 按对齐降序重排后的大小（可重排时）
+    line: int = 0
+
+    @property
+    def exact(self) -> bool:
+        return not self.unknown_types
+
+    def holes(self) -> List[Dict]:
+        """字段之间的空洞（不含尾部填充；与估算大小的字段相邻的不算，那里的空洞可能并不存在）"""
+        result = []
+        for prev, member in zip(self.members, self.members[1:]):
+            if member.hole_before > 0 and not (prev.estimated or member.estimated):
+                result.append({"after": prev.name, "offset": member.offset - member.hole_before,
+                               "size": member.hole_before})
+        return result
+
+    def to_dict(self, cacheline: int) -> Dict:
+        holes = self.holes()
+        result = {
+            "name": self.name,
+            "kind": self.kind,
+            "size": self.size,
+            "align": self.align,
+            "cachelines": -(-self.size // cacheline),
+            "members": [m.to_dict(cacheline) for m in self.members],
+            "holes": holes,
+            "sum_holes": sum(h["size"] for h in holes),
+            "padding": self.padding,
+            "exact": self.exact,
+            "line": self.line,
+        }
+        if self.attributes:
+            result["attributes"] = self.attributes
+        if self.unknown_types:
+            result["unknown_types"] = self.unknown_types
+        if self.reorder_size is not None and self.reorder_size < self.size:
+            result["reorder_size"] = self.reorder_size
+            result["reorder_saving"] = self.size - self.reorder_size
+        return result
+
+
+Record = Union[StructDef, UnionDef]
+
+
+class LayoutEngine:
+    """按 ABI 计算文件内结构体/联合体的布局"""
+
+    def __init__(self, parse_result: ParseResult, arch: str = "x86_64",
+                 type_sizes: Optional[Dict[str, Tuple[int, int]]] = None,
+                 constants: Optional[Mapping[str, int]] = None,
+                 headers: Optional[ParseResult] = None):
+        self.abi = get_abi(arch)
+        self.parse_result = parse_result
+        self.type_sizes = {normalize_type(k): (int(v[0]), int(v[1]))
+                           for k, v in (type_sizes or {}).items()}
+        builtin = dict(KERNEL_CONSTANTS)
+        builtin.update(SMP_CACHE_BYTES=self.abi.cacheline,
+                       L1_CACHE_BYTES=self.abi.cacheline,
+                       BITS_PER_LONG=self.abi.long_size * 8)
+        # 传入的常量（可能是整个项目的常量表）优先，不拷贝
+        self.constants: Mapping[str, int] = ChainMap(constants, builtin) if constants else builtin
+
+        # 名字 / typedef 别名 -> (kind, 定义)；头文件中的定义（headers）只在本文件没有时使用
+        self._records: Dict[str, Tuple[str, Record]] = {}
+        self._typedefs = dict(parse_result.typedefs)
+        for source in (parse_result, headers) if headers is not None else (parse_result,):
+            for kind, table in (("struct", source.structs), ("union", source.unions)):
+                for name, record in table.items():
+                    self._records.setdefault(f"{kind} {name}", (kind, record))
+                    if record.typedef_name:
+                        self._records.setdefault(record.typedef_name, (kind, record))
+        if headers is not None:
+            for alias, typedef in headers.typedefs.items():
+                self._typedefs.setdefault(alias, typedef)
+        self._memo: Dict[str, RecordLayout] = {}
+        self._in_progress: set = set()
+        self._unknown: List[str] = []
+
+    # ---------- 类型 ----------
+
+    def type_info(self, type_name: str, _depth: int = 0) -> Optional[Tuple[int, int]]:
+        """类型的 (大小, 对齐)，未知返回 None"""
+        norm = normalize_type(type_name)
+        abi = self.abi
+        if not norm or _depth > 16:
+            return None
+        if '*' in norm or '(*)' in type_name:
+            return abi.pointer_size, abi.pointer_size
+        if norm in self.type_sizes:
+            return self.type_sizes[norm]
+        if norm in self._records:
+            layout = self._layout_key(norm)
+            return (layout.size, layout.align) if layout else None
+        if norm in KERNEL_TYPES:
+            return KERNEL_TYPES[norm]
+        if norm.startswith("enum "):
+            return 4, 4
+        if norm in _FIXED_SIZES:
+            size = _FIXED_SIZES[norm]
+            return size, size
+        if norm in _LONG_SIZED:
+            return abi.long_size, abi.long_size
+        scalar = self._scalar_info(norm.split())
+        if scalar:
+            return scalar
+        typedef = self._typedefs.get(norm)
+        if typedef:
+            return self.type_info(typedef.original, _depth + 1)
+        return None
+
+    def _scalar_info(self, words: List[str]) -> Optional[Tuple[int, int]]:
+        """C 基本类型（可多词: unsigned long long int）"""
+        allowed = {"char", "short", "int", "long", "signed", "unsigned", "float", "double"}
+        if not words or not set(words) <= allowed:
+            return None
+        longs = words.count("long")
+        if "char" in words:
+            size = 1
+        elif "short" in words:
+            size = 2
+        elif "float" in words:
+            size = 4
+        elif "double" in words:
+            return self.abi.long_double if longs else (8, 8)
+        elif longs >= 2:
+            size = 8
+        elif longs == 1:
+            size = self.abi.long_size
+        else:
+            size = 4
+        return size, size
+
+    def eval(self, expr: str) -> Optional[int]:
+        """求值数组维度/对齐表达式（支持 sizeof(类型) 和已知常量）"""
+        def sizeof(match) -> str:
+            info = self.type_info(match.group(1))
+            return str(info[0]) if info else match.group(0)
+        return eval_int(_SIZEOF.sub(sizeof, expr), self.constants)
+
+    def _explicit_align(self, attributes: List[str]) -> Tuple[Optional[int], bool]:
+        """属性中的显式对齐 -> (对齐, 是否有无法求值的属性)"""
+        align = None
+        unresolved = False
+        for attr in attributes:
+            if attr == "cacheline_aligned":
+                value = self.abi.cacheline
+            elif attr == "aligned":
+                value = self.abi.max_align
+            elif attr.startswith("aligned("):
+                value = self.eval(attr[len("aligned("):-1])
+                if value is None:
+                    unresolved = True
+                    continue
+            else:
+                continue
+            align = max(align or 1, value)
+        return align, unresolved
+
+    # ---------- 布局 ----------
+
+    def layout(self, name: str) -> Optional[RecordLayout]:
+        """按名字计算布局（先找 struct，再找 union，最后找 typedef 别名，含 typedef struct foo foo_t）"""
+        for _ in range(16):
+            for key in (f"struct {name}", f"union {name}", name):
+                if key in self._records:
+                    return self._layout_key(key)
+            typedef = self._typedefs.get(normalize_type(name))
+            if typedef is None or '*' in typedef.original:
+                return None
+            name = normalize_type(typedef.original)
+        return None
+
+    def _layout_key(self, key: str) -> Optional[RecordLayout]:
+        kind, record = self._records[key]
+        memo_key = f"{kind} {record.name}"
+        if memo_key in self._memo:
+            return self._memo[memo_key]
+        if memo_key in self._in_progress:
+            return None  # 按值自包含，非法 C
+        self._in_progress.add(memo_key)
+        try:
+            layout = self.layout_record(kind, record.name, record.fields, record.attributes)
+            layout.line = record.location.line if record.location else 0
+        finally:
+            self._in_progress.discard(memo_key)
+        self._memo[memo_key] = layout
+        return layout
+
+    def layout_record(self, kind: str, name: str, fields: List[StructField],
+                      attributes: List[str]) -> RecordLayout:
+        """计算一组字段的布局"""
+        outer_unknown, self._unknown = self._unknown, []
+        packed = "packed" in attributes
+        explicit, _ = self._explicit_align(attributes)
+        members: List[MemberLayout] = []
+        bit_pos = 0          # 结构体: 下一个可用的位位置
+        max_end = 0          # 联合体: 最大成员大小
+        align_max = 1
+        has_bitfield = False
+        reorderable = kind == "struct" and not packed
+
+        for f in fields:
+            elem_size, elem_align, nested, estimated = self._member_type(f)
+            count, count_known = self._array_count(f.array_size)
+            estimated = estimated or not count_known
+            size = elem_size * count
+            member_align, unresolved = self._explicit_align(f.attributes)
+            align = max(1 if packed else elem_align, member_align or 1)
+            if member_align:
+                reorderable = False
+            line = f.location.line if f.location else 0
+
+            if f.bit_width is not None and not nested:
+                has_bitfield = True
+                reorderable = False
+                unit = max(elem_size, 1) * 8
+                width = f.bit_width
+                start = 0 if kind == "union" else bit_pos
+                if width == 0:
+                    bit_pos = _align_up(bit_pos, elem_align * 8)
+                    continue
+                if member_align:
+                    start = _align_up(start, member_align * 8)
+                if not packed and start // unit != (start + width - 1) // unit:
+                    start = _align_up(start, unit)
+                offset = start // unit * (unit // 8) if not packed else start // 8
+                hole = max(start // 8 - -(-bit_pos // 8), 0) if kind == "struct" else 0
+                members.append(MemberLayout(
+                    name=f.name, type_name=f.type_name, offset=offset, size=elem_size,
+                    align=align, hole_before=hole, bit_offset=start - offset * 8,
+                    bit_width=width, estimated=estimated, line=line))
+                if f.name:
+                    align_max = max(align_max, align)
+                if kind == "struct":
+                    bit_pos = start + width
+                else:
+                    max_end = max(max_end, -(-width // 8))
+                continue
+
+            if kind == "union":
+                offset, hole = 0, 0
+                max_end = max(max_end, size)
+            else:
+                byte_pos = -(-bit_pos // 8)
+                offset = _align_up(byte_pos, align)
+                hole = offset - byte_pos
+                bit_pos = (offset + size) * 8
+            align_max = max(align_max, align)
+            members.append(MemberLayout(
+                name=f.name, type_name=f.type_name, offset=offset, size=size, align=align,
+                hole_before=hole, count=count, estimated=estimated, line=line,
+                members=nested.members if nested else [],
+                nested_kind=nested.kind if nested else ""))
+
+        struct_align = max(align_max, explicit or 1)
+        end = max_end if kind == "union" else -(-bit_pos // 8)
+        size = _align_up(end, struct_align)
+        layout = RecordLayout(name=name, kind=kind, size=size, align=struct_align,
+                              members=members, padding=size - end,
+                              attributes=list(attributes),
+                              unknown_types=sorted(set(self._unknown)))
+        if reorderable and not has_bitfield and members and not any(m.estimated for m in members):
+            # 按对齐降序排列后每个字段天然对齐，只剩尾部填充
+            layout.reorder_size = _align_up(sum(m.size for m in members), struct_align)
+        self._unknown = outer_unknown + self._unknown
+        return layout
+
+    def _member_type(self, f: StructField) -> Tuple[int, int, Optional[RecordLayout], bool]:
+        """字段元素的 (大小, 对齐, 内嵌布局, 是否估算)"""
+        if f.members:
+            kind = "union" if f.type_name.startswith("union") else "struct"
+            nested = self.layout_record(kind, f.name or f"({kind})", f.members,
+                                        [a for a in f.attributes if a == "packed"])
+            return nested.size, nested.align, nested, not nested.exact
+        if f.is_function_ptr or f.is_pointer:
+            return self.abi.pointer_size, self.abi.pointer_size, None, False
+        info = self.type_info(f.type_name)
+        if info:
+            return info[0], info[1], None, False
+        self._unknown.append(normalize_type(f.type_name))
+        return self.abi.pointer_size, self.abi.pointer_size, None, True
+
+    def _array_count(self, array_size: str) -> Tuple[int, bool]:
+        """数组元素个数（多维为乘积），无法求值时按 1 处理"""
+        if not array_size:
+            return 1, True
+        count = 1
+        for dim in array_size.split(']['):
+            value = self.eval(dim)
+            if value is None or value < 0:
+                self._unknown.append(f"[{dim}]")
+                return 1, False
+            count *= value
+        return count, True
+
+
+def layout_engine(ctx: AnalysisContext) -> LayoutEngine:
+    """
+    上下文共享的布局引擎（按 arch / type_sizes 选项创建）
+
+    数组维度中的常量用本文件和 -I 头文件的 #define 宏 / 枚举常量求值（constants.constant_table）。
+    """
+    from .constants import constant_table
+    return ctx.cached("layout_engine", lambda: LayoutEngine(
+        ctx.parse_result,
+        arch=ctx.option("arch", "x86_64"),
+        type_sizes=ctx.option("type_sizes"),
+        constants=constant_table(ctx).names,
+        headers=ctx.option("headers"),
+    ))
+
+
+# ==================== pahole 风格输出 ====================
+
+def _format_members(members: List[MemberLayout], cacheline: int, indent: str,
+                    base: int, out: List[str]) -> None:
+    prev_line = None
+    prev: Optional[MemberLayout] = None
+    for m in members:
+        offset = base + m.offset
+        # 与估算大小的字段相邻的空洞不可信，不提示
+        if m.hole_before and not (m.estimated or (prev is not None and prev.estimated)):
+            out.append(f"{indent}/* XXX {m.hole_before} byte{'s' if m.hole_before > 1 else ''}"
+                       f" hole, try to pack */")
+            out.append("")
+        line_no = offset // cacheline
+        if prev_line is not None and line_no != prev_line:
+            out.append(f"{indent}/* --- cacheline {line_no} boundary "
+                       f"({line_no * cacheline} bytes) --- */")
+        prev_line = (offset + max(m.size, 1) - 1) // cacheline
+        if m.members:
+            out.append(f"{indent}{m.nested_kind} {{")
+            _format_members(m.members, cacheline, indent + "\t", offset, out)
+            decl = f"}} {m.name}".rstrip()
+        else:
+            decl = f"{m.type_name:<24} {m.name}"
+            if m.count != 1:
+                decl += f"[{m.count}]"
+            if m.bit_width is not None:
+                decl += f":{m.bit_width}"
+        mark = " ?" if m.estimated else ""
+        pos = f"/* {offset:5} {m.size:5}"
+        if m.bit_width is not None:
+            pos += f": {m.bit_offset:2}"
+        out.append(f"{indent}{decl + ';':<40} {pos} */{mark}")
+        if offset // cacheline != prev_line and not m.members:
+            out.append(f"{indent}/* XXX crosses cacheline {prev_line} boundary */")
+        prev = m
+
+
+def format_pahole(layout: RecordLayout, cacheline: int = 64) -> str:
+    """pahole 风格的文本布局"""
+    out = [f"{layout.kind} {layout.name} {{"]
+    _format_members(layout.members, cacheline, "\t", 0, out)
+    holes = layout.holes()
+    out.append("")
+    out.append(f"\t/* size: {layout.size}, cachelines: {-(-layout.size // cacheline)}, "
+               f"members: {len(layout.members)} */")
+    if holes:
+        out.append(f"\t/* sum members: {sum(m.size for m in layout.members)}, "
+                   f"holes: {len(holes)}, sum holes: {sum(h['size'] for h in holes)} */")
+    if layout.padding:
+        out.append(f"\t/* padding: {layout.padding} */")
+    last = layout.size % cacheline
+    if last:
+        out.append(f"\t/* last cacheline: {last} bytes */")
+    if layout.reorder_size is not None and layout.reorder_size < layout.size:
+        out.append(f"\t/* 按对齐降序重排可缩小到 {layout.reorder_size} 字节 */")
+    if layout.unknown_types:
+        out.append(f"\t/* ? 未知类型按指针大小估算: {', '.join(layout.unknown_types)} */")
+    attrs = f" {' '.join('__' + a for a in layout.attributes)}" if layout.attributes else ""
+    out.append(f"}}{attrs};")
+    return "\n".join(out)
+
+
+@AnalysisRegistry.register
+class LayoutPass(AnalysisPass):
+    """结构体布局 / 缓存行报告"""
+
+    name = "layout"
+    description = "结构体内存布局、空洞与缓存行报告（pahole 风格）"
+    needs = frozenset({BackendCapability.PARSE_STRUCTS, BackendCapability.PARSE_UNIONS,
+                       BackendCapability.PARSE_TYPEDEFS})
+
+    def run(self, ctx: AnalysisContext) -> Dict:
+        engine = layout_engine(ctx)
+        cacheline = engine.abi.cacheline
+        records = [("struct", n) for n in ctx.parse_result.structs] + \
+                  [("union", n) for n in ctx.parse_result.unions]
+        layouts = []
+        for kind, name in records:
+            layout = engine._layout_key(f"{kind} {name}")
+            if layout:
+                layouts.append(layout)
+        layouts.sort(key=lambda l: l.line)
+
+        structs = {f"{l.kind} {l.name}": l.to_dict(cacheline) for l in layouts}
+        with_holes = [s for s in structs.values() if s["sum_holes"]]
+        return {
+            "arch": engine.abi.name,
+            "cacheline": cacheline,
+            "structs": structs,
+            "summary": {
+                "records": len(structs),
+                "with_holes": len(with_holes),
+                "hole_bytes": sum(s["sum_holes"] for s in structs.values()),
+                "padding_bytes": sum(s["padding"] for s in structs.values()),
+                "reorder_savings": sum(s.get("reorder_saving", 0) for s in structs.values()),
+                "inexact": [k for k, s in structs.items() if not s["exact"]],
+            },
+            "pahole": {k: format_pahole(l, cacheline) for k, l in zip(structs, layouts)},
+        }
+
+    def format_text(self, result: Dict) -> str:
+        summary = result["summary"]
+        out = [f"\n📐 结构体布局 ({result['arch']}, 缓存行 {result['cacheline']} 字节): "
+               f"{summary['records']} 个, {summary['with_holes']} 个有空洞, "
+               f"空洞 {summary['hole_bytes']} 字节, 重排可省 {summary['reorder_savings']} 字节"]
+        for text in result["pahole"].values():
+            out.append("")
+            out.append(text)
+        return "\n".join(out)
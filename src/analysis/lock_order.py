@@ -0,0 +1,352 @@
+#!/usr/bin/env python3
+"""
+锁顺序图
+
+沿文件内调用图提取加锁顺序：持有锁 A 的临界区内（直接或经被调函数）又获取锁 B，
+记一条 A -> B 的边。锁按结构体字段路径识别：&priv->tx_lock（priv 为 struct nic_priv *）
+记为 "nic_priv.tx_lock"，全局锁用变量名，类型未知时用去掉 & 和空白的表达式。
+只统计真正的锁（spin / rwlock / mutex / semaphore / rwsem），关中断、RCU 等不算。
+
+过程间部分基于摘要：在调用图缩点（callgraph.Condensation）上按逆拓扑序
+计算每个函数"调用它会获取的锁"集合，每个临界区只需查区间内调用点的摘要，
+整体为 O(V + E + 区间内调用点 × 锁数)。
+
+报告：
+- 锁顺序图的边（附见证：哪个函数哪一行、经由的调用链）
+- 环：锁顺序图的强连通分量（A -> B -> A，潜在的 AB-BA 死锁），以及同一把锁的嵌套获取
+- 热点锁：被多个执行上下文（入口点）获取的锁，按入口数排序
+
+多个文件一起分析时，merge_lock_order 把各文件的边合并为全局锁顺序图再找环和热点锁
+（结构体字段锁跨文件合并，全局变量和类型未知的锁按文件区分）。
+"""
+
+import os
+import re
+from collections import deque
+from typing import Dict, List, Optional, Tuple
+
+from backends import BackendCapability
+
+from .base import AnalysisContext, AnalysisPass, AnalysisRegistry
+from .callgraph import Condensation, call_graph, condensation, contexts_by_function
+from .fields import global_vars, var_types
+from .locks import LOCK_PAIRS, lock_key, lock_regions
+from .metrics import CallSite, body_metrics
+
+
+# 参与锁顺序的类别（关中断 / 抢占 / 下半部 / RCU 不是互斥锁）
+ORDER_KINDS = {"spin", "mutex", "semaphore", "rwsem"}
+
+# 被至少这么多入口获取的锁为热点锁
+HUB_ENTRIES = 3
+
+# 每条边保留的见证数
+MAX_WITNESSES = 3
+
+_LOCK_EXPR = re.compile(r'^(\w+)((?:(?:->|\.)\w+(?:\[[^\]]*\])*)*)$')
+_HOP = re.compile(r'(?:->|\.)(\w+)')
+
+
+def lock_id(ctx: AnalysisContext, func: str, expr: str) -> Tuple[str, str]:
+    """
+    锁表达式 -> (锁标识, 作用域)
+
+    作用域为 "struct"（结构体字段，跨文件可比）、"global"（文件作用域变量）或 "local"（类型未知）。
+    """
+    text = re.sub(r'\s+', '', expr)
+    while text.startswith('&'):
+        text = text[1:]
+    while text.startswith('(') and text.endswith(')'):
+        text = text[1:-1]
+    m = _LOCK_EXPR.match(text)
+    if not m:
+        return text, "local"
+    var, path = m.group(1), _HOP.findall(m.group(2))
+    if not path:
+        return var, "global" if var in global_vars(ctx) or var not in _locals(ctx, func) else "local"
+    struct = var_types(ctx, func).get(var)
+    if struct:
+        return f"{struct}.{'.'.join(path)}", "struct"
+    return text, "local"
+
+
+def _locals(ctx: AnalysisContext, func: str) -> set:
+    """函数的参数和局部变量名（用于区分全局锁）"""
+    cache = ctx.cached("lock_order.locals", dict)
+    if func not in cache:
+        definition = ctx.parse_result.functions[func]
+        names = {p.name for p in definition.params}
+        names.update(re.findall(r'\b(?:spinlock_t|struct\s+mutex|struct\s+semaphore|rwlock_t|'
+                                r'struct\s+rw_semaphore)\s*\*?\s*(\w+)', definition.body))
+        cache[func] = names
+    return cache[func]
+
+
+def acquisitions(ctx: AnalysisContext, func: str) -> List[Tuple[str, CallSite]]:
+    """函数中直接加锁的调用点 -> [(锁标识, 调用点)]（缓存）"""
+    cache = ctx.cached("lock_order.acquisitions", dict)
+    if func not in cache:
+        found = []
+        for site in body_metrics(ctx, func).calls:
+            pair = LOCK_PAIRS.get(site.name)
+            if pair and pair[1] in ORDER_KINDS:
+                found.append((lock_id(ctx, func, lock_key(site))[0], site))
+        cache[func] = found
+    return cache[func]
+
+
+def lock_summaries(ctx: AnalysisContext) -> Dict[str, frozenset]:
+    """函数 -> 调用它（含传递调用）会获取的锁（缓存）"""
+    def build() -> Dict[str, frozenset]:
+        cond = condensation(ctx)
+        acquired: List[frozenset] = [frozenset()] * len(cond.sccs)
+        # sccs 按拓扑序排列（调用者在前），逆序即先算被调用者
+        for i in range(len(cond.sccs) - 1, -1, -1):
+            locks = set()
+            for func in cond.sccs[i]:
+                locks.update(lock for lock, _ in acquisitions(ctx, func))
+            for j in cond.succ[i]:
+                locks |= acquired[j]
+            acquired[i] = frozenset(locks)
+        return {func: acquired[i] for func, i in cond.scc_of.items()}
+    return ctx.cached("lock_order.summaries", build)
+
+
+def acquire_path(ctx: AnalysisContext, func: str, lock: str) -> List[str]:
+    """func 到直接获取 lock 的函数的一条最短调用链（末尾为加锁调用名，缓存）"""
+    cache = ctx.cached("lock_order.paths", dict)
+    if (func, lock) not in cache:
+        cache[func, lock] = _acquire_path(ctx, func, lock)
+    return cache[func, lock]
+
+
+def _acquire_path(ctx: AnalysisContext, func: str, lock: str) -> List[str]:
+    summaries = lock_summaries(ctx)
+    graph = call_graph(ctx)
+    parent: Dict[str, Optional[str]] = {func: None}
+    queue = deque([func])
+    while queue:
+        current = queue.popleft()
+        site = next((s for l, s in acquisitions(ctx, current) if l == lock), None)
+        if site is not None:
+            chain = [site.name]
+            node: Optional[str] = current
+            while node is not None:
+                chain.append(node)
+                node = parent[node]
+            return chain[::-1]
+        for callee in graph.get(current, ()):
+            if callee not in parent and lock in summaries.get(callee, ()):
+                parent[callee] = current
+                queue.append(callee)
+    return [func]
+
+
+def order_edges(ctx: AnalysisContext) -> Dict[Tuple[str, str], Dict]:
+    """(持有的锁, 随后获取的锁) -> 边（缓存）"""
+    def build() -> Dict[Tuple[str, str], Dict]:
+        functions = ctx.parse_result.functions
+        summaries = lock_summaries(ctx)
+        edges: Dict[Tuple[str, str], Dict] = {}
+
+        def add(held: str, taken: str, func: str, site: CallSite) -> None:
+            edge = edges.setdefault((held, taken), {"from": held, "to": taken, "count": 0,
+                                                    "nested": False, "witnesses": []})
+            edge["count"] += 1
+            if site.name in LOCK_PAIRS:
+                edge["nested"] = edge["nested"] or site.name.endswith("_nested")
+                path = [func, site.name]
+            elif len(edge["witnesses"]) < MAX_WITNESSES:
+                # 经被调函数获取：调用链只为保留的见证计算
+                path = [func] + acquire_path(ctx, site.name, taken)
+                edge["nested"] = edge["nested"] or path[-1].endswith("_nested")
+            else:
+                return
+            if len(edge["witnesses"]) < MAX_WITNESSES:
+                edge["witnesses"].append({"func": func, "line": site.line, "call": path[-1],
+                                          "path": path})
+
+        for func, regions in lock_regions(ctx).items():
+            for region in regions:
+                if region.kind not in ORDER_KINDS:
+                    continue
+                held = lock_id(ctx, func, region.lock)[0]
+                for site in region.calls:
+                    pair = LOCK_PAIRS.get(site.name)
+                    if pair and pair[1] in ORDER_KINDS:
+                        add(held, lock_id(ctx, func, lock_key(site))[0], func, site)
+                    elif site.name in functions and site.name != func:
+                        for taken in sorted(summaries.get(site.name, ())):
+                            add(held, taken, func, site)
+        return edges
+    return ctx.cached("lock_order.edges", build)
+
+
+def find_cycles(edges: List[Dict]) -> List[Dict]:
+    """锁顺序图中的环：多把锁组成的强连通分量，以及非 _nested 的同一把锁嵌套获取"""
+    graph: Dict[str, List[str]] = {}
+    for edge in edges:
+        graph.setdefault(edge["from"], [])
+        graph.setdefault(edge["to"], [])
+        if edge["from"] != edge["to"]:
+            graph[edge["from"]].append(edge["to"])
+    cond = Condensation(graph)
+    cycles = []
+    for comp in cond.sccs:
+        if len(comp) > 1:
+            members = set(comp)
+            cycles.append({
+                "kind": "order",
+                "locks": sorted(comp),
+                "edges": [e for e in edges if e["from"] in members and e["to"] in members
+                          and e["from"] != e["to"]],
+            })
+    for edge in edges:
+        if edge["from"] == edge["to"] and not edge["nested"]:
+            cycles.append({"kind": "recursive", "locks": [edge["from"]], "edges": [edge]})
+    return cycles
+
+
+def rank_locks(locks: Dict[str, Dict], edges: List[Dict]) -> List[Dict]:
+    """补上出入度，按入口数排序并标记热点锁"""
+    out_degree: Dict[str, int] = {}
+    in_degree: Dict[str, int] = {}
+    for edge in edges:
+        out_degree[edge["from"]] = out_degree.get(edge["from"], 0) + 1
+        in_degree[edge["to"]] = in_degree.get(edge["to"], 0) + 1
+    ranked = []
+    for lock, record in locks.items():
+        record["out_degree"] = out_degree.get(lock, 0)
+        record["in_degree"] = in_degree.get(lock, 0)
+        record["hub"] = len(record["entries"]) >= HUB_ENTRIES
+        ranked.append(record)
+    ranked.sort(key=lambda r: (-len(r["entries"]), -r["sites"], r["lock"]))
+    return ranked
+
+
+def _summary(locks: List[Dict], edges: List[Dict], cycles: List[Dict]) -> Dict:
+    return {
+        "locks": len(locks),
+        "edges": len(edges),
+        "cycles": sum(1 for c in cycles if c["kind"] == "order"),
+        "recursive": sum(1 for c in cycles if c["kind"] == "recursive"),
+        "hubs": sum(1 for r in locks if r["hub"]),
+    }
+
+
+@AnalysisRegistry.register
+class LockOrderPass(AnalysisPass):
+    """过程间锁顺序图、环和热点锁"""
+
+    name = "lock-order"
+    description = "锁顺序图：嵌套加锁（含经被调函数）的顺序边、AB-BA 环、被多个执行上下文获取的热点锁"
+    needs = AnalysisPass.needs | {BackendCapability.PARSE_STRUCTS, BackendCapability.PARSE_UNIONS,
+                                  BackendCapability.PARSE_TYPEDEFS}
+
+    def run(self, ctx: AnalysisContext) -> Dict:
+        contexts = contexts_by_function(ctx)
+        locks: Dict[str, Dict] = {}
+        for func in ctx.parse_result.functions:
+            for lock, site in acquisitions(ctx, func):
+                record = locks.setdefault(lock, {
+                    "lock": lock, "scope": lock_id(ctx, func, lock_key(site))[1],
+                    "kinds": [], "functions": [], "entries": [], "sites": 0})
+                record["sites"] += 1
+                kind = LOCK_PAIRS[site.name][1]
+                if kind not in record["kinds"]:
+                    record["kinds"].append(kind)
+                if func not in record["functions"]:
+                    record["functions"].append(func)
+                for entry in contexts.get(func, []):
+                    if entry.label not in record["entries"]:
+                        record["entries"].append(entry.label)
+
+        edges = sorted(order_edges(ctx).values(), key=lambda e: (e["from"], e["to"]))
+        ranked = rank_locks(locks, edges)
+        cycles = find_cycles(edges)
+        return {
+            "locks": ranked,
+            "edges": edges,
+            "cycles": cycles,
+            "summary": _summary(ranked, edges, cycles),
+        }
+
+    def format_text(self, result: Dict) -> str:
+        return format_lock_order(result)
+
+
+def format_lock_order(result: Dict) -> str:
+    summary = result["summary"]
+    out = [f"\n🔗 锁顺序: {summary['locks']} 把锁, {summary['edges']} 条顺序边, "
+           f"环 {summary['cycles']}, 嵌套同一把锁 {summary['recursive']}, 热点锁 {summary['hubs']}"]
+    for cycle in result["cycles"]:
+        title = " <-> ".join(cycle["locks"]) if cycle["kind"] == "order" else \
+            f"{cycle['locks'][0]} 嵌套获取"
+        out.append(f"   ❌ {title}")
+        for edge in cycle["edges"]:
+            w = edge["witnesses"][0]
+            out.append(f"        {edge['from']} -> {edge['to']}: {w['func']}() 行 {w['line']}  "
+                       f"{' -> '.join(w['path'])}")
+    for record in result["locks"]:
+        if record["hub"]:
+            out.append(f"   🔥 {record['lock']} 被 {len(record['entries'])} 个入口获取: "
+                       f"{', '.join(record['entries'])}")
+    for edge in result["edges"]:
+        out.append(f"   {edge['from']} -> {edge['to']}  ({edge['count']} 处)")
+    return "\n".join(out)
+
+
+def merge_lock_order(results: List[Dict]) -> Optional[Dict]:
+    """
+    合并多个文件的 lock-order 结果为全局锁顺序图
+
+    结构体字段锁按标识合并；全局变量和类型未知的锁加上文件名前缀，入口标签同样加文件名。
+    没有任何文件运行了 lock-order 时返回 None。
+    """
+    locks: Dict[str, Dict] = {}
+    edges: Dict[Tuple[str, str], Dict] = {}
+    found = False
+    for file_result in results:
+        per_file = file_result.get("analyses", {}).get("lock-order")
+        if per_file is None:
+            continue
+        found = True
+        name = os.path.basename(file_result.get("file", ""))
+        scopes = {r["lock"]: r["scope"] for r in per_file["locks"]}
+
+        def qualify(lock: str) -> str:
+            return lock if scopes.get(lock, "struct") == "struct" else f"{name}:{lock}"
+
+        for record in per_file["locks"]:
+            merged = locks.setdefault(qualify(record["lock"]), {
+                "lock": qualify(record["lock"]), "scope": record["scope"], "kinds": [],
+                "functions": [], "entries": [], "sites": 0, "files": []})
+            merged["sites"] += record["sites"]
+            merged["files"].append(name)
+            for kind in record["kinds"]:
+                if kind not in merged["kinds"]:
+                    merged["kinds"].append(kind)
+            merged["functions"].extend(f"{name}:{f}" for f in record["functions"])
+            merged["entries"].extend(f"{name}:{e}" for e in record["entries"])
+        for edge in per_file["edges"]:
+            key = (qualify(edge["from"]), qualify(edge["to"]))
+            merged = edges.setdefault(key, {"from": key[0], "to": key[1], "count": 0,
+                                            "nested": False, "witnesses": []})
+            merged["count"] += edge["count"]
+            merged["nested"] = merged["nested"] or edge["nested"]
+            for w in edge["witnesses"]:
+                if len(merged["witnesses"]) < MAX_WITNESSES:
+                    merged["witnesses"].append(dict(w, file=name))
+    if not found:
+        return None
+
+    edge_list = sorted(edges.values(), key=lambda e: (e["from"], e["to"]))
+    ranked = rank_locks(locks, edge_list)
+    cycles = find_cycles(edge_list)
+    return {
+        "files": len(results),
+        "locks": ranked,
+        "edges": edge_list,
+        "cycles": cycles,
+        "summary": _summary(ranked, edge_list, cycles),
+    }
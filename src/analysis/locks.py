@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""
+加锁区间识别
+
+按调用点顺序配对 lock / unlock（锁以第一个参数的表达式区分，如 &priv->lock），
+得到函数体内的临界区：
+- 自旋锁: spin_lock / _irq / _irqsave / _bh、raw_spin_lock*、read_lock* / write_lock*
+- 睡眠锁: mutex_lock*、down / up
+- 关中断/抢占/下半部、RCU 读临界区: local_irq_save / disable、preempt_disable、
+  local_bh_disable、rcu_read_lock
+
+两种配对方式：
+- 语法树（tree-sitter 可用时）：解锁必须是加锁语句所在代码块中后续的语句；
+  嵌在 if 分支里的解锁（出错提前返回）记为提前解锁，不结束临界区；
+  goto out_unlock 形式的出口也不会把临界区拉长到函数末尾
+- 文本（回退）：错误处理路径上提前解锁很常见，因此临界区延伸到
+  下一次对同一把锁加锁之前的最后一次解锁
+"""
+
+import re
+from dataclasses import dataclass, field
+from typing import Dict, List, Optional
+
+from backends import is_treesitter_available
+
+from .base import AnalysisContext
+from .callgraph import function_body
+from .metrics import BodyMetrics, CallSite, body_metrics, split_args
+
+
+# 加锁函数 -> (对应的解锁函数, 类别)
+LOCK_PAIRS: Dict[str, tuple] = {}
+for _prefix in ("spin", "raw_spin", "read", "write"):
+    for _suffix, _unlock in (("", ""), ("_irq", "_irq"), ("_irqsave", "_irqrestore"),
+                             ("_bh", "_bh"), ("_nested", ""), ("_irqsave_nested", "_irqrestore")):
+        LOCK_PAIRS[f"{_prefix}_lock{_suffix}"] = (f"{_prefix}_unlock{_unlock}", "spin")
+for _name in ("mutex_lock", "mutex_lock_interruptible", "mutex_lock_killable", "mutex_lock_nested"):
+    LOCK_PAIRS[_name] = ("mutex_unlock", "mutex")
+for _name in ("down", "down_interruptible", "down_killable", "down_timeout"):
+    LOCK_PAIRS[_name] = ("up", "semaphore")
+LOCK_PAIRS.update({
+    "down_read": ("up_read", "rwsem"),
+    "down_write": ("up_write", "rwsem"),
+    "local_irq_save": ("local_irq_restore", "irq"),
+    "local_irq_disable": ("local_irq_enable", "irq"),
+    "preempt_disable": ("preempt_enable", "preempt"),
+    "local_bh_disable": ("local_bh_enable", "bh"),
+    "rcu_read_lock": ("rcu_read_unlock", "rcu"),
+    "rcu_read_lock_bh": ("rcu_read_unlock_bh", "rcu"),
+})
+UNLOCK_KINDS = {unlock: kind for unlock, kind in LOCK_PAIRS.values()}
+
+# 不可睡眠的临界区类别
+ATOMIC_LOCK_KINDS = {"spin", "irq", "preempt", "bh", "rcu"}
+
+
+@dataclass
+class LockRegion:
+    """一个临界区（函数体内 [start, end) 偏移）"""
+    func: str
+    lock_call: str
+    unlock_call: str
+    lock: str               # 锁表达式: "&priv->lock"；关中断等为调用名
+    kind: str               # spin / mutex / semaphore / rwsem / irq / preempt / bh / rcu
+    start: int
+    end: int
+    line: int
+    end_line: int
+    unlocks: int = 1        # 配对到的解锁次数（>1 表示有提前解锁的路径）
+    calls: List[CallSite] = field(default_factory=list)
+    pairing: str = "text"   # "syntax"（语法树）/ "text"（调用顺序）
+
+    @property
+    def atomic(self) -> bool:
+        return self.kind in ATOMIC_LOCK_KINDS
+
+    @property
+    def irqs_off(self) -> bool:
+        return self.kind == "irq" or self.lock_call.endswith(("_irq", "_irqsave",
+                                                               "_irqsave_nested"))
+
+
+def lock_key(site: CallSite) -> str:
+    """锁的标识：第一个参数去掉空白；无参数的（关中断等）用类别名"""
+    kind = LOCK_PAIRS[site.name][1] if site.name in LOCK_PAIRS else UNLOCK_KINDS.get(site.name)
+    if kind in ("irq", "preempt", "bh", "rcu"):
+        return kind
+    args = split_args(site.args)
+    return re.sub(r'\s+', '', args[0]) if args else site.name
+
+
+def _region(func: str, metrics: BodyMetrics, site: CallSite, last: CallSite, unlocks: int,
+            pairing: str) -> LockRegion:
+    unlock_name, kind = LOCK_PAIRS[site.name]
+    key = lock_key(site)
+    return LockRegion(
+        func=func, lock_call=site.name, unlock_call=unlock_name, lock=key, kind=kind,
+        start=site.pos, end=last.pos, line=site.line, end_line=last.line, unlocks=unlocks,
+        calls=[c for c in metrics.calls if site.pos < c.pos < last.pos
+               and not (c.name == unlock_name and lock_key(c) == key)],
+        pairing=pairing,
+    )
+
+
+def find_regions(func: str, metrics: BodyMetrics) -> List[LockRegion]:
+    """按调用顺序配对加锁/解锁"""
+    calls = metrics.calls
+    regions = []
+    for i, site in enumerate(calls):
+        pair = LOCK_PAIRS.get(site.name)
+        if not pair:
+            continue
+        unlock_name, kind = pair
+        key = lock_key(site)
+        last: Optional[CallSite] = None
+        unlocks = 0
+        for later in calls[i + 1:]:
+            if later.name in LOCK_PAIRS and lock_key(later) == key:
+                break
+            if later.name == unlock_name and lock_key(later) == key:
+                last = later
+                unlocks += 1
+        if last is not None:
+            regions.append(_region(func, metrics, site, last, unlocks, "text"))
+    return regions
+
+
+# 语法树解析时把函数体包成一个函数定义
+_BODY_PREFIX = "void __body(void)\n"
+_syntax_backend = None
+
+
+def _statement(node):
+    """node 所在的、直接位于代码块中的语句"""
+    while node.parent is not None and node.parent.type != 'compound_statement':
+        node = node.parent
+    return node if node.parent is not None else None
+
+
+def find_regions_syntax(func: str, body: str, metrics: BodyMetrics) -> Optional[List[LockRegion]]:
+    """
+    在语法树上配对加锁/解锁
+
+    Args:
+        body: 去掉注释的函数体（偏移与 metrics 的调用点一致）
+
+    Returns:
+        临界区列表；tree-sitter 不可用时返回 None
+    """
+    global _syntax_backend
+    if not is_treesitter_available():
+        return None
+    if _syntax_backend is None:
+        from backends import TreeSitterBackend
+        _syntax_backend = TreeSitterBackend()
+    root = _syntax_backend.parse_tree(_BODY_PREFIX + body)
+    data = body.encode('utf-8')
+    ascii_only = len(data) == len(body)
+    prefix = len(_BODY_PREFIX)
+
+    def char_offset(byte: int) -> int:
+        byte -= prefix
+        return byte if ascii_only else len(data[:byte].decode('utf-8', 'ignore'))
+
+    # 语法树中的加锁/解锁调用 -> (调用点, 所在语句)
+    by_pos = {c.pos: c for c in metrics.calls}
+    sites = []
+    stack = [root]
+    while stack:
+        node = stack.pop()
+        if node.type == 'call_expression':
+            fn = node.child_by_field_name('function')
+            if fn is not None and fn.type == 'identifier':
+                site = by_pos.get(char_offset(fn.start_byte))
+                if site and (site.name in LOCK_PAIRS or site.name in UNLOCK_KINDS):
+                    statement = _statement(node)
+                    if statement is not None:
+                        sites.append((site, statement))
+        stack.extend(reversed(node.children))
+    sites.sort(key=lambda s: s[0].pos)
+
+    regions = []
+    for i, (site, statement) in enumerate(sites):
+        if site.name not in LOCK_PAIRS:
+            continue
+        unlock_name = LOCK_PAIRS[site.name][0]
+        key = lock_key(site)
+        end = None
+        nested = None
+        unlocks = 0
+        sibling = statement.next_named_sibling
+        later = [(s, st) for s, st in sites[i + 1:] if lock_key(s) == key]
+        while sibling is not None and end is None:
+            lo, hi = char_offset(sibling.start_byte), char_offset(sibling.end_byte)
+            inside = [(s, st) for s, st in later if lo <= s.pos < hi]
+            if any(s.name in LOCK_PAIRS for s, _ in inside):
+                break
+            for s, st in inside:
+                if s.name != unlock_name:
+                    continue
+                unlocks += 1
+                # 不带花括号的 if (x) spin_unlock(...); 所在语句是 if 语句，仍算提前解锁
+                if st == sibling and sibling.type == 'expression_statement':
+                    end = s
+                    break
+                nested = s
+            sibling = sibling.next_named_sibling
+        last = end or nested
+        if last is not None:
+            regions.append(_region(func, metrics, site, last, unlocks, "syntax"))
+    return regions
+
+
+def lock_regions(ctx: AnalysisContext) -> Dict[str, List[LockRegion]]:
+    """函数 -> 临界区列表（缓存）"""
+    def build() -> Dict[str, List[LockRegion]]:
+        result = {}
+        for name in ctx.parse_result.functions:
+            metrics = body_metrics(ctx, name)
+            regions = find_regions_syntax(name, function_body(ctx, name), metrics)
+            if regions is None:
+                regions = find_regions(name, metrics)
+            if regions:
+                result[name] = regions
+        return result
+    return ctx.cached("locks.regions", build)
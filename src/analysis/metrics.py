@@ -0,0 +1,221 @@
+#!/usr/bin/env python3
+"""
+函数体度量
+
+对函数体（去掉注释和字符串内容）做一次扫描，得到：
+- 循环区间（for / while / do-while，含只有一条语句或空循环体的写法）及嵌套深度
+- 调用点：被调函数名、参数文本、所在行、所在的循环嵌套深度
+- MMIO 访问（readl / writel 及 relaxed、ioread / iowrite、inb / outb 系列）
+
+循环条件里的调用算在循环内（while (!(readl(r) & BIT(0))); 会重复执行 readl）。
+"""
+
+import re
+from dataclasses import dataclass, field
+from typing import Dict, List, Tuple
+
+from backends import LineIndex
+
+from .base import AnalysisContext
+from .callgraph import body_line, function_body, strip_comments
+
+
+MMIO_READ = re.compile(
+    r'^(?:__raw_)?(?:read[bwlq]|ioread(?:8|16|32|64)(?:be)?|in[bwl])(?:_relaxed|_p)?$')
+MMIO_WRITE = re.compile(
+    r'^(?:__raw_)?(?:write[bwlq]|iowrite(?:8|16|32|64)(?:be)?|out[bwl])(?:_relaxed|_p)?$')
+
+# 形如调用但不是函数调用的关键字 / 编译器内建
+NOT_CALLS = {"if", "for", "while", "switch", "return", "sizeof", "typeof", "__typeof__",
+             "do", "else", "case", "defined", "likely", "unlikely", "alignof", "_Alignof",
+             "offsetof", "__builtin_expect", "ARRAY_SIZE", "BIT", "GENMASK", "container_of"}
+
+_STRING = re.compile(r'"(?:[^"\\\n]|\\.)*"|\'(?:[^\'\\\n]|\\.)*\'')
+_LOOP_KW = re.compile(r'\b(for|while|do)\b')
+_CALL = re.compile(r'\b([A-Za-z_]\w*)\s*\(')
+_DO_TAIL = re.compile(r'\s*while\s*\(')
+
+
+@dataclass
+class CallSite:
+    """函数体中的一次调用"""
+    name: str
+    args: str           # 参数文本（字符串字面量已替换为空白）
+    line: int
+    pos: int            # 在函数体中的偏移
+    loop_depth: int = 0
+    end: int = 0        # 右括号之后的偏移
+
+    @property
+    def is_mmio_read(self) -> bool:
+        return bool(MMIO_READ.match(self.name))
+
+    @property
+    def is_mmio_write(self) -> bool:
+        return bool(MMIO_WRITE.match(self.name))
+
+
+@dataclass
+class Loop:
+    """循环区间 [start, end)，start 为关键字位置"""
+    kind: str
+    start: int
+    end: int
+    line: int
+    depth: int = 1      # 嵌套深度（最外层为 1）
+    empty: bool = False  # 空循环体: while (cond);
+
+
+@dataclass
+class BodyMetrics:
+    """单个函数体的度量"""
+    loops: List[Loop] = field(default_factory=list)
+    calls: List[CallSite] = field(default_factory=list)
+
+    @property
+    def max_loop_depth(self) -> int:
+        return max((l.depth for l in self.loops), default=0)
+
+    @property
+    def mmio_reads(self) -> int:
+        return sum(1 for c in self.calls if c.is_mmio_read)
+
+    @property
+    def mmio_writes(self) -> int:
+        return sum(1 for c in self.calls if c.is_mmio_write)
+
+    def loops_at(self, pos: int) -> List[Loop]:
+        return [l for l in self.loops if l.start <= pos < l.end]
+
+
+def blank_strings(text: str) -> str:
+    """字符串/字符字面量内容替换为空格（保持偏移和换行）"""
+    return _STRING.sub(lambda m: m.group(0)[0] + ' ' * (len(m.group(0)) - 2) + m.group(0)[-1],
+                       text)
+
+
+def matching(text: str, pos: int, open_char: str, close_char: str) -> int:
+    """text[pos] 为开括号，返回匹配的闭括号位置（未闭合返回 len(text) - 1）"""
+    depth = 0
+    for i in range(pos, len(text)):
+        c = text[i]
+        if c == open_char:
+            depth += 1
+        elif c == close_char:
+            depth -= 1
+            if depth == 0:
+                return i
+    return len(text) - 1
+
+
+def _statement_end(text: str, pos: int) -> int:
+    """从 pos 开始的一条语句的结束位置（'{' 开头则到匹配的 '}'）"""
+    while pos < len(text) and text[pos].isspace():
+        pos += 1
+    if pos < len(text) and text[pos] == '{':
+        return matching(text, pos, '{', '}') + 1
+    m = _LOOP_KW.match(text, pos)
+    if m:
+        return _loop_extent(text, m)[0]
+    depth = 0
+    for i in range(pos, len(text)):
+        c = text[i]
+        if c in '([{':
+            depth += 1
+        elif c in ')]}':
+            depth -= 1
+            if depth < 0:
+                return i
+        elif c == ';' and depth == 0:
+            return i + 1
+    return len(text)
+
+
+def _loop_extent(text: str, m: 're.Match') -> Tuple[int, bool]:
+    """循环的结束位置，以及循环体是否为空"""
+    kind = m.group(1)
+    pos = m.end()
+    if kind == 'do':
+        end = _statement_end(text, pos)
+        tail = _DO_TAIL.match(text, end)
+        if tail:
+            close = matching(text, tail.end() - 1, '(', ')')
+            semi = text.find(';', close)
+            end = (semi + 1) if semi >= 0 else close + 1
+        return end, False
+    paren = text.find('(', pos)
+    if paren < 0:
+        return len(text), False
+    close = matching(text, paren, '(', ')')
+    rest = close + 1
+    while rest < len(text) and text[rest].isspace():
+        rest += 1
+    if rest < len(text) and text[rest] == ';':
+        return rest + 1, True
+    return _statement_end(text, close + 1), False
+
+
+def scan_body(body: str, base_line: int = 1) -> BodyMetrics:
+    """扫描函数体"""
+    text = blank_strings(strip_comments(body))
+    lines = LineIndex(text)
+    metrics = BodyMetrics()
+
+    # do { ... } while (x); 的 while 属于 do 循环，不单独计
+    do_tails = set()
+    for m in _LOOP_KW.finditer(text):
+        if m.start() in do_tails:
+            continue
+        end, empty = _loop_extent(text, m)
+        if m.group(1) == 'do':
+            tail = text.rfind('while', m.end(), end)
+            if tail >= 0:
+                do_tails.add(tail)
+        metrics.loops.append(Loop(kind=m.group(1), start=m.start(), end=end,
+                                  line=base_line + lines.line_of(m.start()) - 1, empty=empty))
+    for loop in metrics.loops:
+        loop.depth = sum(1 for outer in metrics.loops
+                         if outer.start <= loop.start and loop.end <= outer.end)
+
+    for m in _CALL.finditer(text):
+        name = m.group(1)
+        if name in NOT_CALLS:
+            continue
+        close = matching(text, m.end() - 1, '(', ')')
+        metrics.calls.append(CallSite(
+            name=name,
+            args=text[m.end():close].strip(),
+            line=base_line + lines.line_of(m.start()) - 1,
+            pos=m.start(),
+            loop_depth=sum(1 for l in metrics.loops if l.start <= m.start() < l.end),
+            end=close + 1,
+        ))
+    return metrics
+
+
+def body_metrics(ctx: AnalysisContext, name: str) -> BodyMetrics:
+    """函数体度量（缓存）"""
+    cache: Dict[str, BodyMetrics] = ctx.cached("metrics.bodies", dict)
+    if name not in cache:
+        func = ctx.parse_result.functions.get(name)
+        cache[name] = scan_body(function_body(ctx, name), body_line(func)) if func \
+            else BodyMetrics()
+    return cache[name]
+
+
+def split_args(args: str) -> List[str]:
+    """按顶层逗号拆分参数文本"""
+    parts, depth, start = [], 0, 0
+    for i, c in enumerate(args):
+        if c in '([{':
+            depth += 1
+        elif c in ')]}':
+            depth -= 1
+        elif c == ',' and depth == 0:
+            parts.append(args[start:i].strip())
+            start = i + 1
+    tail = args[start:].strip()
+    if tail or parts:
+        parts.append(tail)
+    return parts
+
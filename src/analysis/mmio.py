@@ -0,0 +1,294 @@
+#!/usr/bin/env python3
+"""
+MMIO / 内存屏障 / 原子操作密度
+
+按调用点统计每个函数和每条热路径（硬中断、NAPI poll、ndo_start_xmit、read / write）上的：
+- MMIO 读 / 写（readl / writel、ioread* / iowrite*、inb / outb），区分 _relaxed / __raw_ 版本
+- 内存屏障：mb / rmb / wmb、dma_*mb、smp_*、smp_store_release / smp_load_acquire
+- 原子读改写：atomic*_inc / add / cmpxchg ...、set_bit / test_and_set_bit ...
+
+并给出可以减少 PCIe 往返的位置：
+- writel_burst: 连续多次非 relaxed 的 MMIO 写（除最后一次外都可用 writel_relaxed）
+- write_in_loop: 循环内的非 relaxed MMIO 写（门铃可以在循环后批量写一次）
+- doorbell_per_packet: ndo_start_xmit 路径上写门铃但没有检查 netdev_xmit_more()
+- redundant_wmb: wmb() 紧跟 writel()（writel 已保证之前的内存写对设备可见）
+- read_on_hot_path: 热路径上的 MMIO 读（非 posted，需等待设备返回）
+
+访问的寄存器由地址参数解析：writel(val, base + REG_CTRL) 的地址按常量表（#define 宏和
+枚举常量，含 -I 头文件）拆成基址和偏移，按寄存器名统计读写次数和所在热路径。
+偏移是字面量时，在 #define 值索引中唯一或少量匹配的宏名（本文件的优先）作为候选名给出。
+"""
+
+import re
+from typing import Dict, List, Optional
+
+from .base import AnalysisContext, AnalysisPass, AnalysisRegistry
+from .callgraph import entry_points, reachable
+from .hot_path import LOOP_FACTOR
+from .metrics import CallSite, body_metrics, split_args
+
+
+BARRIER = re.compile(r'^(?:mb|rmb|wmb|dma_[rw]?mb|smp_[rw]?mb|smp_mb__(?:before|after)_atomic|'
+                     r'smp_store_release|smp_load_acquire|smp_store_mb|mmiowb|io_stop_wc)$')
+ATOMIC_RMW = re.compile(r'^(?:(?:arch_)?atomic(?:64|_long)?_(?:inc|dec|add|sub|and|or|xor|andnot|'
+                        r'xchg|cmpxchg|try_cmpxchg|fetch)\w*|'
+                        r'(?:test_and_)?(?:set|clear|change)_bit(?:_lock)?|cmpxchg\w*|xchg\w*|'
+                        r'refcount_(?:inc|dec|add|sub)\w*)$')
+XMIT_MORE = re.compile(r'\b(?:netdev_xmit_more|xmit_more|__netdev_tx_sent_queue|netdev_tx_sent_queue)\b')
+
+COUNTERS = ("mmio_reads", "mmio_reads_relaxed", "mmio_writes", "mmio_writes_relaxed",
+            "barriers", "atomics")
+# 字面量偏移反查宏名时，最多给出的候选数（更多说明这个值太常见，不足以确定寄存器）
+MAX_CANDIDATES = 3
+
+
+def is_relaxed(site: CallSite) -> bool:
+    return site.name.endswith("_relaxed") or site.name.startswith("__raw_")
+
+
+def function_counts(ctx: AnalysisContext, func: str) -> Dict[str, int]:
+    """单个函数的计数；in_loops 为循环内的调用点数，weighted 按 LOOP_FACTOR ^ 循环深度加权"""
+    cache = ctx.cached("mmio.counts", dict)
+    if func not in cache:
+        counts = dict.fromkeys(COUNTERS, 0)
+        counts["in_loops"] = 0
+        counts["weighted"] = 0
+        for site in body_metrics(ctx, func).calls:
+            key = None
+            if site.is_mmio_read:
+                key = "mmio_reads_relaxed" if is_relaxed(site) else "mmio_reads"
+            elif site.is_mmio_write:
+                key = "mmio_writes_relaxed" if is_relaxed(site) else "mmio_writes"
+            elif BARRIER.match(site.name):
+                key = "barriers"
+            elif ATOMIC_RMW.match(site.name):
+                key = "atomics"
+            if key:
+                counts[key] += 1
+                counts["in_loops"] += bool(site.loop_depth)
+                counts["weighted"] += LOOP_FACTOR ** site.loop_depth
+        cache[func] = counts
+    return cache[func]
+
+
+def site_register(ctx: AnalysisContext, site: CallSite) -> Optional[Dict]:
+    """
+    MMIO 调用点访问的寄存器：{"label", "base", "offset", "names"[, "candidates"]}
+
+    地址是写操作的第二个参数、读操作的第一个参数；地址中没有常量偏移时返回 None。
+    按 (调用名, 参数文本) 缓存：同一寄存器在驱动中通常以相同的写法出现多次。
+    """
+    if not (site.is_mmio_read or site.is_mmio_write):
+        return None
+    cache = ctx.cached("mmio.registers", dict)
+    key = (site.is_mmio_write, site.args)
+    if key not in cache:
+        from .consteval import DEFINE_GROUP
+        from .constants import constant_table, register_label, resolve_offset
+        args = split_args(site.args)
+        index = 1 if site.is_mmio_write else 0
+        register = None
+        if len(args) > index:
+            table = constant_table(ctx)
+            base, offset, names = resolve_offset(table, args[index])
+            if offset is not None:
+                register = {"label": register_label(table, offset, names),
+                            "base": base, "offset": offset, "names": names}
+                if not names:
+                    # 本文件的宏优先，头文件中同值的宏通常与这个设备无关
+                    candidates = table.names_for(offset, DEFINE_GROUP)
+                    candidates = [n for n in candidates if n in table.values] or candidates
+                    if 0 < len(candidates) <= MAX_CANDIDATES:
+                        register["candidates"] = candidates
+        cache[key] = register
+    return cache[key]
+
+
+def function_registers(ctx: AnalysisContext, func: str) -> Dict[str, Dict]:
+    """单个函数访问的寄存器：名字 -> {offset, base, reads, writes, relaxed, in_loops}"""
+    cache = ctx.cached("mmio.function_registers", dict)
+    if func not in cache:
+        registers: Dict[str, Dict] = {}
+        for site in body_metrics(ctx, func).calls:
+            register = site_register(ctx, site)
+            if register is None:
+                continue
+            entry = registers.get(register["label"])
+            if entry is None:
+                entry = registers[register["label"]] = {
+                    "offset": register["offset"], "base": register["base"],
+                    "reads": 0, "writes": 0, "relaxed": 0, "in_loops": 0}
+                if "candidates" in register:
+                    entry["candidates"] = register["candidates"]
+            entry["writes" if site.is_mmio_write else "reads"] += 1
+            entry["relaxed"] += is_relaxed(site)
+            entry["in_loops"] += bool(site.loop_depth)
+        cache[func] = registers
+    return cache[func]
+
+
+def _labels(ctx: AnalysisContext, sites: List[CallSite]) -> List[str]:
+    """调用点访问的寄存器名（去重，保持顺序）"""
+    labels = (site_register(ctx, site) for site in sites)
+    return list(dict.fromkeys(r["label"] for r in labels if r))
+
+
+def function_hints(ctx: AnalysisContext, func: str) -> List[Dict]:
+    """单个函数中可以减少 MMIO 往返的位置"""
+    calls = body_metrics(ctx, func).calls
+    hints = []
+
+    # 连续的 MMIO 写（中间没有其它调用；写操作参数里的调用不算）
+    run: List[CallSite] = []
+    for site in calls + [None]:
+        if site is not None and run and site.pos < run[-1].end:
+            continue
+        if site is not None and site.is_mmio_write:
+            run.append(site)
+            continue
+        strict = [c for c in run if not is_relaxed(c)]
+        if len(run) >= 2 and len(strict) >= 2:
+            hints.append({
+                "kind": "writel_burst", "func": func, "line": run[0].line,
+                "end_line": run[-1].line, "writes": len(run), "non_relaxed": len(strict),
+                "registers": _labels(ctx, run),
+                "message": f"连续 {len(run)} 次 MMIO 写，其中 {len(strict)} 次非 relaxed；"
+                           f"除最后一次外可改为 *_relaxed，只保留一次有序写",
+            })
+        run = []
+
+    for i, site in enumerate(calls):
+        if site.is_mmio_write and not is_relaxed(site) and site.loop_depth:
+            hints.append({
+                "kind": "write_in_loop", "func": func, "line": site.line, "call": site.name,
+                "registers": _labels(ctx, [site]),
+                "message": "循环内的非 relaxed MMIO 写；门铃可在循环结束后写一次",
+            })
+        if site.name == "wmb" and i + 1 < len(calls) and calls[i + 1].is_mmio_write \
+                and not is_relaxed(calls[i + 1]):
+            hints.append({
+                "kind": "redundant_wmb", "func": func, "line": site.line, "call": calls[i + 1].name,
+                "message": f"wmb() 后紧跟 {calls[i + 1].name}()：非 relaxed 的 MMIO 写已保证之前的内存写可见",
+            })
+
+    return hints
+
+
+@AnalysisRegistry.register
+class MmioPass(AnalysisPass):
+    """MMIO、屏障和原子操作的密度"""
+
+    name = "mmio"
+    description = "MMIO / 内存屏障 / 原子操作密度（按函数和热路径），relaxed 访问与批量门铃提示"
+
+    def run(self, ctx: AnalysisContext) -> Dict:
+        functions = ctx.parse_result.functions
+        counts = {f: function_counts(ctx, f) for f in functions}
+        hot_entries = [e for e in entry_points(ctx) if e.hot]
+
+        paths = []
+        hints = []
+        hot_by_function: Dict[str, List[str]] = {}
+        for entry in hot_entries:
+            reached = reachable(ctx, entry.func)
+            total = dict.fromkeys(COUNTERS, 0)
+            weighted = 0
+            for func in reached:
+                hot_by_function.setdefault(func, []).append(entry.label)
+                for key in COUNTERS:
+                    total[key] += counts[func][key]
+                weighted += counts[func]["weighted"]
+            touched = sorted({r for func in reached for r in function_registers(ctx, func)})
+            paths.append(dict(total, entry=entry.label, functions=len(reached), weighted=weighted,
+                              registers=touched))
+            if entry.label.endswith(".ndo_start_xmit"):
+                hint = self._doorbell_hint(ctx, entry, reached)
+                if hint:
+                    hints.append(hint)
+        paths.sort(key=lambda p: (-p["weighted"], p["entry"]))
+
+        for func in functions:
+            for hint in function_hints(ctx, func):
+                entries = hot_by_function.get(func, [])
+                if entries or hint["kind"] == "redundant_wmb":
+                    hints.append(dict(hint, hot_entries=entries))
+        for func, entries in hot_by_function.items():
+            reads = [c for c in body_metrics(ctx, func).calls if c.is_mmio_read]
+            if reads:
+                hints.append({"kind": "read_on_hot_path", "func": func, "line": reads[0].line,
+                              "reads": len(reads), "registers": _labels(ctx, reads), "hot_entries": entries,
+                              "message": f"热路径上 {len(reads)} 次 MMIO 读；状态可改由设备 DMA 写回内存"})
+        order = {"writel_burst": 0, "doorbell_per_packet": 1, "write_in_loop": 2,
+                 "redundant_wmb": 3, "read_on_hot_path": 4}
+        hints.sort(key=lambda h: (not h["hot_entries"], order[h["kind"]], h["func"], h["line"]))
+
+        registers = self._registers(ctx, functions, hot_by_function)
+        per_function = {f: c for f, c in counts.items() if any(c[k] for k in COUNTERS)}
+        return {
+            "functions": dict(sorted(per_function.items(), key=lambda kv: (-kv[1]["weighted"], kv[0]))),
+            "hot_paths": paths,
+            "registers": registers,
+            "hints": hints,
+            "summary": dict(
+                {key: sum(c[key] for c in counts.values()) for key in COUNTERS},
+                functions=len(per_function), hot_paths=len(paths), hints=len(hints),
+                registers=len(registers)),
+        }
+
+    @staticmethod
+    def _registers(ctx: AnalysisContext, functions, hot_by_function: Dict[str, List[str]]) -> Dict:
+        """按寄存器汇总：热路径上访问的在前，其次按访问次数"""
+        registers: Dict[str, Dict] = {}
+        for func in functions:
+            for label, counts in function_registers(ctx, func).items():
+                entry = registers.get(label)
+                if entry is None:
+                    entry = registers[label] = dict(counts, functions=[], hot_entries=[])
+                else:
+                    for key in ("reads", "writes", "relaxed", "in_loops"):
+                        entry[key] += counts[key]
+                entry["functions"].append(func)
+                for hot in hot_by_function.get(func, []):
+                    if hot not in entry["hot_entries"]:
+                        entry["hot_entries"].append(hot)
+        return dict(sorted(registers.items(), key=lambda kv: (
+            not kv[1]["hot_entries"], -(kv[1]["reads"] + kv[1]["writes"]), kv[0])))
+
+    @staticmethod
+    def _doorbell_hint(ctx: AnalysisContext, entry, reached: Dict[str, int]) -> Dict:
+        """发送路径上写门铃（非 relaxed MMIO 写）却没有检查 xmit_more"""
+        functions = ctx.parse_result.functions
+        if any(XMIT_MORE.search(functions[f].body) for f in reached):
+            return {}
+        writes = [(f, c) for f in sorted(reached, key=lambda f: (reached[f], f))
+                  for c in body_metrics(ctx, f).calls if c.is_mmio_write and not is_relaxed(c)]
+        if not writes:
+            return {}
+        func, last = writes[-1]
+        return {
+            "kind": "doorbell_per_packet", "func": func, "line": last.line, "call": last.name,
+            "writes": [f"{f}:{c.line}" for f, c in writes], "hot_entries": [entry.label],
+            "message": "发送路径上每个包都写门铃；可检查 netdev_xmit_more() 批量写门铃",
+        }
+
+    def format_text(self, result: Dict) -> str:
+        s = result["summary"]
+        out = [f"\n📟 MMIO 密度: 读 {s['mmio_reads']}+{s['mmio_reads_relaxed']} relaxed, "
+               f"写 {s['mmio_writes']}+{s['mmio_writes_relaxed']} relaxed, "
+               f"屏障 {s['barriers']}, 原子 {s['atomics']} ({s['functions']} 个函数)"]
+        for p in result["hot_paths"]:
+            out.append(f"   {p['entry']:<36} 读 {p['mmio_reads']}/{p['mmio_reads_relaxed']}  "
+                       f"写 {p['mmio_writes']}/{p['mmio_writes_relaxed']}  屏障 {p['barriers']}  "
+                       f"原子 {p['atomics']}  加权 {p['weighted']}")
+        registers = list(result.get("registers", {}).items())
+        for label, r in registers[:10]:
+            hot = f"  热路径 {', '.join(r['hot_entries'])}" if r["hot_entries"] else ""
+            alias = f" (可能是 {'/'.join(r['candidates'])})" if r.get("candidates") else ""
+            out.append(f"   🔧 {label:<24} +{r['offset']:#06x}{alias}  读 {r['reads']}  写 {r['writes']}"
+                       f" (relaxed {r['relaxed']}){hot}")
+        if len(registers) > 10:
+            out.append(f"   ... 共 {len(registers)} 个寄存器")
+        for h in result["hints"]:
+            regs = f" [{', '.join(h['registers'])}]" if h.get("registers") else ""
+            out.append(f"   💡 {h['func']}() 行 {h['line']} [{h['kind']}]{regs} {h['message']}")
+        return "\n".join(out)
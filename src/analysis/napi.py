@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+"""
+NAPI 与中断合并模式审计
+
+按文件（驱动）报告收发路径的结构：
+- NAPI poll 函数（netif_napi_add 注册，知识库 napi_struct）：是否按 budget 限制处理量、
+  是否调用 napi_complete_done()、收包用 napi_gro_receive / netif_receive_skb 还是 netif_rx
+- 硬中断处理函数：是调用 napi_schedule() 推迟到 poll，还是直接在硬中断里收包
+  （netif_rx / netif_receive_skb / eth_type_trans）或回收发送完成的 skb
+- 发送路径（ndo_start_xmit）与发送完成在哪个上下文回收
+- 中断合并：ethtool_ops 的 get_coalesce / set_coalesce、net_dim 自适应合并
+
+驱动类型：napi（硬中断只调度 poll）、legacy（硬中断中直接处理包，没有 NAPI）、
+mixed（有 NAPI，但硬中断仍直接处理包）。legacy 驱动在高负载下每个包一次中断，
+是吞吐量问题的主要来源。
+"""
+
+import re
+from typing import Dict, List, Optional, Set
+
+from .base import AnalysisContext, AnalysisPass, AnalysisRegistry
+from .busy_wait import loop_condition
+from .callgraph import call_chain, entry_points, function_body, reachable
+from .metrics import body_metrics, split_args
+
+
+# 把收到的包交给协议栈
+RX_DELIVERY = re.compile(r'^(?:napi_gro_receive|napi_gro_frags|netif_receive_skb(?:_list)?|'
+                         r'netif_rx(?:_ni|_any_context)?|gro_cells_receive)$')
+# 收包处理的标志（分配 skb、解析以太网头）
+RX_PROCESS = re.compile(r'^(?:eth_type_trans|(?:__)?netdev_alloc_skb(?:_ip_align)?|dev_alloc_skb|'
+                        r'napi_alloc_skb|build_skb|napi_build_skb)$')
+# 发送完成回收
+TX_CLEAN = re.compile(r'^(?:dev_(?:kfree|consume)_skb_(?:irq|any)|napi_consume_skb|'
+                      r'netdev_(?:tx_)?completed_queue|netif_(?:tx_)?wake_queue)$')
+LEGACY_RX = re.compile(r'^netif_rx(?:_ni|_any_context)?$')
+DIM = re.compile(r'^(?:net_dim|dim_update_sample|net_dim_get_\w+)$')
+
+NAPI_KB = "napi_struct"
+
+
+def napi_calls(ctx: AnalysisContext, key: str) -> Set[str]:
+    """知识库 napi_struct 中的调度 / 结束函数"""
+    return set(ctx.kb.get(NAPI_KB, {}).get(key, []))
+
+
+def _calls_on_path(ctx: AnalysisContext, root: str, pattern) -> Dict[str, List[str]]:
+    """root 可达的函数中匹配的调用 -> 最短调用链（末尾为调用名）"""
+    found: Dict[str, List[str]] = {}
+    depths = reachable(ctx, root)
+    for func in sorted(depths, key=lambda f: (depths[f], f)):
+        for site in body_metrics(ctx, func).calls:
+            hit = pattern(site.name) if callable(pattern) else pattern.match(site.name)
+            if hit and site.name not in found:
+                found[site.name] = call_chain(ctx, root, func) + [site.name]
+    return found
+
+
+def budget_checks(ctx: AnalysisContext, func: str, param: str, depth: int = 0) -> List[str]:
+    """
+    budget 参数在 func 及其被调函数（传入 budget 的）中的使用方式
+
+    Returns:
+        "loop"（限制了循环：出现在循环条件中，或在循环内参与比较）、
+        "compare"（只在循环外比较，如 work_done < budget 时结束轮询）、
+        "passed"（传给了被调函数，被调函数中的使用一并计入）
+    """
+    body = function_body(ctx, func)
+    name = re.escape(param)
+    metrics = body_metrics(ctx, func)
+    uses = []
+    for loop in metrics.loops:
+        lo, hi = loop_condition(body, loop)
+        if re.search(rf'\b{name}\b', body[lo:hi]):
+            uses.append("loop")
+            break
+    for m in re.finditer(rf'(?:(?<!-)[<>]=?|[!=]=)\s*{name}\b|\b{name}\s*(?:[<>]=?|[!=]=|--)|--\s*{name}\b',
+                         body):
+        use = "loop" if metrics.loops_at(m.start()) else "compare"
+        if use not in uses:
+            uses.append(use)
+    functions = ctx.parse_result.functions
+    if depth < 2:
+        for site in metrics.calls:
+            if site.name not in functions or site.name == func:
+                continue
+            params = functions[site.name].params
+            for index, arg in enumerate(split_args(site.args)):
+                if re.search(rf'\b{name}\b', arg) and index < len(params):
+                    inner = budget_checks(ctx, site.name, params[index].name, depth + 1)
+                    uses.extend(u for u in inner + ["passed"] if u not in uses)
+    return uses
+
+
+def poll_record(ctx: AnalysisContext, func: str) -> Dict:
+    """单个 NAPI poll 函数的审计"""
+    params = ctx.parse_result.functions[func].params
+    budget = params[1].name if len(params) >= 2 else ""
+    checks = budget_checks(ctx, func, budget) if budget else []
+    complete = _calls_on_path(ctx, func, lambda n: n in napi_calls(ctx, "complete_functions"))
+    delivery = _calls_on_path(ctx, func, RX_DELIVERY)
+    tx_clean = _calls_on_path(ctx, func, TX_CLEAN)
+
+    flags = []
+    if "loop" not in checks:
+        flags.append("ignores_budget")
+    if not complete:
+        flags.append("no_complete")
+    elif "napi_complete_done" not in complete:
+        flags.append("legacy_complete")
+    if any(LEGACY_RX.match(c) for c in delivery):
+        flags.append("netif_rx_in_poll")
+    return {
+        "func": func,
+        "budget": budget,
+        "budget_checks": checks,
+        "complete": sorted(complete),
+        "rx_delivery": sorted(delivery),
+        "tx_clean": sorted(tx_clean),
+        "flags": flags,
+    }
+
+
+def irq_record(ctx: AnalysisContext, entry) -> Dict:
+    """单个中断处理函数：推迟到 NAPI 还是直接处理包"""
+    schedule = _calls_on_path(ctx, entry.func, lambda n: n in napi_calls(ctx, "trigger_functions"))
+    delivery = _calls_on_path(ctx, entry.func, RX_DELIVERY)
+    process = _calls_on_path(ctx, entry.func, RX_PROCESS)
+    tx_clean = _calls_on_path(ctx, entry.func, TX_CLEAN)
+
+    # 直接处理包的循环（循环内交付协议栈或分配 skb）
+    loops = []
+    for func in reachable(ctx, entry.func):
+        for site in body_metrics(ctx, func).calls:
+            if site.loop_depth and (RX_DELIVERY.match(site.name) or RX_PROCESS.match(site.name)):
+                loops.append({"func": func, "line": site.line, "call": site.name})
+                break
+
+    flags = []
+    if delivery or process:
+        flags.append("rx_in_irq")
+    if loops:
+        flags.append("packet_loop_in_irq")
+    if tx_clean:
+        flags.append("tx_clean_in_irq")
+    if schedule:
+        flags.append("defers_to_napi")
+    paths = dict(process, **delivery)
+    paths.update(tx_clean)
+    return {
+        "entry": entry.label,
+        "func": entry.func,
+        "kind": entry.kind,
+        "napi_schedule": sorted(schedule),
+        "rx_delivery": sorted(delivery),
+        "rx_process": sorted(process),
+        "tx_clean": sorted(tx_clean),
+        "packet_loops": loops,
+        "paths": paths,
+        "flags": flags,
+    }
+
+
+def classify(polls: List[Dict], irqs: List[Dict]) -> Optional[str]:
+    """驱动类型: napi / legacy / mixed；不涉及收发包时返回 None"""
+    direct = any("rx_in_irq" in r["flags"] or "tx_clean_in_irq" in r["flags"]
+                 for r in irqs if r["kind"] == "irq")
+    if polls:
+        return "mixed" if direct else "napi"
+    return "legacy" if direct else None
+
+
+@AnalysisRegistry.register
+class NapiPass(AnalysisPass):
+    """NAPI poll、硬中断收包和中断合并"""
+
+    name = "napi"
+    description = "NAPI 审计：poll 的 budget / napi_complete_done、硬中断中直接收包（legacy 驱动）、收发路径结构、中断合并"
+
+    def run(self, ctx: AnalysisContext) -> Dict:
+        entries = entry_points(ctx)
+        polls = [poll_record(ctx, e.func) for e in entries if e.kind == "napi"]
+        irqs = [irq_record(ctx, e) for e in entries if e.kind in ("irq", "threaded_irq")]
+
+        xmit = []
+        for entry in entries:
+            if entry.label.endswith(".ndo_start_xmit"):
+                xmit.append({"entry": entry.label, "func": entry.func,
+                             "tx_clean": sorted(_calls_on_path(ctx, entry.func, TX_CLEAN))})
+        # 发送完成在哪里回收
+        tx_clean_in = [f"napi:{p['func']}" for p in polls if p["tx_clean"]] + \
+                      [r["entry"] for r in irqs if r["tx_clean"]] + \
+                      [x["entry"] for x in xmit if x["tx_clean"]]
+
+        coalesce = {}
+        for ops in ctx.struct_ops:
+            if ops["struct_type"] == "ethtool_ops":
+                coalesce.update({f: ops["mappings"][f] for f in ("get_coalesce", "set_coalesce")
+                                 if f in ops["mappings"]})
+        dim = sorted({site.name for f in ctx.parse_result.functions
+                      for site in body_metrics(ctx, f).calls if DIM.match(site.name)})
+
+        driver = classify(polls, irqs)
+        findings = []
+        for r in irqs:
+            if r["kind"] == "irq" and ("rx_in_irq" in r["flags"] or "tx_clean_in_irq" in r["flags"]):
+                findings.append({
+                    "kind": "packets_in_hardirq", "func": r["func"], "entry": r["entry"],
+                    "calls": sorted(r["paths"]),
+                    "message": "硬中断中直接处理包；应关闭设备中断后 napi_schedule()，在 poll 中按 budget 处理",
+                })
+        for p in polls:
+            for flag in p["flags"]:
+                findings.append({"kind": flag, "func": p["func"], "entry": f"napi:{p['func']}",
+                                 "message": _POLL_MESSAGES[flag]})
+        if driver and not coalesce and not dim:
+            findings.append({"kind": "no_coalescing", "func": "", "entry": "",
+                             "message": "没有 ethtool get/set_coalesce 或 net_dim：无法调节中断合并"})
+
+        return {
+            "driver": driver,
+            "polls": polls,
+            "irqs": irqs,
+            "xmit": xmit,
+            "tx_clean_in": tx_clean_in,
+            "coalescing": {"ethtool": coalesce, "dim": dim},
+            "findings": findings,
+            "summary": {
+                "driver": driver,
+                "polls": len(polls),
+                "irqs": len(irqs),
+                "irqs_deferring": sum(1 for r in irqs if "defers_to_napi" in r["flags"]),
+                "irqs_with_packets": sum(1 for r in irqs if "rx_in_irq" in r["flags"]
+                                         or "tx_clean_in_irq" in r["flags"]),
+                "findings": len(findings),
+            },
+        }
+
+    def format_text(self, result: Dict) -> str:
+        summary = result["summary"]
+        out = [f"\n📥 NAPI: 驱动类型 {summary['driver'] or '-'}, poll {summary['polls']} 个, "
+               f"中断 {summary['irqs']} 个 (调度 NAPI {summary['irqs_deferring']}, "
+               f"直接处理包 {summary['irqs_with_packets']})"]
+        for p in result["polls"]:
+            out.append(f"   poll {p['func']}(budget={p['budget'] or '?'})  "
+                       f"budget 检查: {', '.join(p['budget_checks']) or '无'}  "
+                       f"结束: {', '.join(p['complete']) or '无'}  收包: {', '.join(p['rx_delivery']) or '-'}")
+        for r in result["irqs"]:
+            out.append(f"   {r['entry']}  [{', '.join(r['flags']) or '-'}]")
+        for f in result["findings"]:
+            where = f"{f['func']}() " if f["func"] else ""
+            out.append(f"   ⚠️ {where}[{f['kind']}] {f['message']}")
+        return "\n".join(out)
+
+
+_POLL_MESSAGES = {
+    "ignores_budget": "poll 的收包循环没有受 budget 限制，一次 poll 可能处理任意多个包",
+    "no_complete": "poll 中没有 napi_complete_done()：设备中断无法重新打开",
+    "legacy_complete": "使用 napi_complete()，应改用 napi_complete_done(napi, work_done)（支持 GRO 刷新和忙轮询）",
+    "netif_rx_in_poll": "poll 中用 netif_rx() 收包，多一次 backlog 排队；应改用 napi_gro_receive()",
+}
@@ -0,0 +1,266 @@
+#!/usr/bin/env python3
+"""
+工作队列 / 定时器重新调度风暴
+
+对知识库 trigger_functions 中的调度调用（schedule_work、queue_work、mod_timer、
+hrtimer_start、tasklet_schedule、napi_schedule ...）：
+- 按第一个对象参数（&priv->tx_work）和 INIT_WORK / timer_setup / tasklet_init /
+  .function = 的初始化语句，解析出被调度的处理函数
+- 记录调用点从哪些执行上下文可达、是否在循环中、参数为常量时的周期
+- 构建调度图：执行上下文 -> 被调度的处理函数
+
+标记的模式：
+- in_loop: 循环内调度（每次迭代一次 queue_work / mod_timer）
+- self_rearm: 处理函数重新调度自己（hrtimer 回调返回 HRTIMER_RESTART 同样算）
+- short_period: 自我重新调度且周期小于 SHORT_PERIOD_MS
+- cycle: 处理函数之间互相调度（A 调度 B，B 又调度 A）
+- per_interrupt: 在硬中断 / NAPI 中调度（每次中断一次）
+"""
+
+import re
+from typing import Dict, List, Optional, Tuple
+
+from .base import AnalysisContext, AnalysisPass, AnalysisRegistry
+from .callgraph import Condensation, contexts_by_function, entry_points
+from .consteval import eval_int
+from .metrics import CallSite, body_metrics, split_args
+
+
+# 知识库中的结构体 -> 异步处理函数类型（UnifiedAnalyzer.ASYNC_PATTERNS）
+KB_KINDS = {
+    "work_struct": "work",
+    "delayed_work": "delayed_work",
+    "tasklet_struct": "tasklet",
+    "timer_list": "timer",
+    "hrtimer": "hrtimer",
+    "kthread": "kthread",
+    "napi_struct": "napi",
+}
+# 初始化语句中对象参数不在第一个位置的类型: netif_napi_add(dev, &priv->napi, poll)
+INIT_OBJECT_ARG = {"napi": 1}
+
+# 对象参数不在第一个位置的调度函数
+OBJECT_ARG = {"queue_work": 1, "queue_work_on": 2, "queue_delayed_work": 1,
+              "queue_delayed_work_on": 2, "mod_delayed_work": 1}
+# 延迟 / 到期参数的位置；mod_timer 等为绝对到期时间（jiffies + x）
+DELAY_ARG = {"schedule_delayed_work": 1, "queue_delayed_work": 2, "queue_delayed_work_on": 3,
+             "mod_delayed_work": 2, "mod_timer": 1, "mod_timer_pending": 1, "timer_reduce": 1,
+             "hrtimer_start": 1, "hrtimer_start_range_ns": 1,
+             "hrtimer_forward_now": 1, "hrtimer_forward": 2}
+ABSOLUTE_EXPIRES = {"mod_timer", "mod_timer_pending", "timer_reduce"}
+
+SHORT_PERIOD_MS = 10.0
+DEFAULT_HZ = 250
+
+_TO_MS = {
+    "msecs_to_jiffies": 1.0, "usecs_to_jiffies": 1e-3, "nsecs_to_jiffies": 1e-6,
+    "ms_to_ktime": 1.0, "us_to_ktime": 1e-3, "ns_to_ktime": 1e-6,
+}
+_CONVERT = re.compile(r'^(\w+)\s*\((.*)\)$', re.S)
+_RESTART = re.compile(r'\breturn\s+HRTIMER_RESTART\b')
+# hrtimer 的 .function = 初始化
+_FUNCTION_FIELD = re.compile(r'([\w.>\-]+?)\s*(?:\.|->)function\s*=')
+
+
+def object_key(expr: str) -> str:
+    """对象表达式去掉基变量: &priv->tx_work -> "tx_work"，全局变量保持原名"""
+    expr = re.sub(r'[\s&()]', '', expr)
+    for sep in ('->', '.'):
+        if sep in expr:
+            return expr.split(sep, 1)[1].replace('->', '.')
+    return expr
+
+
+def handler_bindings(ctx: AnalysisContext) -> Dict[str, Tuple[str, str]]:
+    """对象键 -> (处理函数, 类型)，取自异步处理函数的初始化语句"""
+    def build() -> Dict[str, Tuple[str, str]]:
+        bindings = {}
+        for handler in ctx.async_handlers:
+            text = handler.init_pattern
+            m = _FUNCTION_FIELD.match(text)
+            if m:
+                key = object_key(m.group(1))
+            else:
+                paren = text.find('(')
+                args = split_args(text[paren + 1:text.rfind(')')]) if paren >= 0 else []
+                index = INIT_OBJECT_ARG.get(handler.handler_type, 0)
+                if len(args) <= index or handler.handler_type == "kthread":
+                    continue
+                key = object_key(args[index])
+            bindings.setdefault(key, (handler.func_name, handler.handler_type))
+        return bindings
+    return ctx.cached("rearm.bindings", build)
+
+
+def trigger_kinds(ctx: AnalysisContext) -> Dict[str, str]:
+    """调度函数 -> 处理函数类型（知识库 trigger_functions）"""
+    def build() -> Dict[str, str]:
+        triggers = {}
+        for struct, kind in KB_KINDS.items():
+            for name in ctx.kb.get(struct, {}).get("trigger_functions", []):
+                triggers[name] = kind
+        return triggers
+    return ctx.cached("rearm.triggers", build)
+
+
+def period_ms(call: str, args: List[str], hz: int) -> Optional[float]:
+    """调度延迟（毫秒）；参数不是常量返回 None"""
+    index = DELAY_ARG.get(call)
+    if index is None or index >= len(args):
+        return None
+    expr = re.sub(r'\s+', ' ', args[index]).strip()
+    if call in ABSOLUTE_EXPIRES:
+        if expr == "jiffies":
+            return 0.0
+        m = re.match(r'^jiffies\s*\+\s*(.+)$', expr)
+        if not m:
+            return None
+        expr = m.group(1)
+    m = _CONVERT.match(expr)
+    if m and m.group(1) in _TO_MS:
+        value = eval_int(m.group(2), {"HZ": hz})
+        return None if value is None else value * _TO_MS[m.group(1)]
+    if m and m.group(1) == "ktime_set":
+        parts = [eval_int(a) for a in split_args(m.group(2))]
+        return None if None in parts or len(parts) != 2 else parts[0] * 1000.0 + parts[1] * 1e-6
+    value = eval_int(expr, {"HZ": hz})
+    if value is None:
+        return None
+    # hrtimer 的裸整数是纳秒，其余是 jiffies
+    return value * 1e-6 if call.startswith("hrtimer") else value * 1000.0 / hz
+
+
+@AnalysisRegistry.register
+class RearmPass(AnalysisPass):
+    """调度图与重新调度风暴模式"""
+
+    name = "rearm"
+    description = "工作队列/定时器重新调度：调度图（谁调度谁）、循环内调度、自我重新调度、短周期、互相调度"
+
+    def run(self, ctx: AnalysisContext) -> Dict:
+        hz = int(ctx.option("hz") or DEFAULT_HZ)
+        triggers = trigger_kinds(ctx)
+        bindings = handler_bindings(ctx)
+        contexts = contexts_by_function(ctx)
+        functions = ctx.parse_result.functions
+        handler_labels = {func: f"{kind}:{func}" for func, kind in bindings.values()}
+        hot = {e.label for e in entry_points(ctx) if e.hot}
+
+        sites = []
+        for func in functions:
+            for site in body_metrics(ctx, func).calls:
+                if site.name in triggers:
+                    sites.append(self._site(func, site, triggers[site.name], bindings, contexts, hz))
+
+        # 调度图: 执行上下文 -> 处理函数
+        edges: Dict[Tuple[str, str], Dict] = {}
+        for s in sites:
+            for source in s["contexts"]:
+                edge = edges.setdefault((source, s["target"] or f"?{s['object']}"), {
+                    "from": source, "to": s["target"] or f"?{s['object']}", "calls": [], "sites": 0})
+                edge["sites"] += 1
+                if s["call"] not in edge["calls"]:
+                    edge["calls"].append(s["call"])
+
+        # 处理函数之间的调度环
+        graph = {label: [] for label in handler_labels.values()}
+        for (source, target) in edges:
+            if source in graph and target in graph and target not in graph[source]:
+                graph[source].append(target)
+        cond = Condensation(graph)
+        cyclic = {label for comp in cond.sccs if len(comp) > 1 for label in comp}
+
+        for s in sites:
+            flags = s["flags"]
+            if s["loop_depth"]:
+                flags.append("in_loop")
+            if s["target"] and s["target"] in s["contexts"]:
+                flags.append("self_rearm")
+                if s["period_ms"] is not None and s["period_ms"] < SHORT_PERIOD_MS:
+                    flags.append("short_period")
+            if s["target"] in cyclic and any(
+                    c in cyclic and c != s["target"] and cond.scc_of[c] == cond.scc_of[s["target"]]
+                    for c in s["contexts"]):
+                flags.append("cycle")
+            if any(c in hot for c in s["contexts"]):
+                flags.append("per_interrupt")
+
+        # hrtimer 回调返回 HRTIMER_RESTART，周期取自 hrtimer_forward(_now)
+        restarts = []
+        for func, kind in bindings.values():
+            if kind == "hrtimer" and func in functions and _RESTART.search(functions[func].body):
+                forward = [period_ms(c.name, split_args(c.args), hz)
+                           for c in body_metrics(ctx, func).calls if c.name.startswith("hrtimer_forward")]
+                period = forward[0] if forward else None
+                restarts.append({
+                    "handler": handler_labels[func],
+                    "period_ms": period,
+                    "flags": ["self_rearm"] + (["short_period"] if period is not None
+                                               and period < SHORT_PERIOD_MS else []),
+                })
+
+        severity = {"in_loop": 0, "cycle": 0, "short_period": 0, "self_rearm": 1, "per_interrupt": 2}
+        sites.sort(key=lambda s: (min((severity[f] for f in s["flags"]), default=3), s["func"], s["line"]))
+        flagged = [s for s in sites if s["flags"]]
+        return {
+            "hz": hz,
+            "handlers": [{"label": label, "func": func} for func, label in sorted(handler_labels.items())],
+            "sites": sites,
+            "graph": {
+                "nodes": sorted({e["from"] for e in edges.values()} | {e["to"] for e in edges.values()}),
+                "edges": sorted(edges.values(), key=lambda e: (e["from"], e["to"])),
+            },
+            "hrtimer_restart": restarts,
+            "cycles": [sorted(comp) for comp in cond.sccs if len(comp) > 1],
+            "summary": {
+                "sites": len(sites),
+                "flagged": len(flagged),
+                "in_loop": sum(1 for s in sites if "in_loop" in s["flags"]),
+                "self_rearm": sum(1 for s in sites if "self_rearm" in s["flags"]) + len(restarts),
+                "short_period": sum(1 for s in sites if "short_period" in s["flags"]) +
+                                sum(1 for r in restarts if "short_period" in r["flags"]),
+                "cycles": sum(1 for comp in cond.sccs if len(comp) > 1),
+                "unresolved": sum(1 for s in sites if not s["target"]),
+            },
+        }
+
+    @staticmethod
+    def _site(func: str, site: CallSite, kind: str, bindings, contexts, hz: int) -> Dict:
+        args = split_args(site.args)
+        index = OBJECT_ARG.get(site.name, 0)
+        obj = object_key(args[index]) if index < len(args) else ""
+        # &priv->dwork.work 这类取内层成员的写法：逐级去掉尾部成员再查
+        key = obj
+        while key and key not in bindings and '.' in key:
+            key = key.rsplit('.', 1)[0]
+        target = bindings.get(key)
+        labels = [e.label for e in contexts.get(func, [])] or [f"{func}()"]
+        return {
+            "func": func,
+            "call": site.name,
+            "line": site.line,
+            "kind": kind,
+            "object": obj,
+            "target": f"{target[1]}:{target[0]}" if target else None,
+            "contexts": labels,
+            "loop_depth": site.loop_depth,
+            "period_ms": period_ms(site.name, args, hz),
+            "flags": [],
+        }
+
+    def format_text(self, result: Dict) -> str:
+        summary = result["summary"]
+        out = [f"\n🔁 重新调度: {summary['sites']} 个调度点 (循环内 {summary['in_loop']}, "
+               f"自我重新调度 {summary['self_rearm']}, 短周期 {summary['short_period']}, "
+               f"互相调度 {summary['cycles']})"]
+        for e in result["graph"]["edges"]:
+            out.append(f"   {e['from']} --{'/'.join(e['calls'])}--> {e['to']}")
+        for s in result["sites"]:
+            if s["flags"]:
+                period = f"  周期 {s['period_ms']:g} ms" if s["period_ms"] is not None else ""
+                out.append(f"   ⚠️ {s['func']}() 行 {s['line']} {s['call']}({s['object']}) "
+                           f"[{', '.join(s['flags'])}]{period}")
+        for r in result["hrtimer_restart"]:
+            period = f"  周期 {r['period_ms']:g} ms" if r["period_ms"] is not None else ""
+            out.append(f"   ⚠️ {r['handler']} 返回 HRTIMER_RESTART [{', '.join(r['flags'])}]{period}")
+        return "\n".join(out)
@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""
+原子上下文睡眠检查
+
+报告从原子上下文到可能睡眠的调用的每一条路径（附调用链作为证据）：
+
+原子上下文（源）
+- 不可睡眠的入口：硬中断、tasklet、定时器、hrtimer、NAPI poll、ndo_start_xmit
+  （以及知识库中 context 标注"不可睡眠"的操作表回调）
+- 自旋锁 / 关中断 / 关抢占 / RCU 读临界区：临界区内的调用
+
+可能睡眠的调用（汇）
+- 知识库 kernel_apis 中 time_hint 含"睡眠" / "阻塞" / "页错误"的 API
+- 带会睡眠的 GFP 标志（GFP_KERNEL / GFP_NOIO / GFP_NOFS / GFP_USER ...）的分配；
+  不带回收位的标志（GFP_ATOMIC / GFP_NOWAIT / 只有 GFP_DMA 等）不会睡眠，列为热路径上的分配；
+  GFP 标志来自变量的分配无法判断，单独列出（unknown_gfp）
+
+传播在调用图的强连通分量缩点上进行，每个源一个位，按拓扑序一次传播，
+整体线性于调用图规模；只对命中的 (源, 函数) 对回溯一条调用链。
+"""
+
+import re
+from typing import Dict, List, Optional, Tuple
+
+from .base import AnalysisContext, AnalysisPass, AnalysisRegistry
+from .callgraph import call_chain, condensation, entry_points
+from .locks import lock_regions
+from .metrics import CallSite, body_metrics
+
+
+SLEEP_HINTS = ("睡眠", "阻塞", "页错误")
+
+SLEEPING_GFP = re.compile(
+    r'\b(?:GFP_KERNEL(?:_ACCOUNT)?|GFP_NOIO|GFP_NOFS|GFP_USER|GFP_HIGHUSER(?:_MOVABLE)?|'
+    r'__GFP_DIRECT_RECLAIM|__GFP_RECLAIM)\b')
+GFP_FLAG = re.compile(r'\b_?_?GFP_\w+')
+
+# 不带 GFP 参数、内部固定用 GFP_ATOMIC 的分配函数
+IMPLICIT_ATOMIC_ALLOCS = re.compile(
+    r'^(?:dev_alloc_skb|netdev_alloc_skb(?:_ip_align)?|napi_alloc_skb|'
+    r'(?:netdev|napi)_alloc_frag|dev_alloc_pages?)$')
+
+# 分配函数
+ALLOC_CALLS = re.compile(
+    r'^(?:k[mz]alloc\w*|kcalloc\w*|krealloc\w*|kmem_cache_(?:z)?alloc\w*|'
+    r'(?:__)?(?:net|napi|dev)?_?alloc_skb\w*|alloc_pages?\w*|__get_free_pages?|'
+    r'dma_alloc_\w+|dma_pool_(?:z)?alloc|devm_k[mz]alloc\w*|kstrdup\w*|kmemdup\w*|'
+    r'mempool_alloc|page_pool_\w*alloc\w*)$')
+
+
+def sleep_apis(ctx: AnalysisContext) -> Dict[str, str]:
+    """知识库中可能睡眠的 API -> time_hint"""
+    def build() -> Dict[str, str]:
+        apis = ctx.kb.get("kernel_apis", {})
+        return {name: info["time_hint"] for name, info in apis.items()
+                if isinstance(info, dict) and any(h in info.get("time_hint", "") for h in SLEEP_HINTS)}
+    return ctx.cached("sleep.apis", build)
+
+
+def classify(ctx: AnalysisContext, site: CallSite) -> Optional[Tuple[str, str]]:
+    """
+    调用点是否可能睡眠
+
+    Returns:
+        (原因, 类别) 类别为 "sleep" / "gfp"；不带回收位的 GFP 掩码（GFP_ATOMIC、
+        GFP_DMA 等）为 (标志, "atomic_alloc")，
+        GFP 标志无法确定的分配为 ("", "unknown_gfp")；否则 None
+    """
+    gfp = GFP_FLAG.findall(site.args)
+    if gfp:
+        flags = '|'.join(dict.fromkeys(gfp))
+        if SLEEPING_GFP.search(site.args):
+            return flags, "gfp"
+        # 不带直接回收位的掩码（GFP_ATOMIC、只有 GFP_DMA / __GFP_NOWARN 等）不会睡眠，
+        # 不再回落到知识库里按 GFP_KERNEL 写的 API 提示
+        return flags, "atomic_alloc"
+    if IMPLICIT_ATOMIC_ALLOCS.match(site.name):
+        return "GFP_ATOMIC", "atomic_alloc"
+    if ALLOC_CALLS.match(site.name):
+        # GFP 标志来自变量时无法判断，单独列出
+        return "", "unknown_gfp"
+    hint = sleep_apis(ctx).get(site.name)
+    if hint:
+        return hint, "sleep"
+    return None
+
+
+@AnalysisRegistry.register
+class SleepInAtomicPass(AnalysisPass):
+    """原子上下文到可能睡眠调用的路径"""
+
+    name = "sleep-in-atomic"
+    description = "原子上下文（IRQ / 软中断 / 自旋锁区间）中可能睡眠的调用和 GFP_KERNEL 分配"
+
+    def run(self, ctx: AnalysisContext) -> Dict:
+        functions = ctx.parse_result.functions
+        cond = condensation(ctx)
+
+        # 源: 不可睡眠的入口 + 原子临界区；每个源一个位
+        sources: List[Dict] = []
+        seeds: Dict[str, int] = {}
+        for entry in entry_points(ctx):
+            if entry.atomic:
+                seeds[entry.func] = seeds.get(entry.func, 0) | (1 << len(sources))
+                sources.append({"kind": "entry", "label": entry.label, "func": entry.func,
+                                "root": entry.func})
+        regions = [r for rs in lock_regions(ctx).values() for r in rs if r.atomic]
+        region_sources = []
+        for region in regions:
+            bit = 1 << len(sources)
+            label = f"{region.lock_call}({region.lock}) @ {region.func}:{region.line}"
+            sources.append({"kind": "lock", "label": label, "func": region.func,
+                            "line": region.line, "lock": region.lock})
+            region_sources.append((region, bit))
+            for site in region.calls:
+                if site.name in functions:
+                    seeds[site.name] = seeds.get(site.name, 0) | bit
+        bits = cond.propagate(seeds)
+
+        violations = []
+        allocations = []
+        unknown_gfp = []
+        seen = set()
+
+        def report(source_index: int, func: str, site: CallSite, reason: str, category: str,
+                   path: List[str]) -> None:
+            key = (source_index, func, site.line, site.name)
+            if key in seen:
+                return
+            seen.add(key)
+            record = {
+                "source": sources[source_index]["label"],
+                "source_kind": sources[source_index]["kind"],
+                "func": func,
+                "call": site.name,
+                "line": site.line,
+                "reason": reason,
+                "path": path + [site.name],
+            }
+            if category == "atomic_alloc":
+                allocations.append(record)
+            elif category == "unknown_gfp":
+                unknown_gfp.append(record)
+            else:
+                record["category"] = category
+                violations.append(record)
+
+        # 同一函数临界区内的直接调用
+        for region, bit in region_sources:
+            index = bit.bit_length() - 1
+            for site in region.calls:
+                hit = classify(ctx, site)
+                if hit:
+                    report(index, region.func, site, hit[0], hit[1], [region.func])
+
+        # 经调用图可达的函数中的调用
+        for func in functions:
+            reached = bits[cond.scc_of[func]] if func in cond.scc_of else 0
+            if not reached:
+                continue
+            hits = [(site, classify(ctx, site)) for site in body_metrics(ctx, func).calls]
+            hits = [(site, hit) for site, hit in hits if hit]
+            if not hits:
+                continue
+            for index in _bit_indices(reached):
+                path = self._witness(ctx, sources[index], region_sources, index, func)
+                if path is None:
+                    continue
+                for site, hit in hits:
+                    report(index, func, site, hit[0], hit[1], path)
+
+        violations.sort(key=lambda v: (v["source"], len(v["path"]), v["line"]))
+        allocations.sort(key=lambda v: (v["source"], len(v["path"]), v["line"]))
+        unknown_gfp.sort(key=lambda v: (v["source"], len(v["path"]), v["line"]))
+        return {
+            "sources": sources,
+            "violations": violations,
+            "atomic_allocations": allocations,
+            "unknown_gfp": unknown_gfp,
+            "summary": {
+                "sources": len(sources),
+                "violations": len(violations),
+                "gfp_kernel": sum(1 for v in violations if v["category"] == "gfp"),
+                "atomic_allocations": len(allocations),
+                "unknown_gfp": len(unknown_gfp),
+                "functions": len(functions),
+                "sccs": len(cond.sccs),
+            },
+        }
+
+    @staticmethod
+    def _witness(ctx: AnalysisContext, source: Dict, region_sources, index: int,
+                 func: str) -> Optional[List[str]]:
+        """源到 func 的一条调用链"""
+        if source["kind"] == "entry":
+            return call_chain(ctx, source["root"], func)
+        region = next(r for r, bit in region_sources if bit == 1 << index)
+        best = None
+        for site in region.calls:
+            if site.name in ctx.parse_result.functions:
+                chain = call_chain(ctx, site.name, func)
+                if chain and (best is None or len(chain) < len(best)):
+                    best = chain
+        return [region.func] + best if best else None
+
+    def format_text(self, result: Dict) -> str:
+        summary = result["summary"]
+        out = [f"\n💤 原子上下文睡眠检查: {summary['violations']} 处可能睡眠 "
+               f"(GFP_KERNEL 分配 {summary['gfp_kernel']}), "
+               f"原子上下文中的分配 {summary['atomic_allocations']} 处"
+               f"（GFP 标志未知 {summary['unknown_gfp']} 处）, 源 {summary['sources']} 个"]
+        for v in result["violations"]:
+            out.append(f"   ❌ {v['source']}")
+            out.append(f"      {' -> '.join(v['path'])}()  行 {v['line']}  [{v['reason']}]")
+        for v in result["unknown_gfp"]:
+            out.append(f"   ❓ {v['source']}: {' -> '.join(v['path'])}()  行 {v['line']}  GFP 标志来自变量，需人工确认")
+        return "\n".join(out)
+
+
+def _bit_indices(value: int):
+    index = 0
+    while value:
+        if value & 1:
+            yield index
+        value >>= 1
+        index += 1
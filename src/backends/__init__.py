@@ -5,7 +5,8 @@ Linux Driver Analyzer - 解析后端
 支持多种解析后端，按精确度排序：
 1. regex    - 正则匹配，无依赖，速度快
 2. tree-sitter - 语法树解析，精确度高
-3. clang    - 完整语义分析（计划中）
+3. clang    - 完整语义分析（libclang，需要编译选项 / compile_commands.json）
+另有 native：C++ 扩展实现的 regex 等价扫描器（结果相同，吞吐量高得多，需 make native 编译）
 
 使用示例：
     from backends import get_backend, list_backends
@@ -20,29 +21,62 @@ Linux Driver Analyzer - 解析后端
     result = backend.parse(source_code)
 """
 
+import importlib
+
 from .base import (
     AnalyzerBackend,
     BackendCapability,
+    BackendDescriptor,
     BackendRegistry,
     ParseResult,
     FunctionDef,
     StructDef,
     StructField,
+    UnionDef,
+    EnumDef,
+    EnumValue,
     FunctionCall,
     TypeDef,
     Parameter,
     Location,
+    LineIndex,
 )
 
-# 导入并注册后端
-from .regex_backend import RegexBackend
+# 延迟注册内置后端：导入本包时不导入任何后端模块（tree-sitter / libclang 的导入耗时
+# 只在真正使用时付出），依赖探测见 BackendDescriptor.dependencies_present
+for _descriptor in (
+    BackendDescriptor('regex', f'{__name__}.regex_backend:RegexBackend'),
+    BackendDescriptor('native', f'{__name__}.native_backend:NativeBackend', (f'{__name__}._lda_scan',)),
+    BackendDescriptor('tree-sitter', f'{__name__}.treesitter_backend:TreeSitterBackend',
+                      ('tree_sitter', 'tree_sitter_c')),
+    BackendDescriptor('clang', f'{__name__}.clang_backend:ClangBackend', ('clang',)),
+):
+    BackendRegistry.register_lazy(_descriptor)
+
+# 按需导入的导出名 -> 所在模块（PEP 562 模块级 __getattr__）
+_LAZY_EXPORTS = {
+    'RegexBackend': '.regex_backend',
+    'NativeBackend': '.native_backend',
+    'NATIVE_AVAILABLE': '.native_backend',
+    'TreeSitterBackend': '.treesitter_backend',
+    'TREE_SITTER_AVAILABLE': '.treesitter_backend',
+    'ClangBackend': '.clang_backend',
+    'CLANG_AVAILABLE': '.clang_backend',
+    'CompileDatabase': '.clang_backend',
+    'BackendSelector': '.selector',
+    'BackendCost': '.selector',
+    'HeaderIndex': '.headers',
+    'harvest': '.headers',
+}
+
 
-# tree-sitter 是可选的
-try:
-    from .treesitter_backend import TreeSitterBackend, TREE_SITTER_AVAILABLE
-except ImportError:
-    TREE_SITTER_AVAILABLE = False
-    TreeSitterBackend = None
+def __getattr__(name: str):
+    module = _LAZY_EXPORTS.get(name)
+    if module is None:
+        raise AttributeError(f"module {__name__!r} has no attribute {name!r}")
+    value = getattr(importlib.import_module(module, __name__), name)
+    globals()[name] = value
+    return value
 
 
 def get_backend(name: str = None) -> AnalyzerBackend:
@@ -50,7 +84,7 @@ def get_backend(name: str = None) -> AnalyzerBackend:
     获取解析后端
     
     Args:
-        name: 后端名称，可选值: 'regex', 'tree-sitter', 'clang'
+        name: 后端名称，可选值: 'regex', 'native', 'tree-sitter', 'clang'
               如果不指定，返回最佳可用后端
     
     Returns:
@@ -77,44 +111,73 @@ def get_backend(name: str = None) -> AnalyzerBackend:
     backend = BackendRegistry.get_best_available()
     if not backend:
         # 回退到 regex
-        return RegexBackend()
+        return BackendRegistry.get('regex')
     return backend
 
 
-def list_backends() -> list:
+def list_backends(probe_only: bool = False) -> list:
     """
     列出所有可用的后端
     
+    Args:
+        probe_only: 只探测依赖模块，不导入后端模块（CLI --list-backends 用）
+    
     Returns:
         list: 可用后端名称列表
     """
-    return BackendRegistry.list_available()
+    return BackendRegistry.list_available(probe_only)
 
 
 def is_treesitter_available() -> bool:
-    """检查 tree-sitter 是否可用"""
-    return TREE_SITTER_AVAILABLE
+    """检查 tree-sitter 是否可用（只探测，不导入 tree_sitter）"""
+    return BackendRegistry.is_available('tree-sitter')
+
+
+def is_native_available() -> bool:
+    """检查 native 扩展是否已编译"""
+    return BackendRegistry.is_available('native')
+
+
+def is_clang_available() -> bool:
+    """检查 libclang 是否可用（Python 绑定和动态库都能加载）"""
+    return BackendRegistry.is_available('clang')
 
 
 __all__ = [
     # 核心类
     'AnalyzerBackend',
     'BackendCapability',
+    'BackendDescriptor',
     'BackendRegistry',
     'ParseResult',
     'FunctionDef',
     'StructDef',
     'StructField',
+    'UnionDef',
+    'EnumDef',
+    'EnumValue',
     'FunctionCall',
     'TypeDef',
     'Parameter',
     'Location',
+    'LineIndex',
     # 具体后端
     'RegexBackend',
+    'NativeBackend',
     'TreeSitterBackend',
+    'ClangBackend',
+    'CompileDatabase',
+    # 逐文件选择后端（auto 策略）
+    'BackendSelector',
+    'BackendCost',
+    # 头文件类型声明收集
+    'HeaderIndex',
+    'harvest',
     # 工具函数
     'get_backend',
     'list_backends',
     'is_treesitter_available',
+    'is_native_available',
+    'is_clang_available',
 ]
 
@@ -5,6 +5,10 @@
 定义所有后端必须实现的统一接口，确保不同后端可以互换使用。
 """
 
+import bisect
+import importlib
+import importlib.util
+import re
 from abc import ABC, abstractmethod
 from dataclasses import dataclass, field
 from typing import Dict, List, Set, Optional, Tuple, Any
@@ -45,6 +49,83 @@ class Location:
         }
 
 
+_NEWLINE = re.compile(r'\n')
+
+
+class LineIndex:
+    """
+    字符偏移 -> 行号索引
+    
+    预先记录所有换行符位置，行号查询为 O(log n)。
+    用于替代 content[:pos].count('\\n') + 1（每次查询 O(n)，整体二次复杂度）。
+    """
+    
+    def __init__(self, text: str):
+        self._newlines = [m.start() for m in _NEWLINE.finditer(text)]
+    
+    def line_of(self, pos: int) -> int:
+        """返回偏移 pos 所在的行号（从1开始）"""
+        return bisect.bisect_left(self._newlines, pos) + 1
+
+
+# 影响内存布局的属性：__packed / __aligned(N) / ____cacheline_aligned / GCC __attribute__((...))
+LAYOUT_ATTR_PATTERN = re.compile(
+    r'__attribute__\s*\(\((?:[^()]|\((?:[^()]|\([^()]*\))*\))*\)\)'
+    r'|__packed\b'
+    r'|__aligned\s*\((?:[^()]|\([^()]*\))*\)'
+    r'|_{2,4}cacheline_aligned(?:_in_smp)?\b'
+    r'|__randomize_layout\b'
+)
+
+
+def _split_top_level(text: str) -> List[str]:
+    """按顶层逗号切分（忽略括号内的逗号）"""
+    parts, depth, start = [], 0, 0
+    for i, c in enumerate(text):
+        if c == '(':
+            depth += 1
+        elif c == ')':
+            depth -= 1
+        elif c == ',' and depth == 0:
+            parts.append(text[start:i])
+            start = i + 1
+    parts.append(text[start:])
+    return [p.strip() for p in parts if p.strip()]
+
+
+def extract_layout_attributes(text: str) -> Tuple[str, List[str]]:
+    """
+    提取布局属性
+    
+    Returns:
+        (去掉属性后的文本, 规范化属性列表)
+        规范化形式: "packed" / "aligned(N)" / "aligned" / "cacheline_aligned" / "randomize_layout"
+    """
+    attrs: List[str] = []
+    
+    def take(match) -> str:
+        token = match.group(0)
+        if token.startswith('__attribute__'):
+            inner = token[token.index('((') + 2:token.rindex('))')]
+            for item in _split_top_level(inner):
+                m = re.match(r'(?:__)?(packed|aligned)(?:__)?\s*(?:\((.*)\))?$', item, re.DOTALL)
+                if m and m.group(1) == 'packed':
+                    attrs.append("packed")
+                elif m:
+                    attrs.append(f"aligned({m.group(2).strip()})" if m.group(2) else "aligned")
+        elif token == '__packed':
+            attrs.append("packed")
+        elif token.startswith('__aligned'):
+            attrs.append(f"aligned({token[token.index('(') + 1:token.rindex(')')].strip()})")
+        elif 'cacheline_aligned' in token:
+            attrs.append("cacheline_aligned")
+        else:
+            attrs.append("randomize_layout")
+        return ' '
+    
+    return LAYOUT_ATTR_PATTERN.sub(take, text), attrs
+
+
 @dataclass
 class StructField:
     """结构体字段"""
@@ -56,9 +137,13 @@ class StructField:
     array_size: str = ""
     location: Optional[Location] = None
     comment: str = ""
+    bit_width: Optional[int] = None    # 位域宽度（u32 x:4）
+    attributes: List[str] = field(default_factory=list)  # 布局属性，见 extract_layout_attributes
+    # 内嵌 struct/union 定义的成员（type_name 为 "struct"/"union" 或 "struct tag"）
+    members: List['StructField'] = field(default_factory=list)
     
     def to_dict(self) -> Dict:
-        return {
+        result = {
             "name": self.name,
             "type_name": self.type_name,
             "is_pointer": self.is_pointer,
@@ -68,6 +153,13 @@ class StructField:
             "line": self.location.line if self.location else 0,
             "comment": self.comment
         }
+        if self.bit_width is not None:
+            result["bit_width"] = self.bit_width
+        if self.attributes:
+            result["attributes"] = self.attributes
+        if self.members:
+            result["members"] = [m.to_dict() for m in self.members]
+        return result
 
 
 @dataclass
@@ -78,9 +170,10 @@ class StructDef:
     location: Optional[Location] = None
     typedef_name: str = ""
     referenced_structs: List[str] = field(default_factory=list)
+    attributes: List[str] = field(default_factory=list)  # 布局属性，如 ["packed"]
     
     def to_dict(self) -> Dict:
-        return {
+        result = {
             "name": self.name,
             "fields": [f.to_dict() for f in self.fields],
             "start_line": self.location.line if self.location else 0,
@@ -88,6 +181,9 @@ class StructDef:
             "typedef_name": self.typedef_name,
             "referenced_structs": self.referenced_structs
         }
+        if self.attributes:
+            result["attributes"] = self.attributes
+        return result
 
 
 @dataclass
@@ -196,15 +292,19 @@ class UnionDef:
     fields: List[StructField] = field(default_factory=list)
     location: Optional[Location] = None
     typedef_name: str = ""
+    attributes: List[str] = field(default_factory=list)  # 布局属性
     
     def to_dict(self) -> Dict:
-        return {
+        result = {
             "name": self.name,
             "fields": [f.to_dict() for f in self.fields],
             "start_line": self.location.line if self.location else 0,
             "end_line": self.location.end_line if self.location else 0,
             "typedef_name": self.typedef_name
         }
+        if self.attributes:
+            result["attributes"] = self.attributes
+        return result
 
 
 @dataclass
@@ -283,6 +383,17 @@ class AnalyzerBackend(ABC):
         """
         pass
     
+    def parse_declarations(self, source_code: str, filename: str = "<string>") -> ParseResult:
+        """
+        只提取类型声明（结构体 / 联合体 / 枚举 / typedef），用于头文件
+        
+        默认完整解析后丢弃函数和调用；regex / native 后端覆盖为跳过函数体的快速路径。
+        """
+        result = self.parse(source_code, filename)
+        result.functions = {}
+        result.calls = []
+        return result
+    
     def parse_file(self, filepath: str) -> ParseResult:
         """
         解析源文件
@@ -310,28 +421,79 @@ class AnalyzerBackend(ABC):
         return capability in self.capabilities()
 
 
+@dataclass(frozen=True)
+class BackendDescriptor:
+    """
+    后端描述符（入口点风格的延迟注册）
+    
+    只记录名称、"模块:类" 和依赖的顶层模块。列出 / 挑选后端时用 importlib.util.find_spec
+    检查依赖是否存在（不执行模块代码），第一次 get() 时才导入后端模块并实例化。
+    """
+    name: str
+    target: str                         # "backends.treesitter_backend:TreeSitterBackend"
+    requires: Tuple[str, ...] = ()      # 依赖模块，如 ("tree_sitter", "tree_sitter_c")
+    
+    def dependencies_present(self) -> bool:
+        """依赖模块是否都能找到（不导入）"""
+        for module in self.requires:
+            try:
+                if importlib.util.find_spec(module) is None:
+                    return False
+            except (ImportError, ValueError):
+                return False
+        return True
+    
+    def load(self) -> type:
+        """导入并返回后端类"""
+        module, _, attr = self.target.partition(':')
+        return getattr(importlib.import_module(module), attr)
+
+
 class BackendRegistry:
-    """后端注册中心"""
+    """
+    后端注册中心
+    
+    内置后端以 BackendDescriptor 延迟注册：导入 backends 包不会导入任何后端模块，
+    list_available() 只探测依赖，get() 时才导入并创建（每个后端一个实例）。
+    """
     
+    _descriptors: Dict[str, BackendDescriptor] = {}
     _backends: Dict[str, type] = {}
     _instances: Dict[str, AnalyzerBackend] = {}
     
     @classmethod
-    def register(cls, backend_class: type) -> None:
+    def register(cls, backend_class: type, name: Optional[str] = None) -> None:
         """
         注册后端类
         
         Args:
             backend_class: 后端类（需继承AnalyzerBackend）
+            name: 后端名称；不给时创建临时实例获取
         """
-        # 创建临时实例获取名称
-        instance = backend_class()
-        cls._backends[instance.name] = backend_class
+        if name is None:
+            name = backend_class().name
+        cls._backends[name] = backend_class
+    
+    @classmethod
+    def register_lazy(cls, descriptor: BackendDescriptor) -> None:
+        """注册后端描述符（不导入后端模块）"""
+        cls._descriptors[descriptor.name] = descriptor
+    
+    @classmethod
+    def names(cls) -> List[str]:
+        """所有已注册的后端名称（按注册顺序）"""
+        return list(dict.fromkeys([*cls._descriptors, *cls._backends]))
+    
+    @classmethod
+    def _backend_class(cls, name: str) -> Optional[type]:
+        if name not in cls._backends and name in cls._descriptors:
+            cls._backends[name] = cls._descriptors[name].load()
+        return cls._backends.get(name)
     
     @classmethod
     def get(cls, name: str) -> Optional[AnalyzerBackend]:
         """
-        获取后端实例
+        获取后端实例（第一次获取时导入并创建）
         
         Args:
             name: 后端名称
@@ -340,26 +502,50 @@ class BackendRegistry:
             AnalyzerBackend: 后端实例，如果不存在返回None
         """
         if name not in cls._instances:
-            if name in cls._backends:
-                cls._instances[name] = cls._backends[name]()
+            backend_class = cls._backend_class(name)
+            if backend_class is not None:
+                cls._instances[name] = backend_class()
         return cls._instances.get(name)
     
     @classmethod
-    def list_available(cls) -> List[str]:
+    def is_available(cls, name: str) -> bool:
+        """
+        后端是否可用
+        
+        依赖模块缺失时直接返回 False（不导入后端模块）；否则创建实例做完整检查
+        （如 libclang 动态库能否加载、native 扩展能否导入）。
+        """
+        descriptor = cls._descriptors.get(name)
+        if descriptor is not None and name not in cls._instances \
+                and not descriptor.dependencies_present():
+            return False
+        try:
+            backend = cls.get(name)
+            return backend is not None and backend.is_available()
+        except Exception:
+            return False
+    
+    @classmethod
+    def list_available(cls, probe_only: bool = False) -> List[str]:
         """
         列出所有可用的后端
         
+        Args:
+            probe_only: 只检查依赖模块是否存在，不导入任何后端模块
+                        （--list-backends 用；libclang 动态库等运行时条件不检查）
+        
         Returns:
             List[str]: 可用后端名称列表
         """
         available = []
-        for name, backend_class in cls._backends.items():
-            try:
-                instance = backend_class()
-                if instance.is_available():
-                    available.append(name)
-            except Exception:
-                pass
+        for name in cls.names():
+            descriptor = cls._descriptors.get(name)
+            if probe_only and descriptor is not None and name not in cls._instances:
+                ok = descriptor.dependencies_present()
+            else:
+                ok = cls.is_available(name)
+            if ok:
+                available.append(name)
         return available
     
     @classmethod
@@ -367,21 +553,23 @@ class BackendRegistry:
         """
         获取最佳可用后端（按优先级）
         
-        优先级：clang > tree-sitter > regex
+        优先级：clang > tree-sitter > native > regex
+        （native 与 regex 结果相同、速度更快，扩展已编译时优先）
+        依赖缺失的后端不会被导入。
         
         Returns:
             AnalyzerBackend: 最佳可用后端
         """
-        priority = ['clang', 'tree-sitter', 'regex']
+        priority = ['clang', 'tree-sitter', 'native', 'regex']
         for name in priority:
-            backend = cls.get(name)
-            if backend and backend.is_available():
-                return backend
+            if cls.is_available(name):
+                return cls.get(name)
         return None
     
     @classmethod
     def clear(cls) -> None:
         """清除所有注册的后端"""
+        cls._descriptors.clear()
         cls._backends.clear()
         cls._instances.clear()
 
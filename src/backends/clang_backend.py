@@ -0,0 +1,706 @@
+#!/usr/bin/env python3
+"""
+libclang 解析后端
+
+基于 clang.cindex 的完整前端解析，相比 tree-sitter 有以下优势：
+- 真正的预处理：宏展开后的调用（spin_lock -> _raw_spin_lock）和宏调用本身都会记录
+- 类型推导：参数 / 字段类型来自语义分析，函数指针、数组、位域宽度由类型系统给出
+- 跨文件：驱动目录下头文件中定义的结构体 / 枚举 / typedef 一并收集
+
+编译选项来自 compile_commands.json（环境变量 LDA_COMPILE_COMMANDS 指定，
+或从源文件目录向上查找），只保留影响解析的 -I / -D / -include / -std 等选项。
+
+解析速度靠两级复用：
+- 同一文件再次解析时对缓存的 TU 调用 reparse()，复用 PARSE_PRECOMPILED_PREAMBLE 生成的前导
+- 编译选项相同、开头 #include <...> 序列相同的文件共用一个 PCH（-include-pch），
+  内核头文件只解析一次
+
+多文件并行由 analyze_files(jobs=N) 的进程池完成，每个 worker 持有自己的 Index、TU 缓存和 PCH。
+
+依赖安装：
+    pip install libclang
+"""
+
+import bisect
+import json
+import os
+import re
+import shlex
+import shutil
+import tempfile
+import weakref
+from collections import OrderedDict
+from typing import Dict, List, Set, Optional, Tuple
+
+from .base import (
+    AnalyzerBackend, BackendCapability, BackendRegistry,
+    ParseResult, FunctionDef, StructDef, StructField,
+    FunctionCall, TypeDef, Parameter, Location,
+    EnumDef, EnumValue, UnionDef, extract_layout_attributes
+)
+
+
+# libclang 可选导入（pip install libclang 自带动态库）
+try:
+    from clang import cindex
+    CLANG_AVAILABLE = True
+except ImportError:
+    CLANG_AVAILABLE = False
+    cindex = None
+
+
+# 没有编译数据库条目时的默认选项
+DEFAULT_ARGS = ['-std=gnu11']
+# 总是附加：按 C 解析（.h 也一样）、不输出警告、不因错误过多停止
+FIXED_ARGS = ['-x', 'c', '-w', '-ferror-limit=0']
+
+# 带独立参数值的选项：值为路径的需要相对 directory 解析
+_PATH_OPTIONS = {'-I', '-isystem', '-iquote', '-idirafter', '-include', '-imacros'}
+_VALUE_OPTIONS = {'-D', '-U', '-target'}
+_FLAG_OPTIONS = {'-nostdinc', '-undef', '-ansi'}
+# 丢弃且带参数值的选项
+_SKIP_WITH_VALUE = {'-o', '-MF', '-MT', '-MQ', '-x', '-arch'}
+
+# 与其他后端一致过滤的伪调用
+_EXCLUDED_CALLS = {'if', 'while', 'for', 'switch', 'return', 'sizeof', 'typeof',
+                   'offsetof', 'container_of', 'likely', 'unlikely'}
+_FUNC_ATTRIBUTES = {'static', 'inline', 'extern', '__init', '__exit'}
+
+# 文件开头的注释 / 空白 / #include <...> 序列（共享 PCH 的依据）
+_PREAMBLE = re.compile(r'(?:\s+|//[^\n]*|/\*.*?\*/|#[ \t]*include[ \t]*<[^>\n]+>[^\n]*)*', re.S)
+_ANGLE_INCLUDE = re.compile(r'#[ \t]*include[ \t]*<[^>\n]+>')
+
+# 每个 worker 缓存的 TU 数（用于 reparse）
+MAX_CACHED_TUS = 16
+# 写入 ParseResult.errors 的诊断条数上限
+MAX_ERRORS = 20
+
+
+# ==================== 编译数据库 ====================
+
+def filter_arguments(argv: List[str], directory: str) -> List[str]:
+    """
+    编译命令 -> libclang 解析选项
+
+    去掉编译器、源文件、-c / -o / 依赖文件和代码生成选项（-f* / -m*，
+    GCC 专有选项会让 libclang 拒绝创建 TU），相对路径按 directory 解析。
+    """
+    def resolve(path: str) -> str:
+        return path if os.path.isabs(path) else os.path.normpath(os.path.join(directory, path))
+
+    out: List[str] = []
+    i = 1
+    while i < len(argv):
+        arg = argv[i]
+        value = argv[i + 1] if i + 1 < len(argv) else None
+        if arg in _PATH_OPTIONS and value is not None:
+            out += [arg, resolve(value)]
+            i += 2
+            continue
+        if arg in _VALUE_OPTIONS and value is not None:
+            out += [arg, value]
+            i += 2
+            continue
+        if arg in _SKIP_WITH_VALUE:
+            i += 2
+            continue
+        if arg.startswith(('-I', '-isystem')) and arg not in _PATH_OPTIONS:
+            flag = '-isystem' if arg.startswith('-isystem') else '-I'
+            out.append(flag + resolve(arg[len(flag):]))
+        elif arg.startswith(('-D', '-U', '-std=', '--target=')) or arg in _FLAG_OPTIONS:
+            out.append(arg)
+        i += 1
+    return out
+
+
+class CompileDatabase:
+    """
+    compile_commands.json 的纯 Python 读取（不依赖 libclang）
+
+    条目可以用 "arguments" 列表或 "command" 字符串；同一文件有多条时取第一条。
+    """
+
+    def __init__(self, path: str):
+        if os.path.isdir(path):
+            path = os.path.join(path, 'compile_commands.json')
+        self.path = os.path.abspath(path)
+        self._entries: Dict[str, List[str]] = {}
+        with open(self.path, 'r', encoding='utf-8') as f:
+            for entry in json.load(f):
+                directory = entry.get('directory', os.path.dirname(self.path))
+                argv = entry.get('arguments') or shlex.split(entry.get('command', ''))
+                source = entry['file']
+                if not os.path.isabs(source):
+                    source = os.path.join(directory, source)
+                self._entries.setdefault(os.path.normpath(source), filter_arguments(argv, directory))
+
+    def args_for(self, filename: str) -> Optional[List[str]]:
+        """文件的解析选项；不在数据库中返回 None"""
+        return self._entries.get(os.path.normpath(os.path.abspath(filename)))
+
+    def files(self) -> List[str]:
+        """数据库中的全部源文件（按出现顺序）"""
+        return list(self._entries)
+
+    def __len__(self) -> int:
+        return len(self._entries)
+
+
+# 目录 -> 编译数据库（None 表示向上查找不到）
+_db_cache: Dict[str, Optional[CompileDatabase]] = {}
+
+
+def find_compile_database(filename: str) -> Optional[CompileDatabase]:
+    """
+    查找文件对应的编译数据库
+
+    先看环境变量 LDA_COMPILE_COMMANDS（文件或目录），否则从源文件目录逐级向上找
+    compile_commands.json。结果按目录缓存。
+    """
+    override = os.environ.get('LDA_COMPILE_COMMANDS')
+    directory = override or os.path.dirname(os.path.abspath(filename))
+    if directory in _db_cache:
+        return _db_cache[directory]
+    db = None
+    if override:
+        db = CompileDatabase(override)
+    else:
+        current = directory
+        while True:
+            candidate = os.path.join(current, 'compile_commands.json')
+            if os.path.isfile(candidate):
+                db = CompileDatabase(candidate)
+                break
+            parent = os.path.dirname(current)
+            if parent == current:
+                break
+            current = parent
+    _db_cache[directory] = db
+    return db
+
+
+def leading_includes(source: str) -> List[str]:
+    """文件开头（只隔着注释和空行）的 #include <...> 序列"""
+    block = _PREAMBLE.match(source).group(0)
+    return _ANGLE_INCLUDE.findall(block)
+
+
+# ==================== 后端 ====================
+
+def _tag_name(cursor) -> str:
+    """struct/union/enum 的标签名；匿名时返回空串（新版 libclang 拼写为 "(unnamed at ...)"）"""
+    name = cursor.spelling
+    return "" if not name or '(' in name or ' ' in name else name
+
+
+def _element_type(ctype):
+    """去掉数组层，得到元素类型"""
+    while ctype.kind in (cindex.TypeKind.CONSTANTARRAY, cindex.TypeKind.INCOMPLETEARRAY,
+                         cindex.TypeKind.VARIABLEARRAY, cindex.TypeKind.DEPENDENTSIZEDARRAY):
+        ctype = ctype.element_type
+    return ctype
+
+
+class ClangBackend(AnalyzerBackend):
+    """
+    libclang C 语言解析后端
+
+    提供预处理后的语义级解析能力，需要正确的头文件路径和编译选项。
+    """
+
+    _library_ok: Optional[bool] = None
+
+    def __init__(self, share_preamble: bool = True):
+        self.share_preamble = share_preamble
+        self._index = None
+        self._tus: 'OrderedDict[str, Tuple[Tuple[str, ...], object]]' = OrderedDict()
+        # (选项, include 序列) -> PCH 路径（None 表示构建失败，不再重试）
+        self._pch: Dict[Tuple[Tuple[str, ...], Tuple[str, ...]], Optional[str]] = {}
+        self._pch_dir: Optional[str] = None
+        self._src = b""
+        self._main = ""
+        self._file_bytes: Dict[str, bytes] = {}
+        self._bodies: List[Tuple[int, int, str]] = []  # 函数体 (起始偏移, 结束偏移, 函数名)
+        self.stats = {"parsed": 0, "reparsed": 0, "pch_built": 0, "pch_used": 0}
+
+    @property
+    def name(self) -> str:
+        return "clang"
+
+    @property
+    def version(self) -> str:
+        return "0.3.0"
+
+    def is_available(self) -> bool:
+        # 绑定装了但找不到 libclang.so 时 Index.create() 才会失败，探测一次
+        if not CLANG_AVAILABLE:
+            return False
+        if ClangBackend._library_ok is None:
+            try:
+                cindex.Index.create()
+                ClangBackend._library_ok = True
+            except Exception:
+                ClangBackend._library_ok = False
+        return ClangBackend._library_ok
+
+    def capabilities(self) -> Set[BackendCapability]:
+        return {
+            BackendCapability.PARSE_FUNCTIONS,
+            BackendCapability.PARSE_STRUCTS,
+            BackendCapability.PARSE_ENUMS,
+            BackendCapability.PARSE_UNIONS,
+            BackendCapability.PARSE_CALLS,
+            BackendCapability.PARSE_TYPEDEFS,
+            BackendCapability.PARSE_DECLARATIONS,
+            BackendCapability.TYPE_INFERENCE,
+            BackendCapability.MACRO_EXPANSION,
+            BackendCapability.CROSS_FILE,
+            BackendCapability.PRECISE_LOCATION,
+            BackendCapability.INCREMENTAL,
+        }
+
+    # ---------- TU 管理 ----------
+
+    def _get_index(self):
+        if self._index is None:
+            if not self.is_available():
+                raise RuntimeError("libclang 未安装，请运行: pip install libclang")
+            self._index = cindex.Index.create()
+        return self._index
+
+    def compile_args(self, filename: str) -> List[str]:
+        """文件的解析选项：编译数据库条目（没有时用默认选项）+ 固定选项"""
+        db = find_compile_database(filename)
+        args = db.args_for(filename) if db else None
+        return FIXED_ARGS + (args if args is not None else DEFAULT_ARGS)
+
+    def _shared_pch(self, source: str, args: List[str]) -> Optional[str]:
+        """开头 include 序列相同的文件共用的 PCH；构建失败返回 None"""
+        includes = tuple(leading_includes(source))
+        if not includes:
+            return None
+        key = (tuple(args), includes)
+        if key in self._pch:
+            return self._pch[key]
+        if self._pch_dir is None:
+            self._pch_dir = tempfile.mkdtemp(prefix='lda-pch-')
+            weakref.finalize(self, shutil.rmtree, self._pch_dir, True)
+        header = os.path.join(self._pch_dir, f"preamble_{len(self._pch)}.h")
+        with open(header, 'w', encoding='utf-8') as f:
+            f.write("\n".join(includes) + "\n")
+        pch = None
+        try:
+            tu = self._get_index().parse(header, args=['-x', 'c-header'] + args[2:])
+            if not any(d.severity >= cindex.Diagnostic.Error for d in tu.diagnostics):
+                tu.save(header + '.pch')
+                pch = header + '.pch'
+                self.stats["pch_built"] += 1
+        except (cindex.TranslationUnitLoadError, cindex.TranslationUnitSaveError):
+            pch = None
+        self._pch[key] = pch
+        return pch
+
+    def _translation_unit(self, source_code: str, filename: str):
+        """解析或 reparse 文件，返回 TU"""
+        args = self.compile_args(filename)
+        if self.share_preamble:
+            pch = self._shared_pch(source_code, args)
+            if pch:
+                args = args + ['-include-pch', pch]
+                self.stats["pch_used"] += 1
+        key = tuple(args)
+        unsaved = [(filename, source_code)]
+        cached = self._tus.get(filename)
+        if cached and cached[0] == key:
+            self._tus.move_to_end(filename)
+            cached[1].reparse(unsaved_files=unsaved)
+            self.stats["reparsed"] += 1
+            return cached[1]
+        options = (cindex.TranslationUnit.PARSE_DETAILED_PROCESSING_RECORD |
+                   cindex.TranslationUnit.PARSE_PRECOMPILED_PREAMBLE)
+        tu = self._get_index().parse(filename, args=args, unsaved_files=unsaved, options=options)
+        self._tus[filename] = (key, tu)
+        if len(self._tus) > MAX_CACHED_TUS:
+            self._tus.popitem(last=False)
+        self.stats["parsed"] += 1
+        return tu
+
+    # ---------- 解析 ----------
+
+    def parse(self, source_code: str, filename: str = "<string>") -> ParseResult:
+        """解析源代码"""
+        if not self.is_available():
+            return ParseResult(errors=["libclang 未安装"])
+
+        # 内存中的源码也需要一个文件名（不要求存在）
+        self._main = filename if not filename.startswith('<') else 'lda_input.c'
+        self._src = source_code.encode('utf-8')
+        self._file_bytes = {self._main: self._src}
+        self._bodies = []
+
+        result = ParseResult()
+        try:
+            tu = self._translation_unit(source_code, self._main)
+        except cindex.TranslationUnitLoadError as e:
+            result.errors.append(f"libclang 无法创建翻译单元: {e}")
+            return result
+
+        macros: List = []
+        records: Dict[Tuple[str, int], object] = {}
+        variables: List = []
+        for cursor in tu.cursor.get_children():
+            kind = cursor.kind
+            if kind == cindex.CursorKind.MACRO_INSTANTIATION:
+                if self._in_main(cursor):
+                    macros.append(cursor)
+            elif kind == cindex.CursorKind.FUNCTION_DECL:
+                if self._in_main(cursor):
+                    self._add_function(cursor, result)
+            elif kind in (cindex.CursorKind.STRUCT_DECL, cindex.CursorKind.UNION_DECL,
+                          cindex.CursorKind.ENUM_DECL):
+                if cursor.is_definition() and self._in_scope(cursor):
+                    self._add_record(cursor, result, records)
+            elif kind == cindex.CursorKind.TYPEDEF_DECL:
+                if self._in_scope(cursor):
+                    self._add_typedef(cursor, result, records)
+            elif kind == cindex.CursorKind.VAR_DECL:
+                if self._in_main(cursor):
+                    variables.append(cursor)
+
+        self._add_macro_calls(macros, result)
+        for cursor in variables:
+            self._check_struct_init(cursor, result)
+        self._check_module_init(source_code, result)
+        self._build_call_relations(result)
+
+        for diag in tu.diagnostics:
+            if diag.severity >= cindex.Diagnostic.Error and len(result.errors) < MAX_ERRORS:
+                loc = diag.location
+                where = f"{loc.file.name}:{loc.line}" if loc.file else "?"
+                result.errors.append(f"{where}: {diag.spelling}")
+        return result
+
+    def _in_main(self, cursor) -> bool:
+        f = cursor.location.file
+        return f is not None and f.name == self._main
+
+    def _in_scope(self, cursor) -> bool:
+        """主文件，或主文件目录树下的头文件（驱动自己的头文件，不含内核头文件）"""
+        f = cursor.location.file
+        if f is None:
+            return False
+        if f.name == self._main:
+            return True
+        base = os.path.dirname(os.path.abspath(self._main))
+        return os.path.abspath(f.name).startswith(base + os.sep)
+
+    def _bytes_of(self, cursor) -> bytes:
+        name = cursor.location.file.name
+        data = self._file_bytes.get(name)
+        if data is None:
+            try:
+                with open(name, 'rb') as f:
+                    data = f.read()
+            except OSError:
+                data = b""
+            self._file_bytes[name] = data
+        return data
+
+    def _text(self, cursor, start: Optional[int] = None, end: Optional[int] = None) -> str:
+        extent = cursor.extent
+        data = self._bytes_of(cursor)
+        lo = extent.start.offset if start is None else start
+        hi = extent.end.offset if end is None else end
+        return data[lo:hi].decode('utf-8', errors='replace')
+
+    @staticmethod
+    def _location(cursor) -> Location:
+        extent = cursor.extent
+        # libclang 列号从 1 开始，与 tree-sitter 一致转为从 0 开始
+        return Location(
+            line=extent.start.line,
+            column=extent.start.column - 1,
+            end_line=extent.end.line,
+            end_column=extent.end.column - 1
+        )
+
+    def _add_function(self, cursor, result: ParseResult) -> None:
+        """函数定义或声明"""
+        name = cursor.spelling
+        prefix = self._text(cursor, end=cursor.location.offset)
+        words = re.findall(r'\w+', prefix)
+        attributes = [w for w in words if w in _FUNC_ATTRIBUTES]
+        # 返回类型取源码文本：缺头文件时语义类型会退化为 int
+        return_type = ' '.join(w for w in words if w not in _FUNC_ATTRIBUTES) \
+            or cursor.result_type.spelling
+        params = [self._parameter(arg) for arg in cursor.get_arguments()]
+
+        if not cursor.is_definition():
+            if name not in result.functions:
+                result.functions[name] = FunctionDef(
+                    name=name, return_type=return_type, params=params, body="",
+                    location=self._location(cursor), attributes=["declaration"])
+            return
+
+        body_cursor = None
+        for child in cursor.get_children():
+            if child.kind == cindex.CursorKind.COMPOUND_STMT:
+                body_cursor = child
+        body = ""
+        if body_cursor is not None:
+            body = self._text(body_cursor)
+            self._bodies.append((body_cursor.extent.start.offset, body_cursor.extent.end.offset, name))
+
+        calls: Dict[str, None] = {}
+        if body_cursor is not None:
+            for node in body_cursor.walk_preorder():
+                if node.kind == cindex.CursorKind.CALL_EXPR:
+                    callee = node.spelling
+                    if callee and callee not in _EXCLUDED_CALLS:
+                        calls.setdefault(callee)
+
+        result.functions[name] = FunctionDef(
+            name=name,
+            return_type=return_type,
+            params=params,
+            body=body,
+            location=self._location(cursor),
+            calls=list(calls),
+            uses_structs=self._used_structs(params, body),
+            attributes=attributes
+        )
+
+    def _parameter(self, cursor) -> Parameter:
+        """参数：类型优先取源码文本（与其他后端一致），函数指针等无法切分时用语义类型"""
+        name = cursor.spelling
+        text = self._text(cursor).strip()
+        match = re.match(rf'(.*?)\s*\b{re.escape(name)}\s*$', text, re.S) if name else None
+        if match and match.group(1):
+            type_name = match.group(1)
+            if type_name.endswith('*'):
+                type_name = type_name.rstrip('* ') + ' ' + '*' * (len(type_name) - len(type_name.rstrip('*')))
+        else:
+            type_name = cursor.type.spelling
+        return Parameter(name=name, type_name=type_name)
+
+    @staticmethod
+    def _used_structs(params: List[Parameter], body: str) -> List[str]:
+        structs = set()
+        for param in params:
+            match = re.search(r'struct\s+(\w+)', param.type_name)
+            if match:
+                structs.add(match.group(1))
+        for match in re.finditer(r'struct\s+(\w+)', body):
+            structs.add(match.group(1))
+        return list(structs)
+
+    def _add_macro_calls(self, macros: List, result: ParseResult) -> None:
+        """函数式宏调用按位置归入所在函数的 calls（展开后的调用已由 CALL_EXPR 记录）"""
+        if not self._bodies:
+            return
+        self._bodies.sort()
+        starts = [b[0] for b in self._bodies]
+        for cursor in macros:
+            name = cursor.spelling
+            if name in _EXCLUDED_CALLS:
+                continue
+            offset = cursor.extent.start.offset
+            i = bisect.bisect_right(starts, offset) - 1
+            if i < 0 or offset >= self._bodies[i][1]:
+                continue
+            if not self._text(cursor)[len(name):].lstrip().startswith('('):
+                continue
+            func = result.functions[self._bodies[i][2]]
+            if name not in func.calls:
+                func.calls.append(name)
+
+    def _add_record(self, cursor, result: ParseResult, records: Dict) -> None:
+        """struct / union / enum 定义"""
+        tag = _tag_name(cursor)
+        row = cursor.extent.start.line - 1
+        key = (cursor.location.file.name, cursor.extent.start.offset)
+        kind = cursor.kind
+        if kind == cindex.CursorKind.ENUM_DECL:
+            values = []
+            for child in cursor.get_children():
+                if child.kind == cindex.CursorKind.ENUM_CONSTANT_DECL:
+                    text = self._text(child)
+                    values.append(EnumValue(
+                        name=child.spelling,
+                        value=text.split('=', 1)[1].strip() if '=' in text else None,
+                        location=self._location(child)))
+            record = EnumDef(name=tag or f"anonymous_enum_{row}", values=values,
+                             location=self._location(cursor))
+            result.enums[record.name] = record
+        elif kind == cindex.CursorKind.UNION_DECL:
+            record = UnionDef(name=tag or f"anonymous_union_{row}",
+                              fields=self._record_fields(cursor),
+                              location=self._location(cursor),
+                              attributes=self._layout_attributes_of(cursor))
+            result.unions[record.name] = record
+        else:
+            fields = self._record_fields(cursor)
+            referenced = {m.group(1) for f in fields
+                          for m in [re.search(r'struct\s+(\w+)', f.type_name)] if m}
+            record = StructDef(name=tag or f"anonymous_{row}", fields=fields,
+                               location=self._location(cursor),
+                               referenced_structs=list(referenced),
+                               attributes=self._layout_attributes_of(cursor))
+            result.structs[record.name] = record
+        records[key] = record
+
+    def _layout_attributes_of(self, cursor) -> List[str]:
+        """名字到 '{' 之间、'}' 到声明结束 ';' 之间的布局属性（__packed 等宏按源码文本识别）"""
+        data = self._bytes_of(cursor)
+        start, end = cursor.extent.start.offset, cursor.extent.end.offset
+        brace = data.find(b'{', start, end)
+        head = data[start:brace if brace >= 0 else end]
+        semi = data.find(b';', end)
+        tail = data[end:semi] if semi >= 0 else b""
+        return extract_layout_attributes((head + b' ' + tail).decode('utf-8', errors='replace'))[1]
+
+    def _record_fields(self, cursor) -> List[StructField]:
+        """字段列表；内嵌 struct/union 定义展开为 members"""
+        entries: List[StructField] = []
+        nested: List[Tuple[object, StructField]] = []
+        for child in cursor.get_children():
+            if child.kind in (cindex.CursorKind.STRUCT_DECL, cindex.CursorKind.UNION_DECL) \
+                    and child.is_definition():
+                kind = 'struct' if child.kind == cindex.CursorKind.STRUCT_DECL else 'union'
+                tag = _tag_name(child)
+                # 先按匿名成员记录；后面有字段使用它时再替换
+                field = StructField(name="", type_name=f"{kind} {tag}" if tag else kind,
+                                    location=self._location(child),
+                                    members=self._record_fields(child))
+                nested.append((child, field))
+                entries.append(field)
+            elif child.kind == cindex.CursorKind.FIELD_DECL:
+                decl = _element_type(child.type).get_declaration()
+                owner = next((f for c, f in nested if c == decl), None)
+                field = self._field(child, owner)
+                if owner is not None:
+                    entries = [e for e in entries if e is not owner]
+                    nested = [(c, f) for c, f in nested if f is not owner]
+                if field:
+                    entries.append(field)
+        return entries
+
+    def _field(self, cursor, owner: Optional[StructField]) -> Optional[StructField]:
+        """单个字段"""
+        name = cursor.spelling
+        ctype = cursor.type
+        text = self._text(cursor)
+        attributes = extract_layout_attributes(text)[1]
+        bit_width = cursor.get_bitfield_width() if cursor.is_bitfield() else None
+
+        array_size = ""
+        if ctype.kind in (cindex.TypeKind.CONSTANTARRAY, cindex.TypeKind.INCOMPLETEARRAY):
+            # 维度保留源码写法（宏名），与其他后端一致；柔性数组记为 "0"
+            match = re.search(rf'\b{re.escape(name)}\s*\[([^\]]*)\]', text) if name else None
+            if match and match.group(1).strip():
+                array_size = match.group(1).strip()
+            elif ctype.kind == cindex.TypeKind.CONSTANTARRAY:
+                array_size = str(ctype.element_count)
+            else:
+                array_size = "0"
+            ctype = _element_type(ctype)
+
+        if owner is not None:
+            return StructField(name=name, type_name=owner.type_name, array_size=array_size,
+                               location=self._location(cursor), bit_width=bit_width,
+                               attributes=attributes, members=owner.members)
+
+        is_pointer = ctype.kind == cindex.TypeKind.POINTER
+        is_function_ptr = False
+        func_ptr_signature = ""
+        type_name = ctype.spelling
+        if is_pointer:
+            pointee = ctype.get_pointee().get_canonical()
+            if pointee.kind in (cindex.TypeKind.FUNCTIONPROTO, cindex.TypeKind.FUNCTIONNOPROTO):
+                is_function_ptr = True
+                func_ptr_signature = text
+                type_name = pointee.get_result().spelling
+
+        if not name and bit_width is None:
+            return None
+        return StructField(
+            name=name,
+            type_name=type_name,
+            is_pointer=is_pointer,
+            is_function_ptr=is_function_ptr,
+            func_ptr_signature=func_ptr_signature,
+            array_size=array_size,
+            location=self._location(cursor),
+            bit_width=bit_width,
+            attributes=attributes
+        )
+
+    def _add_typedef(self, cursor, result: ParseResult, records: Dict) -> None:
+        """typedef；typedef 内定义的 struct/union/enum 改用别名命名"""
+        alias = cursor.spelling
+        underlying = cursor.underlying_typedef_type
+        decl = underlying.get_declaration()
+        if decl.kind in (cindex.CursorKind.STRUCT_DECL, cindex.CursorKind.UNION_DECL,
+                         cindex.CursorKind.ENUM_DECL) and decl.location.file is not None \
+                and decl.location.file.name == cursor.location.file.name \
+                and cursor.extent.start.offset <= decl.extent.start.offset < cursor.extent.end.offset:
+            record = records.get((decl.location.file.name, decl.extent.start.offset))
+            if record is not None:
+                record.typedef_name = alias
+                if record.name.startswith("anonymous_"):
+                    table = (result.structs if isinstance(record, StructDef) else
+                             result.unions if isinstance(record, UnionDef) else result.enums)
+                    table.pop(record.name, None)
+                    record.name = alias
+                    table[alias] = record
+            return
+        result.typedefs[alias] = TypeDef(alias=alias, original=underlying.spelling,
+                                         location=self._location(cursor))
+
+    def _check_struct_init(self, cursor, result: ParseResult) -> None:
+        """结构体初始化中的回调映射（static struct xxx yyy = { .field = func }）"""
+        match = re.match(
+            r'(?:static\s+)?(?:const\s+)?struct\s+(\w+)\s+(\w+)\s*=\s*\{([^}]+)\}',
+            self._text(cursor), re.DOTALL
+        )
+        if not match:
+            return
+        struct_type = match.group(1)
+        for fm in re.finditer(r'\.(\w+)\s*=\s*&?\s*(\w+)', match.group(3)):
+            field_name, value = fm.group(1), fm.group(2)
+            if value in result.functions:
+                result.functions[value].is_callback = True
+                result.functions[value].callback_context = f"{struct_type}.{field_name}"
+                result.calls.append(FunctionCall(
+                    caller=f"{struct_type}.{field_name}",
+                    callee=value,
+                    location=self._location(cursor),
+                    is_indirect=True
+                ))
+
+    @staticmethod
+    def _check_module_init(source_code: str, result: ParseResult) -> None:
+        """module_init / module_exit（没有内核头文件时这两个宏无法展开，按源码识别）"""
+        for macro in ("module_init", "module_exit"):
+            match = re.search(rf'\b{macro}\s*\(\s*(\w+)\s*\)', source_code)
+            if match and match.group(1) in result.functions:
+                func = result.functions[match.group(1)]
+                func.is_callback = True
+                func.callback_context = macro
+
+    def _build_call_relations(self, result: ParseResult) -> None:
+        """构建函数调用关系"""
+        callers_seen: Dict[str, Set[str]] = {}
+        for func_name, func_def in result.functions.items():
+            for called in func_def.calls:
+                if called in result.functions:
+                    seen = callers_seen.get(called)
+                    if seen is None:
+                        seen = callers_seen[called] = set(result.functions[called].called_by)
+                    if func_name not in seen:
+                        seen.add(func_name)
+                        result.functions[called].called_by.append(func_name)
+
+
+# 注册后端（包导入时已按描述符延迟注册；直接导入本模块时登记类，不创建实例）
+BackendRegistry.register(ClangBackend, "clang")
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""
+头文件类型声明收集（header-only 快速路径）
+
+头文件里分析需要的只有结构体 / 联合体 / 枚举 / typedef 和对象式宏
+（#define NAME value，寄存器偏移 / 位掩码）。收集时用后端的
+parse_declarations()：函数体和初始化器按花括号配对整段跳过，不提取函数、
+不做调用和回调分析；宏由 extract_defines() 单独一遍扫描。结果合并成一份
+按名称索引的类型表（HeaderIndex），布局、常量求值等分析在源文件中找不到
+定义时回退到这里查找。
+
+吞吐量单独统计（HeaderIndex.stats），不计入源文件的解析耗时。
+
+使用方法:
+    index = harvest(['/usr/include/linux'], jobs=4)
+    index.structs['ethhdr'], index.origins['struct ethhdr'], index.stats['mb_per_s']
+    index.macros['ETH_P_IP'], index.origins['define ETH_P_IP']
+"""
+
+import os
+import time
+from dataclasses import dataclass, field
+from typing import Dict, Iterable, List, Optional, Tuple
+
+from .base import BackendRegistry, EnumDef, ParseResult, StructDef, TypeDef, UnionDef
+from .regex_backend import extract_defines
+
+HEADER_SUFFIXES = ('.h', '.hh', '.hpp')
+
+
+@dataclass
+class HeaderIndex:
+    """头文件类型表：同名定义以先收集到的为准（文件按路径排序）"""
+    structs: Dict[str, StructDef] = field(default_factory=dict)
+    unions: Dict[str, UnionDef] = field(default_factory=dict)
+    enums: Dict[str, EnumDef] = field(default_factory=dict)
+    typedefs: Dict[str, TypeDef] = field(default_factory=dict)
+    macros: Dict[str, str] = field(default_factory=dict)      # 对象式宏：名字 -> 替换文本
+    origins: Dict[str, str] = field(default_factory=dict)     # "struct foo" / "define FOO" -> 文件
+    stats: Dict = field(default_factory=dict)
+
+    def merge(self, path: str, result: ParseResult, macros: Optional[Dict[str, str]] = None) -> None:
+        """并入一个头文件的解析结果和宏"""
+        for kind, table, source in (("struct", self.structs, result.structs),
+                                    ("union", self.unions, result.unions),
+                                    ("enum", self.enums, result.enums),
+                                    ("typedef", self.typedefs, result.typedefs),
+                                    ("define", self.macros, macros or {})):
+            for name, definition in source.items():
+                if name not in table:
+                    table[name] = definition
+                    self.origins[f"{kind} {name}"] = path
+
+    def as_parse_result(self) -> ParseResult:
+        """只含类型声明的 ParseResult（与源文件的解析结果同构）"""
+        return ParseResult(structs=self.structs, unions=self.unions,
+                           enums=self.enums, typedefs=self.typedefs)
+
+    def summary(self) -> Dict:
+        """输出到分析结果的摘要（统计 + 各类定义数量）"""
+        return dict(self.stats, structs=len(self.structs), unions=len(self.unions),
+                    enums=len(self.enums), typedefs=len(self.typedefs), macros=len(self.macros))
+
+
+def find_headers(paths: Iterable[str]) -> List[str]:
+    """展开目录（递归）为头文件列表；直接给出的文件不检查后缀。结果按路径排序、去重"""
+    found = set()
+    for path in paths:
+        if os.path.isdir(path):
+            for root, _, files in os.walk(path):
+                found.update(os.path.join(root, f) for f in files if f.endswith(HEADER_SUFFIXES))
+        elif os.path.isfile(path):
+            found.add(path)
+    return sorted(found)
+
+
+def _parse_headers(backend_name: str, paths: List[str]
+                   ) -> List[Tuple[str, Optional[ParseResult], Dict[str, str], int, float]]:
+    """解析一组头文件（也是并行 worker 的入口），返回 [(路径, 结果或 None, 宏, 字节数, 秒)]"""
+    backend = BackendRegistry.get(backend_name)
+    out = []
+    for path in paths:
+        try:
+            with open(path, 'r', encoding='utf-8', errors='ignore') as f:
+                source = f.read()
+        except OSError:
+            out.append((path, None, {}, 0, 0.0))
+            continue
+        start = time.perf_counter()
+        result = backend.parse_declarations(source, path)
+        # 懒解码的结果在这里解码，耗时计入解析
+        result.structs, result.unions, result.typedefs
+        macros = extract_defines(source) if 'define' in source else {}
+        out.append((path, result, macros, len(source.encode('utf-8', errors='ignore')),
+                    time.perf_counter() - start))
+    return out
+
+
+def default_backend() -> str:
+    """收集头文件用的后端：native（已编译时）> regex"""
+    return 'native' if BackendRegistry.is_available('native') else 'regex'
+
+
+def harvest(paths: Iterable[str], backend_name: Optional[str] = None, jobs: int = 1) -> HeaderIndex:
+    """
+    收集头文件中的类型声明
+
+    Args:
+        paths: 头文件或目录（递归）
+        backend_name: 后端名称，默认见 default_backend()
+        jobs: 并行进程数；>1 时按文件分块并行解析，合并顺序与串行相同
+
+    Returns:
+        HeaderIndex，stats 中是单独统计的吞吐量
+    """
+    backend_name = backend_name or default_backend()
+    files = find_headers(paths)
+    wall_start = time.perf_counter()
+    if jobs > 1 and len(files) > 1:
+        from concurrent.futures import ProcessPoolExecutor
+        chunk = max(1, -(-len(files) // (jobs * 4)))
+        chunks = [files[i:i + chunk] for i in range(0, len(files), chunk)]
+        with ProcessPoolExecutor(max_workers=jobs) as pool:
+            parsed = [item for part in pool.map(_parse_headers, [backend_name] * len(chunks), chunks)
+                      for item in part]
+    else:
+        parsed = _parse_headers(backend_name, files)
+
+    index = HeaderIndex()
+    total_bytes, parse_seconds, unreadable = 0, 0.0, []
+    for path, result, macros, size, seconds in parsed:
+        if result is None:
+            unreadable.append(path)
+            continue
+        index.merge(path, result, macros)
+        total_bytes += size
+        parse_seconds += seconds
+    wall = time.perf_counter() - wall_start
+
+    index.stats = {
+        "backend": backend_name,
+        "jobs": jobs,
+        "files": len(files) - len(unreadable),
+        "bytes": total_bytes,
+        "parse_seconds": round(parse_seconds, 4),
+        "wall_seconds": round(wall, 4),
+        "mb_per_s": round(total_bytes / 1024.0 / 1024.0 / wall, 3) if wall > 0 else 0.0,
+    }
+    if unreadable:
+        index.stats["unreadable"] = unreadable
+    return index
@@ -0,0 +1,811 @@
+// 原生扫描器：native 后端的扫描和提取部分
+//
+// 在去掉注释的源码上完成与 regex 后端逐项等价的扫描：
+//   - 注释去除（块注释替换为同样数量的换行，保持行号）
+//   - struct/union 定义区域（名字、typedef 别名、前后布局属性、成员体）
+//   - typedef、函数定义（参数、属性、函数体、调用）、ops 表初始化、module_init/exit
+//
+// 结果以 uint32 数组（紧凑缓冲区）返回，所有文本都是去注释后源码中的 [起, 止) 码位区间，
+// 由 native_backend.py 按需解码成 ParseResult。按 PyUnicode 的存储宽度（1/2/4 字节）
+// 模板化，偏移即 Python 字符串下标，\w / \s 的判定与 re 模块的 Unicode 语义一致。
+//
+// 每处扫描逻辑旁注明了对应的 regex_backend.py 正则；修改任一侧都要同步另一侧，
+// tests/test_native_backend.py 逐字节对比两个后端的 JSON 输出。
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+typedef Py_ssize_t Pos;
+
+const uint32_t MAGIC = 0x4C44414E;  // "LDAN"
+const uint32_t VERSION = 1;
+const uint32_t NONE = 0xFFFFFFFFu;
+
+// 缓冲区布局（见 native_backend.py）
+enum Header {
+    H_MAGIC, H_VERSION,
+    H_FUNCS, H_FUNCS_OFF, H_PARAMS_OFF, H_CALLS_OFF,
+    H_STRUCTS, H_STRUCTS_OFF,
+    H_TYPEDEFS, H_TYPEDEFS_OFF,
+    H_INITS, H_INITS_OFF,
+    H_MODINIT_S, H_MODINIT_E, H_MODEXIT_S, H_MODEXIT_E,
+    H_SIZE
+};
+
+const int FUNC_WORDS = 13;    // name_s name_e ret_s ret_e attrs line end_line body_s body_e
+                              // param_first param_count call_first call_count
+const int PARAM_WORDS = 6;    // type_s type_e name_s name_e struct_s struct_e
+const int STRUCT_WORDS = 17;  // kind start end name_s name_e alias_s alias_e pre_s pre_e
+                              // post_s post_e post2_s post2_e body_s body_e line end_line
+const int TYPEDEF_WORDS = 5;  // orig_s orig_e alias_s alias_e line
+const int INIT_WORDS = 6;     // type_s type_e field_s field_e value_s value_e
+
+// 函数属性位（与 regex 后端按 ['static', '__init', '__exit', 'inline'] 的子串判断一致）
+const uint32_t ATTR_STATIC = 1, ATTR_INIT = 2, ATTR_EXIT = 4, ATTR_INLINE = 8;
+
+// ASCII 字符类表: \w / \s / '*'（非 ASCII 交给 Python 的 Unicode 数据库）
+enum CharClass : uint8_t { C_WORD = 1, C_SPACE = 2, C_STAR = 4 };
+
+struct AsciiTable {
+    uint8_t cls[128];
+    AsciiTable() {
+        for (int c = 0; c < 128; c++) {
+            bool w = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+            cls[c] = (w ? C_WORD : 0) | (Py_UNICODE_ISSPACE(c) ? C_SPACE : 0) | (c == '*' ? C_STAR : 0);
+        }
+    }
+};
+const AsciiTable ascii;
+
+inline uint8_t char_class(Py_UCS4 c) {
+    if (c < 128)
+        return ascii.cls[c];
+    return (Py_UNICODE_ISALNUM(c) ? C_WORD : 0) | (Py_UNICODE_ISSPACE(c) ? C_SPACE : 0);
+}
+
+inline bool is_word(Py_UCS4 c) { return char_class(c) & C_WORD; }
+inline bool is_space(Py_UCS4 c) { return char_class(c) & C_SPACE; }
+
+template <typename Ch>
+class Scanner {
+public:
+    Scanner(const Ch* src, Pos n) : src_(src), n_src_(n) {}
+
+    void run() {
+        strip_comments();
+        index_lines();
+        scan_structs();
+        scan_typedefs();
+        scan_functions();
+        scan_inits();
+        scan_module_macro("module_init", H_MODINIT_S);
+        scan_module_macro("module_exit", H_MODEXIT_S);
+    }
+
+    std::vector<Ch> out;            // 去注释后的源码
+    std::vector<uint32_t> funcs, params, calls, structs, typedefs, inits;
+    uint32_t module_spans[4] = {NONE, NONE, NONE, NONE};
+
+private:
+    const Ch* src_;
+    Pos n_src_;
+    const Ch* s_ = nullptr;
+    Pos n_ = 0;
+    std::vector<Pos> newlines_;
+    mutable std::vector<std::pair<Pos, Pos>> chain_;  // 函数头属性关键字链（复用的缓冲）
+
+    // ---------- 基础 ----------
+
+    Py_UCS4 at(Pos i) const { return i >= 0 && i < n_ ? (Py_UCS4)s_[i] : 0; }
+    bool word(Pos i) const { return i >= 0 && i < n_ && is_word(s_[i]); }
+    bool space(Pos i) const { return i >= 0 && i < n_ && is_space(s_[i]); }
+
+    bool starts(Pos i, const char* lit) const {
+        if (i < 0)
+            return false;
+        for (Pos k = 0; lit[k]; k++)
+            if (i + k >= n_ || (Py_UCS4)s_[i + k] != (Py_UCS4)(unsigned char)lit[k])
+                return false;
+        return true;
+    }
+
+    // [i, e) 是否恰好是 lit
+    bool equals(Pos i, Pos e, const char* lit) const {
+        Pos k = 0;
+        for (; lit[k]; k++)
+            if (i + k >= e || (Py_UCS4)s_[i + k] != (Py_UCS4)(unsigned char)lit[k])
+                return false;
+        return i + k == e;
+    }
+
+    Pos skip_space(Pos i) const { while (space(i)) i++; return i; }
+    Pos skip_word(Pos i) const { while (word(i)) i++; return i; }
+
+    // LineIndex.line_of：pos 之前的换行数 + 1
+    uint32_t line_of(Pos pos) const {
+        return (uint32_t)(std::lower_bound(newlines_.begin(), newlines_.end(), pos) - newlines_.begin()) + 1;
+    }
+
+    // str.strip()
+    void strip(Pos& a, Pos& b) const {
+        while (a < b && space(a)) a++;
+        while (b > a && space(b - 1)) b--;
+    }
+
+    // ---------- 注释 ----------
+
+    // re.sub(r'/\*.*?\*/', 换行, DOTALL) 之后 re.sub(r'//.*$', '', MULTILINE)
+    void strip_comments() {
+        // 第一遍：块注释（按 '/' 跳跃查找，其余字符整段复制）
+        std::vector<Ch> tmp(n_src_);
+        Ch* w = tmp.data();
+        const Ch* end = src_ + n_src_;
+        const Ch* p = src_;
+        while (p < end) {
+            const Ch* slash = std::find(p, end, (Ch)'/');
+            w = std::copy(p, slash, w);
+            p = slash;
+            if (p == end)
+                break;
+            if (p + 1 == end || p[1] != '*') {
+                *w++ = *p++;
+                continue;
+            }
+            const Ch* k = p + 2;
+            while (k + 1 < end && !(k[0] == '*' && k[1] == '/'))
+                k++;
+            if (k + 1 >= end) {  // 没有闭合：其后不会再有匹配
+                w = std::copy(p, end, w);
+                break;
+            }
+            for (const Ch* j = p; j < k; j++)
+                if (*j == '\n')
+                    *w++ = '\n';
+            p = k + 2;
+        }
+        tmp.resize(w - tmp.data());
+
+        // 第二遍：行注释（保留行尾换行）
+        out.resize(tmp.size());
+        w = out.data();
+        end = tmp.data() + tmp.size();
+        p = tmp.data();
+        while (p < end) {
+            const Ch* slash = std::find(p, end, (Ch)'/');
+            w = std::copy(p, slash, w);
+            p = slash;
+            if (p == end)
+                break;
+            if (p + 1 == end || p[1] != '/') {
+                *w++ = *p++;
+                continue;
+            }
+            p = std::find(p, end, (Ch)'\n');
+        }
+        out.resize(w - out.data());
+        s_ = out.data();
+        n_ = (Pos)out.size();
+    }
+
+    void index_lines() {
+        for (Pos i = 0; i < n_; i++)
+            if (s_[i] == '\n')
+                newlines_.push_back(i);
+    }
+
+    // ---------- 布局属性（base.LAYOUT_ATTR_PATTERN） ----------
+
+    // 平衡括号，内部最多嵌套 depth_limit 层；i 指向 '('，返回 ')' 之后的位置或 -1
+    Pos balanced(Pos i, int depth_limit) const {
+        int depth = 0;
+        for (Pos k = i + 1; k < n_; k++) {
+            Py_UCS4 c = s_[k];
+            if (c == '(') {
+                if (++depth > depth_limit)
+                    return -1;
+            } else if (c == ')') {
+                if (depth == 0)
+                    return k + 1;
+                depth--;
+            }
+        }
+        return -1;
+    }
+
+    Pos match_attr(Pos i) const {
+        if (starts(i, "__attribute__")) {
+            Pos k = skip_space(i + 13);
+            if (at(k) == '(' && at(k + 1) == '(') {
+                // \(\( (?:[^()]|\((?:[^()]|\([^()]*\))*\))* \)\)
+                Pos end = balanced(k + 1, 2);
+                if (end > 0 && at(end) == ')')
+                    return end + 1;
+            }
+            return -1;
+        }
+        if (starts(i, "__packed") && !word(i + 8))
+            return i + 8;
+        if (starts(i, "__aligned")) {
+            Pos k = skip_space(i + 9);
+            return at(k) == '(' ? balanced(k, 1) : -1;
+        }
+        Pos u = i;
+        while (at(u) == '_') u++;
+        if (u - i >= 2 && u - i <= 4 && starts(u, "cacheline_aligned")) {
+            Pos k = u + 17;
+            if (starts(k, "_in_smp") && !word(k + 7))
+                return k + 7;
+            return word(k) ? -1 : k;
+        }
+        if (starts(i, "__randomize_layout") && !word(i + 18))
+            return i + 18;
+        return -1;
+    }
+
+    // (?:\s*(?:ATTR))* 贪婪匹配，返回结束位置
+    Pos match_attrs(Pos i) const {
+        for (;;) {
+            Pos end = match_attr(skip_space(i));
+            if (end < 0)
+                return i;
+            i = end;
+        }
+    }
+
+    // ---------- 结构体 ----------
+
+    // 成员体 [^{}]*(?:\{...\})* 最多两层内嵌；i 指向 '{'，返回匹配的 '}' 位置或 -1
+    Pos struct_body(Pos i) const {
+        int depth = 0;
+        for (Pos k = i + 1; k < n_; k++) {
+            Py_UCS4 c = s_[k];
+            if (c == '{') {
+                if (++depth > 2)
+                    return -1;
+            } else if (c == '}') {
+                if (depth == 0)
+                    return k;
+                depth--;
+            }
+        }
+        return -1;
+    }
+
+    // (?:typedef\s+)?(struct|union)\b(pre)\s*(name)?\s*\{(body)\}(post)\s*(alias)?(post2)\s*;
+    void scan_structs() {
+        Pos resume = 0;
+        for (Pos i = 0; i < n_; i++) {
+            uint32_t kind;
+            Pos kw_end;
+            if (s_[i] == 's' && starts(i, "struct")) {
+                kind = 0;
+                kw_end = i + 6;
+            } else if (s_[i] == 'u' && starts(i, "union")) {
+                kind = 1;
+                kw_end = i + 5;
+            } else {
+                continue;
+            }
+            if (word(kw_end))
+                continue;
+            Pos pre_e = match_attrs(kw_end);
+            Pos k = skip_space(pre_e);
+            Pos name_s = k, name_e = skip_word(k);
+            k = skip_space(name_e);
+            if (at(k) != '{')
+                continue;
+            Pos close = struct_body(k);
+            if (close < 0)
+                continue;
+            Pos body_s = k + 1;
+            Pos post_s = close + 1, post_e = match_attrs(post_s);
+            Pos alias_s = skip_space(post_e), alias_e = skip_word(alias_s);
+            Pos post2_e = match_attrs(alias_e);
+            Pos semi = skip_space(post2_e);
+            if (at(semi) != ';')
+                continue;
+
+            // typedef 前缀（从不早于上一个匹配的结尾）
+            Pos start = i;
+            Pos t = i;
+            while (t > 0 && space(t - 1)) t--;
+            if (t < i && t >= 7 + resume && starts(t - 7, "typedef"))
+                start = t - 7;
+
+            uint32_t rec[STRUCT_WORDS] = {
+                kind, (uint32_t)start, (uint32_t)(semi + 1),
+                name_e > name_s ? (uint32_t)name_s : NONE, (uint32_t)name_e,
+                alias_e > alias_s ? (uint32_t)alias_s : NONE, (uint32_t)alias_e,
+                (uint32_t)kw_end, (uint32_t)pre_e,
+                (uint32_t)post_s, (uint32_t)post_e,
+                (uint32_t)alias_e, (uint32_t)post2_e,
+                (uint32_t)body_s, (uint32_t)close,
+                line_of(start), line_of(semi + 1),
+            };
+            structs.insert(structs.end(), rec, rec + STRUCT_WORDS);
+            resume = semi + 1;
+            i = semi;
+        }
+    }
+
+    // ---------- typedef ----------
+
+    // typedef\s+(.+?)\s+(\w+)\s*;     （. 不匹配换行）
+    void scan_typedefs() {
+        for (Pos t = 0; t + 7 <= n_; t++) {
+            if (s_[t] != 't' || !starts(t, "typedef"))
+                continue;
+            Pos p = t + 7;
+            Pos p2 = skip_space(p);
+            if (p2 == p)
+                continue;
+            bool matched = false;
+            Pos orig_s = 0, orig_e = 0, alias_s = 0, alias_e = 0, end = 0;
+            // \s+ 贪婪，从最长开始让出
+            for (Pos o = p2; o > p && !matched; o--) {
+                for (Pos e = o + 1; e <= n_; e++) {
+                    if (s_[e - 1] == '\n')
+                        break;
+                    if (!space(e))
+                        continue;
+                    Pos w = skip_space(e);
+                    Pos we = skip_word(w);
+                    if (we == w)
+                        continue;
+                    Pos semi = skip_space(we);
+                    if (at(semi) != ';')
+                        continue;
+                    orig_s = o, orig_e = e, alias_s = w, alias_e = we, end = semi + 1;
+                    matched = true;
+                    break;
+                }
+            }
+            if (!matched)
+                continue;
+            strip(orig_s, orig_e);
+            bool has_brace = false;
+            for (Pos k = orig_s; k < orig_e; k++)
+                if (s_[k] == '{')
+                    has_brace = true;
+            if (!has_brace) {
+                uint32_t rec[TYPEDEF_WORDS] = {(uint32_t)orig_s, (uint32_t)orig_e,
+                                               (uint32_t)alias_s, (uint32_t)alias_e, line_of(t)};
+                typedefs.insert(typedefs.end(), rec, rec + TYPEDEF_WORDS);
+            }
+            t = end - 1;
+        }
+    }
+
+    // ---------- 函数 ----------
+
+    // 函数头前的属性关键字 static\s+|inline\s+|__init\s+|__exit\s+|__always_inline\s+
+    Pos match_func_keyword(Pos i) const {
+        static const char* const words[] = {"static", "inline", "__init", "__exit", "__always_inline"};
+        for (const char* w : words) {
+            if (!starts(i, w))
+                continue;
+            Pos len = (Pos)strlen(w);
+            if (space(i + len))
+                return i + len;
+        }
+        return -1;
+    }
+
+    bool in_return_class(Pos i) const { return i < n_ && char_class(s_[i]) != 0; }
+
+    // regex 后端 _find_matching_paren / _find_matching_brace（含字符串、字符字面量处理）
+    Pos find_matching(Pos start, Ch open, Ch close) const {
+        if (start >= n_ || s_[start] != open)
+            return -1;
+        int count = 1;
+        Pos pos = start + 1;
+        bool in_string = false, in_char = false;
+        while (pos < n_ && count > 0) {
+            Ch c = s_[pos];
+            Ch prev = s_[pos - 1];
+            if (c == '"' && prev != '\\' && !in_char)
+                in_string = !in_string;
+            else if (c == '\'' && prev != '\\' && !in_string)
+                in_char = !in_char;
+            else if (!in_string && !in_char) {
+                if (c == open)
+                    count++;
+                else if (c == close)
+                    count--;
+            }
+            pos++;
+        }
+        return count == 0 ? pos - 1 : -1;
+    }
+
+    // 第一个 "struct\s+(\w+)" 的名字区间
+    void struct_ref(Pos a, Pos b, uint32_t& rs, uint32_t& re) const {
+        rs = re = NONE;
+        for (Pos i = a; i + 6 <= b; i++) {
+            if (s_[i] != 's' || !starts(i, "struct"))
+                continue;
+            Pos k = i + 6;
+            Pos w = k;
+            while (w < b && space(w)) w++;
+            if (w == k)
+                continue;
+            Pos we = w;
+            while (we < b && word(we)) we++;
+            if (we > w) {
+                rs = (uint32_t)w, re = (uint32_t)we;
+                return;
+            }
+        }
+    }
+
+    // _parse_params：按逗号切分，每段 (.+?)(\w+)\s*$
+    void parse_params(Pos a, Pos b) {
+        strip(a, b);
+        if (a == b || (b - a == 4 && starts(a, "void") ))
+            return;
+        Pos seg = a;
+        for (Pos k = a; k <= b; k++) {
+            if (k < b && s_[k] != ',')
+                continue;
+            Pos ps = seg, pe = k;
+            seg = k + 1;
+            strip(ps, pe);
+            if (ps == pe)
+                continue;
+            // (.+?) 不跨行，(\w+) 是末尾的词（至少给类型留一个字符）
+            Pos w = pe;
+            while (w > ps && word(w - 1)) w--;
+            if (w == ps)
+                w = ps + 1;
+            bool matched = w < pe && word(pe - 1);
+            for (Pos k = ps; matched && k < w; k++)
+                if (s_[k] == '\n')
+                    matched = false;
+            if (!matched) {
+                uint32_t rec[PARAM_WORDS] = {(uint32_t)ps, (uint32_t)pe, NONE, NONE, NONE, NONE};
+                struct_ref(ps, pe, rec[4], rec[5]);
+                params.insert(params.end(), rec, rec + PARAM_WORDS);
+                continue;
+            }
+            Pos ts = ps, te = w;
+            strip(ts, te);
+            uint32_t rec[PARAM_WORDS] = {(uint32_t)ts, (uint32_t)te, (uint32_t)w, (uint32_t)pe, NONE, NONE};
+            struct_ref(ts, te, rec[4], rec[5]);
+            params.insert(params.end(), rec, rec + PARAM_WORDS);
+        }
+    }
+
+    // _analyze_calls：\b(\w+)\s*\( 排除关键字
+    void scan_calls(Pos a, Pos b) {
+        static const char* const excluded[] = {"if", "while", "for", "switch", "return", "sizeof",
+                                               "typeof", "container_of", "offsetof", "likely",
+                                               "unlikely"};
+        Pos i = a;
+        while (i < b) {
+            if (!word(i)) {
+                i++;
+                continue;
+            }
+            Pos we = i;
+            while (we < b && word(we)) we++;
+            Pos k = we;
+            while (k < b && space(k)) k++;
+            if (k < b && s_[k] == '(') {
+                bool skip = false;
+                for (const char* w : excluded) {
+                    if (equals(i, we, w)) {
+                        skip = true;
+                        break;
+                    }
+                }
+                if (!skip) {
+                    calls.push_back((uint32_t)i);
+                    calls.push_back((uint32_t)we);
+                }
+            }
+            i = we;
+        }
+    }
+
+    // (?:^|\n)\s*((?:static\s+|...)*)([\w\s\*]+?)\s+(\w+)\s*\(
+    //
+    // 回溯顺序下 a（返回类型起点）依次取值单调递减，第一个能让 "返回类型 \s+ 名字 \s* (" 成立的
+    // a 即为匹配：名字是 '(' 前最后一个词，返回类型至少一个字符且名字前至少一个空白。
+    bool match_function_head(Pos q, Pos& attrs_s, Pos& a, Pos& ret_e, Pos& name_s,
+                             Pos& name_e, Pos& paren) const {
+        Pos c_end = q;
+        while (in_return_class(c_end)) c_end++;
+        if (at(c_end) != '(')
+            return false;
+        Pos e = c_end;
+        while (e > q && space(e - 1)) e--;
+        name_e = e;
+        while (e > q && word(e - 1)) e--;
+        name_s = e;
+        if (name_s == name_e || name_s == q || !space(name_s - 1))
+            return false;
+        Pos ws_start = name_s;
+        while (ws_start > q && space(ws_start - 1)) ws_start--;
+        Pos limit = name_s - 2;  // a + 1 < name_s
+        if (limit < q)
+            return false;
+
+        Pos w_end = skip_space(q);
+        // 属性关键字链: (关键字结束, 空白结束)
+        Pos best = -1;
+        Pos pos = w_end;
+        std::vector<std::pair<Pos, Pos>>& chain = chain_;
+        chain.clear();
+        for (;;) {
+            Pos kw = match_func_keyword(pos);
+            if (kw < 0)
+                break;
+            Pos we = skip_space(kw);
+            chain.push_back(std::make_pair(kw, we));
+            pos = we;
+        }
+        for (auto it = chain.rbegin(); it != chain.rend() && best < 0; ++it) {
+            // 该次迭代的 \s+ 从最长开始让出: [kw_end + 1, ws_end]
+            if (it->first + 1 <= limit)
+                best = std::min(it->second, limit);
+        }
+        if (best < 0 && w_end <= limit)
+            best = w_end;
+        if (best < 0)
+            best = limit;  // [q, w_end) 中 a = s，无属性
+        a = best;
+        attrs_s = a >= w_end ? w_end : a;
+        ret_e = std::max(a + 1, ws_start);
+        paren = c_end;
+        return true;
+    }
+
+    void scan_functions() {
+        static const char* const keywords[] = {"if", "while", "for", "switch", "sizeof", "typeof"};
+        Pos resume = 0;
+        // 候选起点: 文件开头和每个换行
+        for (size_t c = 0; c <= newlines_.size(); c++) {
+            Pos p = c == 0 ? 0 : newlines_[c - 1];
+            if (p < resume || (c > 0 && p == 0))
+                continue;
+            Pos q = c == 0 ? 0 : p + 1;
+            Pos attrs_s, a, ret_e, name_s, name_e, paren;
+            bool ok = match_function_head(q, attrs_s, a, ret_e, name_s, name_e, paren);
+            if (!ok && p == 0 && n_ > 0 && s_[0] == '\n')
+                ok = match_function_head(1, attrs_s, a, ret_e, name_s, name_e, paren);
+            if (!ok)
+                continue;
+            resume = paren + 1;
+            Pos start = p;
+
+            bool keyword = false;
+            for (const char* w : keywords)
+                if (equals(name_s, name_e, w))
+                    keyword = true;
+            if (keyword)
+                continue;
+
+            Pos paren_end = find_matching(paren, '(', ')');
+            if (paren_end < 0)
+                continue;
+            Pos brace = skip_space(paren_end + 1);
+            if (at(brace) != '{')
+                continue;
+            Pos end_pos = find_matching(brace, '{', '}');
+            Pos body_s = brace, body_e = brace;
+            if (end_pos > brace)
+                body_e = end_pos + 1;
+
+            uint32_t attrs = 0;
+            Pos as = attrs_s, ae = a;
+            strip(as, ae);
+            for (Pos k = as; k < ae; k++) {
+                if (starts(k, "static") && k + 6 <= ae) attrs |= ATTR_STATIC;
+                if (starts(k, "__init") && k + 6 <= ae) attrs |= ATTR_INIT;
+                if (starts(k, "__exit") && k + 6 <= ae) attrs |= ATTR_EXIT;
+                if (starts(k, "inline") && k + 6 <= ae) attrs |= ATTR_INLINE;
+            }
+            Pos rs = a, re = ret_e;
+            strip(rs, re);
+
+            uint32_t first_param = (uint32_t)(params.size() / PARAM_WORDS);
+            parse_params(paren + 1, paren_end);
+            uint32_t first_call = (uint32_t)(calls.size() / 2);
+            if (body_e > body_s)
+                scan_calls(body_s, body_e);
+
+            uint32_t line = line_of(start);
+            uint32_t rec[FUNC_WORDS] = {
+                (uint32_t)name_s, (uint32_t)name_e, (uint32_t)rs, (uint32_t)re, attrs,
+                line, end_pos > 0 ? line_of(end_pos) : line,
+                (uint32_t)body_s, (uint32_t)body_e,
+                first_param, (uint32_t)(params.size() / PARAM_WORDS) - first_param,
+                first_call, (uint32_t)(calls.size() / 2) - first_call,
+            };
+            funcs.insert(funcs.end(), rec, rec + FUNC_WORDS);
+        }
+    }
+
+    // ---------- 回调 ----------
+
+    // struct\s+(\w+)\s+(\w+)\s*=\s*\{([^}]+)\} 中的 \.(\w+)\s*=\s*(\w+)
+    void scan_inits() {
+        for (Pos i = 0; i + 6 <= n_; i++) {
+            if (s_[i] != 's' || !starts(i, "struct"))
+                continue;
+            Pos k = i + 6;
+            Pos t_s = skip_space(k);
+            if (t_s == k)
+                continue;
+            Pos t_e = skip_word(t_s);
+            if (t_e == t_s)
+                continue;
+            Pos v_s = skip_space(t_e);
+            if (v_s == t_e)
+                continue;
+            Pos v_e = skip_word(v_s);
+            if (v_e == v_s)
+                continue;
+            Pos eq = skip_space(v_e);
+            if (at(eq) != '=')
+                continue;
+            Pos brace = skip_space(eq + 1);
+            if (at(brace) != '{')
+                continue;
+            Pos close = brace + 1;
+            while (close < n_ && s_[close] != '}') close++;
+            if (close >= n_ || close == brace + 1)
+                continue;
+            for (Pos d = brace + 1; d < close; d++) {
+                if (s_[d] != '.')
+                    continue;
+                Pos f_s = d + 1, f_e = f_s;
+                while (f_e < close && word(f_e)) f_e++;
+                if (f_e == f_s)
+                    continue;
+                Pos e = f_e;
+                while (e < close && space(e)) e++;
+                if (e >= close || s_[e] != '=')
+                    continue;
+                Pos x_s = e + 1;
+                while (x_s < close && space(x_s)) x_s++;
+                Pos x_e = x_s;
+                while (x_e < close && word(x_e)) x_e++;
+                if (x_e == x_s)
+                    continue;
+                uint32_t rec[INIT_WORDS] = {(uint32_t)t_s, (uint32_t)t_e, (uint32_t)f_s,
+                                            (uint32_t)f_e, (uint32_t)x_s, (uint32_t)x_e};
+                inits.insert(inits.end(), rec, rec + INIT_WORDS);
+                d = x_e - 1;
+            }
+            i = close;
+        }
+    }
+
+    // NAME\s*\(\s*(\w+)\s*\) 的第一个匹配
+    void scan_module_macro(const char* macro, int header_slot) {
+        Pos len = (Pos)strlen(macro);
+        for (Pos i = 0; i + len <= n_; i++) {
+            if (!starts(i, macro))
+                continue;
+            Pos k = skip_space(i + len);
+            if (at(k) != '(')
+                continue;
+            Pos w = skip_space(k + 1);
+            Pos we = skip_word(w);
+            if (we == w || at(skip_space(we)) != ')')
+                continue;
+            int slot = header_slot == H_MODINIT_S ? 0 : 2;
+            module_spans[slot] = (uint32_t)w;
+            module_spans[slot + 1] = (uint32_t)we;
+            return;
+        }
+    }
+};
+
+template <typename Ch>
+PyObject* scan_kind(PyObject* text, int kind) {
+    const Ch* data = (const Ch*)PyUnicode_DATA(text);
+    Pos n = PyUnicode_GET_LENGTH(text);
+    if (n >= (Pos)NONE) {
+        PyErr_SetString(PyExc_ValueError, "source too large for native scanner");
+        return nullptr;
+    }
+
+    std::vector<uint32_t> buf;
+    PyObject* content = nullptr;
+    Py_BEGIN_ALLOW_THREADS
+    {
+        Scanner<Ch> sc(data, n);
+        sc.run();
+
+        uint32_t header[H_SIZE] = {0};
+        header[H_MAGIC] = MAGIC;
+        header[H_VERSION] = VERSION;
+        uint32_t off = H_SIZE;
+        header[H_FUNCS] = (uint32_t)(sc.funcs.size() / FUNC_WORDS);
+        header[H_FUNCS_OFF] = off;
+        off += (uint32_t)sc.funcs.size();
+        header[H_PARAMS_OFF] = off;
+        off += (uint32_t)sc.params.size();
+        header[H_CALLS_OFF] = off;
+        off += (uint32_t)sc.calls.size();
+        header[H_STRUCTS] = (uint32_t)(sc.structs.size() / STRUCT_WORDS);
+        header[H_STRUCTS_OFF] = off;
+        off += (uint32_t)sc.structs.size();
+        header[H_TYPEDEFS] = (uint32_t)(sc.typedefs.size() / TYPEDEF_WORDS);
+        header[H_TYPEDEFS_OFF] = off;
+        off += (uint32_t)sc.typedefs.size();
+        header[H_INITS] = (uint32_t)(sc.inits.size() / INIT_WORDS);
+        header[H_INITS_OFF] = off;
+        off += (uint32_t)sc.inits.size();
+        for (int k = 0; k < 4; k++)
+            header[H_MODINIT_S + k] = sc.module_spans[k];
+
+        buf.reserve(off);
+        buf.insert(buf.end(), header, header + H_SIZE);
+        for (auto* part : {&sc.funcs, &sc.params, &sc.calls, &sc.structs, &sc.typedefs, &sc.inits})
+            buf.insert(buf.end(), part->begin(), part->end());
+
+        Py_BLOCK_THREADS
+        content = PyUnicode_FromKindAndData(kind, sc.out.data(), (Pos)sc.out.size());
+        Py_UNBLOCK_THREADS
+    }
+    Py_END_ALLOW_THREADS
+
+    if (!content)
+        return nullptr;
+    PyObject* packed = PyBytes_FromStringAndSize((const char*)buf.data(),
+                                                 (Pos)(buf.size() * sizeof(uint32_t)));
+    if (!packed) {
+        Py_DECREF(content);
+        return nullptr;
+    }
+    return Py_BuildValue("(NN)", content, packed);
+}
+
+PyObject* scan(PyObject*, PyObject* arg) {
+    if (!PyUnicode_Check(arg)) {
+        PyErr_SetString(PyExc_TypeError, "scan() expects str");
+        return nullptr;
+    }
+    if (PyUnicode_READY(arg) < 0)
+        return nullptr;
+    switch (PyUnicode_KIND(arg)) {
+    case PyUnicode_1BYTE_KIND:
+        return scan_kind<Py_UCS1>(arg, PyUnicode_1BYTE_KIND);
+    case PyUnicode_2BYTE_KIND:
+        return scan_kind<Py_UCS2>(arg, PyUnicode_2BYTE_KIND);
+    default:
+        return scan_kind<Py_UCS4>(arg, PyUnicode_4BYTE_KIND);
+    }
+}
+
+PyMethodDef methods[] = {
+    {"scan", scan, METH_O,
+     "scan(source) -> (content, buffer)\n\n"
+     "content: 去掉注释的源码；buffer: uint32 紧凑记录（布局见 native_backend.py）"},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyModuleDef module = {
+    PyModuleDef_HEAD_INIT, "_lda_scan", "native 后端的扫描器", -1, methods,
+    nullptr, nullptr, nullptr, nullptr,
+};
+
+}  // namespace
+
+PyMODINIT_FUNC PyInit__lda_scan(void) {
+    PyObject* m = PyModule_Create(&module);
+    if (m) {
+        PyModule_AddIntConstant(m, "VERSION", VERSION);
+    }
+    return m;
+}
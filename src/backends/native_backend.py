@@ -0,0 +1,287 @@
+#!/usr/bin/env python3
+"""
+原生扫描后端
+
+扫描和提取在 C++ 扩展 backends._lda_scan（native/lda_scan.cpp）中完成，
+结果是一块 uint32 紧凑缓冲区（只有去注释源码中的偏移和行号），
+ParseResult 的各部分在第一次访问时才解码成 FunctionDef / StructDef 等对象：
+- 只需要函数和调用关系的调用方不会为结构体成员付出代价
+- 结构体成员声明的解析复用 RegexBackend._parse_struct_fields（与 regex 后端完全一致）
+
+输出与 regex 后端逐项相同（tests/test_native_backend.py 对比 to_dict() 的 JSON），
+扩展未编译时该后端不可用。编译: make native（或 python setup.py build_ext --inplace）。
+"""
+
+import re
+from typing import Dict, List, Optional, Set
+
+from .base import (
+    AnalyzerBackend, BackendCapability, BackendRegistry,
+    ParseResult, FunctionDef, StructDef, UnionDef, TypeDef, Parameter, Location, LineIndex,
+    extract_layout_attributes
+)
+from .regex_backend import RegexBackend, extract_enums, skip_bodies
+
+try:
+    from . import _lda_scan
+    NATIVE_AVAILABLE = True
+except ImportError:
+    _lda_scan = None
+    NATIVE_AVAILABLE = False
+
+
+# 缓冲区布局，与 lda_scan.cpp 中的 Header 和 *_WORDS 一致
+MAGIC = 0x4C44414E
+(H_MAGIC, H_VERSION, H_FUNCS, H_FUNCS_OFF, H_PARAMS_OFF, H_CALLS_OFF,
+ H_STRUCTS, H_STRUCTS_OFF, H_TYPEDEFS, H_TYPEDEFS_OFF, H_INITS, H_INITS_OFF,
+ H_MODINIT_S, H_MODINIT_E, H_MODEXIT_S, H_MODEXIT_E, H_SIZE) = range(17)
+FUNC_WORDS, PARAM_WORDS, STRUCT_WORDS, TYPEDEF_WORDS, INIT_WORDS = 13, 6, 17, 5, 6
+NONE = 0xFFFFFFFF
+
+# 函数属性位 -> 名称（顺序与 regex 后端一致）
+_ATTR_BITS = ((1, 'static'), (2, '__init'), (4, '__exit'), (8, 'inline'))
+
+_STRUCT_REF = re.compile(r'struct\s+(\w+)')
+
+# 成员声明解析器（无状态）
+_MEMBERS = RegexBackend()
+
+
+class NativeParseResult(ParseResult):
+    """
+    按需解码的解析结果
+
+    functions（含调用关系和回调标记）、structs / unions、typedefs 各自在第一次访问时解码；
+    赋值后以赋值为准。序列化（pickle）时先完整解码成普通 ParseResult。
+    """
+
+    def __init__(self, content: str, buffer: bytes):
+        self._content = content
+        self._words = memoryview(buffer).cast('I')
+        if len(self._words) < H_SIZE or self._words[H_MAGIC] != MAGIC:
+            raise ValueError("native 扫描结果格式不匹配")
+        self._functions: Optional[Dict[str, FunctionDef]] = None
+        self._structs: Optional[Dict[str, StructDef]] = None
+        self._unions: Optional[Dict[str, UnionDef]] = None
+        self._typedefs: Optional[Dict[str, TypeDef]] = None
+        self.enums = {}
+        self.calls = []
+        self.errors = []
+
+    # ---------- 懒解码属性 ----------
+
+    @property
+    def functions(self) -> Dict[str, FunctionDef]:
+        if self._functions is None:
+            self._functions = self._decode_functions()
+        return self._functions
+
+    @functions.setter
+    def functions(self, value: Dict[str, FunctionDef]) -> None:
+        self._functions = value
+
+    @property
+    def structs(self) -> Dict[str, StructDef]:
+        if self._structs is None:
+            self._decode_records()
+        return self._structs
+
+    @structs.setter
+    def structs(self, value: Dict[str, StructDef]) -> None:
+        self._structs = value
+
+    @property
+    def unions(self) -> Dict[str, UnionDef]:
+        if self._unions is None:
+            self._decode_records()
+        return self._unions
+
+    @unions.setter
+    def unions(self, value: Dict[str, UnionDef]) -> None:
+        self._unions = value
+
+    @property
+    def typedefs(self) -> Dict[str, TypeDef]:
+        if self._typedefs is None:
+            self._typedefs = self._decode_typedefs()
+        return self._typedefs
+
+    @typedefs.setter
+    def typedefs(self, value: Dict[str, TypeDef]) -> None:
+        self._typedefs = value
+
+    def __reduce__(self):
+        return (ParseResult, (self.functions, self.structs, self.enums, self.unions,
+                              self.typedefs, self.calls, self.errors))
+
+    # ---------- 解码 ----------
+
+    def _text(self, start: int, end: int) -> str:
+        return self._content[start:end] if start != NONE else ""
+
+    def _records(self, count_slot: int, offset_slot: int, width: int):
+        words = self._words
+        offset = words[offset_slot]
+        for i in range(words[count_slot]):
+            yield words[offset + i * width:offset + (i + 1) * width]
+
+    def _decode_functions(self) -> Dict[str, FunctionDef]:
+        words, content = self._words, self._content
+        params_off, calls_off = words[H_PARAMS_OFF], words[H_CALLS_OFF]
+        functions: Dict[str, FunctionDef] = {}
+        call_spans: Dict[str, tuple] = {}
+
+        for rec in self._records(H_FUNCS, H_FUNCS_OFF, FUNC_WORDS):
+            (name_s, name_e, ret_s, ret_e, attrs, line, end_line, body_s, body_e,
+             param_first, param_count, call_first, call_count) = rec
+            name = content[name_s:name_e]
+            params = []
+            uses_structs = []
+            base = params_off + param_first * PARAM_WORDS
+            for i in range(param_count):
+                type_s, type_e, pname_s, pname_e, struct_s, struct_e = \
+                    words[base + i * PARAM_WORDS:base + (i + 1) * PARAM_WORDS]
+                params.append(Parameter(name=self._text(pname_s, pname_e),
+                                        type_name=content[type_s:type_e]))
+                if struct_s != NONE:
+                    uses_structs.append(content[struct_s:struct_e])
+            functions[name] = FunctionDef(
+                name=name,
+                return_type=content[ret_s:ret_e],
+                params=params,
+                body=content[body_s:body_e],
+                location=Location(line=line, end_line=end_line),
+                uses_structs=list(set(uses_structs)),
+                attributes=[attr for bit, attr in _ATTR_BITS if attrs & bit]
+            )
+            call_spans[name] = (calls_off + call_first * 2, call_count)
+
+        # 调用关系（集合按出现顺序构造，列表顺序与 regex 后端一致）
+        callers_seen: Dict[str, Set[str]] = {}
+        for func_name, func_def in functions.items():
+            base, count = call_spans[func_name]
+            calls = set(content[words[k]:words[k + 1]] for k in range(base, base + count * 2, 2))
+            func_def.calls = list(calls)
+            for called in calls:
+                if called in functions:
+                    seen = callers_seen.get(called)
+                    if seen is None:
+                        seen = callers_seen[called] = set(functions[called].called_by)
+                    if func_name not in seen:
+                        seen.add(func_name)
+                        functions[called].called_by.append(func_name)
+
+        # 回调: ops 表初始化、module_init / module_exit
+        for type_s, type_e, field_s, field_e, value_s, value_e in \
+                self._records(H_INITS, H_INITS_OFF, INIT_WORDS):
+            value = content[value_s:value_e]
+            if value in functions:
+                functions[value].is_callback = True
+                functions[value].callback_context = \
+                    f"{content[type_s:type_e]}.{content[field_s:field_e]}"
+        for slot, context in ((H_MODINIT_S, "module_init"), (H_MODEXIT_S, "module_exit")):
+            value = self._text(words[slot], words[slot + 1])
+            if value in functions:
+                functions[value].is_callback = True
+                functions[value].callback_context = context
+        return functions
+
+    def _record_name(self, rec) -> str:
+        name = self._text(rec[3], rec[4]) or self._text(rec[5], rec[6])
+        return name or f"anonymous_{rec[1]}"
+
+    def _decode_records(self) -> None:
+        structs: Dict[str, StructDef] = {}
+        unions: Dict[str, UnionDef] = {}
+        for rec in self._records(H_STRUCTS, H_STRUCTS_OFF, STRUCT_WORDS):
+            (kind, start, end, name_s, name_e, alias_s, alias_e, pre_s, pre_e,
+             post_s, post_e, post2_s, post2_e, body_s, body_e, line, end_line) = rec
+            name = self._record_name(rec)
+            typedef_name = self._text(alias_s, alias_e)
+            fields = _MEMBERS._parse_struct_fields(self._content[body_s:body_e], line)
+            attributes = []
+            for start_, end_ in ((pre_s, pre_e), (post_s, post_e), (post2_s, post2_e)):
+                attributes.extend(extract_layout_attributes(self._content[start_:end_])[1])
+            location = Location(line=line, end_line=end_line)
+            if kind == 1:
+                unions[name] = UnionDef(name=name, fields=fields, location=location,
+                                        typedef_name=typedef_name, attributes=attributes)
+            else:
+                referenced = []
+                for f in fields:
+                    m = _STRUCT_REF.search(f.type_name)
+                    if m:
+                        referenced.append(m.group(1))
+                structs[name] = StructDef(name=name, fields=fields, location=location,
+                                          typedef_name=typedef_name,
+                                          referenced_structs=list(set(referenced)),
+                                          attributes=attributes)
+        if self._structs is None:
+            self._structs = structs
+        if self._unions is None:
+            self._unions = unions
+
+    def _decode_typedefs(self) -> Dict[str, TypeDef]:
+        content = self._content
+        typedefs: Dict[str, TypeDef] = {}
+        # typedef struct {...} alias; 先于 typedef 语句登记（与 regex 后端的提取顺序一致）
+        for rec in self._records(H_STRUCTS, H_STRUCTS_OFF, STRUCT_WORDS):
+            alias = self._text(rec[5], rec[6])
+            name = self._record_name(rec)
+            if alias and alias != name:
+                kind = "union" if rec[0] == 1 else "struct"
+                typedefs[alias] = TypeDef(alias=alias, original=f"{kind} {name}")
+        for orig_s, orig_e, alias_s, alias_e, line in \
+                self._records(H_TYPEDEFS, H_TYPEDEFS_OFF, TYPEDEF_WORDS):
+            alias = content[alias_s:alias_e]
+            typedefs[alias] = TypeDef(alias=alias, original=content[orig_s:orig_e],
+                                      location=Location(line=line))
+        return typedefs
+
+
+class NativeBackend(AnalyzerBackend):
+    """
+    原生扫描后端
+
+    与 regex 后端结果相同、吞吐量高一到两个数量级；需要先编译 C++ 扩展。
+    """
+
+    @property
+    def name(self) -> str:
+        return "native"
+
+    @property
+    def version(self) -> str:
+        return "0.1.0"
+
+    def is_available(self) -> bool:
+        return NATIVE_AVAILABLE
+
+    def capabilities(self) -> Set[BackendCapability]:
+        return RegexBackend().capabilities()
+
+    def parse(self, source_code: str, filename: str = "<string>") -> ParseResult:
+        """解析源代码（各部分在访问时解码）"""
+        if not NATIVE_AVAILABLE:
+            return ParseResult(errors=["native 扩展未编译（make native）"])
+        content, buffer = _lda_scan.scan(source_code)
+        return NativeParseResult(content, buffer)
+
+    def parse_declarations(self, source_code: str, filename: str = "<string>") -> ParseResult:
+        """
+        只提取类型声明（与 regex 后端的 parse_declarations 结果相同）
+
+        第一遍扫描只用来去注释，跳过函数体后再扫描一遍；函数表从不解码。
+        """
+        if not NATIVE_AVAILABLE:
+            return ParseResult(errors=["native 扩展未编译（make native）"])
+        content, _ = _lda_scan.scan(source_code)
+        content, buffer = _lda_scan.scan(skip_bodies(content))
+        result = NativeParseResult(content, buffer)
+        result.functions = {}
+        extract_enums(content, LineIndex(content), result)
+        return result
+
+
+# 注册后端（包导入时已按描述符延迟注册；直接导入本模块时登记类，不创建实例）
+BackendRegistry.register(NativeBackend, "native")
@@ -15,11 +15,209 @@ from typing import Dict, List, Set, Optional, Tuple
 
 from .base import (
     AnalyzerBackend, BackendCapability, BackendRegistry,
-    ParseResult, FunctionDef, StructDef, StructField,
-    FunctionCall, TypeDef, Parameter, Location
+    ParseResult, FunctionDef, StructDef, StructField, UnionDef, EnumDef, EnumValue,
+    FunctionCall, TypeDef, Parameter, Location, LineIndex,
+    LAYOUT_ATTR_PATTERN, extract_layout_attributes
 )
 
 
+# 函数参数列表后紧跟函数体的判断（在原串上定位匹配，避免切片拷贝）
+_BODY_START = re.compile(r'\s*\{')
+
+# 零个或多个布局属性（__packed、__aligned(N) 等）
+_ATTRS = r'(?:\s*(?:' + LAYOUT_ATTR_PATTERN.pattern + r'))*'
+
+# 结构体成员声明：类型 + 指针 + 名称 + 数组维度 + 位域
+_MEMBER_DECL = re.compile(
+    r'(?P<type>.*?\w)(?=[\s*])\s*(?P<stars>\**)\s*(?P<name>\w+)\s*'
+    r'(?P<dims>(?:\[[^\]]*\]\s*)*)(?::\s*(?P<bits>\w+))?$'
+)
+# 成员切分只关心括号和分号
+_MEMBER_TOKEN = re.compile(r'[{}();]')
+_NESTED_RECORD = re.compile(r'\s*(?:const\s+|volatile\s+)*(struct|union)\b([^{;]*)\{')
+_FUNC_PTR_MEMBER = re.compile(r'(.+?)\s*\(\s*\*\s*(\w+)\s*\)\s*\((.*)\)$')
+_ANON_BITFIELD = re.compile(r'(.*?\w)\s*:\s*(\w+)$')
+# 逗号后的其它声明符: *b / c[4] / d:3
+_EXTRA_DECL = re.compile(
+    r'(?P<stars>\**)\s*(?P<name>\w+)\s*(?P<dims>(?:\[[^\]]*\]\s*)*)(?::\s*(?P<bits>\w+))?$'
+)
+
+# ---------- 头文件快速路径（parse_declarations） ----------
+
+# 预处理指令（含续行）：宏体里的花括号不参与配对
+_DIRECTIVE = re.compile(r'^[ \t]*#(?:[^\n]*\\\n)*[^\n]*', re.MULTILINE)
+# 花括号和字符串 / 字符字面量（字面量整体作为一个记号，其中的花括号被跳过）
+_BRACE_TOKEN = re.compile(r'"(?:\\.|[^"\\\n])*"|\'(?:\\.|[^\'\\\n])*\'|[{}]')
+# 花括号前的 ") {"：取右括号前的标识符，判断是函数头还是 __attribute__((...)) 之类
+_CALL_HEAD = re.compile(r'(\w+)\s*$')
+_ATTR_CALLS = frozenset({
+    '__attribute__', '__attribute', '__aligned', '__declspec', '__section',
+    '__counted_by', '__alignas', '_Alignas', 'alignas',
+})
+
+# 枚举定义；不要求以分号结尾（enum { ... } x = ...;、参数中的 enum 也算）
+_ENUM_DEF = re.compile(
+    rf'(?P<typedef>\btypedef\s+)?\benum\b(?P<pre>{_ATTRS})\s*(?P<name>\w+)?\s*'
+    rf'\{{(?P<body>[^{{}}]*)\}}(?P<post>{_ATTRS})\s*(?P<alias>\w+)?'
+)
+# 对象式宏 #define NAME value（名字后紧跟 "(" 的是函数式宏，不算）；值可以有续行
+_DEFINE = re.compile(r'^[ \t]*#[ \t]*define[ \t]+([A-Za-z_]\w*)(?![\w(])([^\n]*(?:(?<=\\)\n[^\n]*)*)',
+                     re.MULTILINE)
+# 宏值中的注释（行尾未闭合的块注释也去掉）
+_VALUE_COMMENT = re.compile(r'/\*.*?(?:\*/|$)|//.*', re.DOTALL)
+_ENUMERATOR = re.compile(
+    r'(?P<name>[A-Za-z_]\w*)\s*(?:__attribute__\s*\(\(.*?\)\)\s*)?(?:=\s*(?P<value>.*\S))?\s*$',
+    re.DOTALL
+)
+
+
+def _paren_open(content: str, close: int) -> int:
+    """content[close] == ')' 时向前找匹配的 '('，找不到返回 -1"""
+    depth = 0
+    for i in range(close, -1, -1):
+        c = content[i]
+        if c == ')':
+            depth += 1
+        elif c == '(':
+            depth -= 1
+            if depth == 0:
+                return i
+        elif c in ';{}':
+            return -1
+    return -1
+
+
+def skip_bodies(content: str) -> str:
+    """
+    快进跳过函数体和初始化器（content 须已去掉注释）
+
+    顶层 "{" 之前是 ")"（且不是 __attribute__((...)) 等属性）时视为函数体，是 "=" 时视为初始化器，
+    两者的内容只保留换行（行号不变）；结构体 / 联合体 / 枚举的花括号原样保留。
+    预处理指令行同样只保留换行，宏体里不成对的花括号不会影响配对。
+    只用一个正则遍历花括号和字面量，不逐字符处理函数体。
+    """
+    content = _DIRECTIVE.sub(lambda m: '\n' * m.group(0).count('\n'), content)
+    pieces: List[str] = []
+    last = 0            # 已输出到的位置
+    depth = 0           # 保留区域内的花括号深度
+    skip_depth = 0      # >0 时处于被跳过的区域
+    skip_start = 0
+    for token in _BRACE_TOKEN.finditer(content):
+        c = token.group(0)
+        if skip_depth:
+            if c == '{':
+                skip_depth += 1
+            elif c == '}':
+                skip_depth -= 1
+                if skip_depth == 0:
+                    pieces.append(content[last:skip_start])
+                    pieces.append('\n' * content.count('\n', skip_start, token.start()))
+                    last = token.start()
+            continue
+        if c == '}':
+            depth = max(0, depth - 1)
+            continue
+        if c != '{':
+            continue
+        if depth == 0:
+            head = content[max(0, token.start() - 512):token.start()].rstrip()
+            if head.endswith('extern "C"'):
+                continue    # 链接说明的花括号不计深度，其中的函数体照样跳过
+            skip = head.endswith('=')
+            if head.endswith(')'):
+                open_pos = _paren_open(head, len(head) - 1)
+                word = _CALL_HEAD.search(head, 0, open_pos) if open_pos > 0 else None
+                skip = not (word and word.group(1) in _ATTR_CALLS)
+            if skip:
+                skip_depth = 1
+                skip_start = token.end()
+                continue
+        depth += 1
+    if skip_depth:
+        # 未闭合的函数体：剩余部分全部跳过
+        pieces.append(content[last:skip_start])
+        pieces.append('\n' * content.count('\n', skip_start))
+        return ''.join(pieces)
+    pieces.append(content[last:])
+    return ''.join(pieces)
+
+
+def _split_enumerators(body: str) -> List[Tuple[str, int]]:
+    """按顶层逗号切分枚举体，返回 (文本, 在 body 中的偏移)"""
+    parts, depth, start = [], 0, 0
+    for m in re.finditer(r'[(),]', body):
+        c = m.group(0)
+        if c == '(':
+            depth += 1
+        elif c == ')':
+            depth -= 1
+        elif depth == 0:
+            parts.append((body[start:m.start()], start))
+            start = m.end()
+    parts.append((body[start:], start))
+    return parts
+
+
+def extract_enums(content: str, lines: LineIndex, result: ParseResult) -> None:
+    """
+    提取枚举定义（content 须已去掉注释）
+
+    值保留源码文本（空白规范化），隐式值为 None；枚举体中的预处理指令行被忽略。
+    匿名枚举命名与 tree-sitter 后端一致：anonymous_enum_{行号-1}，typedef 的匿名枚举取别名。
+    """
+    for match in _ENUM_DEF.finditer(content):
+        body = match.group('body')
+        if '#' in body:
+            body = _DIRECTIVE.sub(lambda m: ' ' * len(m.group(0)), body)
+        body_start = match.start('body')
+        values = []
+        for text, offset in _split_enumerators(body):
+            stripped = text.strip()
+            if not stripped:
+                continue
+            item = _ENUMERATOR.match(stripped)
+            if not item:
+                continue
+            value = item.group('value')
+            pos = body_start + offset + (len(text) - len(text.lstrip()))
+            values.append(EnumValue(
+                name=item.group('name'),
+                value=' '.join(value.split()) if value else None,
+                location=Location(line=lines.line_of(pos))
+            ))
+        start_line = lines.line_of(match.start())
+        alias = match.group('alias') if match.group('typedef') else ""
+        name = match.group('name') or alias or f"anonymous_enum_{start_line - 1}"
+        result.enums[name] = EnumDef(
+            name=name,
+            values=values,
+            location=Location(line=start_line, end_line=lines.line_of(match.end('body'))),
+            typedef_name=alias or ""
+        )
+        if alias and alias != name:
+            result.typedefs[alias] = TypeDef(alias=alias, original=f"enum {name}")
+
+
+def extract_defines(source: str) -> Dict[str, str]:
+    """
+    提取对象式宏：名字 -> 替换文本（去掉注释和续行、空白规范化；#define FOO 为空串）
+
+    只做一次正则扫描，不处理条件编译；同名宏以先出现的为准。
+    """
+    macros: Dict[str, str] = {}
+    for match in _DEFINE.finditer(source):
+        name = match.group(1)
+        if name in macros:
+            continue
+        value = match.group(2)
+        if '\\' in value:
+            value = value.replace('\\\n', ' ')
+        if '/' in value:
+            value = _VALUE_COMMENT.sub(' ', value)
+        macros[name] = ' '.join(value.split())
+    return macros
+
+
 class RegexBackend(AnalyzerBackend):
     """
     正则匹配解析后端
@@ -30,6 +228,7 @@ class RegexBackend(AnalyzerBackend):
     def __init__(self):
         self._source_content = ""
         self._source_lines = []
+        self._lines: Optional[LineIndex] = None
     
     @property
     def name(self) -> str:
@@ -46,6 +245,7 @@ class RegexBackend(AnalyzerBackend):
         return {
             BackendCapability.PARSE_FUNCTIONS,
             BackendCapability.PARSE_STRUCTS,
+            BackendCapability.PARSE_UNIONS,
             BackendCapability.PARSE_CALLS,
             BackendCapability.PARSE_TYPEDEFS,
             BackendCapability.BROWSER_COMPATIBLE,
@@ -58,6 +258,7 @@ class RegexBackend(AnalyzerBackend):
         
         # 预处理：移除注释
         content = self._remove_comments(source_code)
+        self._lines = LineIndex(content)
         
         result = ParseResult()
         
@@ -74,6 +275,16 @@ class RegexBackend(AnalyzerBackend):
         
         return result
     
+    def parse_declarations(self, source_code: str, filename: str = "<string>") -> ParseResult:
+        """只提取类型声明：跳过函数体和初始化器，不做函数 / 调用 / 回调分析"""
+        content = skip_bodies(self._remove_comments(source_code))
+        self._lines = LineIndex(content)
+        result = ParseResult()
+        self._extract_structs(content, result)
+        self._extract_typedefs(content, result)
+        extract_enums(content, self._lines, result)
+        return result
+    
     def _remove_comments(self, content: str) -> str:
         """移除C语言注释"""
         # 移除多行注释，保留行数
@@ -88,28 +299,34 @@ class RegexBackend(AnalyzerBackend):
         return content
     
     def _extract_structs(self, content: str, result: ParseResult) -> None:
-        """提取结构体定义"""
-        struct_pattern = r'''
+        """提取结构体和联合体定义"""
+        struct_pattern = rf'''
             (?:typedef\s+)?
-            struct\s+(\w+)?\s*
-            \{
-            ([^{}]*(?:\{[^{}]*\}[^{}]*)*)
-            \}\s*
-            (\w+)?
-            \s*;
+            (?P<kind>struct|union)\b(?P<pre>{_ATTRS})\s*(?P<name>\w+)?\s*
+            \{{
+            (?P<body>[^{{}}]*(?:\{{[^{{}}]*(?:\{{[^{{}}]*\}}[^{{}}]*)*\}}[^{{}}]*)*)
+            \}}
+            (?P<post>{_ATTRS})\s*
+            (?P<alias>\w+)?
+            (?P<post2>{_ATTRS})\s*;
         '''
         
         for match in re.finditer(struct_pattern, content, re.VERBOSE | re.DOTALL):
-            struct_name = match.group(1) or match.group(3) or f"anonymous_{match.start()}"
-            body = match.group(2)
-            typedef_name = match.group(3) or ""
+            struct_name = match.group('name') or match.group('alias') or f"anonymous_{match.start()}"
+            body = match.group('body')
+            typedef_name = match.group('alias') or ""
             
-            start_line = content[:match.start()].count('\n') + 1
-            end_line = content[:match.end()].count('\n') + 1
+            start_line = self._lines.line_of(match.start())
+            end_line = self._lines.line_of(match.end())
             
             # 解析字段
             fields = self._parse_struct_fields(body, start_line)
             
+            # 布局属性（struct __packed foo { ... } / } __aligned(8);）
+            attributes = []
+            for group in ('pre', 'post', 'post2'):
+                attributes.extend(extract_layout_attributes(match.group(group) or "")[1])
+            
             # 分析引用的结构体
             referenced_structs = []
             for field in fields:
@@ -117,78 +334,168 @@ class RegexBackend(AnalyzerBackend):
                 if type_match:
                     referenced_structs.append(type_match.group(1))
             
-            struct_def = StructDef(
-                name=struct_name,
-                fields=fields,
-                location=Location(line=start_line, end_line=end_line),
-                typedef_name=typedef_name,
-                referenced_structs=list(set(referenced_structs))
-            )
-            
-            result.structs[struct_name] = struct_def
+            kind = match.group('kind')
+            if kind == 'union':
+                result.unions[struct_name] = UnionDef(
+                    name=struct_name,
+                    fields=fields,
+                    location=Location(line=start_line, end_line=end_line),
+                    typedef_name=typedef_name,
+                    attributes=attributes
+                )
+            else:
+                result.structs[struct_name] = StructDef(
+                    name=struct_name,
+                    fields=fields,
+                    location=Location(line=start_line, end_line=end_line),
+                    typedef_name=typedef_name,
+                    referenced_structs=list(set(referenced_structs)),
+                    attributes=attributes
+                )
             
             if typedef_name and typedef_name != struct_name:
                 result.typedefs[typedef_name] = TypeDef(
                     alias=typedef_name,
-                    original=f"struct {struct_name}"
+                    original=f"{kind} {struct_name}"
                 )
     
+    def _split_members(self, body: str, base_line: int) -> List[Tuple[str, int]]:
+        """
+        按顶层分号切分成员声明（跳过预处理指令行）
+        
+        Returns:
+            [(声明文本, 声明首个非空字符所在行号), ...]
+        """
+        members = []
+        depth = 0
+        line = base_line
+        current: List[str] = []
+        stmt_line = None
+        for raw in body.split('\n'):
+            if raw.lstrip().startswith('#'):
+                line += 1
+                continue
+            start = 0
+            for token in _MEMBER_TOKEN.finditer(raw):
+                c = token.group(0)
+                if c in '{(':
+                    depth += 1
+                elif c in '})':
+                    depth -= 1
+                elif depth == 0:
+                    piece = raw[start:token.end()]
+                    if stmt_line is None and piece.strip():
+                        stmt_line = line
+                    current.append(piece)
+                    members.append((''.join(current), stmt_line))
+                    current = []
+                    stmt_line = None
+                    start = token.end()
+            rest = raw[start:]
+            if stmt_line is None and rest.strip():
+                stmt_line = line
+            current.append(rest)
+            current.append('\n')
+            line += 1
+        return members
+    
     def _parse_struct_fields(self, body: str, base_line: int) -> List[StructField]:
-        """解析结构体字段"""
+        """解析结构体字段（支持多行声明、逗号分隔声明符、位域、内嵌 struct/union）"""
         fields = []
-        current_line = base_line
+        for decl, line in self._split_members(body, base_line):
+            fields.extend(self._parse_member(decl, line))
+        return fields
+    
+    def _parse_member(self, decl: str, line: int) -> List[StructField]:
+        """解析一条成员声明"""
+        # 内嵌 struct/union 定义: union { ... } name;
+        nested = _NESTED_RECORD.match(decl)
+        if nested:
+            open_pos = nested.end() - 1
+            close_pos = decl.rindex('}')
+            head, attributes = extract_layout_attributes(nested.group(2))
+            tail, tail_attrs = extract_layout_attributes(decl[close_pos + 1:].rstrip().rstrip(';'))
+            attributes += tail_attrs
+            tag = head.strip()
+            inner_line = line + decl[:open_pos].lstrip().count('\n')
+            members = self._parse_struct_fields(decl[open_pos + 1:close_pos], inner_line)
+            tail_match = _EXTRA_DECL.match(tail.strip())
+            return [StructField(
+                name=tail_match.group('name') if tail_match else "",
+                type_name=f"{nested.group(1)} {tag}".strip(),
+                array_size=self._dims(tail_match.group('dims')) if tail_match else "",
+                location=Location(line=line),
+                attributes=attributes,
+                members=members
+            )]
         
-        for line in body.split('\n'):
-            line_stripped = line.strip()
-            if not line_stripped or line_stripped.startswith('//'):
-                current_line += 1
-                continue
-            
-            # 函数指针: 返回类型 (*名称)(参数)
-            func_ptr_match = re.match(
-                r'(.+?)\s*\(\s*\*\s*(\w+)\s*\)\s*\(([^)]*)\)\s*;',
-                line_stripped
-            )
-            if func_ptr_match:
-                fields.append(StructField(
-                    name=func_ptr_match.group(2),
-                    type_name=f"{func_ptr_match.group(1)} (*)({func_ptr_match.group(3)})",
-                    is_pointer=True,
-                    is_function_ptr=True,
-                    func_ptr_signature=f"{func_ptr_match.group(1)}({func_ptr_match.group(3)})",
-                    location=Location(line=current_line)
-                ))
-                current_line += 1
-                continue
-            
-            # 普通字段: 支持 struct xxx *name, int name, char name[32] 等
-            # 匹配: 类型修饰符 + (struct/enum 类型名 | 普通类型) + 指针 + 字段名 + 可选数组
-            field_match = re.match(
-                r'((?:const\s+|volatile\s+|unsigned\s+|signed\s+)*'  # 类型修饰符
-                r'(?:struct\s+\w+|enum\s+\w+|\w+)'  # struct xxx 或 enum xxx 或普通类型
-                r'(?:\s*\*+)?)'  # 可选指针（支持 type* 或 type * 格式）
-                r'\s*(\w+)'  # 字段名（前面可能有空格也可能没有）
-                r'(?:\s*\[([^\]]*)\])?'  # 可选数组
-                r'\s*;',
-                line_stripped
-            )
-            if field_match:
-                type_name = field_match.group(1).strip()
-                field_name = field_match.group(2)
-                array_size = field_match.group(3) or ""
-                
-                fields.append(StructField(
-                    name=field_name,
-                    type_name=type_name,
-                    is_pointer='*' in type_name,
-                    array_size=array_size,
-                    location=Location(line=current_line)
-                ))
-            
-            current_line += 1
+        text, attributes = extract_layout_attributes(decl.strip().rstrip(';'))
+        text = ' '.join(text.split())
+        if not text:
+            return []
+        
+        # 函数指针: 返回类型 (*名称)(参数)
+        func_ptr_match = _FUNC_PTR_MEMBER.match(text)
+        if func_ptr_match:
+            return [StructField(
+                name=func_ptr_match.group(2),
+                type_name=f"{func_ptr_match.group(1)} (*)({func_ptr_match.group(3)})",
+                is_pointer=True,
+                is_function_ptr=True,
+                func_ptr_signature=f"{func_ptr_match.group(1)}({func_ptr_match.group(3)})",
+                location=Location(line=line),
+                attributes=attributes
+            )]
         
+        # 宏调用（DECLARE_BITMAP(...) 等）和初始化表达式无法按声明解析
+        if '(' in text or '=' in text:
+            return []
+        
+        declarators = text.split(',')
+        first = _MEMBER_DECL.match(declarators[0].strip())
+        if not first:
+            # 匿名位域: u32 :4;
+            anon = _ANON_BITFIELD.match(declarators[0].strip())
+            if anon:
+                return [StructField(name="", type_name=anon.group(1),
+                                    bit_width=self._bit_width(anon.group(2)),
+                                    location=Location(line=line), attributes=attributes)]
+            return []
+        base_type = first.group('type').strip()
+        
+        fields = []
+        matches = [first] + [_EXTRA_DECL.match(d.strip()) for d in declarators[1:]]
+        for m in matches:
+            if not m:
+                continue
+            stars = m.group('stars')
+            type_name = f"{base_type} {stars}" if stars else base_type
+            fields.append(StructField(
+                name=m.group('name'),
+                type_name=type_name,
+                is_pointer='*' in type_name,
+                array_size=self._dims(m.group('dims')),
+                location=Location(line=line),
+                bit_width=self._bit_width(m.group('bits')),
+                attributes=list(attributes)
+            ))
         return fields
     
+    @staticmethod
+    def _dims(dims: str) -> str:
+        """数组维度 "[4] [8]" -> "4][8"（单维时就是方括号内的表达式，柔性数组 [] 记为 "0"）"""
+        parts = re.findall(r'\[([^\]]*)\]', dims or "")
+        return ']['.join(p.strip() or "0" for p in parts)
+    
+    @staticmethod
+    def _bit_width(text: Optional[str]) -> Optional[int]:
+        if not text:
+            return None
+        try:
+            return int(text, 0)
+        except ValueError:
+            return None
+    
     def _extract_typedefs(self, content: str, result: ParseResult) -> None:
         """提取typedef定义"""
         typedef_pattern = r'typedef\s+(.+?)\s+(\w+)\s*;'
@@ -204,7 +511,7 @@ class RegexBackend(AnalyzerBackend):
             result.typedefs[alias] = TypeDef(
                 alias=alias,
                 original=original,
-                location=Location(line=content[:match.start()].count('\n') + 1)
+                location=Location(line=self._lines.line_of(match.start()))
             )
     
     def _extract_functions(self, content: str, result: ParseResult) -> None:
@@ -237,20 +544,20 @@ class RegexBackend(AnalyzerBackend):
             params_str = content[paren_start + 1:paren_end].strip()
             
             # 检查参数后面是否是函数体 {
-            after_paren = content[paren_end + 1:].lstrip()
-            if not after_paren.startswith('{'):
+            brace = _BODY_START.match(content, paren_end + 1)
+            if not brace:
                 continue
             
             # 解析参数
             params = self._parse_params(params_str)
             
             # 找到函数体结束位置
-            body_start = content.index('{', paren_end)
+            body_start = brace.end() - 1
             end_pos = self._find_matching_brace(content, body_start)
             body = content[body_start:end_pos + 1] if end_pos > body_start else ""
             
-            start_line = content[:match.start()].count('\n') + 1
-            end_line = content[:end_pos].count('\n') + 1 if end_pos > 0 else start_line
+            start_line = self._lines.line_of(match.start())
+            end_line = self._lines.line_of(end_pos) if end_pos > 0 else start_line
             
             # 解析属性
             attributes = []
@@ -356,6 +663,8 @@ class RegexBackend(AnalyzerBackend):
     def _analyze_calls(self, result: ParseResult) -> None:
         """分析函数调用"""
         call_pattern = r'\b(\w+)\s*\('
+        # called_by 去重用的集合（列表 in 判断在被大量调用的函数上是二次复杂度）
+        callers_seen: Dict[str, Set[str]] = {}
         
         for func_name, func_def in result.functions.items():
             body = func_def.body
@@ -373,7 +682,11 @@ class RegexBackend(AnalyzerBackend):
             # 更新 called_by
             for called in calls:
                 if called in result.functions:
-                    if func_name not in result.functions[called].called_by:
+                    seen = callers_seen.get(called)
+                    if seen is None:
+                        seen = callers_seen[called] = set(result.functions[called].called_by)
+                    if func_name not in seen:
+                        seen.add(func_name)
                         result.functions[called].called_by.append(func_name)
     
     def _identify_callbacks(self, content: str, result: ParseResult) -> None:
@@ -414,6 +727,5 @@ class RegexBackend(AnalyzerBackend):
             result.functions[exit_match.group(1)].callback_context = "module_exit"
 
 
-# 注册后端
-BackendRegistry.register(RegexBackend)
-
+# 注册后端（包导入时已按描述符延迟注册；直接导入本模块时登记类，不创建实例）
+BackendRegistry.register(RegexBackend, "regex")
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""
+按文件选择解析后端（auto 策略）
+
+get_backend() 按固定优先级为整次运行挑一个后端；auto 策略对每个文件估算各后端的解析耗时，
+在能提供所需能力的后端中选耗时最小的：
+- 只需要函数 / 调用 / 结构体（调用图、大多数专项分析）→ native（未编译时 regex）
+- 需要枚举、函数声明、精确位置 → tree-sitter；需要宏展开、类型推导、跨文件 → clang
+- 宏密度高的文件上 tree-sitter 的错误恢复更多、clang 的展开结果更大，估算耗时相应放大
+
+估算: startup_ms（本进程第一次使用时）+ 大小KB × ms_per_kb × (1 + macro_factor × 宏密度)。
+默认代价是 1MB 合成驱动上的实测量级，可用 bench_backends.py 的结果替换（load_costs）。
+"""
+
+import json
+from dataclasses import dataclass, replace
+from typing import Dict, Iterable, List, Optional, Set, Tuple
+
+from .base import AnalyzerBackend, BackendCapability, BackendRegistry
+
+
+@dataclass(frozen=True)
+class BackendCost:
+    """后端解析代价模型"""
+    startup_ms: float           # 第一次使用的固定开销（导入、创建解析器 / 索引、首个 TU 的头文件）
+    ms_per_kb: float            # 每 KB 源码的解析耗时（含结果解码）
+    macro_factor: float = 0.0   # 宏密度每增加 1.0 耗时增加的倍数
+
+
+DEFAULT_COSTS: Dict[str, BackendCost] = {
+    'native': BackendCost(startup_ms=1.0, ms_per_kb=0.17),
+    'regex': BackendCost(startup_ms=1.0, ms_per_kb=0.75),
+    'tree-sitter': BackendCost(startup_ms=40.0, ms_per_kb=1.2, macro_factor=2.0),
+    'clang': BackendCost(startup_ms=250.0, ms_per_kb=3.0, macro_factor=1.0),
+}
+
+# UnifiedAnalyzer 的基本输出（functions / structs / call_tree）需要的能力
+BASE_CAPABILITIES = frozenset({
+    BackendCapability.PARSE_FUNCTIONS,
+    BackendCapability.PARSE_CALLS,
+    BackendCapability.PARSE_STRUCTS,
+})
+
+
+def parse_capabilities(names: Iterable[str]) -> Set[BackendCapability]:
+    """
+    解析能力名称（命令行 --need）
+
+    不区分大小写，'-' 等同 '_'，可省略 PARSE_ 前缀：enums、precise-location、macro_expansion。
+
+    Raises:
+        ValueError: 未知的能力名称
+    """
+    caps = set()
+    for name in names:
+        key = name.strip().upper().replace('-', '_')
+        if not key:
+            continue
+        cap = BackendCapability.__members__.get(key) or BackendCapability.__members__.get(f'PARSE_{key}')
+        if cap is None:
+            known = ', '.join(c.name.lower().replace('parse_', '').replace('_', '-')
+                              for c in BackendCapability)
+            raise ValueError(f"未知的后端能力: '{name}'。可用: {known}")
+        caps.add(cap)
+    return caps
+
+
+def macro_density(source: str) -> float:
+    """预处理行（含续行）占总行数的比例"""
+    lines = source.count('\n') + 1
+    directives = source.count('\n#') + source.startswith('#')
+    return min(1.0, (directives + source.count('\\\n')) / lines)
+
+
+def load_costs(path: str) -> Dict[str, BackendCost]:
+    """
+    用 bench_backends.py 的结果 JSON 更新 ms_per_kb（各数据集吞吐的平均）
+
+    startup_ms / macro_factor 沿用默认值；结果中没有的后端保持默认。
+    """
+    with open(path, 'r', encoding='utf-8') as f:
+        report = json.load(f)
+    throughput: Dict[str, List[float]] = {}
+    for r in report.get('results', []):
+        if 'error' not in r and r.get('mb_per_s'):
+            throughput.setdefault(r['backend'], []).append(r['mb_per_s'])
+    costs = dict(DEFAULT_COSTS)
+    for name, values in throughput.items():
+        mb_per_s = sum(values) / len(values)
+        base = costs.get(name, BackendCost(startup_ms=0.0, ms_per_kb=0.0))
+        costs[name] = replace(base, ms_per_kb=round(1000.0 / (mb_per_s * 1024), 4))
+    return costs
+
+
+class BackendSelector:
+    """
+    auto 策略：逐文件选择后端
+
+    一个进程（worker）一个实例；可用后端只探测一次，已使用过的后端不再计启动开销。
+    """
+
+    def __init__(self, required: Iterable[BackendCapability] = BASE_CAPABILITIES,
+                 costs: Optional[Dict[str, BackendCost]] = None):
+        self.required = frozenset(required)
+        self.costs = costs or DEFAULT_COSTS
+        self._available: Optional[List[str]] = None
+        self._warm: Set[str] = set()
+
+    def _candidates(self) -> Tuple[List[str], bool]:
+        """满足所需能力的可用后端；没有时退回覆盖能力最多的后端（第二项为 False）"""
+        if self._available is None:
+            self._available = [name for name in self.costs if BackendRegistry.is_available(name)]
+        if not self._available:
+            return ['regex'], False
+        overlap = {name: len(self.required & BackendRegistry.get(name).capabilities())
+                   for name in self._available}
+        best = max(overlap.values())
+        return [name for name in self._available if overlap[name] == best], \
+            best == len(self.required)
+
+    def estimate_ms(self, name: str, size_kb: float, density: float) -> float:
+        cost = self.costs[name]
+        startup = 0.0 if name in self._warm else cost.startup_ms
+        return startup + size_kb * cost.ms_per_kb * (1.0 + cost.macro_factor * density)
+
+    def select(self, source: str) -> Tuple[AnalyzerBackend, Dict]:
+        """
+        为一个文件选择后端
+
+        Returns:
+            (后端实例, 决策记录)，决策记录写入分析结果的 stats.backend_selection
+        """
+        size_kb = len(source) / 1024
+        density = macro_density(source)
+        candidates, covered = self._candidates()
+        estimates = {name: self.estimate_ms(name, size_kb, density) for name in candidates}
+        choice = min(candidates, key=estimates.get)
+        self._warm.add(choice)
+
+        decision = {
+            "policy": "auto",
+            "backend": choice,
+            "size_kb": round(size_kb, 1),
+            "macro_density": round(density, 3),
+            "required": sorted(cap.name for cap in self.required),
+            "estimates_ms": {name: round(ms, 2) for name, ms in estimates.items()},
+        }
+        if not covered:
+            backend = BackendRegistry.get(choice)
+            decision["missing"] = sorted(cap.name for cap in self.required - backend.capabilities())
+        return BackendRegistry.get(choice), decision
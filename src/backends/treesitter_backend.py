@@ -12,6 +12,7 @@ Tree-sitter 解析后端
     pip install tree-sitter tree-sitter-c
 """
 
+import importlib.util
 import re
 from typing import Dict, List, Set, Optional, Tuple, Any
 
@@ -19,18 +20,13 @@ from .base import (
     AnalyzerBackend, BackendCapability, BackendRegistry,
     ParseResult, FunctionDef, StructDef, StructField,
     FunctionCall, TypeDef, Parameter, Location,
-    EnumDef, EnumValue, UnionDef
+    EnumDef, EnumValue, UnionDef, extract_layout_attributes
 )
 
 
-# Tree-sitter 可选导入
-try:
-    import tree_sitter_c as tsc
-    from tree_sitter import Language, Parser, Node
-    TREE_SITTER_AVAILABLE = True
-except ImportError:
-    TREE_SITTER_AVAILABLE = False
-    Node = None
+# Tree-sitter 可选依赖：这里只探测是否安装，第一次解析时才导入（见 _get_parser）
+TREE_SITTER_AVAILABLE = all(importlib.util.find_spec(m) is not None
+                            for m in ('tree_sitter', 'tree_sitter_c'))
 
 
 class TreeSitterBackend(AnalyzerBackend):
@@ -75,6 +71,8 @@ class TreeSitterBackend(AnalyzerBackend):
         if self._parser is None:
             if not TREE_SITTER_AVAILABLE:
                 raise RuntimeError("tree-sitter 未安装，请运行: pip install tree-sitter tree-sitter-c")
+            import tree_sitter_c as tsc
+            from tree_sitter import Language, Parser
             self._parser = Parser(Language(tsc.language()))
         return self._parser
     
@@ -111,7 +109,18 @@ class TreeSitterBackend(AnalyzerBackend):
         self._build_call_relations(result)
         
         return result
-    
+
+    def parse_tree(self, source_code: str) -> Optional['Node']:
+        """
+        解析并返回语法树根节点（供需要语句结构的分析使用）
+
+        Returns:
+            根节点；tree-sitter 未安装时返回 None
+        """
+        if not TREE_SITTER_AVAILABLE:
+            return None
+        return self._get_parser().parse(source_code.encode('utf-8')).root_node
+
     def _extract_from_tree(self, node: 'Node', result: ParseResult) -> None:
         """递归遍历语法树提取信息"""
         
@@ -382,18 +391,78 @@ class TreeSitterBackend(AnalyzerBackend):
             name=struct_name,
             fields=fields,
             location=self._get_location(node),
-            referenced_structs=list(referenced_structs)
+            referenced_structs=list(referenced_structs),
+            attributes=self._layout_attributes_of(node)
         )
     
+    def _layout_attributes_of(self, node: 'Node') -> List[str]:
+        """
+        struct/union 的布局属性
+        
+        __packed 等是宏，语法树里可能是 ERROR 节点或被当成声明符，
+        因此直接取名字到 '{' 之间、以及 '}' 到所在声明结束之间的文本提取。
+        """
+        body = node.child_by_field_name('body')
+        if not body:
+            return []
+        text = self._source_bytes[node.start_byte:body.start_byte].decode('utf-8')
+        parent = node.parent
+        if parent is not None and parent.type in ('declaration', 'type_definition'):
+            text += ' ' + self._source_bytes[node.end_byte:parent.end_byte].decode('utf-8')
+        return extract_layout_attributes(text)[1]
+    
     def _extract_field(self, node: 'Node') -> Optional[StructField]:
         """提取结构体字段"""
         type_node = node.child_by_field_name('type')
         type_name = self._get_node_text(type_node) if type_node else ""
         
+        full_text = self._get_node_text(node)
+        cleaned_text, attributes = extract_layout_attributes(full_text)
+        
+        # 位域: u32 x : 4;
+        bit_width = None
+        for child in node.children:
+            if child.type == 'bitfield_clause':
+                width = self._get_node_text(child).lstrip(':').strip()
+                bit_width = int(width, 0) if re.fullmatch(r'0[xX][0-9a-fA-F]+|\d+', width) else None
+        
+        # 内嵌 struct/union 定义: union { ... } u;
+        members = []
+        if type_node is not None and type_node.type in ('struct_specifier', 'union_specifier'):
+            nested_body = type_node.child_by_field_name('body')
+            if nested_body:
+                members = [f for f in (self._extract_field(c) for c in nested_body.children
+                                       if c.type == 'field_declaration') if f]
+                tag_node = type_node.child_by_field_name('name')
+                kind = 'struct' if type_node.type == 'struct_specifier' else 'union'
+                type_name = f"{kind} {self._get_node_text(tag_node)}" if tag_node else kind
+        
         decl_node = node.child_by_field_name('declarator')
         if not decl_node:
+            if members or bit_width is not None:
+                # 匿名内嵌 struct/union 或匿名位域
+                return StructField(name="", type_name=type_name, bit_width=bit_width,
+                                   location=self._get_location(node),
+                                   attributes=attributes, members=members)
             return None
         
+        if attributes and extract_layout_attributes(self._get_node_text(decl_node))[1]:
+            # ____cacheline_aligned 等宏被解析成了声明符，按去掉属性后的文本重新拆分
+            match = re.match(r'\s*(.*?\w)\s*(\**)\s*(\w+)\s*(?:\[([^\]]*)\])?\s*;?\s*$',
+                             cleaned_text, re.DOTALL)
+            if not match:
+                return None
+            stars = match.group(2)
+            return StructField(
+                name=match.group(3),
+                type_name=f"{match.group(1)} {stars}" if stars else match.group(1),
+                is_pointer=bool(stars),
+                array_size=match.group(4) or "",
+                location=self._get_location(node),
+                bit_width=bit_width,
+                attributes=attributes
+            )
+        
         field_name = ""
         is_pointer = False
         is_function_ptr = False
@@ -418,8 +487,8 @@ class TreeSitterBackend(AnalyzerBackend):
                 else:
                     field_name = self._extract_declarator_name(inner)
             size_node = decl_node.child_by_field_name('size')
-            if size_node:
-                array_size = self._get_node_text(size_node)
+            # 柔性数组成员 [] 与 regex 后端一致记为 "0"
+            array_size = self._get_node_text(size_node) if size_node else "0"
         
         elif decl_node.type == 'function_declarator':
             # 函数指针字段
@@ -452,7 +521,10 @@ class TreeSitterBackend(AnalyzerBackend):
             is_function_ptr=is_function_ptr,
             func_ptr_signature=func_ptr_signature,
             array_size=array_size,
-            location=self._get_location(node)
+            location=self._get_location(node),
+            bit_width=bit_width,
+            attributes=attributes,
+            members=members
         )
     
     def _extract_typedef(self, node: 'Node') -> Optional[TypeDef]:
@@ -571,7 +643,8 @@ class TreeSitterBackend(AnalyzerBackend):
         return UnionDef(
             name=union_name,
             fields=fields,
-            location=self._get_location(node)
+            location=self._get_location(node),
+            attributes=self._layout_attributes_of(node)
         )
     
     def _check_function_declaration(self, node: 'Node', result: ParseResult) -> None:
@@ -687,15 +760,18 @@ class TreeSitterBackend(AnalyzerBackend):
     
     def _build_call_relations(self, result: ParseResult) -> None:
         """构建函数调用关系"""
-        # 更新 called_by 信息
+        # 更新 called_by 信息（集合去重，避免被大量调用的函数上出现二次复杂度）
+        callers_seen: Dict[str, Set[str]] = {}
         for func_name, func_def in result.functions.items():
             for called in func_def.calls:
                 if called in result.functions:
-                    if func_name not in result.functions[called].called_by:
+                    seen = callers_seen.get(called)
+                    if seen is None:
+                        seen = callers_seen[called] = set(result.functions[called].called_by)
+                    if func_name not in seen:
+                        seen.add(func_name)
                         result.functions[called].called_by.append(func_name)
 
 
-# 注册后端
-if TREE_SITTER_AVAILABLE:
-    BackendRegistry.register(TreeSitterBackend)
-
+# 注册后端（包导入时已按描述符延迟注册；直接导入本模块时登记类，不创建实例）
+BackendRegistry.register(TreeSitterBackend, "tree-sitter")
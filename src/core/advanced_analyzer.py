@@ -18,10 +18,19 @@ import re
 import json
 import argparse
 import os
+import sys
 from dataclasses import dataclass, field, asdict
 from typing import Dict, List, Set, Optional, Tuple, Any
 from pathlib import Path
 from collections import defaultdict
+from bisect import bisect_left
+
+# 添加 src 目录到路径
+src_dir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+if src_dir not in sys.path:
+    sys.path.insert(0, src_dir)
+
+from backends.regex_backend import extract_defines
 
 
 # ==================== 数据结构定义 ====================
@@ -97,7 +106,7 @@ class AdvancedCAnalyzer:
         self.structs: Dict[str, StructDef] = {}
         self.functions: Dict[str, FunctionDef] = {}
         self.typedefs: Dict[str, str] = {}  # typedef别名 -> 原始类型
-        self.macros: Dict[str, str] = {}
+        self.macros: Dict[str, str] = {}  # 对象式宏名 -> 替换文本
         self.global_vars: Dict[str, str] = {}  # 变量名 -> 类型
         
         # 引用关系
@@ -110,6 +119,8 @@ class AdvancedCAnalyzer:
         self.source_lines: List[str] = []
         self.source_content: str = ""
         self.current_file: str = ""
+        self._newlines: List[int] = []
+        self._decl_index: Optional[Dict[str, Dict[str, Tuple[int, str]]]] = None
         
         # 知识库
         self.knowledge_base = {}
@@ -134,6 +145,11 @@ class AdvancedCAnalyzer:
         
         # 预处理
         content = self._preprocess(self.source_content)
+        self._newlines = [m.start() for m in re.finditer('\n', content)]
+        self._decl_index = None
+        
+        # 对象式宏（寄存器偏移、位掩码等常量）
+        self.macros = extract_defines(content)
         
         # 第一遍：提取结构体定义
         self._extract_structs(content)
@@ -159,6 +175,10 @@ class AdvancedCAnalyzer:
         # 构建输出
         return self._build_output()
     
+    def _line_of(self, pos: int) -> int:
+        """预处理后内容中偏移量对应的行号（从1开始）"""
+        return bisect_left(self._newlines, pos) + 1
+    
     def _preprocess(self, content: str) -> str:
         """预处理：移除注释，保留行号信息"""
         # 移除多行注释
@@ -185,8 +205,8 @@ class AdvancedCAnalyzer:
             body = match.group(2)
             typedef_name = match.group(3) or ""
             
-            start_line = content[:match.start()].count('\n') + 1
-            end_line = content[:match.end()].count('\n') + 1
+            start_line = self._line_of(match.start())
+            end_line = self._line_of(match.end())
             
             struct_def = StructDef(
                 name=struct_name,
@@ -311,8 +331,8 @@ class AdvancedCAnalyzer:
             start_pos = match.end() - 1
             end_pos = self._find_matching_brace(content, start_pos)
             
-            start_line = content[:match.start()].count('\n') + 1
-            end_line = content[:end_pos].count('\n') + 1 if end_pos > 0 else start_line
+            start_line = self._line_of(match.start())
+            end_line = self._line_of(end_pos) if end_pos > 0 else start_line
             
             # 提取属性
             attributes = []
@@ -421,9 +441,9 @@ class AdvancedCAnalyzer:
                 self.reverse_call_graph[called].add(func_name)
         
         # 更新called_by
+        known = set(self.functions.keys())
         for func_name, func_def in self.functions.items():
-            func_def.called_by = list(self.reverse_call_graph.get(func_name, set()) & 
-                                       set(self.functions.keys()))
+            func_def.called_by = list(self.reverse_call_graph.get(func_name, set()) & known)
     
     def _extract_func_ptr_assignments(self, content: str):
         """提取函数指针赋值（结构体初始化）"""
@@ -441,7 +461,7 @@ class AdvancedCAnalyzer:
             struct_type = match.group(1)
             var_name = match.group(2)
             init_content = match.group(3)
-            line = content[:match.start()].count('\n') + 1
+            line = self._line_of(match.start())
             
             # 解析字段赋值
             field_pattern = r'\.(\w+)\s*=\s*(\w+)'
@@ -472,7 +492,7 @@ class AdvancedCAnalyzer:
             value = match.group(3)
             
             if value in self.functions and field_name not in ['next', 'prev', 'parent', 'child']:
-                line = content[:match.start()].count('\n') + 1
+                line = self._line_of(match.start())
                 # 尝试推断结构体类型
                 struct_type = self._infer_var_type(var_name, content, match.start())
                 
@@ -485,22 +505,34 @@ class AdvancedCAnalyzer:
                 )
                 self.func_ptr_assignments.append(assignment)
     
+    def _build_decl_index(self, content: str) -> Dict[str, Dict[str, Tuple[int, str]]]:
+        """
+        变量声明索引：变量名 -> 首次声明（结束偏移, 类型名）
+        
+        一遍扫描建好，供 _infer_var_type 查询，避免每次赋值都重新搜索全文。
+        """
+        index = {'struct': {}, 'typedef': {}}
+        for key, pattern in (('struct', r'struct\s+(\w+)\s+\*?\s*(\w+)\b'),
+                             ('typedef', r'(\w+_t)\s+\*?\s*(\w+)\b')):
+            decls = index[key]
+            for match in re.finditer(pattern, content):
+                decls.setdefault(match.group(2), (match.end(), match.group(1)))
+        return index
+    
     def _infer_var_type(self, var_name: str, content: str, before_pos: int) -> Optional[str]:
-        """推断变量类型"""
-        # 在before_pos之前搜索变量声明
-        search_content = content[:before_pos]
+        """推断变量类型（只认 before_pos 之前的声明）"""
+        if self._decl_index is None:
+            self._decl_index = self._build_decl_index(content)
         
         # 模式1: struct xxx *var 或 struct xxx var
-        pattern1 = rf'struct\s+(\w+)\s+\*?\s*{var_name}\b'
-        match = re.search(pattern1, search_content)
-        if match:
-            return match.group(1)
+        decl = self._decl_index['struct'].get(var_name)
+        if decl and decl[0] <= before_pos:
+            return decl[1]
         
         # 模式2: xxx_t *var (typedef)
-        pattern2 = rf'(\w+_t)\s+\*?\s*{var_name}\b'
-        match = re.search(pattern2, search_content)
-        if match:
-            typedef_name = match.group(1)
+        decl = self._decl_index['typedef'].get(var_name)
+        if decl and decl[0] <= before_pos:
+            typedef_name = decl[1]
             if typedef_name in self.typedefs:
                 original = self.typedefs[typedef_name]
                 struct_match = re.search(r'struct\s+(\w+)', original)
@@ -620,6 +652,7 @@ class AdvancedCAnalyzer:
             "call_graph": {
                 name: list(calls) for name, calls in self.call_graph.items()
             },
+            "macros": self.macros,
             "summary": self._generate_summary()
         }
     
@@ -644,6 +677,7 @@ class AdvancedCAnalyzer:
             "total_structs": len(self.structs),
             "total_functions": len(self.functions),
             "total_callbacks": len(callbacks),
+            "total_macros": len(self.macros),
             "callback_groups": dict(callback_groups),
             "func_ptr_assignments": len(self.func_ptr_assignments),
             "struct_with_relations": len([r for r in self.struct_relations.values() if r]),
@@ -10,6 +10,9 @@
 
 使用方法:
     python src/core/analyzer.py driver.c -o result.json
+    python src/core/analyzer.py drivers/net/*.c -j 8 --trace trace.json
+    python src/core/analyzer.py drivers/net/*.c --mem-profile mem.json
+    python src/core/analyzer.py driver.c -a layout --arch arm64
 """
 
 import re
@@ -17,6 +20,9 @@ import json
 import argparse
 import os
 import sys
+import time
+from collections import deque
+from contextlib import ExitStack, contextmanager, nullcontext
 from dataclasses import dataclass, field, asdict
 from typing import Dict, List, Set, Optional, Any
 from pathlib import Path
@@ -26,7 +32,19 @@ src_dir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
 if src_dir not in sys.path:
     sys.path.insert(0, src_dir)
 
-from backends import get_backend, list_backends, ParseResult
+from backends import get_backend, list_backends, ParseResult, LineIndex
+from core.tracing import TraceRecorder, now_us
+from core.memprof import MemoryProfiler
+
+# 专项分析（src/analysis，导入约 0.1~0.3s）、进程池和编译数据库在用到时才导入，
+# --list-backends 和不带 -a 的小文件分析不付出这部分启动开销（见 benchmarks/bench_startup.py）
+
+
+# 调用参数（允许两层括号嵌套），用于按位置匹配回调参数
+_ARG = r'(?:[^,()]|\((?:[^()]|\([^()]*\))*\))*'
+
+# 调用树最大展开深度，更深的函数标记为截断（node_type="truncated"）
+MAX_CALL_DEPTH = 10
 
 
 @dataclass
@@ -115,6 +133,24 @@ class UnifiedAnalyzer:
             'icon': '⏱️',
             'desc': '高精度定时器'
         },
+        'urb': {
+            # usb_fill_bulk_urb / usb_fill_int_urb 的第 6 个参数、usb_fill_control_urb 的第 7 个参数
+            'init': [r'usb_fill_(?:bulk|int)_urb\s*\((?:' + _ARG + r',){5}\s*(\w+)\s*,',
+                     r'usb_fill_control_urb\s*\((?:' + _ARG + r',){6}\s*(\w+)\s*,',
+                     r'urb->complete\s*=\s*(\w+)'],
+            'trigger': 'usb_submit_urb 提交的传输完成时',
+            'context': '中断上下文（URB 完成回调），不可睡眠',
+            'icon': '🔁',
+            'desc': 'URB 完成回调'
+        },
+        'napi': {
+            # netif_napi_add(dev, &napi, poll) / netif_napi_add_weight(dev, &napi, poll, weight)
+            'init': [r'netif_napi_add\w*\s*\((?:' + _ARG + r',){2}\s*(\w+)\s*[,)]'],
+            'trigger': 'napi_schedule',
+            'context': '软中断上下文（NET_RX），不可睡眠',
+            'icon': '📥',
+            'desc': 'NAPI poll'
+        },
         'kthread': {
             'init': [r'kthread_run\s*\(\s*(\w+)\s*,',
                      r'kthread_create\s*\(\s*(\w+)\s*,'],
@@ -125,9 +161,27 @@ class UnifiedAnalyzer:
         },
     }
     
-    def __init__(self, backend_name: str = None, knowledge_base_path: str = None):
-        # 选择后端
-        self.backend = get_backend(backend_name)
+    def __init__(self, backend_name: str = None, knowledge_base_path: str = None,
+                 analyses: Optional[List[str]] = None, options: Optional[Dict[str, Any]] = None,
+                 needs: Optional[Set[Any]] = None, costs: Optional[Dict[str, Any]] = None):
+        # 专项分析（见 src/analysis），名称在构造时校验
+        self.analyses = []
+        required = set(needs or ())
+        if analyses:
+            from analysis import AnalysisRegistry, required_capabilities
+            self.analyses = AnalysisRegistry.resolve(analyses)
+            required |= required_capabilities(self.analyses)
+        self.analysis_options = options or {}
+        
+        # 选择后端：'auto' 逐文件按代价模型选择（needs 为输出额外需要的能力，
+        # costs 为替换默认代价的 BackendCost 表），否则整次运行使用同一个后端
+        self.selector = None
+        if backend_name == 'auto':
+            from backends.selector import BASE_CAPABILITIES, BackendSelector
+            self.selector = BackendSelector(BASE_CAPABILITIES | required, costs)
+            self.backend = None
+        else:
+            self.backend = get_backend(backend_name)
         
         # 加载知识库
         self.knowledge_base = {}
@@ -138,44 +192,118 @@ class UnifiedAnalyzer:
         self.async_handlers: List[AsyncHandler] = []
         self.struct_ops: List[Dict] = []
         self.source_content = ""
+        
+        # 阶段钩子：挂载的 profiler 需提供 stage(name, **args) 上下文管理器，
+        # 可选提供 observe(kind, obj, file=...) 以查看中间结果
+        self.profilers: List[Any] = []
+        self._stage_times: Dict[str, float] = {}
+        self._current_file = ""
+    
+    def _reset(self) -> None:
+        """重置单文件状态（同一实例可连续分析多个文件）"""
+        self.async_handlers = []
+        self.struct_ops = []
+        self.source_content = ""
+        self._stage_times = {}
+    
+    @contextmanager
+    def _stage(self, name: str):
+        """流水线阶段：记录耗时，并通知已挂载的 profiler"""
+        with ExitStack() as stack:
+            for profiler in self.profilers:
+                stack.enter_context(profiler.stage(name, file=self._current_file))
+            start = time.perf_counter()
+            try:
+                yield
+            finally:
+                self._stage_times[name] = round((time.perf_counter() - start) * 1000, 3)
+    
+    def _observe(self, kind: str, obj: Any) -> None:
+        """把中间结果交给支持 observe 的 profiler（阶段计时之外调用）"""
+        for profiler in self.profilers:
+            observe = getattr(profiler, 'observe', None)
+            if observe:
+                observe(kind, obj, file=self._current_file)
     
     def analyze_file(self, filepath: str) -> Dict:
         """分析文件"""
-        with open(filepath, 'r', encoding='utf-8', errors='ignore') as f:
-            self.source_content = f.read()
+        self._reset()
+        self._current_file = filepath
+        
+        with self._stage("read"):
+            with open(filepath, 'r', encoding='utf-8', errors='ignore') as f:
+                self.source_content = f.read()
+        self._observe("source", self.source_content)
+        
+        # auto 策略：按文件大小、宏密度和所需能力选择后端
+        selection = None
+        if self.selector:
+            with self._stage("select_backend"):
+                self.backend, selection = self.selector.select(self.source_content)
         
         # 使用后端解析
-        parse_result = self.backend.parse_file(filepath)
+        with self._stage("parse"):
+            parse_result = self.backend.parse(self.source_content, filepath)
+        self._observe("parse_result", parse_result)
         
         # 异步机制识别
-        self._extract_async_handlers(self.source_content)
+        with self._stage("async_handlers"):
+            self._extract_async_handlers(self.source_content)
         
         # 提取 struct ops 映射
-        self._extract_struct_ops(self.source_content, parse_result)
+        with self._stage("struct_ops"):
+            self._extract_struct_ops(self.source_content, parse_result)
         
-        # 应用知识库
-        self._apply_knowledge_base(parse_result)
-        
-        # 标记异步回调
-        self._mark_async_callbacks(parse_result)
+        # 应用知识库、标记异步回调
+        with self._stage("knowledge_base"):
+            self._apply_knowledge_base(parse_result)
+            self._mark_async_callbacks(parse_result)
         
         # 构建调用树
-        call_tree = self._build_call_tree(parse_result)
+        with self._stage("call_tree"):
+            call_tree = self._build_call_tree(parse_result)
+        self._observe("call_tree", call_tree)
         
-        return {
-            "file": filepath,
-            "backend": self.backend.name,
-            "backend_version": self.backend.version,
-            "functions": {k: v.to_dict() for k, v in parse_result.functions.items()},
-            "structs": {k: v.to_dict() for k, v in parse_result.structs.items()},
-            "struct_ops": self.struct_ops,
-            "async_handlers": [asdict(h) for h in self.async_handlers],
-            "call_tree": self._call_tree_to_dict(call_tree),
-            "summary": self._generate_summary(parse_result)
+        # 专项分析（每个 pass 一个阶段）
+        analyses = {}
+        if self.analyses:
+            from analysis import AnalysisContext, run_analyses
+            ctx = AnalysisContext(parse_result, self.source_content, filepath,
+                                  async_handlers=self.async_handlers,
+                                  struct_ops=self.struct_ops,
+                                  knowledge_base=self.knowledge_base,
+                                  options=self.analysis_options)
+            analyses = run_analyses(self.analyses, ctx, stage=self._stage)
+        
+        with self._stage("build_output"):
+            result = {
+                "file": filepath,
+                "backend": self.backend.name,
+                "backend_version": self.backend.version,
+                "functions": {k: v.to_dict() for k, v in parse_result.functions.items()},
+                "structs": {k: v.to_dict() for k, v in parse_result.structs.items()},
+                "struct_ops": self.struct_ops,
+                "async_handlers": [asdict(h) for h in self.async_handlers],
+                "call_tree": self._call_tree_to_dict(call_tree),
+                "summary": self._generate_summary(parse_result)
+            }
+            if analyses:
+                result["analyses"] = analyses
+        
+        self._observe("output", result)
+        
+        result["stats"] = {
+            "stages_ms": dict(self._stage_times),
+            "total_ms": round(sum(self._stage_times.values()), 3)
         }
+        if selection:
+            result["stats"]["backend_selection"] = selection
+        return result
     
     def _extract_async_handlers(self, content: str) -> None:
         """提取异步处理函数"""
+        lines = LineIndex(content)
+        seen = {(h.func_name, h.handler_type) for h in self.async_handlers}
         for handler_type, pattern_info in self.ASYNC_PATTERNS.items():
             for pattern in pattern_info['init']:
                 for match in re.finditer(pattern, content):
@@ -184,12 +312,11 @@ class UnifiedAnalyzer:
                     func_name = groups[-1] if groups else None
                     
                     if func_name and func_name != 'NULL':
-                        line = content[:match.start()].count('\n') + 1
+                        line = lines.line_of(match.start())
                         
                         # 检查是否已存在
-                        exists = any(h.func_name == func_name and h.handler_type == handler_type 
-                                    for h in self.async_handlers)
-                        if not exists:
+                        if (func_name, handler_type) not in seen:
+                            seen.add((func_name, handler_type))
                             self.async_handlers.append(AsyncHandler(
                                 handler_type=handler_type,
                                 func_name=func_name,
@@ -212,6 +339,7 @@ class UnifiedAnalyzer:
             \}
         '''
         
+        lines = LineIndex(content)
         for match in re.finditer(struct_pattern, content, re.VERBOSE):
             struct_type = match.group(1)
             var_name = match.group(2)
@@ -233,7 +361,7 @@ class UnifiedAnalyzer:
                     'struct_type': struct_type,
                     'var_name': var_name,
                     'mappings': mappings,
-                    'line': content[:match.start()].count('\n') + 1
+                    'line': lines.line_of(match.start())
                 })
     
     def _apply_knowledge_base(self, parse_result: ParseResult) -> None:
@@ -292,6 +420,11 @@ class UnifiedAnalyzer:
                     "context": handler.context
                 }
         
+        # 异步处理函数按函数名索引（同名取第一个注册）
+        handler_by_func: Dict[str, AsyncHandler] = {}
+        for handler in self.async_handlers:
+            handler_by_func.setdefault(handler.func_name, handler)
+        
         # 构建每个回调函数的调用树
         processed = set()
         for func_name, func_def in parse_result.functions.items():
@@ -300,18 +433,16 @@ class UnifiedAnalyzer:
                 info = entry_points.get(context, {"icon": "📌", "desc": context})
                 
                 # 获取异步处理函数的详细信息
-                if context.startswith("async_"):
-                    for handler in self.async_handlers:
-                        if handler.func_name == func_name:
-                            info = {
-                                "icon": handler.extra_info.get('icon', '📌'),
-                                "desc": handler.extra_info.get('desc', handler.handler_type),
-                                "trigger": handler.trigger_pattern,
-                                "context": handler.context
-                            }
-                            break
+                handler = handler_by_func.get(func_name) if context.startswith("async_") else None
+                if handler:
+                    info = {
+                        "icon": handler.extra_info.get('icon', '📌'),
+                        "desc": handler.extra_info.get('desc', handler.handler_type),
+                        "trigger": handler.trigger_pattern,
+                        "context": handler.context
+                    }
                 
-                node = self._build_call_subtree(func_name, parse_result, set())
+                node = self._build_call_subtree(func_name, parse_result)
                 node.node_type = "entry_point"
                 node.display_name = f"{info.get('icon', '📌')} [{info.get('desc', context)}] → {func_name}()"
                 node.description = info.get("trigger", "")
@@ -321,44 +452,71 @@ class UnifiedAnalyzer:
         
         return trees
     
-    def _build_call_subtree(self, func_name: str, parse_result: ParseResult, 
-                           visited: Set[str], depth: int = 0) -> CallNode:
-        """构建调用子树"""
-        if func_name in visited or depth > 10:
-            return CallNode(
-                name=func_name,
-                display_name=f"{func_name}() [递归]",
-                node_type="recursive"
-            )
-        
-        visited = visited.copy()
-        visited.add(func_name)
-        
-        node = CallNode(name=func_name, display_name=f"{func_name}()")
-        
-        if func_name in parse_result.functions:
-            func_def = parse_result.functions[func_name]
-            node.line = func_def.location.line if func_def.location else 0
-            
-            for called in func_def.calls:
-                if called in parse_result.functions:
-                    child = self._build_call_subtree(called, parse_result, visited, depth + 1)
+    def _build_call_subtree(self, func_name: str, parse_result: ParseResult) -> CallNode:
+        """
+        构建调用子树
+
+        按广度优先展开：同一函数在一棵树里只在最浅处展开一次，之后出现时作为
+        引用叶子（避免菱形调用结构按路径数指数展开）；最浅处的展开剩余深度最大，
+        引用不会指向被深度截断得更少的展开。超过 MAX_CALL_DEPTH 的函数标记为截断，
+        与递归区分。
+        """
+        functions = parse_result.functions
+        root = self._function_node(func_name, functions)
+        if func_name not in functions:
+            return root
+
+        expanded = {func_name}
+        queue = deque([(root, (func_name,))])
+        while queue:
+            node, path = queue.popleft()
+            for called in functions[node.name].calls:
+                if called not in functions:
+                    node.children.append(self._kernel_api_node(called))
+                elif called in path:
+                    node.children.append(CallNode(
+                        name=called,
+                        display_name=f"{called}() [递归]",
+                        node_type="recursive"
+                    ))
+                elif called in expanded:
+                    child = self._function_node(called, functions)
+                    child.display_name = f"{called}() [已展开]"
+                    child.node_type = "reference"
+                    node.children.append(child)
+                elif len(path) > MAX_CALL_DEPTH:
+                    child = self._function_node(called, functions)
+                    child.display_name = f"{called}() [深度截断]"
+                    child.node_type = "truncated"
                     node.children.append(child)
                 else:
-                    # 外部函数
-                    child = CallNode(
-                        name=called,
-                        display_name=f"{called}()",
-                        node_type="kernel_api"
-                    )
-                    # 知识库查询
-                    if "kernel_apis" in self.knowledge_base:
-                        if called in self.knowledge_base["kernel_apis"]:
-                            api_info = self.knowledge_base["kernel_apis"][called]
-                            child.description = api_info.get("description", "")
+                    child = self._function_node(called, functions)
+                    expanded.add(called)
                     node.children.append(child)
-        
-        return node
+                    queue.append((child, path + (called,)))
+
+        return root
+
+    @staticmethod
+    def _function_node(func_name: str, functions: Dict) -> CallNode:
+        func_def = functions.get(func_name)
+        return CallNode(
+            name=func_name,
+            display_name=f"{func_name}()",
+            line=func_def.location.line if func_def and func_def.location else 0
+        )
+
+    def _kernel_api_node(self, called: str) -> CallNode:
+        """外部函数，描述取自知识库"""
+        child = CallNode(
+            name=called,
+            display_name=f"{called}()",
+            node_type="kernel_api"
+        )
+        api_info = self.knowledge_base.get("kernel_apis", {}).get(called)
+        if api_info:
+            child.description = api_info.get("description", "")
+        return child
     
     def _call_tree_to_dict(self, trees: List[CallNode]) -> List[Dict]:
         """调用树转字典"""
@@ -410,82 +568,343 @@ class UnifiedAnalyzer:
         }
 
 
+# ==================== 多文件调度 ====================
+
+# 每个 worker 进程持有一个分析器实例（由 _init_worker 创建）
+_worker_analyzer: Optional[UnifiedAnalyzer] = None
+_worker_tracer: Optional[TraceRecorder] = None
+_worker_memprof: Optional[MemoryProfiler] = None
+
+
+def _init_worker(backend_name: Optional[str], kb_path: Optional[str],
+                 trace: bool, process_name: str = "", mem_profile: bool = False,
+                 analyses: Optional[List[str]] = None,
+                 options: Optional[Dict[str, Any]] = None,
+                 needs: Optional[Set[Any]] = None,
+                 costs: Optional[Dict[str, Any]] = None) -> None:
+    """worker 初始化：创建分析器，需要时挂载 trace 记录器和内存剖析器"""
+    global _worker_analyzer, _worker_tracer, _worker_memprof
+    _worker_analyzer = UnifiedAnalyzer(backend_name, kb_path, analyses, options, needs, costs)
+    _worker_tracer = None
+    _worker_memprof = None
+    if trace:
+        _worker_tracer = TraceRecorder(process_name)
+        _worker_analyzer.profilers.append(_worker_tracer)
+    if mem_profile:
+        _worker_memprof = MemoryProfiler()
+        _worker_memprof.start()
+        _worker_analyzer.profilers.append(_worker_memprof)
+
+
+def _analyze_task(filepath: str, submit_us: float):
+    """
+    worker 任务：分析单个文件
+    
+    Returns:
+        (分析结果, trace 事件, 内存剖析记录, 任务结束时间)
+    """
+    start_us = now_us()
+    tracer = _worker_tracer
+    if tracer:
+        tracer.name_thread(f"worker {os.getpid()}")
+        tracer.complete("queue_wait", submit_us, start_us, cat="scheduler",
+                        args={"file": filepath})
+    
+    span = tracer.span(os.path.basename(filepath), cat="file", file=filepath) if tracer else nullcontext()
+    with span:
+        result = _worker_analyzer.analyze_file(filepath)
+    
+    events = tracer.drain() if tracer else []
+    mem_records = _worker_memprof.drain() if _worker_memprof else []
+    return result, events, mem_records, now_us()
+
+
+def analyze_files(files: List[str], backend_name: str = None, kb_path: str = None,
+                  jobs: int = 1, tracer: Optional[TraceRecorder] = None,
+                  mem_profiler: Optional[MemoryProfiler] = None,
+                  analyses: Optional[List[str]] = None,
+                  options: Optional[Dict[str, Any]] = None,
+                  needs: Optional[Set[Any]] = None,
+                  costs: Optional[Dict[str, Any]] = None) -> List[Dict]:
+    """
+    分析多个文件
+    
+    jobs > 1 时使用进程池并行分析；结果按输入顺序返回。
+    传入 tracer 时记录每个文件/阶段的事件、队列等待时间和结果回传耗时。
+    传入 mem_profiler 时每个 worker 各自跟踪分配，按文件的记录合并到 mem_profiler。
+    analyses / options 为专项分析的名称和选项（见 src/analysis）。
+    backend_name 为 'auto' 时每个 worker 逐文件选择后端，needs / costs 见 UnifiedAnalyzer。
+    """
+    if tracer:
+        tracer.name_thread("scheduler")
+    mem_profile = mem_profiler is not None
+    
+    if jobs <= 1 or len(files) <= 1:
+        _init_worker(backend_name, kb_path, tracer is not None, mem_profile=mem_profile,
+                     analyses=analyses, options=options, needs=needs, costs=costs)
+        submit_us = now_us()
+        results = []
+        for filepath in files:
+            result, events, mem_records, _ = _analyze_task(filepath, submit_us)
+            results.append(result)
+            if tracer:
+                tracer.extend(events)
+            if mem_profiler:
+                mem_profiler.merge(mem_records)
+        if _worker_memprof:
+            _worker_memprof.stop()
+        return results
+    
+    from concurrent.futures import ProcessPoolExecutor, as_completed
+    
+    results: List[Optional[Dict]] = [None] * len(files)
+    with ProcessPoolExecutor(max_workers=jobs, initializer=_init_worker,
+                             initargs=(backend_name, kb_path, tracer is not None,
+                                       "lda worker", mem_profile, analyses, options,
+                                       needs, costs)) as pool:
+        futures = {}
+        for index, filepath in enumerate(files):
+            futures[pool.submit(_analyze_task, filepath, now_us())] = index
+        
+        for future in as_completed(futures):
+            result, events, mem_records, done_us = future.result()
+            index = futures[future]
+            results[index] = result
+            if mem_profiler:
+                mem_profiler.merge(mem_records)
+            if tracer:
+                # worker 结束到主进程拿到结果之间：结果序列化/回传/调度延迟
+                tracer.complete("collect", done_us, now_us(), cat="serialization",
+                                args={"file": files[index]})
+                tracer.extend(events)
+    
+    return results
+
+
+def _print_summary(result: Dict) -> None:
+    """打印单个文件的分析摘要"""
+    summary = result['summary']
+    print(f"\n📊 分析摘要 (后端: {summary['backend']}):")
+    print(f"   函数总数: {summary['total_functions']}")
+    print(f"   结构体: {summary['total_structs']}")
+    print(f"   回调函数: {summary['callbacks']}")
+    print(f"   操作结构体: {summary['struct_ops_count']} ({', '.join(summary['struct_types'])})")
+    
+    if summary.get('async_handlers_count', 0) > 0:
+        print(f"\n   异步处理函数: {summary['async_handlers_count']}个")
+        type_icons = {
+            'work': '⚙️ 工作队列', 'delayed_work': '⏰ 延迟工作',
+            'irq': '⚡ 硬中断', 'threaded_irq': '🧵 线程化中断',
+            'tasklet': '🔄 Tasklet', 'timer': '⏲️ 定时器',
+            'hrtimer': '⏱️ 高精度定时器', 'kthread': '🧵 内核线程',
+            'urb': '🔁 URB 完成回调', 'napi': '📥 NAPI poll',
+        }
+        for htype, handlers in summary.get('async_handlers_by_type', {}).items():
+            print(f"     {type_icons.get(htype, htype)}:")
+            for h in handlers:
+                ctx = f" ({h['context']})" if h.get('context') else ""
+                print(f"       - {h['func']}(){ctx}")
+    
+    if summary.get('most_complex'):
+        print(f"\n   调用最多的函数:")
+        for name, count in summary['most_complex']:
+            if count > 0:
+                print(f"     - {name}: {count}个调用")
+
+
+class _ArgumentParser(argparse.ArgumentParser):
+    """显示帮助时才导入 src/analysis 填入可用分析列表"""
+    
+    def format_help(self) -> str:
+        from analysis import list_analyses
+        return super().format_help().replace('{analyses}', ', '.join(list_analyses()))
+
+
 def main():
-    parser = argparse.ArgumentParser(
+    parser = _ArgumentParser(
         description='Linux 驱动代码分析器 (v0.2 - 使用可插拔后端)',
         formatter_class=argparse.RawDescriptionHelpFormatter,
         epilog="""
 示例:
-  %(prog)s driver.c                    # 使用最佳后端分析
+  %(prog)s driver.c                    # 逐文件按代价模型选择后端（auto）
+  %(prog)s *.c --need enums            # auto 时要求枚举（选 tree-sitter / clang）
   %(prog)s driver.c -b regex           # 指定使用 regex 后端
   %(prog)s driver.c -b tree-sitter     # 指定使用 tree-sitter 后端
+  %(prog)s *.c -b native -j 8          # C++ 扫描器（与 regex 结果相同，先 make native）
+  %(prog)s -b clang -p build/ -j 8     # 按 compile_commands.json 用 libclang 并行解析全部 TU
   %(prog)s driver.c -o result.json     # 输出到指定文件
+  %(prog)s *.c -j 8 --trace trace.json # 并行分析并导出 Chrome trace
+  %(prog)s *.c --mem-profile mem.json  # 按阶段/模型类型统计内存
+  %(prog)s driver.c -a layout --arch arm64  # 结构体布局/缓存行报告
+  %(prog)s driver.c -a layout -I /usr/include/linux  # 布局回退到头文件中的类型定义
 """
     )
-    parser.add_argument('file', help='要分析的 C 源文件')
+    parser.add_argument('files', nargs='*', help='要分析的 C 源文件')
     parser.add_argument('-o', '--output', default='analysis_result.json',
                         help='输出 JSON 文件路径 (默认: analysis_result.json)')
-    parser.add_argument('-b', '--backend', choices=['regex', 'tree-sitter', 'auto'],
-                        default='auto', help='选择解析后端 (默认: auto)')
+    parser.add_argument('-b', '--backend', choices=['regex', 'native', 'tree-sitter', 'clang', 'auto'],
+                        default='auto',
+                        help='选择解析后端 (默认: auto，按文件大小、宏密度和所需能力逐文件选择)')
+    parser.add_argument('--need', action='append', default=[], metavar='CAP[,CAP]',
+                        help='auto 时输出额外需要的后端能力，如 enums、declarations、'
+                             'precise-location、macro-expansion')
+    parser.add_argument('--cost-model', metavar='BENCH.json', default=None,
+                        help='auto 的代价模型改用 bench_backends.py 结果中的实测吞吐')
+    parser.add_argument('-p', '--compile-commands', metavar='PATH', default=None,
+                        help='compile_commands.json 或其所在目录（clang 后端的编译选项；'
+                             '不给源文件时分析其中全部文件）')
     parser.add_argument('-k', '--knowledge-base', default=None,
                         help='知识库路径')
     parser.add_argument('--list-backends', action='store_true',
                         help='列出可用后端')
+    parser.add_argument('-j', '--jobs', type=int, default=1,
+                        help='并行分析的 worker 进程数 (默认: 1)')
+    parser.add_argument('--trace', metavar='OUT.json', default=None,
+                        help='导出 Chrome/Perfetto trace 事件（每个文件、阶段、worker）')
+    parser.add_argument('--mem-profile', metavar='OUT.json', nargs='?', const='', default=None,
+                        help='用 tracemalloc 统计各阶段、各模型类型的内存和分配最多的源码行'
+                             '（可选写出 JSON 报告）')
+    parser.add_argument('-a', '--analysis', action='append', default=[], metavar='NAME',
+                        help='运行专项分析，可重复；all 表示全部 (可用: {analyses})')
+    parser.add_argument('--arch', default='x86_64', choices=['x86_64', 'arm64'],
+                        help='布局计算的目标架构 (默认: x86_64)')
+    parser.add_argument('--type-sizes', metavar='FILE.json', default=None,
+                        help='补充类型大小表 {"struct foo": [size, align]}')
+    parser.add_argument('--hz', type=int, default=250,
+                        help='换算 jiffies 周期用的 CONFIG_HZ (默认: 250)')
+    parser.add_argument('-I', '--include-dir', action='append', default=[], metavar='DIR',
+                        help='收集头文件（目录递归）中的结构体/联合体/枚举/typedef，'
+                             '本文件中没有的类型定义到这里查找；可重复')
     
     args = parser.parse_args()
     
     if args.list_backends:
-        print(f"可用后端: {list_backends()}")
+        # 只探测依赖，不导入后端模块
+        print(f"可用后端: {list_backends(probe_only=True)}")
         return
     
+    if args.compile_commands:
+        from backends import CompileDatabase
+        # 通过环境变量传给 clang 后端（worker 进程继承）
+        os.environ['LDA_COMPILE_COMMANDS'] = os.path.abspath(args.compile_commands)
+        if not args.files:
+            args.files = [f for f in CompileDatabase(args.compile_commands).files()
+                          if f.endswith('.c')]
+    
+    if not args.files:
+        parser.error('需要至少一个源文件')
+    
     # 知识库路径
     kb_path = args.knowledge_base
     if not kb_path:
         script_dir = os.path.dirname(os.path.abspath(__file__))
         kb_path = os.path.join(script_dir, 'knowledge_base.json')
     
-    # 选择后端
-    backend_name = None if args.backend == 'auto' else args.backend
+    # 选择后端（auto 时逐文件选择）
+    backend_name = args.backend
+    needs, costs = set(), None
+    if args.need or args.cost_model:
+        from backends.selector import load_costs, parse_capabilities
+        try:
+            needs = parse_capabilities(n for spec in args.need for n in spec.split(','))
+        except ValueError as e:
+            parser.error(str(e))
+        if args.cost_model:
+            costs = load_costs(args.cost_model)
+    
+    # 专项分析
+    analyses = []
+    if args.analysis:
+        from analysis import AnalysisRegistry, merge_lock_order
+        try:
+            analyses = AnalysisRegistry.resolve(args.analysis)
+        except ValueError as e:
+            parser.error(str(e))
+    options = {"arch": args.arch, "hz": args.hz}
+    if args.type_sizes:
+        with open(args.type_sizes, 'r', encoding='utf-8') as f:
+            options["type_sizes"] = json.load(f)
+    
+    tracer = TraceRecorder("lda main") if args.trace else None
+    mem_profiler = None
+    if args.mem_profile is not None:
+        mem_profiler = MemoryProfiler()
+        mem_profiler.start()
+    
+    # 头文件类型声明：只收集一次（跳过函数体），吞吐量单独统计
+    header_index = None
+    if args.include_dir:
+        from backends.headers import harvest
+        with ExitStack() as stack:
+            if tracer:
+                stack.enter_context(tracer.span("harvest_headers", cat="parse"))
+            if mem_profiler:
+                stack.enter_context(mem_profiler.stage("harvest_headers"))
+            header_index = harvest(args.include_dir,
+                                   backend_name if backend_name in ('regex', 'native') else None,
+                                   jobs=args.jobs)
+        options["headers"] = header_index
+        stats = header_index.stats
+        print(f"📚 头文件: {stats['files']} 个, {stats['bytes'] / 1024 / 1024:.1f} MB, "
+              f"{stats['wall_seconds']:.2f}s ({stats['mb_per_s']} MB/s, {stats['backend']}), "
+              f"{len(header_index.macros)} 个宏")
     
     # 分析
-    analyzer = UnifiedAnalyzer(backend_name, kb_path)
-    result = analyzer.analyze_file(args.file)
+    results = analyze_files(args.files, backend_name, kb_path, args.jobs, tracer, mem_profiler,
+                            analyses, options, needs, costs)
+    result = results[0] if len(results) == 1 else {"files": results}
+    # 多个文件时把各文件的锁顺序边合并为全局锁顺序图
+    global_lock_order = merge_lock_order(results) if analyses and len(results) > 1 else None
+    if global_lock_order:
+        result["lock_order"] = global_lock_order
+    if header_index:
+        result["header_harvest"] = header_index.summary()
     
     # 输出
-    with open(args.output, 'w', encoding='utf-8') as f:
-        json.dump(result, f, ensure_ascii=False, indent=2)
+    with ExitStack() as stack:
+        if tracer:
+            stack.enter_context(tracer.span("write_output", cat="serialization"))
+        if mem_profiler:
+            stack.enter_context(mem_profiler.stage("write_output"))
+        with open(args.output, 'w', encoding='utf-8') as f:
+            json.dump(result, f, ensure_ascii=False, indent=2)
+    if mem_profiler:
+        mem_profiler.stop()
     
     print(f"分析完成！结果已保存到: {args.output}")
     
-    # 打印摘要
-    summary = result['summary']
-    print(f"\n📊 分析摘要 (后端: {summary['backend']}):")
-    print(f"   函数总数: {summary['total_functions']}")
-    print(f"   结构体: {summary['total_structs']}")
-    print(f"   回调函数: {summary['callbacks']}")
-    print(f"   操作结构体: {summary['struct_ops_count']} ({', '.join(summary['struct_types'])})")
+    if tracer:
+        tracer.save(args.trace)
+        print(f"Trace 已保存到: {args.trace}")
     
-    if summary.get('async_handlers_count', 0) > 0:
-        print(f"\n   异步处理函数: {summary['async_handlers_count']}个")
-        type_icons = {
-            'work': '⚙️ 工作队列', 'delayed_work': '⏰ 延迟工作',
-            'irq': '⚡ 硬中断', 'threaded_irq': '🧵 线程化中断',
-            'tasklet': '🔄 Tasklet', 'timer': '⏲️ 定时器',
-            'hrtimer': '⏱️ 高精度定时器', 'kthread': '🧵 内核线程',
-        }
-        for htype, handlers in summary.get('async_handlers_by_type', {}).items():
-            print(f"     {type_icons.get(htype, htype)}:")
-            for h in handlers:
-                ctx = f" ({h['context']})" if h.get('context') else ""
-                print(f"       - {h['func']}(){ctx}")
+    if mem_profiler:
+        print(mem_profiler.format_report())
+        if args.mem_profile:
+            mem_profiler.save(args.mem_profile)
+            print(f"内存剖析报告已保存到: {args.mem_profile}")
     
-    if summary.get('most_complex'):
-        print(f"\n   调用最多的函数:")
-        for name, count in summary['most_complex']:
-            if count > 0:
-                print(f"     - {name}: {count}个调用")
+    # 打印摘要
+    for file_result in results:
+        if len(results) > 1:
+            print(f"\n📄 {file_result['file']}")
+        _print_summary(file_result)
+        # 只打印显式要求的分析（依赖的 pass 结果仍写入 JSON）
+        for name, analysis_result in file_result.get("analyses", {}).items():
+            if name not in args.analysis and 'all' not in args.analysis:
+                continue
+            text = AnalysisRegistry.get(name).format_text(analysis_result)
+            if text:
+                print(text)
+    if len(results) > 1 and backend_name == 'auto':
+        chosen: Dict[str, int] = {}
+        for file_result in results:
+            name = file_result["stats"]["backend_selection"]["backend"]
+            chosen[name] = chosen.get(name, 0) + 1
+        print(f"\n🔀 后端选择 (auto): " + ", ".join(f"{k}×{v}" for k, v in chosen.items()))
+    if global_lock_order:
+        print(f"\n🌐 全局锁顺序 ({global_lock_order['files']} 个文件)")
+        print(AnalysisRegistry.get("lock-order").format_text(global_lock_order))
 
 
 if __name__ == '__main__':
     main()
-
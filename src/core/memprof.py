@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""
+内存剖析
+
+基于 tracemalloc 统计一次分析运行的内存使用，定位大批量分析时的内存大户：
+- 按流水线阶段：每个阶段内的峰值增量和净分配
+- 按模型类型：FunctionDef、StructField、函数体字符串、CallNode 调用树、输出字典
+  （对象图遍历得到的存活大小，各类别独立计算，共享的字符串会在多个类别中重复计入）
+- 分配最多的源码行：每个文件构建完输出后（此时源码、解析结果、调用树、输出都存活）
+  的快照，按行取各文件中的最大值
+
+与 TraceRecorder 一样挂到 UnifiedAnalyzer.profilers 上，通过 stage() 钩子工作。
+
+使用方法:
+    profiler = MemoryProfiler()
+    profiler.start()
+    analyzer.profilers.append(profiler)
+    analyzer.analyze_file("driver.c")
+    profiler.stop()
+    print(profiler.format_report())
+"""
+
+import dataclasses
+import json
+import os
+import sys
+import tracemalloc
+from contextlib import contextmanager
+from typing import Any, Dict, Iterable, List, Optional, Set
+
+
+def deep_sizeof(roots: Iterable[Any], seen: Optional[Set[int]] = None) -> int:
+    """
+    对象图的存活大小（字节）
+
+    遍历 dict / list / tuple / set 以及 dataclass 实例的字段；
+    seen 中已有的对象不再计入（用于排除某类对象或跨根去重）。
+    """
+    seen = set() if seen is None else seen
+    stack = list(roots)
+    total = 0
+    while stack:
+        obj = stack.pop()
+        if id(obj) in seen:
+            continue
+        seen.add(id(obj))
+        total += sys.getsizeof(obj)
+        if isinstance(obj, dict):
+            stack.extend(obj.keys())
+            stack.extend(obj.values())
+        elif isinstance(obj, (list, tuple, set, frozenset)):
+            stack.extend(obj)
+        elif dataclasses.is_dataclass(obj) and not isinstance(obj, type):
+            attrs = getattr(obj, '__dict__', None)
+            if attrs is not None:
+                total += sys.getsizeof(attrs)
+                stack.extend(attrs.values())
+    return total
+
+
+def _kb(size: float) -> float:
+    return round(size / 1024.0, 1)
+
+
+class MemoryProfiler:
+    """按阶段和模型类型统计内存"""
+
+    # 模型类型的显示顺序
+    MODEL_TYPES = ["source", "FunctionDef", "body_str", "StructDef", "StructField",
+                   "other_models", "CallNode", "output_dict"]
+
+    def __init__(self, top_lines: int = 15):
+        self.top_lines = top_lines
+        self.records: List[Dict] = []
+        self._current: Optional[Dict] = None
+        self._started_here = False
+        self._overall_peak = 0
+
+    def start(self) -> None:
+        """开始跟踪（只记录一层调用栈，按行统计足够）"""
+        if not tracemalloc.is_tracing():
+            tracemalloc.start(1)
+            self._started_here = True
+
+    def stop(self) -> None:
+        if self._started_here:
+            self._overall_peak = max(self._overall_peak, tracemalloc.get_traced_memory()[1])
+            tracemalloc.stop()
+            self._started_here = False
+
+    def _record_for(self, filepath: str) -> Dict:
+        if self._current is None or self._current["file"] != filepath:
+            self._current = {"file": filepath, "peak_kb": 0.0, "stages": {},
+                             "models": {}, "top_lines": []}
+            self.records.append(self._current)
+        return self._current
+
+    # 与 UnifiedAnalyzer 的阶段钩子对接；file 为空表示主进程自身的阶段（如写出结果）
+    @contextmanager
+    def stage(self, name: str, file: str = "", **args):
+        record = self._record_for(file)
+        if not tracemalloc.is_tracing():
+            yield
+            return
+        start, before_peak = tracemalloc.get_traced_memory()
+        # reset_peak() 需要 Python 3.9；3.8 上峰值是开始跟踪以来的最大值
+        can_reset = hasattr(tracemalloc, "reset_peak")
+        if can_reset:
+            tracemalloc.reset_peak()
+        try:
+            yield
+        finally:
+            current, peak = tracemalloc.get_traced_memory()
+            if not can_reset and peak <= before_peak:
+                # 阶段内没有超过之前的峰值，真实峰值不可知，取阶段前后的较大值作为下界
+                peak = max(start, current)
+            self._overall_peak = max(self._overall_peak, peak)
+            record["peak_kb"] = max(record["peak_kb"], _kb(peak))
+            record["stages"][name] = {
+                "peak_kb": _kb(peak - start),
+                "net_kb": _kb(current - start),
+            }
+            if name == "build_output":
+                record["top_lines"] = self._top_lines()
+
+    def observe(self, kind: str, obj: Any, file: str = "") -> None:
+        """
+        统计分析器交给 profiler 的中间结果
+
+        kind: "source" / "parse_result" / "call_tree" / "output"
+        """
+        models = self._record_for(file)["models"]
+        if kind == "source":
+            models["source"] = sys.getsizeof(obj)
+        elif kind == "parse_result":
+            bodies = [f.body for f in obj.functions.values()]
+            models["body_str"] = deep_sizeof(bodies)
+            # FunctionDef 不含函数体；StructDef 不含字段
+            models["FunctionDef"] = deep_sizeof(obj.functions.values(), {id(b) for b in bodies})
+            fields = [fd for s in obj.structs.values() for fd in s.fields]
+            models["StructField"] = deep_sizeof(fields)
+            models["StructDef"] = deep_sizeof(obj.structs.values(), {id(fd) for fd in fields})
+            models["other_models"] = deep_sizeof([obj.enums, obj.unions, obj.typedefs,
+                                                  obj.calls, obj.errors])
+        elif kind == "call_tree":
+            models["CallNode"] = deep_sizeof(obj)
+        elif kind == "output":
+            models["output_dict"] = deep_sizeof([obj])
+
+    def _top_lines(self) -> List[Dict]:
+        snapshot = tracemalloc.take_snapshot().filter_traces([
+            tracemalloc.Filter(False, tracemalloc.__file__),
+            tracemalloc.Filter(False, __file__),
+        ])
+        lines = []
+        for stat in snapshot.statistics('lineno')[:self.top_lines]:
+            frame = stat.traceback[0]
+            lines.append({
+                "location": f"{frame.filename}:{frame.lineno}",
+                "size_kb": _kb(stat.size),
+                "count": stat.count,
+            })
+        return lines
+
+    def drain(self) -> List[Dict]:
+        """取出并清空已记录的单文件数据（worker 回传结果时使用）"""
+        records, self.records = self.records, []
+        self._current = None
+        return records
+
+    def merge(self, records: List[Dict]) -> None:
+        """合并其他进程（worker）回传的单文件数据"""
+        self.records.extend(records)
+        for record in records:
+            self._overall_peak = max(self._overall_peak, int(record["peak_kb"] * 1024))
+
+    def report(self) -> Dict:
+        """汇总：阶段取峰值最大值和净分配总和，模型类型取单文件最大值和总和"""
+        stages: Dict[str, Dict] = {}
+        models: Dict[str, Dict] = {}
+        lines: Dict[str, Dict] = {}
+        for record in self.records:
+            for name, s in record["stages"].items():
+                agg = stages.setdefault(name, {"max_peak_kb": 0.0, "total_net_kb": 0.0})
+                agg["max_peak_kb"] = max(agg["max_peak_kb"], s["peak_kb"])
+                agg["total_net_kb"] = round(agg["total_net_kb"] + s["net_kb"], 1)
+            for name, size in record["models"].items():
+                agg = models.setdefault(name, {"max_kb": 0.0, "total_kb": 0.0})
+                agg["max_kb"] = max(agg["max_kb"], _kb(size))
+                agg["total_kb"] = round(agg["total_kb"] + _kb(size), 1)
+            for line in record["top_lines"]:
+                best = lines.get(line["location"])
+                if best is None or line["size_kb"] > best["size_kb"]:
+                    lines[line["location"]] = line
+        ordered_models = {name: models[name] for name in self.MODEL_TYPES if name in models}
+        top = sorted(lines.values(), key=lambda l: l["size_kb"], reverse=True)[:self.top_lines]
+        return {
+            "files": sum(1 for r in self.records if r["file"]),
+            "peak_kb": _kb(self._overall_peak),
+            "stages": stages,
+            "models": ordered_models,
+            "top_lines": top,
+            "per_file": self.records,
+        }
+
+    def save(self, path: str) -> None:
+        with open(path, 'w', encoding='utf-8') as f:
+            json.dump(self.report(), f, ensure_ascii=False, indent=2)
+
+    def format_report(self) -> str:
+        """人类可读的摘要"""
+        report = self.report()
+        out = [f"\n🧠 内存剖析 ({report['files']} 个文件, tracemalloc 峰值 {report['peak_kb']:.1f} KB):"]
+        out.append("   按阶段 (单文件峰值增量 / 净分配总和):")
+        for name, s in report["stages"].items():
+            out.append(f"     {name:<16} {s['max_peak_kb']:>10.1f} KB {s['total_net_kb']:>12.1f} KB")
+        out.append("   按模型类型 (单文件最大 / 总和):")
+        for name, m in report["models"].items():
+            out.append(f"     {name:<16} {m['max_kb']:>10.1f} KB {m['total_kb']:>12.1f} KB")
+        if report["top_lines"]:
+            out.append("   分配最多的源码行:")
+            cwd = os.getcwd() + os.sep
+            for line in report["top_lines"]:
+                location = line["location"].replace(cwd, "")
+                out.append(f"     {line['size_kb']:>10.1f} KB {line['count']:>8} 块  {location}")
+        return "\n".join(out)
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""
+Chrome trace-event 记录器
+
+把一次分析运行记录为 Chrome/Perfetto 可直接加载的 trace 文件
+(chrome://tracing、https://ui.perfetto.dev 或本地 trace viewer)。
+
+- 每个文件、每个阶段一个 "X"（complete）事件
+- pid/tid 使用真实的进程号和线程号，多进程调度时每个 worker 一条泳道
+- 时间戳基于 CLOCK_MONOTONIC（Linux 上跨进程可比），单位微秒
+
+使用方法:
+    tracer = TraceRecorder()
+    with tracer.span("parse", cat="stage", file="driver.c"):
+        ...
+    tracer.save("out.json")
+"""
+
+import json
+import os
+import threading
+import time
+from contextlib import contextmanager
+from typing import Dict, List, Optional
+
+
+def now_us() -> float:
+    """当前单调时钟时间（微秒）"""
+    return time.monotonic_ns() / 1000.0
+
+
+class TraceRecorder:
+    """Chrome trace-event 格式的事件收集器"""
+
+    def __init__(self, process_name: str = ""):
+        self.events: List[Dict] = []
+        self._named_threads = set()
+        if process_name:
+            self.name_process(process_name)
+
+    @staticmethod
+    def _ids() -> tuple:
+        return os.getpid(), threading.get_native_id()
+
+    def name_process(self, name: str) -> None:
+        """设置当前进程在 trace viewer 中的显示名"""
+        pid, tid = self._ids()
+        self.events.append({
+            "name": "process_name", "ph": "M", "pid": pid, "tid": tid,
+            "args": {"name": name}
+        })
+
+    def name_thread(self, name: str) -> None:
+        """设置当前线程在 trace viewer 中的显示名（每个线程只记录一次）"""
+        pid, tid = self._ids()
+        if (pid, tid) in self._named_threads:
+            return
+        self._named_threads.add((pid, tid))
+        self.events.append({
+            "name": "thread_name", "ph": "M", "pid": pid, "tid": tid,
+            "args": {"name": name}
+        })
+
+    def complete(self, name: str, start_us: float, end_us: float,
+                 cat: str = "stage", args: Optional[Dict] = None) -> None:
+        """记录一个已结束的区间事件"""
+        pid, tid = self._ids()
+        event = {
+            "name": name, "cat": cat, "ph": "X",
+            "ts": start_us, "dur": max(end_us - start_us, 0.0),
+            "pid": pid, "tid": tid,
+        }
+        if args:
+            event["args"] = args
+        self.events.append(event)
+
+    def instant(self, name: str, cat: str = "mark", args: Optional[Dict] = None) -> None:
+        """记录一个瞬时事件"""
+        pid, tid = self._ids()
+        event = {"name": name, "cat": cat, "ph": "i", "s": "t",
+                 "ts": now_us(), "pid": pid, "tid": tid}
+        if args:
+            event["args"] = args
+        self.events.append(event)
+
+    @contextmanager
+    def span(self, name: str, cat: str = "stage", **args):
+        """以上下文管理器的方式记录一个区间"""
+        start = now_us()
+        try:
+            yield
+        finally:
+            self.complete(name, start, now_us(), cat, args or None)
+
+    # 与 UnifiedAnalyzer 的阶段钩子对接
+    def stage(self, name: str, **args):
+        return self.span(name, cat="stage", **args)
+
+    def extend(self, events: List[Dict]) -> None:
+        """合并其他进程（worker）回传的事件"""
+        self.events.extend(events)
+
+    def drain(self) -> List[Dict]:
+        """取出并清空已记录的事件（worker 回传结果时使用）"""
+        events, self.events = self.events, []
+        return events
+
+    def save(self, path: str) -> None:
+        """写出 trace 文件"""
+        events = sorted(self.events, key=lambda e: (e["ph"] != "M", e.get("ts", 0)))
+        with open(path, 'w', encoding='utf-8') as f:
+            json.dump({"traceEvents": events, "displayTimeUnit": "ms"},
+                      f, ensure_ascii=False)
@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+"""
+测试公共辅助
+
+专项分析测试都是"把一段驱动源码写到临时文件，用 regex 后端跑指定分析"，
+这里提供统一的入口：from helpers import run_analysis。
+"""
+
+import os
+import sys
+from typing import Any, Dict, Sequence
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from core.analyzer import UnifiedAnalyzer
+
+
+def analyze_source(tmp_path, source: str, analyses: Sequence[str],
+                   filename: str = 'nic.c', **options: Any) -> Dict:
+    """
+    把源码写入 tmp_path/filename，用 regex 后端运行 analyses
+
+    Args:
+        tmp_path: pytest 的临时目录
+        source: C 源码
+        analyses: 分析名称列表
+        filename: 写入的文件名
+        **options: 传给分析的选项（如 hz=250）
+
+    Returns:
+        analyze_file 的完整结果
+    """
+    path = tmp_path / filename
+    path.write_text(source)
+    analyzer = UnifiedAnalyzer('regex', analyses=list(analyses), options=options)
+    return analyzer.analyze_file(str(path))
+
+
+def run_analysis(tmp_path, source: str, name: str, filename: str = 'nic.c',
+                 **options: Any) -> Dict:
+    """运行单个分析并返回 result["analyses"][name]"""
+    return analyze_source(tmp_path, source, [name], filename, **options)["analyses"][name]
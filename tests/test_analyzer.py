@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""
+统一分析器测试
+
+测试 UnifiedAnalyzer 的流水线、多文件调度和运行时诊断功能。
+"""
+
+import json
+import os
+import sys
+import tracemalloc
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from core.analyzer import UnifiedAnalyzer, analyze_files
+from core.tracing import TraceRecorder
+from core.memprof import MemoryProfiler, deep_sizeof
+
+
+EXAMPLES_DIR = os.path.join(os.path.dirname(__file__), '..', 'examples')
+EXAMPLE_FILES = [
+    os.path.join(EXAMPLES_DIR, 'usb_serial', 'usb_serial_example.c'),
+    os.path.join(EXAMPLES_DIR, 'async_demo', 'async_demo_example.c'),
+    os.path.join(EXAMPLES_DIR, 'advanced_features', 'advanced_driver.c'),
+]
+
+
+class TestMultiFile:
+    """多文件调度测试"""
+
+    def test_sequential_order(self):
+        """结果按输入顺序返回"""
+        results = analyze_files(EXAMPLE_FILES, 'regex')
+        assert [r['file'] for r in results] == EXAMPLE_FILES
+
+    def test_parallel_matches_sequential(self):
+        """并行与串行结果一致"""
+        sequential = analyze_files(EXAMPLE_FILES, 'regex')
+        parallel = analyze_files(EXAMPLE_FILES, 'regex', jobs=2)
+        for a, b in zip(sequential, parallel):
+            assert a['functions'] == b['functions']
+            assert a['async_handlers'] == b['async_handlers']
+
+    def test_analyzer_reuse_resets_state(self):
+        """同一实例连续分析不会累积上一个文件的状态"""
+        analyzer = UnifiedAnalyzer('regex')
+        first = analyzer.analyze_file(EXAMPLE_FILES[1])
+        analyzer.analyze_file(EXAMPLE_FILES[0])
+        again = analyzer.analyze_file(EXAMPLE_FILES[1])
+        assert first['async_handlers'] == again['async_handlers']
+        assert first['struct_ops'] == again['struct_ops']
+
+    def test_stage_stats(self):
+        """结果包含各阶段耗时"""
+        result = UnifiedAnalyzer('regex').analyze_file(EXAMPLE_FILES[0])
+        stages = result['stats']['stages_ms']
+        assert 'parse' in stages
+        assert 'call_tree' in stages
+
+
+class TestTrace:
+    """Chrome trace 导出测试"""
+
+    def test_trace_events(self, tmp_path):
+        """每个文件和阶段都有事件，并包含队列等待"""
+        tracer = TraceRecorder("test")
+        analyze_files(EXAMPLE_FILES, 'regex', jobs=2, tracer=tracer)
+        out = tmp_path / 'trace.json'
+        tracer.save(str(out))
+
+        events = json.loads(out.read_text())['traceEvents']
+        complete = [e for e in events if e['ph'] == 'X']
+
+        assert all('ts' in e and 'dur' in e and 'pid' in e and 'tid' in e for e in complete)
+        assert sum(1 for e in complete if e['cat'] == 'file') == len(EXAMPLE_FILES)
+        assert sum(1 for e in complete if e['name'] == 'queue_wait') == len(EXAMPLE_FILES)
+        assert sum(1 for e in complete if e['name'] == 'parse') == len(EXAMPLE_FILES)
+        assert any(e['name'] == 'collect' for e in complete)
+        assert any(e['ph'] == 'M' and e['name'] == 'process_name' for e in events)
+
+
+class TestMemProfile:
+    """内存剖析测试"""
+
+    def test_stages_and_models(self):
+        """按阶段、按模型类型统计，并给出分配最多的源码行"""
+        profiler = MemoryProfiler()
+        analyze_files(EXAMPLE_FILES, 'regex', mem_profiler=profiler)
+        report = profiler.report()
+
+        assert not tracemalloc.is_tracing()
+        assert report['files'] == len(EXAMPLE_FILES)
+        assert report['peak_kb'] > 0
+        assert {'parse', 'call_tree', 'build_output'} <= set(report['stages'])
+        for name in ('FunctionDef', 'StructField', 'body_str', 'CallNode', 'output_dict'):
+            assert report['models'][name]['max_kb'] > 0
+        assert report['top_lines']
+        assert all(':' in line['location'] for line in report['top_lines'])
+
+    def test_parallel_merges_worker_records(self):
+        """并行时各 worker 的记录合并到主进程"""
+        profiler = MemoryProfiler()
+        analyze_files(EXAMPLE_FILES, 'regex', jobs=2, mem_profiler=profiler)
+        report = profiler.report()
+        assert sorted(r['file'] for r in report['per_file']) == sorted(EXAMPLE_FILES)
+        assert report['models']['FunctionDef']['total_kb'] > 0
+
+    def test_without_reset_peak(self, monkeypatch):
+        """Python 3.8 没有 tracemalloc.reset_peak()：阶段峰值退化为相对历史峰值的增量"""
+        monkeypatch.delattr(tracemalloc, 'reset_peak')
+        profiler = MemoryProfiler()
+        profiler.start()
+        try:
+            with profiler.stage('big', 'a.c'):
+                data = bytearray(1 << 20)
+                del data
+            with profiler.stage('small', 'a.c'):
+                data = bytearray(1 << 10)
+        finally:
+            profiler.stop()
+        stages = profiler.report()['stages']
+        assert stages['big']['max_peak_kb'] >= 1024
+        # 没有超过历史峰值的阶段不会被记成整个历史峰值
+        assert stages['small']['max_peak_kb'] < 512
+
+    def test_deep_sizeof_excludes_seen(self):
+        """deep_sizeof 遍历容器，seen 中的对象不计入"""
+        body = 'x' * 10000
+        holder = {'body': body, 'calls': ['a', 'b']}
+        full = deep_sizeof([holder])
+        assert full > 10000
+        assert deep_sizeof([holder], {id(body)}) < full - 10000
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
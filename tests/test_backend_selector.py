@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""
+auto 策略（逐文件选择后端）测试
+
+用假后端替换注册中心中的 tree-sitter / clang，不依赖它们是否安装。
+"""
+
+import json
+import os
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from backends import BackendCapability, BackendRegistry, RegexBackend
+from backends.selector import (
+    BASE_CAPABILITIES, DEFAULT_COSTS, BackendCost, BackendSelector,
+    load_costs, macro_density, parse_capabilities
+)
+from core.analyzer import UnifiedAnalyzer
+
+ROOT = os.path.join(os.path.dirname(__file__), '..')
+EXAMPLE = os.path.join(ROOT, 'examples', 'usb_serial', 'usb_serial_example.c')
+
+PRECISE = {BackendCapability.PARSE_ENUMS, BackendCapability.PARSE_DECLARATIONS,
+           BackendCapability.PRECISE_LOCATION}
+
+
+class FakeTreeSitter(RegexBackend):
+    @property
+    def name(self) -> str:
+        return "tree-sitter"
+
+    def capabilities(self):
+        return super().capabilities() | PRECISE
+
+
+class FakeClang(RegexBackend):
+    @property
+    def name(self) -> str:
+        return "clang"
+
+    def capabilities(self):
+        return super().capabilities() | PRECISE | {BackendCapability.MACRO_EXPANSION}
+
+
+@pytest.fixture
+def registry(monkeypatch):
+    """注册中心的副本：tree-sitter / clang 换成假后端"""
+    monkeypatch.setattr(BackendRegistry, '_descriptors',
+                        {k: v for k, v in BackendRegistry._descriptors.items()
+                         if k not in ('tree-sitter', 'clang')})
+    monkeypatch.setattr(BackendRegistry, '_backends', dict(BackendRegistry._backends))
+    monkeypatch.setattr(BackendRegistry, '_instances', dict(BackendRegistry._instances))
+    BackendRegistry._instances.pop('tree-sitter', None)
+    BackendRegistry._instances.pop('clang', None)
+    BackendRegistry.register(FakeTreeSitter, 'tree-sitter')
+    BackendRegistry.register(FakeClang, 'clang')
+    return BackendRegistry
+
+
+def _driver(lines: int, macro_every: int = 0) -> str:
+    out = []
+    for i in range(lines):
+        if macro_every and i % macro_every == 0:
+            out.append(f'#define REG_{i} 0x{i:04x}')
+        else:
+            out.append(f'static int f{i}(int x) {{ return g{i}(x); }}')
+    return '\n'.join(out) + '\n'
+
+
+class TestCostModel:
+    """代价模型和辅助函数"""
+
+    def test_parse_capabilities(self):
+        caps = parse_capabilities(['enums', 'Precise-Location', 'MACRO_EXPANSION', ''])
+        assert caps == {BackendCapability.PARSE_ENUMS, BackendCapability.PRECISE_LOCATION,
+                        BackendCapability.MACRO_EXPANSION}
+        with pytest.raises(ValueError):
+            parse_capabilities(['no-such-cap'])
+
+    def test_macro_density(self):
+        assert macro_density('') == 0.0
+        assert macro_density(_driver(100)) == pytest.approx(0.0)
+        assert macro_density('#define A \\\n  1\nint x;\n') == pytest.approx(2 / 4)
+        assert macro_density(_driver(100, macro_every=2)) == pytest.approx(50 / 101)
+
+    def test_load_costs(self, tmp_path):
+        path = tmp_path / 'bench.json'
+        path.write_text(json.dumps({"results": [
+            {"backend": "regex", "dataset": "a", "mb_per_s": 1.0},
+            {"backend": "regex", "dataset": "b", "mb_per_s": 3.0},
+            {"backend": "clang", "dataset": "a", "error": "libclang 未安装"},
+        ]}))
+        costs = load_costs(str(path))
+        assert costs['regex'].ms_per_kb == pytest.approx(1000 / (2.0 * 1024), abs=1e-4)
+        assert costs['regex'].startup_ms == DEFAULT_COSTS['regex'].startup_ms
+        assert costs['clang'] == DEFAULT_COSTS['clang']
+
+
+class TestBackendSelector:
+    """逐文件选择"""
+
+    def test_call_graph_uses_fast_scanner(self, registry):
+        backend, decision = BackendSelector().select(_driver(2000))
+        assert backend.name in ('native', 'regex')
+        assert decision["backend"] == backend.name
+        assert set(decision["estimates_ms"]) >= {'regex', 'tree-sitter', 'clang'}
+        assert decision["required"] == sorted(c.name for c in BASE_CAPABILITIES)
+        assert "missing" not in decision
+
+    def test_precise_outputs_use_tree_sitter(self, registry):
+        selector = BackendSelector(BASE_CAPABILITIES | {BackendCapability.PARSE_ENUMS})
+        backend, decision = selector.select(_driver(200))
+        assert backend.name == 'tree-sitter'
+        assert set(decision["estimates_ms"]) == {'tree-sitter', 'clang'}
+        selector = BackendSelector(BASE_CAPABILITIES | {BackendCapability.MACRO_EXPANSION})
+        assert selector.select(_driver(200))[0].name == 'clang'
+
+    def test_macro_density_shifts_choice(self, registry):
+        costs = dict(DEFAULT_COSTS)
+        costs['tree-sitter'] = BackendCost(startup_ms=0.0, ms_per_kb=1.0, macro_factor=8.0)
+        costs['clang'] = BackendCost(startup_ms=0.0, ms_per_kb=2.0, macro_factor=0.0)
+        selector = BackendSelector(BASE_CAPABILITIES | {BackendCapability.PARSE_ENUMS}, costs)
+        assert selector.select(_driver(500))[0].name == 'tree-sitter'
+        backend, decision = selector.select(_driver(500, macro_every=2))
+        assert backend.name == 'clang' and decision["macro_density"] > 0.4
+
+    def test_startup_counted_once(self, registry):
+        costs = {'regex': BackendCost(startup_ms=100.0, ms_per_kb=1.0)}
+        selector = BackendSelector(costs=costs)
+        _, first = selector.select('int x;\n' * 128)
+        _, second = selector.select('int x;\n' * 128)
+        assert first["estimates_ms"]["regex"] - second["estimates_ms"]["regex"] == pytest.approx(100.0)
+
+    def test_uncovered_records_missing(self, registry):
+        costs = {name: DEFAULT_COSTS[name] for name in ('regex', 'tree-sitter')}
+        selector = BackendSelector(BASE_CAPABILITIES | {BackendCapability.MACRO_EXPANSION}, costs)
+        backend, decision = selector.select(_driver(10))
+        # 覆盖能力最多的后端中选耗时最小的
+        assert backend.name == 'regex'
+        assert decision["missing"] == ['MACRO_EXPANSION']
+
+
+class TestAnalyzerAuto:
+    """UnifiedAnalyzer 的 auto 策略"""
+
+    def test_decision_in_stats(self, registry):
+        analyzer = UnifiedAnalyzer('auto')
+        result = analyzer.analyze_file(EXAMPLE)
+        selection = result["stats"]["backend_selection"]
+        assert selection["backend"] == result["backend"] in ('native', 'regex')
+        assert "select_backend" in result["stats"]["stages_ms"]
+
+    def test_needs_from_analyses_and_cli(self, registry):
+        analyzer = UnifiedAnalyzer('auto', analyses=['layout'])
+        assert BackendCapability.PARSE_UNIONS in analyzer.selector.required
+        analyzer = UnifiedAnalyzer('auto', needs={BackendCapability.PRECISE_LOCATION})
+        assert analyzer.analyze_file(EXAMPLE)["backend"] == 'tree-sitter'
+
+    def test_fixed_backend_unchanged(self):
+        result = UnifiedAnalyzer('regex').analyze_file(EXAMPLE)
+        assert result["backend"] == 'regex' and "backend_selection" not in result["stats"]
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
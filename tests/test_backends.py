@@ -6,6 +6,7 @@
 """
 
 import os
+import subprocess
 import sys
 import pytest
 
@@ -14,9 +15,11 @@ sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
 
 from backends import (
     get_backend, list_backends, is_treesitter_available,
-    RegexBackend, BackendCapability
+    RegexBackend, BackendCapability, BackendDescriptor, BackendRegistry
 )
 
+SRC_DIR = os.path.join(os.path.dirname(__file__), '..', 'src')
+
 
 # 测试用的简单驱动代码
 SIMPLE_DRIVER = '''
@@ -265,6 +268,39 @@ class TestBackendRegistry:
         """测试获取无效后端"""
         with pytest.raises(ValueError):
             get_backend('invalid-backend-name')
+    
+    def test_import_is_lazy(self):
+        """导入包和只探测依赖时不导入任何后端模块"""
+        code = (
+            f"import sys; sys.path.insert(0, {SRC_DIR!r}); import backends; "
+            "assert 'regex' in backends.list_backends(probe_only=True); "
+            "print(sorted(m for m in sys.modules "
+            "if m.endswith('_backend') or m.split('.')[0] in ('tree_sitter', 'clang')))"
+        )
+        out = subprocess.run([sys.executable, '-c', code], capture_output=True, text=True, check=True)
+        assert out.stdout.strip() == '[]'
+    
+    def test_lazy_descriptor(self, monkeypatch):
+        """依赖缺失的描述符不导入目标模块；依赖存在时 get() 才导入"""
+        missing = BackendDescriptor('missing', 'no_such_pkg.backend:Backend', ('no_such_pkg',))
+        present = BackendDescriptor('regex-alias', 'backends.regex_backend:RegexBackend')
+        monkeypatch.setitem(BackendRegistry._descriptors, 'missing', missing)
+        monkeypatch.setitem(BackendRegistry._descriptors, 'regex-alias', present)
+        monkeypatch.setattr(BackendRegistry, '_backends', dict(BackendRegistry._backends))
+        monkeypatch.setattr(BackendRegistry, '_instances', dict(BackendRegistry._instances))
+        assert not missing.dependencies_present()
+        assert not BackendRegistry.is_available('missing')
+        assert 'missing' not in BackendRegistry.list_available(probe_only=True)
+        assert 'regex-alias' in BackendRegistry.list_available(probe_only=True)
+        assert isinstance(BackendRegistry.get('regex-alias'), RegexBackend)
+    
+    def test_lazy_exports(self):
+        """具体后端类按需从包中导出"""
+        import backends
+        from backends.regex_backend import RegexBackend as direct
+        assert backends.RegexBackend is direct
+        with pytest.raises(AttributeError):
+            backends.NoSuchBackend
 
 
 class TestComplexCode:
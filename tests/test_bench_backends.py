@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""
+后端基准工具测试
+
+验证分位数、基线对比和子进程隔离（崩溃 / 超时记为错误行而不是挂起）。
+"""
+
+import os
+import sys
+import time
+import pytest
+
+# 添加 src 和 benchmarks 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'benchmarks'))
+
+from bench_backends import compare, percentile, run_isolated
+
+
+def _crash_entry(queue, backend_name, spec, repeat):
+    """模拟 native 扩展段错误：不写结果直接退出"""
+    os.abort()
+
+
+def _hang_entry(queue, backend_name, spec, repeat):
+    time.sleep(60)
+
+
+def _ok_entry(queue, backend_name, spec, repeat):
+    queue.put({"backend": backend_name, "repeat": repeat})
+
+
+def row(backend, dataset, mb_per_s, p99, rss=10.0):
+    return {"backend": backend, "dataset": dataset, "mb_per_s": mb_per_s,
+            "latency_ms": {"p50": p99 / 2, "p99": p99}, "peak_rss_mb": rss}
+
+
+class TestPercentile:
+    """最近秩法"""
+
+    @pytest.mark.parametrize("values, pct, expected", [
+        (list(range(1, 11)), 50, 5),
+        (list(range(1, 11)), 90, 9),
+        (list(range(1, 11)), 99, 10),
+        (list(range(1, 11)), 100, 10),
+        (list(range(1, 11)), 0, 1),
+        ([7.5], 50, 7.5),
+        ([7.5], 99, 7.5),
+        ([7.5], 100, 7.5),
+        ([3, 1, 2], 50, 2),
+        ([], 99, 0.0),
+    ])
+    def test_nearest_rank(self, values, pct, expected):
+        assert percentile(values, pct) == expected
+
+
+class TestCompare:
+    """与基线对比"""
+
+    def test_flags_regression(self):
+        baseline = {"results": [row("regex", "examples", 10.0, 2.0),
+                                row("native", "examples", 50.0, 1.0)]}
+        current = {"results": [row("regex", "examples", 7.0, 2.0, rss=12.5),
+                               row("native", "examples", 49.0, 1.05)]}
+        rows = {r["backend"]: r for r in compare(current, baseline, threshold=0.1)}
+        assert rows["regex"]["regression"]
+        assert rows["regex"]["mb_per_s_ratio"] == 0.7
+        assert rows["regex"]["rss_delta_mb"] == 2.5
+        assert not rows["native"]["regression"]
+
+    def test_p99_regression(self):
+        baseline = {"results": [row("regex", "examples", 10.0, 2.0)]}
+        current = {"results": [row("regex", "examples", 10.0, 3.0)]}
+        [r] = compare(current, baseline, threshold=0.1)
+        assert r["regression"] and r["p99_ratio"] == 1.5
+
+    def test_error_rows_skipped(self):
+        baseline = {"results": [row("regex", "examples", 10.0, 2.0),
+                                {"backend": "native", "dataset": "examples", "error": "x"}]}
+        current = {"results": [{"backend": "regex", "dataset": "examples", "error": "超时 (1s)"},
+                               row("native", "examples", 1.0, 9.0),
+                               row("clang", "examples", 1.0, 9.0)]}
+        assert compare(current, baseline, threshold=0.1) == []
+
+
+class TestRunIsolated:
+    """子进程隔离"""
+
+    def test_result_returned(self):
+        assert run_isolated("regex", {}, 3, entry=_ok_entry) == {"backend": "regex", "repeat": 3}
+
+    def test_crash_reported(self):
+        start = time.monotonic()
+        result = run_isolated("native", {}, 1, entry=_crash_entry)
+        assert result["backend"] == "native"
+        assert result["error"].startswith("子进程异常退出")
+        assert time.monotonic() - start < 30
+
+    def test_timeout_reported(self):
+        start = time.monotonic()
+        result = run_isolated("native", {}, 1, timeout=1, entry=_hang_entry)
+        assert result == {"backend": "native", "error": "超时 (1s)"}
+        assert time.monotonic() - start < 30
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
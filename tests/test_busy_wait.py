@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+忙等待检测测试
+"""
+
+import os
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from analysis.busy_wait import loop_iterations
+from analysis.metrics import scan_body
+from helpers import run_analysis
+
+
+SOURCE = """
+static int nic_wait_ready(struct nic_priv *priv)
+{
+    int timeout = 1000;
+
+    while (--timeout && !(readl(priv->base + 0x4) & BIT(1)))
+        udelay(10);
+    return timeout ? 0 : -ETIMEDOUT;
+}
+
+static void nic_reset_phy(struct nic_priv *priv)
+{
+    u32 val;
+
+    mdelay(5);
+    while (!(readl(priv->base) & BIT(0)))
+        ;
+    readl_poll_timeout_atomic(priv->base + 0x8, val, val & 1, 1, 500);
+    readl_poll_timeout(priv->base + 0x8, val, val & 1, 10, 0);
+    for (int i = 0; i < 4; i++)
+        udelay(2);
+}
+
+static irqreturn_t nic_isr(int irq, void *data)
+{
+    struct nic_priv *priv = data;
+    nic_wait_ready(priv);
+    nic_reset_phy(priv);
+    return IRQ_HANDLED;
+}
+
+static void nic_work(struct work_struct *w)
+{
+    mdelay(100);
+}
+
+static int nic_probe(struct pci_dev *pdev)
+{
+    INIT_WORK(&priv->work, nic_work);
+    request_irq(pdev->irq, nic_isr, 0, "nic", priv);
+    return 0;
+}
+"""
+
+
+@pytest.fixture
+def result(tmp_path):
+    return run_analysis(tmp_path, SOURCE, "busy-wait")
+
+
+def finding(result, func, line):
+    return next(f for f in result["findings"] if f["func"] == func and f["line"] == line)
+
+
+class TestBusyWait:
+    """不可睡眠入口可达的忙等待"""
+
+    def test_counted_polling_loop(self, result):
+        f = finding(result, "nic_wait_ready", 6)
+        assert f["kind"] == "polling_loop"
+        assert f["iterations"] == 1000 and f["bounded"]
+        assert f["worst_case_us"] == 10000
+        assert f["reached_from"][0]["path"] == ["nic_isr", "nic_wait_ready", "readl"]
+
+    def test_unbounded_polling_loop(self, result):
+        f = finding(result, "nic_reset_phy", 16)
+        assert f["kind"] == "polling_loop"
+        assert not f["bounded"] and f["severity"] == "high"
+
+    def test_mdelay(self, result):
+        f = finding(result, "nic_reset_phy", 15)
+        assert (f["kind"], f["worst_case_us"]) == ("delay", 5000)
+
+    def test_poll_macros(self, result):
+        atomic = finding(result, "nic_reset_phy", 18)
+        assert (atomic["kind"], atomic["worst_case_us"]) == ("poll_atomic", 500)
+        sleeping = finding(result, "nic_reset_phy", 19)
+        # timeout_us 为 0 表示不超时
+        assert sleeping["kind"] == "poll_sleeping" and not sleeping["bounded"]
+
+    def test_delay_in_counted_loop(self, result):
+        f = finding(result, "nic_reset_phy", 21)
+        assert f["worst_case_us"] == 8 and f["severity"] == "low"
+
+    def test_process_context_ignored(self, result):
+        assert "irq:nic_isr" in result["entries"]
+        assert not any(f["func"] == "nic_work" for f in result["findings"])
+        assert result["summary"]["findings"] == 6
+
+
+class TestLoopIterations:
+    """常量计数循环的迭代次数"""
+
+    @pytest.mark.parametrize("body, expected", [
+        ("{ for (i = 0; i < 16; i++) x(); }", 16),
+        ("{ for (i = 1; i <= 16; i++) x(); }", 16),
+        ("{ n = 50; while (n--) x(); }", 50),
+        ("{ while (readl(r)) x(); }", None),
+        ("{ for (i = 0; i < n; i++) x(); }", None),
+    ])
+    def test_iterations(self, body, expected):
+        metrics = scan_body(body)
+        assert loop_iterations(body, metrics.loops[0]) == expected
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""
+libclang 后端测试
+
+编译数据库读取和选项过滤不依赖 libclang，总是运行；
+解析相关测试在 libclang 不可用时跳过。
+"""
+
+import json
+import os
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from backends import BackendCapability, is_clang_available
+from backends.clang_backend import (
+    CompileDatabase, filter_arguments, find_compile_database, leading_includes, _db_cache
+)
+
+
+SOURCE = '''
+typedef unsigned int u32;
+struct device;
+
+struct nic_stats {
+    u32 packets;
+    u32 errors : 4;
+};
+
+struct nic_priv {
+    struct device *dev;
+    struct nic_stats stats;
+    u32 ring[16];
+    int (*poll)(struct nic_priv *priv, int budget);
+    union {
+        u32 raw;
+        struct { u32 lo : 16; u32 hi : 16; } parts;
+    };
+};
+
+typedef struct {
+    int value;
+} simple_t;
+
+enum nic_state { NIC_DOWN, NIC_UP = 4 };
+
+#define nic_read(p, r) nic_io((p), (r))
+
+static u32 nic_io(struct nic_priv *priv, u32 reg)
+{
+    return priv->ring[reg];
+}
+
+static int nic_poll(struct nic_priv *priv, int budget)
+{
+    int done = 0;
+    while (done < budget && nic_read(priv, done))
+        done++;
+    return done;
+}
+
+struct nic_ops { int (*poll)(struct nic_priv *priv, int budget); };
+
+static const struct nic_ops ops = {
+    .poll = nic_poll,
+};
+'''
+
+
+class TestCompileDatabase:
+    """compile_commands.json 读取（纯 Python）"""
+
+    def test_filter_arguments(self):
+        argv = ['gcc', '-Wp,-MMD,foo.d', '-nostdinc', '-I./include', '-I', 'arch/x86/include',
+                '-isystem', '/usr/lib/gcc/include', '-include', './include/linux/kconfig.h',
+                '-D__KERNEL__', '-DKBUILD_MODNAME="nic"', '-std=gnu11', '-fno-strict-aliasing',
+                '-mno-red-zone', '-O2', '-c', '-o', 'nic.o', 'drivers/net/nic.c']
+        args = filter_arguments(argv, '/src/linux')
+        assert args == ['-nostdinc', '-I/src/linux/include', '-I', '/src/linux/arch/x86/include',
+                        '-isystem', '/usr/lib/gcc/include',
+                        '-include', '/src/linux/include/linux/kconfig.h',
+                        '-D__KERNEL__', '-DKBUILD_MODNAME="nic"', '-std=gnu11']
+
+    def test_load_and_lookup(self, tmp_path):
+        db_path = tmp_path / 'compile_commands.json'
+        db_path.write_text(json.dumps([
+            {"directory": str(tmp_path), "file": "a.c",
+             "command": "cc -Iinc -DA=1 -c a.c -o a.o"},
+            {"directory": str(tmp_path), "file": str(tmp_path / 'b.c'),
+             "arguments": ["cc", "-DB", "-c", "b.c"]},
+        ]))
+        db = CompileDatabase(str(tmp_path))
+        assert len(db) == 2
+        assert db.args_for(str(tmp_path / 'a.c')) == [f'-I{tmp_path}/inc', '-DA=1']
+        assert db.args_for(str(tmp_path / 'b.c')) == ['-DB']
+        assert db.args_for(str(tmp_path / 'c.c')) is None
+
+    def test_find_upwards_and_env_override(self, tmp_path, monkeypatch):
+        (tmp_path / 'compile_commands.json').write_text(json.dumps([
+            {"directory": str(tmp_path), "file": "drivers/x.c", "arguments": ["cc", "-DX"]},
+        ]))
+        (tmp_path / 'drivers').mkdir()
+        monkeypatch.delenv('LDA_COMPILE_COMMANDS', raising=False)
+        _db_cache.clear()
+        db = find_compile_database(str(tmp_path / 'drivers' / 'x.c'))
+        assert db is not None and db.args_for(str(tmp_path / 'drivers' / 'x.c')) == ['-DX']
+
+        other = tmp_path / 'other'
+        other.mkdir()
+        (other / 'compile_commands.json').write_text('[]')
+        monkeypatch.setenv('LDA_COMPILE_COMMANDS', str(other))
+        _db_cache.clear()
+        assert len(find_compile_database(str(tmp_path / 'drivers' / 'x.c'))) == 0
+        _db_cache.clear()
+
+    def test_leading_includes(self):
+        source = ('// SPDX-License-Identifier: GPL-2.0\n/*\n * nic\n */\n'
+                  '#include <linux/module.h>\n#include <linux/pci.h>  /* pci */\n\n'
+                  '#include "nic.h"\n#include <linux/io.h>\n')
+        # 引号 include 之后的不计入（相对路径依赖源文件目录，不能放进共享 PCH）
+        assert leading_includes(source) == ['#include <linux/module.h>', '#include <linux/pci.h>']
+        assert leading_includes('static int x;\n#include <linux/io.h>\n') == []
+
+
+@pytest.mark.skipif(not is_clang_available(), reason="libclang 未安装")
+class TestClangBackend:
+    """ClangBackend 解析"""
+
+    @pytest.fixture
+    def backend(self):
+        from backends import ClangBackend
+        return ClangBackend()
+
+    @pytest.fixture
+    def result(self, backend, tmp_path):
+        return backend.parse(SOURCE, str(tmp_path / 'nic.c'))
+
+    def test_capabilities(self, backend):
+        caps = backend.capabilities()
+        for cap in (BackendCapability.TYPE_INFERENCE, BackendCapability.MACRO_EXPANSION,
+                    BackendCapability.CROSS_FILE, BackendCapability.INCREMENTAL):
+            assert cap in caps
+
+    def test_functions_and_calls(self, result):
+        poll = result.functions['nic_poll']
+        # 宏调用本身和展开后的调用都记录
+        assert {'nic_read', 'nic_io'} <= set(poll.calls)
+        assert 'nic_poll' in result.functions['nic_io'].called_by
+        assert poll.params[0].type_name == 'struct nic_priv *'
+        assert poll.is_callback and poll.callback_context == 'nic_ops.poll'
+        assert poll.body.startswith('{') and 'budget' in poll.body
+
+    def test_struct_fields(self, result):
+        priv = {f.name: f for f in result.structs['nic_priv'].fields}
+        assert priv['dev'].is_pointer and priv['dev'].type_name == 'struct device *'
+        assert priv['ring'].array_size == '16' and priv['ring'].type_name == 'u32'
+        assert priv['poll'].is_function_ptr
+        # 匿名 union 成员，内嵌带声明符的 struct
+        anonymous = priv['']
+        assert anonymous.type_name == 'union'
+        parts = {m.name: m for m in anonymous.members}['parts']
+        assert [m.bit_width for m in parts.members] == [16, 16]
+        assert result.structs['nic_stats'].fields[1].bit_width == 4
+
+    def test_typedef_enum(self, result):
+        assert 'simple_t' in result.structs and result.structs['simple_t'].typedef_name == 'simple_t'
+        assert result.typedefs['u32'].original == 'unsigned int'
+        values = [(v.name, v.value) for v in result.enums['nic_state'].values]
+        assert values == [('NIC_DOWN', None), ('NIC_UP', '4')]
+
+    def test_reparse_reuses_tu(self, backend, tmp_path):
+        path = str(tmp_path / 'nic.c')
+        backend.parse(SOURCE, path)
+        result = backend.parse(SOURCE.replace('done++;', 'done += 2;'), path)
+        assert backend.stats['reparsed'] == 1
+        assert 'done += 2' in result.functions['nic_poll'].body
+
+    def test_header_structs(self, backend, tmp_path):
+        (tmp_path / 'nic.h').write_text('struct nic_desc { unsigned int addr; unsigned int len; };\n')
+        result = backend.parse('#include "nic.h"\nint f(struct nic_desc *d) { return d->len; }\n',
+                               str(tmp_path / 'nic.c'))
+        assert [f.name for f in result.structs['nic_desc'].fields] == ['addr', 'len']
+
+    def test_consistent_with_regex(self, result):
+        from backends import RegexBackend
+        regex = RegexBackend().parse(SOURCE)
+        assert {'nic_io', 'nic_poll'} <= set(regex.functions) & set(result.functions)
+        assert {'nic_priv', 'nic_stats'} <= set(regex.structs) & set(result.structs)
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
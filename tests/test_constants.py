@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+"""
+命名常量测试（常量表达式求值、枚举常量表、#define 宏常量、enums / defines 分析）
+"""
+
+import os
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from backends import EnumDef, EnumValue, RegexBackend
+from backends.headers import harvest
+from backends.regex_backend import extract_defines
+from analysis import (AnalysisContext, ConstantTable, eval_int, project_constants, resolve_offset,
+                      run_analyses)
+from core.analyzer import UnifiedAnalyzer
+
+SOURCE = '''
+enum ctrl_bits {
+    CTRL_EN = BIT(0),
+    CTRL_RST = BIT(1),
+    CTRL_IRQ = 1 << 4,
+};
+
+enum dev_state {
+    ST_IDLE,
+    ST_RUN = 5,
+    ST_DONE,
+    ST_MASK = ST_RUN + GENMASK(3, 0),
+    ST_EXT = EXT_BASE,
+    ST_NEXT,
+};
+
+static int demo(void) { return ST_IDLE; }
+'''
+
+
+def _enum(name, *items):
+    return EnumDef(name=name, values=[EnumValue(n, v) for n, v in items])
+
+
+class TestEvalInt:
+    """常量表达式求值"""
+
+    def test_bit_macros(self):
+        assert eval_int("GENMASK(7, 4) | BIT(0)") == 0xf1
+        assert eval_int("BIT_ULL(40)") == 1 << 40
+        assert eval_int("GENMASK_ULL(63, 32)") == 0xffffffff00000000
+        assert eval_int("_BITUL(3) | _UL(1) << 8") == 0x108
+        assert eval_int("BIT(SHIFT)", {"SHIFT": 5}) == 32
+
+    def test_fast_paths(self):
+        assert eval_int("0x10UL") == 16
+        assert eval_int("0755") == 0o755
+        assert eval_int(" 0 ") == 0
+        assert eval_int("PREV", {"PREV": 9}) == 9
+        assert eval_int("PREV") is None
+
+    @pytest.mark.parametrize("expr, value", [
+        ("~0U", 0xffffffff),
+        ("~0UL", 0xffffffffffffffff),
+        ("(u32)~0", 0xffffffff),
+        ("(unsigned long)-1", 0xffffffffffffffff),
+        ("-1U", 0xffffffff),
+        ("~BIT(3)", 0xfffffffffffffff7),
+        ("~(u32)BIT(0)", 0xfffffffe),
+        ("1U << 31", 0x80000000),
+        ("1 << 31", -0x80000000),
+        ("(u8)0x1ff + 1", 0x100),
+        ("(s8)0xff", -1),
+        ("-1 / 2U", 0x7fffffff),
+        ("~0", -1),
+        ("~MASK", 0),
+    ])
+    def test_unsigned_semantics(self, expr, value):
+        # 名字的值按十六进制字面量定类型：0xffffffff 是 unsigned int
+        assert eval_int(expr, {"MASK": 0xffffffff}) == value
+
+    def test_invalid(self):
+        assert eval_int("GENMASK(2, 5)") is None
+        assert eval_int("BIT(200)") is None
+        assert eval_int("1 << 32") is None           # 移位数超出 int 位宽
+        assert eval_int("BIT") is None
+        assert eval_int("BIT(2) + UNKNOWN") is None
+        assert eval_int("foo(1)") is None
+
+
+class TestConstantTable:
+    """枚举常量表和反查索引"""
+
+    def test_implicit_and_references(self):
+        table = ConstantTable()
+        values = table.add_enum(_enum('st', ('A', None), ('B', '5'), ('C', None),
+                                      ('D', 'B + GENMASK(3, 0)'), ('E', 'MISSING'), ('F', None)))
+        assert values == [('A', 0), ('B', 5), ('C', 6), ('D', 20), ('E', None), ('F', None)]
+        assert table.unresolved == {'E': 'MISSING', 'F': 'E + 1'}
+        assert len(table) == 4 and 'D' in table and 'E' not in table
+
+    def test_reverse_index(self):
+        table = ConstantTable()
+        table.add_enum(_enum('a', ('A0', None), ('A1', None)))
+        table.add_enum(_enum('b', ('B1', '1'), ('B_ALIAS', 'B1')))
+        assert table.names_for(1) == ['A1', 'B1', 'B_ALIAS']
+        assert table.names_for(1, 'b') == ['B1', 'B_ALIAS']
+        assert table.name_for(1, 'a') == 'A1'
+        assert table.name_for(7) is None
+
+    def test_unsigned_masks_reverse_lookup(self):
+        table = ConstantTable()
+        table.add_macros({"ALL_U32": "~0U", "ALL": "(u32)~0", "NOT_EN": "~BIT(0)", "EN": "BIT(0)"})
+        assert table.names_for(0xffffffff) == ["ALL_U32", "ALL"]
+        assert table.decode_flags(table.get("EN") | 0x20, "#define") == (["EN"], 0x20)
+        assert table.get("NOT_EN") == 0xfffffffffffffffe
+
+    def test_decode_flags(self):
+        table = ConstantTable()
+        table.add_enum(_enum('ctrl', ('EN', 'BIT(0)'), ('RST', 'BIT(1)'), ('IRQ', 'BIT(4)'),
+                             ('BOTH', 'EN | RST')))
+        assert table.decode_flags(0x13, 'ctrl') == (['EN', 'RST', 'IRQ'], 0)
+        assert table.decode_flags(0x21, 'ctrl') == (['EN'], 0x20)
+
+    def test_parent_memo(self):
+        project = ConstantTable()
+        project.add_enum(_enum('hw', ('HW_BASE', '0x100'), ('HW_NEXT', None)))
+        local = ConstantTable(project)
+        # 已在项目表中的常量不再求值，也不重复加入本表
+        values = local.add_enum(_enum('hw', ('HW_BASE', 'BROKEN'), ('HW_NEXT', None)))
+        assert values == [('HW_BASE', 0x100), ('HW_NEXT', 0x101)] and len(local) == 0
+        local.add_enum(_enum('mine', ('MINE', 'HW_NEXT + 1')))
+        assert local.get('MINE') == 0x102 and project.get('MINE') is None
+        assert local.names_for(0x100) == ['HW_BASE']
+
+
+DEFINES = r'''
+#define REG_CTRL        0x04    /* 控制 */
+ #  define REG_STAT      (REG_CTRL + 4)  // 状态
+#define REG_TAIL        REG_BASE + \
+                        8
+#define REG_BASE        0x100UL
+#define REG_CTRL        0x99
+#define REG_Q(n)        (0x200 + (n) * 4)
+#define CTRL_EN         BIT(0)
+#define LOOP_A          LOOP_B
+#define LOOP_B          LOOP_A
+#define DRV_NAME        "demo"
+#define CONFIG_DEMO
+'''
+
+
+class TestMacros:
+    """#define 宏常量的提取和求值"""
+
+    def test_extract_defines(self):
+        macros = extract_defines(DEFINES)
+        assert macros["REG_CTRL"] == "0x04"          # 先出现的为准
+        assert macros["REG_STAT"] == "(REG_CTRL + 4)"
+        assert macros["REG_TAIL"] == "REG_BASE + 8"
+        assert macros["CONFIG_DEMO"] == "" and 'REG_Q' not in macros
+
+    def test_forward_references_and_cycles(self):
+        table = ConstantTable()
+        assert table.add_macros(extract_defines(DEFINES)) == 5
+        assert table.get("REG_TAIL") == 0x108 and table.get("REG_STAT") == 8
+        assert table.get("CTRL_EN") == 1
+        assert set(table.unresolved) == {"LOOP_A", "LOOP_B", "DRV_NAME"}
+        assert table.names_for(0x108, "#define") == ["REG_TAIL"]
+
+    def test_macros_and_enums(self):
+        table = ConstantTable()
+        table.add_macros({"EXT_BASE": "0x40"})
+        table.add_enum(_enum('e', ('E0', 'EXT_BASE'), ('E1', None)))
+        assert table.get("E1") == 0x41
+        # 宏可以引用父表中的枚举常量
+        local = ConstantTable(table)
+        local.add_macros({"REG": "E1 << 4"})
+        assert local.get("REG") == 0x410 and local.names_for(0x40) == ["EXT_BASE", "E0"]
+
+    def test_resolve_offset(self):
+        table = ConstantTable()
+        table.add_macros(extract_defines(DEFINES))
+        assert resolve_offset(table, "priv->base + REG_CTRL") == ("priv->base", 4, ["REG_CTRL"])
+        assert resolve_offset(table, "(base + REG_BASE + 0x10)") == ("base", 0x110, ["REG_BASE"])
+        assert resolve_offset(table, "ioaddr + REG_Q(i)") == ("ioaddr + REG_Q(i)", None, [])
+        assert resolve_offset(table, "0x3f8") == ("", 0x3f8, [])
+
+
+class TestEnumPass:
+    """enums 分析"""
+
+    def test_regex_fallback(self, tmp_path):
+        path = tmp_path / 'demo.c'
+        path.write_text(SOURCE)
+        result = UnifiedAnalyzer('regex', analyses=['enums']).analyze_file(str(path))
+        enums = result["analyses"]["enums"]
+        ctrl = enums["enums"]["ctrl_bits"]
+        assert ctrl["values"] == {"CTRL_EN": 1, "CTRL_RST": 2, "CTRL_IRQ": 16}
+        assert ctrl["flags"] and ctrl["by_value"]["16"] == ["CTRL_IRQ"]
+        state = enums["enums"]["dev_state"]
+        assert state["values"]["ST_MASK"] == 20 and state["unresolved"] == ["ST_EXT", "ST_NEXT"]
+        assert not state["flags"]
+        assert enums["summary"] == {"enums": 2, "constants": 9, "unresolved": 2, "project_constants": 0}
+
+    def test_header_constants(self, tmp_path):
+        (tmp_path / 'regs.h').write_text('enum ext { EXT_BASE = 0x40, EXT_END };\n')
+        headers = harvest([str(tmp_path / 'regs.h')], 'regex')
+        ctx = AnalysisContext(RegexBackend().parse(SOURCE), SOURCE, options={"headers": headers})
+        enums = run_analyses(['enums'], ctx)['enums']
+        assert enums["enums"]["dev_state"]["values"]["ST_NEXT"] == 0x41
+        assert enums["summary"]["unresolved"] == 0 and enums["summary"]["project_constants"] == 2
+        # 同一个 headers 的项目表只构建一次
+        assert project_constants(headers) is project_constants(headers)
+
+
+class TestDefinePass:
+    """defines 分析"""
+
+    def test_values_and_index(self, tmp_path):
+        path = tmp_path / 'regs.c'
+        path.write_text(DEFINES + SOURCE)
+        defines = UnifiedAnalyzer('regex', analyses=['defines']).analyze_file(str(path))["analyses"]["defines"]
+        assert defines["values"]["REG_TAIL"] == 0x108
+        assert defines["by_value"]["4"] == ["REG_CTRL"]
+        assert defines["unresolved"]["DRV_NAME"] == '"demo"'
+        assert defines["summary"] == {"defines": 9, "constants": 5, "unresolved": 3, "empty": 1,
+                                      "project_constants": 0}
+
+    def test_header_macros(self, tmp_path):
+        (tmp_path / 'regs.h').write_text('#define EXT_BASE 0x40\n#define REG_BASE 0x1000\n')
+        headers = harvest([str(tmp_path / 'regs.h')], 'regex')
+        assert headers.macros == {"EXT_BASE": "0x40", "REG_BASE": "0x1000"}
+        assert headers.origins["define EXT_BASE"].endswith('regs.h')
+        source = DEFINES + SOURCE
+        ctx = AnalysisContext(RegexBackend().parse(source), source, options={"headers": headers})
+        result = run_analyses(['defines', 'enums'], ctx)
+        # 头文件中先定义的 REG_BASE 优先；宏常量也用于枚举求值
+        assert result['defines']["values"]["REG_TAIL"] == 0x1008
+        assert result['enums']["enums"]["dev_state"]["values"]["ST_EXT"] == 0x40
+        assert result['defines']["summary"]["project_constants"] == 2
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
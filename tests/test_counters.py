@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""
+计数器热点测试
+"""
+
+import os
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from helpers import run_analysis
+
+
+SOURCE = """
+struct nic_priv {
+    struct net_device *dev;
+    atomic_t tx_inflight;
+    unsigned long last_rx;
+    struct pcpu_sw_netstats __percpu *tstats;
+    refcount_t refs;
+};
+
+static atomic_t global_drops;
+static unsigned long total_irqs;
+
+static void nic_rx_one(struct nic_priv *priv, struct sk_buff *skb)
+{
+    struct pcpu_sw_netstats *tstats = this_cpu_ptr(priv->tstats);
+    u64_stats_update_begin(&tstats->syncp);
+    u64_stats_inc(&tstats->rx_packets);
+    u64_stats_update_end(&tstats->syncp);
+    priv->last_rx = jiffies;
+}
+
+static int nic_poll(struct napi_struct *napi, int budget)
+{
+    struct nic_priv *priv = container_of(napi, struct nic_priv, napi);
+    nic_rx_one(priv, NULL);
+    return 0;
+}
+
+static netdev_tx_t nic_xmit(struct sk_buff *skb, struct net_device *dev)
+{
+    struct nic_priv *priv = netdev_priv(dev);
+    dev->stats.tx_packets++;
+    dev->stats.tx_bytes += skb->len;
+    atomic_inc(&priv->tx_inflight);
+    refcount_inc(&priv->refs);
+    this_cpu_inc(priv->xmit_calls);
+    return NETDEV_TX_OK;
+}
+
+static irqreturn_t nic_isr(int irq, void *data)
+{
+    struct nic_priv *priv = data;
+    total_irqs++;
+    atomic_inc(&global_drops);
+    atomic_dec(&priv->tx_inflight);
+    return IRQ_HANDLED;
+}
+
+static void nic_reset_stats(struct nic_priv *priv)
+{
+    atomic_set(&priv->tx_inflight, 0);
+    total_irqs = 0;
+}
+
+static int nic_probe(struct pci_dev *pdev)
+{
+    struct nic_priv *priv;
+    netif_napi_add(priv->dev, &priv->napi, nic_poll);
+    request_irq(pdev->irq, nic_isr, 0, "nic", priv);
+    return 0;
+}
+
+static const struct net_device_ops nic_ops = {
+    .ndo_start_xmit = nic_xmit,
+};
+"""
+
+
+@pytest.fixture
+def result(tmp_path):
+    return run_analysis(tmp_path, SOURCE, "counters")
+
+
+def counter(result, target):
+    return next(r for r in result["counters"] if r["target"] == target)
+
+
+class TestClassification:
+    """共享原子 / 普通共享写 / per-CPU"""
+
+    @pytest.mark.parametrize("target, cls", [
+        ("global_drops", "shared_atomic"),
+        ("nic_priv.tx_inflight", "shared_atomic"),
+        ("net_device.stats.tx_packets", "plain_shared"),
+        ("net_device.stats.tx_bytes", "plain_shared"),
+        ("total_irqs", "plain_shared"),
+        ("nic_priv.last_rx", "plain_shared"),
+        ("pcpu_sw_netstats.rx_packets", "per_cpu"),
+        ("nic_priv.xmit_calls", "per_cpu"),
+    ])
+    def test_class(self, result, target, cls):
+        assert counter(result, target)["class"] == cls
+
+    def test_refcount_and_atomic_set_are_not_counters(self, result):
+        targets = {r["target"] for r in result["counters"]}
+        assert "nic_priv.refs" not in targets
+        assert [s["func"] for s in counter(result, "nic_priv.tx_inflight")["sites"]] == \
+            ["nic_xmit", "nic_isr"]
+
+    def test_stat_names(self, result):
+        assert counter(result, "net_device.stats.tx_packets")["stat"]
+        assert not counter(result, "nic_priv.last_rx")["stat"]
+
+
+class TestRanking:
+    """共享计数按到热入口的距离排序"""
+
+    def test_distance(self, result):
+        assert counter(result, "nic_priv.tx_inflight")["distance"] == 0
+        assert counter(result, "nic_priv.last_rx")["distance"] == 1
+        assert counter(result, "nic_priv.last_rx")["hot_entries"] == ["napi:nic_poll"]
+
+    def test_multi_context(self, result):
+        record = counter(result, "nic_priv.tx_inflight")
+        assert record["multi_context"]
+        assert sorted(record["hot_entries"]) == ["irq:nic_isr", "net_device_ops.ndo_start_xmit"]
+
+    def test_order(self, result):
+        classes = [r["class"] for r in result["counters"]]
+        # 共享的在前，per-CPU 在最后
+        assert classes.index("per_cpu") > max(i for i, c in enumerate(classes) if c != "per_cpu")
+        # 不在热路径上的共享写（nic_reset_stats 中的 total_irqs = 0 与 total_irqs++ 合并）排在候选之后
+        assert result["candidates"][-1] == "nic_priv.last_rx"
+        assert result["summary"]["candidates"] == 6
+
+    def test_global_write_sites(self, result):
+        ops = [(s["func"], s["op"]) for s in counter(result, "total_irqs")["sites"]]
+        assert ops == [("nic_isr", "rmw"), ("nic_reset_stats", "write")]
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""
+临界区范围分析测试
+"""
+
+import os
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from analysis import AnalysisContext
+from analysis.locks import find_regions, find_regions_syntax, lock_regions
+from analysis.metrics import scan_body
+from backends import RegexBackend, is_treesitter_available
+from helpers import run_analysis
+
+
+SOURCE = """
+static void nic_drain(struct nic_priv *priv)
+{
+    int i;
+    for (i = 0; i < 64; i++)
+        priv->ring[i] = readl(priv->base + 0x10);
+}
+
+static void nic_tx(struct nic_priv *priv)
+{
+    unsigned long flags;
+
+    spin_lock_irqsave(&priv->lock, flags);
+    if (priv->dead) {
+        spin_unlock_irqrestore(&priv->lock, flags);
+        return;
+    }
+    while (!(readl(priv->base) & BIT(0)))
+        cpu_relax();
+    nic_drain(priv);
+    spin_unlock_irqrestore(&priv->lock, flags);
+
+    spin_lock_bh(&priv->stats_lock);
+    priv->packets++;
+    spin_unlock_bh(&priv->stats_lock);
+
+    mutex_lock(&priv->cfg);
+    nic_apply(priv);
+    mutex_unlock(&priv->cfg);
+}
+"""
+
+GOTO_BODY = """{
+    spin_lock(&priv->lock);
+    if (priv->dead)
+        goto out_unlock;
+    priv->count++;
+    spin_unlock(&priv->lock);
+    nic_slow_work(priv);
+    return 0;
+out_unlock:
+    spin_unlock(&priv->lock);
+    return -ENODEV;
+}"""
+
+
+@pytest.fixture
+def result(tmp_path):
+    return run_analysis(tmp_path, SOURCE, "critical-sections")
+
+
+def region(result, lock_call):
+    return next(r for r in result["regions"] if r["lock_call"] == lock_call)
+
+
+class TestCriticalSections:
+    """加锁区间的范围、调用和循环"""
+
+    def test_irqsave_region(self, result):
+        r = region(result, "spin_lock_irqsave")
+        assert (r["line"], r["end_line"]) == (13, 21)
+        assert r["irqs_off"] and r["severity"] == "high"
+        # 提前解锁的路径不结束临界区
+        assert r["unlocks"] == 2
+        assert r["calls"] == ["readl", "cpu_relax", "nic_drain"]
+
+    def test_transitive_callees_and_loops(self, result):
+        r = region(result, "spin_lock_irqsave")
+        assert r["callees"] == ["nic_drain"]
+        assert [(l["kind"], l["empty"]) for l in r["loops"]] == [("while", False)]
+        assert r["callee_loops"] == 1
+        assert r["mmio_reads"] == 2
+        # readl 在循环内: 10*8 + cpu_relax 2*8 + nic_drain (1 + 10*8)
+        assert r["cost"] == 177
+
+    def test_ranking(self, result):
+        assert result["regions"][0]["lock_call"] == "spin_lock_irqsave"
+        assert result["summary"]["regions"] == 3
+        assert result["summary"]["irqs_off"] == 1
+
+    def test_sleeping_lock_not_atomic(self, result):
+        r = region(result, "mutex_lock")
+        assert r["kind"] == "mutex" and not r["atomic"]
+        assert r["severity"] == "low"
+
+    def test_short_bh_region(self, result):
+        r = region(result, "spin_lock_bh")
+        assert r["call_sites"] == 0 and r["cost"] == 0
+        assert not r["irqs_off"]
+
+
+class TestPairing:
+    """加锁/解锁配对"""
+
+    def test_text_pairing_extends_to_last_unlock(self):
+        regions = find_regions("f", scan_body(GOTO_BODY))
+        assert len(regions) == 1
+        assert regions[0].pairing == "text"
+        assert regions[0].end_line == 10
+
+    def test_lock_regions_uses_available_pairing(self):
+        source = "int f(struct nic_priv *priv)\n" + GOTO_BODY + "\n"
+        parsed = RegexBackend().parse(source)
+        ctx = AnalysisContext(parsed, source)
+        [r] = lock_regions(ctx)["f"]
+        assert r.pairing == ("syntax" if is_treesitter_available() else "text")
+
+    @pytest.mark.skipif(not is_treesitter_available(), reason="tree-sitter 未安装")
+    def test_syntax_pairing_goto_exit(self):
+        regions = find_regions_syntax("f", GOTO_BODY, scan_body(GOTO_BODY))
+        assert len(regions) == 1
+        # 临界区在同一代码块中的第一个解锁处结束，不包含 nic_slow_work
+        assert regions[0].end_line == 6
+        assert "nic_slow_work" not in [c.name for c in regions[0].calls]
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+"""
+头文件快速路径测试（parse_declarations / 枚举提取 / harvest / 布局回退）
+"""
+
+import json
+import os
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from backends import AnalyzerBackend, BackendRegistry, RegexBackend, is_native_available
+from backends.headers import find_headers, harvest
+from backends.regex_backend import skip_bodies
+from analysis import LayoutEngine
+from core.analyzer import UnifiedAnalyzer
+
+HEADER = '''
+#define WRAP(x) { x }
+#define OPEN {
+struct ring {
+    u32 head;
+    u32 tail;
+} __packed;
+
+typedef struct {
+    u16 id;
+    union { u8 raw[4]; u32 word; };
+} ring_desc_t;
+
+static inline int ring_empty(const struct ring *r)
+{
+    struct local { int x; };
+    if (r->head == r->tail) { return '}' == 0; }
+    return "{" != 0;
+}
+
+static const int table[] = { 1, 2, 3 };
+
+enum ring_state {
+    RING_IDLE,
+    RING_BUSY = 4,
+    RING_MASK = FIELD(0x3, 2),
+#ifdef CONFIG_RING_DEBUG
+    RING_DEBUG,
+#endif
+    RING_LAST
+};
+
+typedef enum { MODE_A = 1 << 0, MODE_B } ring_mode_t;
+
+enum { ANON_X = 7 };
+'''
+
+
+def _line_of(source: str, needle: str) -> int:
+    return source[:source.index(needle)].count('\n') + 1
+
+
+class TestSkipBodies:
+    """函数体 / 初始化器快进"""
+
+    def test_bodies_and_initializers_removed(self):
+        skipped = skip_bodies(RegexBackend()._remove_comments(HEADER))
+        assert 'struct local' not in skipped and 'r->head' not in skipped
+        assert '1, 2, 3' not in skipped
+        assert 'u32 tail;' in skipped and 'RING_BUSY = 4' in skipped
+        assert 'WRAP' not in skipped
+        # 行号不变
+        assert skipped.count('\n') == HEADER.count('\n')
+
+    def test_attribute_braces_kept(self):
+        source = 'struct __attribute__((packed)) a { int x; };\nint f(void) { struct b { int y; }; }\n'
+        skipped = skip_bodies(source)
+        assert 'int x;' in skipped and 'struct b' not in skipped
+
+    def test_extern_c_and_unclosed(self):
+        skipped = skip_bodies('extern "C" {\nint f(void) { return 1; }\nstruct s { int a; };\n}\n'
+                              'int g(void) { {\n')
+        assert 'return 1' not in skipped and 'int a;' in skipped
+        assert skipped.count('\n') == 5
+
+
+class TestParseDeclarations:
+    """regex 后端的头文件模式"""
+
+    def test_types_without_functions(self):
+        result = RegexBackend().parse_declarations(HEADER)
+        assert result.functions == {} and result.calls == []
+        assert set(result.structs) == {'ring', 'ring_desc_t'}
+        assert 'local' not in result.structs
+        assert result.structs['ring'].attributes == ['packed']
+        assert [f.name for f in result.structs['ring_desc_t'].fields] == ['id', '']
+
+    def test_enums(self):
+        result = RegexBackend().parse_declarations(HEADER)
+        state = result.enums['ring_state']
+        assert [(v.name, v.value) for v in state.values] == [
+            ('RING_IDLE', None), ('RING_BUSY', '4'), ('RING_MASK', 'FIELD(0x3, 2)'),
+            ('RING_DEBUG', None), ('RING_LAST', None)]
+        assert state.values[1].location.line == _line_of(HEADER, 'RING_BUSY')
+        assert state.location.line == _line_of(HEADER, 'enum ring_state')
+        mode = result.enums['ring_mode_t']
+        assert mode.typedef_name == 'ring_mode_t'
+        assert [v.value for v in mode.values] == ['1 << 0', None]
+        anon = f"anonymous_enum_{_line_of(HEADER, 'enum { ANON_X') - 1}"
+        assert result.enums[anon].values[0].value == '7'
+
+    def test_default_implementation(self):
+        class FullOnly(RegexBackend):
+            parse_declarations = AnalyzerBackend.parse_declarations
+
+        result = FullOnly().parse_declarations(HEADER)
+        assert result.functions == {} and 'ring' in result.structs
+
+    def test_pathological_function_heads(self):
+        # 大段注释后接函数：完整解析的函数头正则会严重回溯，头文件模式根本不做函数提取
+        source = ('/*' + ' x' * 5000 + '*/\n' + 'int a;\n' * 200) * 20 + HEADER
+        result = RegexBackend().parse_declarations(source)
+        assert 'ring' in result.structs
+
+    @pytest.mark.skipif(not is_native_available(), reason="native 扩展未编译（make native）")
+    def test_native_matches_regex(self):
+        regex = RegexBackend().parse_declarations(HEADER)
+        native = BackendRegistry.get('native').parse_declarations(HEADER)
+        assert json.dumps(native.to_dict(), sort_keys=True) == json.dumps(regex.to_dict(), sort_keys=True)
+
+
+@pytest.fixture
+def include_dir(tmp_path):
+    (tmp_path / 'a.h').write_text(HEADER)
+    sub = tmp_path / 'sub'
+    sub.mkdir()
+    (sub / 'b.h').write_text('struct ring { u64 other; };\nstruct peer { struct ring r; u8 flag; };\n'
+                             'typedef struct peer peer_t;\n')
+    (sub / 'notes.txt').write_text('struct ignored { int x; };')
+    return tmp_path
+
+
+class TestHarvest:
+    """头文件收集"""
+
+    def test_index_and_stats(self, include_dir):
+        index = harvest([str(include_dir)], 'regex')
+        assert index.stats["files"] == 2 and index.stats["bytes"] > 0
+        assert index.stats["backend"] == 'regex' and index.stats["mb_per_s"] > 0
+        # 同名定义以先收集到的为准（a.h 排在 sub/b.h 前）
+        assert [f.name for f in index.structs['ring'].fields] == ['head', 'tail']
+        assert index.origins['struct ring'].endswith('a.h')
+        assert index.origins['struct peer'].endswith('b.h')
+        assert 'ignored' not in index.structs
+        assert index.summary()["enums"] == len(index.enums) == 3
+
+    def test_find_headers(self, include_dir):
+        extra = str(include_dir / 'sub' / 'notes.txt')
+        files = find_headers([str(include_dir), extra, str(include_dir / 'missing.h')])
+        assert [os.path.basename(f) for f in files] == ['a.h', 'b.h', 'notes.txt']
+
+    def test_parallel_same_result(self, include_dir):
+        serial = harvest([str(include_dir)], 'regex')
+        parallel = harvest([str(include_dir)], 'regex', jobs=2)
+        assert parallel.origins == serial.origins
+        assert parallel.as_parse_result().to_dict() == serial.as_parse_result().to_dict()
+
+
+class TestLayoutFallback:
+    """布局引擎回退到头文件类型"""
+
+    SOURCE = '''
+struct my_priv {
+    struct ring ring;
+    peer_t peer;
+    u8 state;
+};
+'''
+
+    def test_header_records(self, include_dir):
+        index = harvest([str(include_dir)], 'regex')
+        layout = LayoutEngine(RegexBackend().parse(self.SOURCE), headers=index).layout('my_priv')
+        assert layout.exact
+        # ring: __packed 8 字节；peer: ring + u8 -> 9 字节，对齐 1
+        assert [(m.name, m.offset, m.size) for m in layout.members] == [
+            ('ring', 0, 8), ('peer', 8, 9), ('state', 17, 1)]
+
+    def test_local_definition_wins(self, include_dir):
+        index = harvest([str(include_dir)], 'regex')
+        source = 'struct ring { u64 a; u64 b; };\n' + self.SOURCE
+        layout = LayoutEngine(RegexBackend().parse(source), headers=index).layout('my_priv')
+        assert layout.members[0].size == 16
+
+    def test_analyzer_option(self, include_dir, tmp_path_factory):
+        path = tmp_path_factory.mktemp('src') / 'drv.c'
+        path.write_text(self.SOURCE)
+        index = harvest([str(include_dir)], 'regex')
+        analyzer = UnifiedAnalyzer('regex', analyses=['layout'], options={"headers": index})
+        layout = analyzer.analyze_file(str(path))["analyses"]["layout"]
+        # 头文件中的类型只用于回退查找，不出现在本文件的报告里
+        assert list(layout["structs"]) == ['struct my_priv']
+        assert layout["structs"]['struct my_priv']["size"] == 18
+        assert layout["summary"]["inexact"] == []
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
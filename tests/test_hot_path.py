@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""
+函数体度量与热路径开销估算测试
+"""
+
+import os
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from analysis.metrics import scan_body
+from analysis.hot_path import LOOP_FACTOR, WEIGHTS
+from helpers import run_analysis
+
+
+NIC_SOURCE = """
+static void nic_refill(struct nic_priv *priv)
+{
+    int i;
+    for (i = 0; i < 64; i++) {
+        priv->ring[i] = dma_map_single(priv->dev, priv->buf[i], 2048, DMA_FROM_DEVICE);
+        writel(i, priv->base + 0x10);
+    }
+}
+
+static int nic_poll(struct napi_struct *napi, int budget)
+{
+    struct nic_priv *priv = container_of(napi, struct nic_priv, napi);
+    int done = 0;
+
+    while (done < budget && readl(priv->base + 0x20)) {
+        napi_gro_receive(napi, build_skb(priv->buf[done], 2048));
+        done++;
+    }
+    nic_refill(priv);
+    if (done < budget)
+        napi_complete_done(napi, done);
+    return done;
+}
+
+static irqreturn_t nic_isr(int irq, void *data)
+{
+    struct nic_priv *priv = data;
+    u32 status = readl(priv->base + 0x30);
+
+    writel(status, priv->base + 0x30);
+    napi_schedule(&priv->napi);
+    return IRQ_HANDLED;
+}
+
+static netdev_tx_t nic_xmit(struct sk_buff *skb, struct net_device *dev)
+{
+    struct nic_priv *priv = netdev_priv(dev);
+    writel(1, priv->base);
+    return NETDEV_TX_OK;
+}
+
+static void nic_get_stats(struct net_device *dev)
+{
+    nic_refill(netdev_priv(dev));
+}
+
+static const struct net_device_ops nic_ops = {
+    .ndo_start_xmit = nic_xmit,
+    .ndo_get_stats64 = nic_get_stats,
+};
+
+static int nic_probe(struct pci_dev *pdev)
+{
+    netif_napi_add(ndev, &priv->napi, nic_poll);
+    request_irq(pdev->irq, nic_isr, 0, "nic", priv);
+    return 0;
+}
+"""
+
+
+class TestBodyMetrics:
+    """循环区间和调用点"""
+
+    BODY = """{
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < m; j++)
+            writel(j, base + i);
+        readl(base);
+    }
+    do {
+        x = readl(r);
+    } while (!(x & 1));
+    while (!(readl(base + 4) & BIT(3)));
+    /* while (fake) { } */
+    dev_info(dev, "for (;;) foo(%d)", x);
+}"""
+
+    def test_loops(self):
+        metrics = scan_body(self.BODY, 10)
+        assert [(l.kind, l.depth, l.empty) for l in metrics.loops] == [
+            ("for", 1, False), ("for", 2, False), ("do", 1, False), ("while", 1, True)]
+        assert metrics.loops[0].line == 11
+        assert metrics.max_loop_depth == 2
+
+    def test_call_sites(self):
+        metrics = scan_body(self.BODY, 10)
+        calls = [(c.name, c.loop_depth) for c in metrics.calls]
+        # 循环条件中的 readl 在循环内；字符串里的 foo( 不是调用
+        assert calls == [("writel", 2), ("readl", 1), ("readl", 1), ("readl", 1),
+                         ("dev_info", 0)]
+        assert metrics.mmio_reads == 3
+        assert metrics.mmio_writes == 1
+        assert metrics.calls[0].args == "j, base + i"
+
+
+@pytest.fixture
+def result(tmp_path):
+    return run_analysis(tmp_path, NIC_SOURCE, "hot-path")
+
+
+class TestHotPath:
+    """从延迟敏感入口展开的开销排名"""
+
+    def test_entries(self, result):
+        # ndo_get_stats64 不是热路径入口
+        assert [e["entry"] for e in result["entries"]] == [
+            "napi:nic_poll", "irq:nic_isr", "net_device_ops.ndo_start_xmit"]
+
+    def test_costs(self, result):
+        entries = {e["entry"]: e for e in result["entries"]}
+        refill = LOOP_FACTOR * (WEIGHTS["external_call"] + WEIGHTS["mmio_write"])
+        isr = WEIGHTS["mmio_read"] + WEIGHTS["mmio_write"] + WEIGHTS["external_call"]
+        assert entries["irq:nic_isr"]["cost"] == isr
+        poll = entries["napi:nic_poll"]
+        assert poll["call_depth"] == 1
+        assert poll["max_loop_depth"] == 1
+        assert poll["mmio_reads"] == 1 and poll["mmio_writes"] == 1
+        assert poll["heaviest_path"] == ["nic_poll", "nic_refill"]
+        refill_record = next(r for r in poll["hot_functions"] if r["func"] == "nic_refill")
+        assert refill_record["self_cost"] == refill
+        assert poll["cost"] > refill + isr
+
+    def test_ranking(self, result):
+        assert result["ranking"][0]["func"] == "nic_poll"
+        assert {r["func"] for r in result["ranking"]} == {
+            "nic_poll", "nic_refill", "nic_isr", "nic_xmit"}
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
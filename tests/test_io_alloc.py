@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""
+每次 I/O 的分配与 DMA 映射测试
+"""
+
+import os
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from analysis.io_alloc import match_site
+from helpers import analyze_source, run_analysis
+
+
+SOURCE = """
+static void nic_unmap(struct nic_priv *priv, struct nic_desc *d)
+{
+    dma_unmap_single(priv->dev, d->dma, d->len, DMA_TO_DEVICE);
+    kfree(d->hdr);
+}
+
+static int nic_map(struct nic_priv *priv, struct sk_buff *skb, struct nic_desc *d)
+{
+    d->hdr = kmalloc(64, GFP_ATOMIC);
+    d->dma = dma_map_single(priv->dev, skb->data, skb->len, DMA_TO_DEVICE);
+    return 0;
+}
+
+static netdev_tx_t nic_xmit(struct sk_buff *skb, struct net_device *dev)
+{
+    struct nic_priv *priv = netdev_priv(dev);
+    int i;
+    for (i = 0; i < skb_shinfo(skb)->nr_frags; i++)
+        skb_frag_dma_map(priv->dev, &skb_shinfo(skb)->frags[i], 0, 10, DMA_TO_DEVICE);
+    nic_map(priv, skb, &priv->ring[0]);
+    return NETDEV_TX_OK;
+}
+
+static void nic_rx_complete(struct urb *urb)
+{
+    struct nic_priv *priv = urb->context;
+    struct sk_buff *skb = netdev_alloc_skb(priv->ndev, urb->actual_length);
+    nic_unmap(priv, &priv->ring[0]);
+    usb_submit_urb(urb, GFP_ATOMIC);
+}
+
+static int nic_open(struct net_device *dev)
+{
+    priv->ring = dma_alloc_coherent(priv->dev, 4096, &priv->ring_dma, GFP_KERNEL);
+    usb_fill_bulk_urb(priv->urb, priv->udev, usb_rcvbulkpipe(priv->udev, 1),
+                      priv->buf, 512, nic_rx_complete, priv);
+    return 0;
+}
+
+static const struct net_device_ops nic_ops = {
+    .ndo_open = nic_open,
+    .ndo_start_xmit = nic_xmit,
+};
+"""
+
+
+@pytest.fixture
+def analyzed(tmp_path):
+    return analyze_source(tmp_path, SOURCE, ["io-alloc"])
+
+
+@pytest.fixture
+def result(analyzed):
+    return analyzed["analyses"]["io-alloc"]
+
+
+def site(result, call):
+    return next(s for s in result["sites"] if s["call"] == call)
+
+
+class TestIoAlloc:
+    """每次 I/O 路径上的分配/映射"""
+
+    def test_urb_completion_is_async_handler(self, analyzed):
+        urb = [h for h in analyzed["async_handlers"] if h["handler_type"] == "urb"]
+        assert [h["func_name"] for h in urb] == ["nic_rx_complete"]
+
+    def test_entries(self, result):
+        assert sorted(result["entries"]) == ["net_device_ops.ndo_start_xmit", "urb:nic_rx_complete"]
+
+    def test_ranked_by_proximity(self, result):
+        assert [s["depth"] for s in result["sites"]] == [0, 0, 1, 1]
+        # 同一深度下循环内的排在前面
+        assert result["sites"][0]["call"] == "skb_frag_dma_map"
+        assert result["sites"][0]["loop_depth"] == 1
+
+    def test_path_and_category(self, result):
+        s = site(result, "dma_map_single")
+        assert s["category"] == "dma_map"
+        assert s["path"] == ["nic_xmit", "nic_map", "dma_map_single"]
+        assert s["entries"] == ["net_device_ops.ndo_start_xmit"]
+
+    def test_churn(self, result):
+        # dma_unmap_single / kfree 在 URB 完成回调路径上
+        assert site(result, "dma_map_single")["churn"]
+        assert site(result, "kmalloc")["churn"]
+        assert not site(result, "netdev_alloc_skb")["churn"]
+        assert result["released_on_path"]["urb:nic_rx_complete"] == ["dma_map", "kmalloc"]
+
+    def test_cold_path_excluded(self, result):
+        assert not any(s["call"] == "dma_alloc_coherent" for s in result["sites"])
+        assert result["summary"]["sites"] == 4
+
+
+class TestPatterns:
+    """获取/释放模式表"""
+
+    @pytest.mark.parametrize("name, category, op", [
+        ("dma_map_page", "dma_map", "acquire"),
+        ("dma_unmap_sg", "dma_map", "release"),
+        ("dma_pool_alloc", "dma_alloc", "acquire"),
+        ("kmem_cache_zalloc", "slab", "acquire"),
+        ("napi_alloc_skb", "skb", "acquire"),
+        ("dev_kfree_skb_any", "skb", "release"),
+        ("kfree", "kmalloc", "release"),
+        ("usb_alloc_urb", "urb", "acquire"),
+    ])
+    def test_match(self, name, category, op):
+        pattern, kind = match_site(name)
+        assert (pattern.category, kind) == (category, op)
+
+    def test_no_match(self):
+        assert match_site("netdev_priv") is None
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, "-v"])
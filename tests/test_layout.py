@@ -0,0 +1,296 @@
+#!/usr/bin/env python3
+"""
+结构体布局引擎测试
+
+期望值按 x86_64 / arm64 GCC 的 ABI 规则手算（与 pahole 在同样定义上的输出一致）。
+"""
+
+import os
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from backends import RegexBackend
+from analysis import AnalysisContext, LayoutEngine, format_pahole, run_analyses
+from core.analyzer import UnifiedAnalyzer
+
+
+def layout_of(source: str, name: str, **kwargs):
+    result = RegexBackend().parse(source)
+    return LayoutEngine(result, **kwargs).layout(name)
+
+
+def offsets(layout) -> dict:
+    return {m.name: m.offset for m in layout.members}
+
+
+class TestBasicLayout:
+    """基本类型、空洞和填充"""
+
+    def test_holes_and_padding(self):
+        layout = layout_of("""
+struct demo {
+    char flag;
+    u64 counter;
+    u16 id;
+};
+""", "demo")
+        assert offsets(layout) == {"flag": 0, "counter": 8, "id": 16}
+        assert layout.size == 24
+        assert layout.align == 8
+        assert layout.holes() == [{"after": "flag", "offset": 1, "size": 7}]
+        assert layout.padding == 6
+        # 重排后 counter, id, flag -> 8 + 2 + 1 = 11 -> 16
+        assert layout.reorder_size == 16
+
+    def test_kernel_types_and_pointers(self):
+        layout = layout_of("""
+struct priv {
+    spinlock_t lock;
+    struct list_head list;
+    void __iomem *base;
+    int (*callback)(struct priv *p, int arg);
+    struct work_struct work;
+    unsigned long flags;
+};
+""", "priv")
+        assert offsets(layout) == {"lock": 0, "list": 8, "base": 24, "callback": 32,
+                                   "work": 40, "flags": 72}
+        assert layout.size == 80
+        assert layout.exact
+
+    def test_arrays_with_constants(self):
+        layout = layout_of("""
+#define RING_SIZE 8
+struct ring {
+    u8 mac[ETH_ALEN];
+    u32 slots[2][4];
+    char name[IFNAMSIZ];
+    u8 data[];
+};
+""", "ring")
+        assert offsets(layout) == {"mac": 0, "slots": 8, "name": 40, "data": 56}
+        assert layout.members[1].count == 8
+        assert layout.size == 56
+
+    def test_unknown_type_estimated(self):
+        layout = layout_of("""
+struct wrapper {
+    struct mystery m;
+    int x;
+};
+""", "wrapper")
+        assert not layout.exact
+        assert layout.unknown_types == ["struct mystery"]
+        assert layout.members[0].estimated
+
+    def test_no_holes_next_to_estimates(self):
+        layout = layout_of("""
+struct est {
+    int q[UNKNOWN_N];
+    long x;
+    char c;
+    int y;
+};
+""", "est")
+        # q 的大小是估算的，q 与 x 之间的 4 字节空洞不可信；c 与 y 之间的是真的
+        assert layout.holes() == [{"after": "c", "offset": 17, "size": 3}]
+        assert layout.reorder_size is None
+        text = format_pahole(layout)
+        assert text.count("hole, try to pack") == 1
+
+    def test_extra_type_sizes(self):
+        layout = layout_of("""
+struct wrapper {
+    struct mystery m;
+    int x;
+};
+""", "wrapper", type_sizes={"struct mystery": [12, 4]})
+        assert layout.exact
+        assert layout.size == 16
+
+
+class TestAttributes:
+    """__packed / __aligned / ____cacheline_aligned"""
+
+    def test_packed(self):
+        layout = layout_of("""
+struct hdr {
+    u8 type;
+    u32 len;
+    u16 csum;
+} __packed;
+""", "hdr")
+        assert offsets(layout) == {"type": 0, "len": 1, "csum": 5}
+        assert layout.size == 7
+        assert layout.align == 1
+
+    def test_attribute_packed_prefix(self):
+        layout = layout_of("""
+struct __attribute__((packed)) hdr {
+    u8 type;
+    u64 value;
+};
+""", "hdr")
+        assert layout.size == 9
+
+    def test_aligned_member_and_struct(self):
+        layout = layout_of("""
+struct stats {
+    u32 rx;
+    u32 tx __aligned(16);
+} __aligned(32);
+""", "stats")
+        assert offsets(layout) == {"rx": 0, "tx": 16}
+        assert layout.align == 32
+        assert layout.size == 32
+
+    def test_cacheline_aligned_member(self):
+        layout = layout_of("""
+struct queue {
+    spinlock_t lock;
+    u64 head;
+    u64 tail ____cacheline_aligned_in_smp;
+};
+""", "queue")
+        assert offsets(layout) == {"lock": 0, "head": 8, "tail": 64}
+        assert layout.size == 128
+        assert layout.to_dict(64)["members"][2]["cacheline"] == 1
+        # 显式对齐的字段不给出重排建议
+        assert layout.reorder_size is None
+
+
+class TestBitfields:
+    """位域放置"""
+
+    def test_bitfields_share_unit(self):
+        layout = layout_of("""
+struct flags {
+    unsigned int a:3, b:5;
+    unsigned int c:30;
+    u8 tail;
+};
+""", "flags")
+        a, b, c, tail = layout.members
+        assert (a.offset, a.bit_offset, b.offset, b.bit_offset) == (0, 0, 0, 3)
+        # c 放不进第一个 int 剩余的 24 位，移到下一个存储单元
+        assert (c.offset, c.bit_offset) == (4, 0)
+        assert tail.offset == 8
+        assert layout.size == 12
+
+    def test_zero_width_bitfield(self):
+        layout = layout_of("""
+struct z {
+    u8 a:1;
+    int :0;
+    u8 b:1;
+};
+""", "z")
+        assert [m.name for m in layout.members] == ["a", "b"]
+        assert layout.members[1].offset == 4
+        assert layout.size == 5
+
+
+class TestNestedAndUnions:
+    """嵌套结构体与联合体"""
+
+    def test_union(self):
+        layout = layout_of("""
+union reg {
+    u32 raw;
+    struct {
+        u32 en:1;
+        u32 mode:3;
+    } bits;
+    u64 wide;
+};
+""", "reg")
+        assert layout.kind == "union"
+        assert layout.size == 8
+        assert all(m.offset == 0 for m in layout.members)
+
+    def test_struct_by_value(self):
+        source = """
+struct inner {
+    u8 a;
+    u32 b;
+};
+struct outer {
+    u8 tag;
+    struct inner in;
+    u8 end;
+};
+"""
+        layout = layout_of(source, "outer")
+        assert offsets(layout) == {"tag": 0, "in": 4, "end": 12}
+        assert layout.size == 16
+
+    def test_typedef_struct(self):
+        layout = layout_of("""
+typedef struct {
+    u16 a;
+    u64 b;
+} pair_t;
+struct holder {
+    pair_t p;
+    u8 c;
+};
+""", "holder")
+        assert layout.size == 24
+
+
+class TestArchAndReport:
+    """架构与输出"""
+
+    SOURCE = """
+struct demo {
+    char flag;
+    long counter;
+    long double precise;
+};
+"""
+
+    @pytest.mark.parametrize("arch", ["x86_64", "arm64", "aarch64"])
+    def test_lp64_arches(self, arch):
+        layout = layout_of(self.SOURCE, "demo", arch=arch)
+        assert offsets(layout) == {"flag": 0, "counter": 8, "precise": 16}
+        assert layout.size == 32
+
+    def test_unknown_arch(self):
+        with pytest.raises(ValueError):
+            layout_of(self.SOURCE, "demo", arch="mips")
+
+    def test_pahole_text(self):
+        text = format_pahole(layout_of(self.SOURCE, "demo"))
+        assert "/* XXX 7 bytes hole, try to pack */" in text
+        assert "/* size: 32, cachelines: 1, members: 3 */" in text
+
+    def test_pass_via_context(self):
+        ctx = AnalysisContext(RegexBackend().parse(self.SOURCE), options={"arch": "arm64"})
+        result = run_analyses(["layout"], ctx)["layout"]
+        assert result["arch"] == "arm64"
+        assert result["structs"]["struct demo"]["sum_holes"] == 7
+        assert result["summary"]["with_holes"] == 1
+
+    def test_file_defines_in_array_sizes(self):
+        source = "#define NQ 8\nstruct foo { int q[NQ]; long x; };\n"
+        ctx = AnalysisContext(RegexBackend().parse(source), source)
+        foo = run_analyses(["layout"], ctx)["layout"]["structs"]["struct foo"]
+        assert (foo["size"], foo["holes"], foo["exact"]) == (40, [], True)
+
+    def test_analyzer_integration(self, tmp_path):
+        path = tmp_path / 'demo.c'
+        path.write_text(self.SOURCE)
+        result = UnifiedAnalyzer('regex', analyses=["layout"]).analyze_file(str(path))
+        assert result["analyses"]["layout"]["structs"]["struct demo"]["size"] == 32
+        assert "analysis.layout" in result["stats"]["stages_ms"]
+
+    def test_unknown_analysis(self):
+        with pytest.raises(ValueError):
+            UnifiedAnalyzer('regex', analyses=["no-such-pass"])
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""
+锁顺序图测试
+"""
+
+import os
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from analysis import merge_lock_order
+from helpers import analyze_source, run_analysis
+
+
+SOURCE = """
+struct nic_priv {
+    spinlock_t tx_lock;
+    spinlock_t stats_lock;
+    struct mutex cfg;
+};
+static DEFINE_SPINLOCK(global_lock);
+
+static void nic_stats(struct nic_priv *priv)
+{
+    spin_lock(&priv->stats_lock);
+    priv->n++;
+    spin_unlock(&priv->stats_lock);
+}
+
+static void nic_update(struct nic_priv *priv)
+{
+    nic_stats(priv);
+}
+
+static netdev_tx_t nic_xmit(struct sk_buff *skb, struct net_device *dev)
+{
+    struct nic_priv *priv = netdev_priv(dev);
+    spin_lock(&priv->tx_lock);
+    nic_update(priv);
+    spin_unlock(&priv->tx_lock);
+    return 0;
+}
+
+static irqreturn_t nic_isr(int irq, void *data)
+{
+    struct nic_priv *priv = data;
+    spin_lock(&priv->stats_lock);
+    spin_lock(&priv->tx_lock);
+    spin_unlock(&priv->tx_lock);
+    spin_unlock(&priv->stats_lock);
+    spin_lock(&global_lock);
+    spin_unlock(&global_lock);
+    return IRQ_HANDLED;
+}
+
+static void nic_timer(struct timer_list *t)
+{
+    struct nic_priv *priv = from_timer(priv, t, timer);
+    local_irq_disable();
+    spin_lock(&priv->stats_lock);
+    spin_unlock(&priv->stats_lock);
+    local_irq_enable();
+}
+
+static int nic_probe(struct pci_dev *pdev)
+{
+    struct nic_priv *priv;
+    request_irq(pdev->irq, nic_isr, 0, "nic", priv);
+    timer_setup(&priv->timer, nic_timer, 0);
+    return 0;
+}
+
+static const struct net_device_ops nic_ops = {
+    .ndo_start_xmit = nic_xmit,
+};
+"""
+
+
+def analyze(tmp_path, source: str, name: str = 'nic.c') -> dict:
+    return analyze_source(tmp_path, source, ["lock-order"], name)
+
+
+@pytest.fixture
+def result(tmp_path):
+    return analyze(tmp_path, SOURCE)["analyses"]["lock-order"]
+
+
+def edge(result, a, b):
+    return next((e for e in result["edges"] if (e["from"], e["to"]) == (a, b)), None)
+
+
+class TestLockIdentity:
+    """锁按结构体字段路径识别"""
+
+    def test_struct_field_locks(self, result):
+        scopes = {r["lock"]: r["scope"] for r in result["locks"]}
+        assert scopes == {"nic_priv.tx_lock": "struct", "nic_priv.stats_lock": "struct",
+                          "global_lock": "global"}
+
+    def test_irq_disable_is_not_a_lock(self, result):
+        assert all(e["from"] != "irq" for e in result["edges"])
+
+
+class TestOrderEdges:
+    """直接和经被调函数的嵌套加锁"""
+
+    def test_direct_nesting(self, result):
+        e = edge(result, "nic_priv.stats_lock", "nic_priv.tx_lock")
+        assert e["witnesses"][0]["path"] == ["nic_isr", "spin_lock"]
+
+    def test_nesting_through_callees(self, result):
+        e = edge(result, "nic_priv.tx_lock", "nic_priv.stats_lock")
+        assert e["witnesses"][0]["func"] == "nic_xmit"
+        assert e["witnesses"][0]["path"] == ["nic_xmit", "nic_update", "nic_stats", "spin_lock"]
+
+    def test_sequential_locks_are_not_ordered(self, result):
+        assert edge(result, "nic_priv.stats_lock", "global_lock") is None
+
+
+class TestCyclesAndHubs:
+    """环与热点锁"""
+
+    def test_abba_cycle(self, result):
+        [cycle] = result["cycles"]
+        assert cycle["kind"] == "order"
+        assert cycle["locks"] == ["nic_priv.stats_lock", "nic_priv.tx_lock"]
+        assert len(cycle["edges"]) == 2
+
+    def test_hub_lock(self, result):
+        top = result["locks"][0]
+        assert top["lock"] == "nic_priv.stats_lock" and top["hub"]
+        assert sorted(top["entries"]) == ["irq:nic_isr", "net_device_ops.ndo_start_xmit",
+                                          "timer:nic_timer"]
+        assert result["summary"]["hubs"] == 1
+
+    def test_recursive_locking(self, tmp_path):
+        source = """
+static void nic_reset(struct nic_priv *priv)
+{
+    mutex_lock(&priv->cfg);
+    nic_apply(priv);
+    mutex_unlock(&priv->cfg);
+}
+
+static void nic_apply(struct nic_priv *priv)
+{
+    mutex_lock(&priv->cfg);
+    mutex_unlock(&priv->cfg);
+}
+"""
+        result = analyze(tmp_path, source)["analyses"]["lock-order"]
+        assert [c["kind"] for c in result["cycles"]] == ["recursive"]
+        nested = analyze(tmp_path, source.replace("    mutex_lock(&priv->cfg);\n    mutex_unlock",
+                                                  "    mutex_lock_nested(&priv->cfg, 1);\n    mutex_unlock"))
+        assert nested["analyses"]["lock-order"]["cycles"] == []
+
+
+class TestMerge:
+    """多文件合并为全局锁顺序图"""
+
+    def test_cross_file_cycle(self, tmp_path):
+        # 两个文件各自只有一个方向的顺序，合并后成环
+        first = SOURCE.replace("    spin_lock(&priv->tx_lock);\n    spin_unlock(&priv->tx_lock);\n", "")
+        second = SOURCE.replace("    nic_update(priv);\n", "")
+        results = [analyze(tmp_path, first, 'a.c'), analyze(tmp_path, second, 'b.c')]
+        assert all(r["analyses"]["lock-order"]["cycles"] == [] for r in results)
+        merged = merge_lock_order(results)
+        assert merged["summary"]["cycles"] == 1
+        # 全局变量锁按文件区分，结构体字段锁合并
+        names = {r["lock"] for r in merged["locks"]}
+        assert {"a.c:global_lock", "b.c:global_lock", "nic_priv.stats_lock"} <= names
+
+    def test_no_lock_order_results(self):
+        assert merge_lock_order([{"file": "a.c"}]) is None
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+"""
+MMIO / 内存屏障 / 原子操作密度测试（含寄存器偏移解析）
+"""
+
+import os
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from analysis.mmio import ATOMIC_RMW, BARRIER
+from helpers import run_analysis
+
+
+SOURCE = """
+static void nic_kick(struct nic_priv *priv, u32 tail)
+{
+    wmb();
+    writel(tail, priv->base + 0x18);
+}
+
+static netdev_tx_t nic_xmit(struct sk_buff *skb, struct net_device *dev)
+{
+    struct nic_priv *priv = netdev_priv(dev);
+    int i;
+
+    writel(skb->len, priv->base + 0x10);
+    writel(lower_32_bits(priv->dma), priv->base + 0x14);
+    writel_relaxed(0, priv->base + 0x1c);
+    for (i = 0; i < skb_shinfo(skb)->nr_frags; i++)
+        writel(i, priv->base + 0x20);
+    atomic_inc(&priv->inflight);
+    nic_kick(priv, priv->tail);
+    return NETDEV_TX_OK;
+}
+
+static irqreturn_t nic_isr(int irq, void *data)
+{
+    struct nic_priv *priv = data;
+    u32 status = readl(priv->base + 0x4);
+    writel(status, priv->base + 0x4);
+    set_bit(0, &priv->flags);
+    smp_mb__after_atomic();
+    return IRQ_HANDLED;
+}
+
+static int nic_probe(struct pci_dev *pdev)
+{
+    writel(1, priv->base);
+    writel(2, priv->base + 4);
+    request_irq(pdev->irq, nic_isr, 0, "nic", priv);
+    return 0;
+}
+
+static const struct net_device_ops nic_ops = {
+    .ndo_start_xmit = nic_xmit,
+};
+"""
+
+
+@pytest.fixture
+def result(tmp_path):
+    return run_analysis(tmp_path, SOURCE, "mmio")
+
+
+def hints(result, kind):
+    return [h for h in result["hints"] if h["kind"] == kind]
+
+
+class TestCounts:
+    """按函数和热路径计数"""
+
+    def test_function_counts(self, result):
+        xmit = result["functions"]["nic_xmit"]
+        assert (xmit["mmio_writes"], xmit["mmio_writes_relaxed"]) == (3, 1)
+        assert xmit["atomics"] == 1 and xmit["in_loops"] == 1
+        isr = result["functions"]["nic_isr"]
+        assert (isr["mmio_reads"], isr["mmio_writes"], isr["barriers"], isr["atomics"]) == (1, 1, 1, 1)
+
+    def test_hot_path_totals(self, result):
+        xmit = next(p for p in result["hot_paths"] if p["entry"] == "net_device_ops.ndo_start_xmit")
+        # nic_xmit + nic_kick
+        assert xmit["functions"] == 2
+        assert (xmit["mmio_writes"], xmit["barriers"]) == (4, 1)
+
+    def test_summary(self, result):
+        assert result["summary"]["mmio_writes"] == 7
+        assert result["summary"]["hot_paths"] == 2
+
+
+class TestHints:
+    """减少 PCIe 往返的提示"""
+
+    def test_writel_burst(self, result):
+        [burst] = hints(result, "writel_burst")
+        # 参数里的 lower_32_bits() 不打断连续写；probe 中的连续写不在热路径上
+        assert (burst["func"], burst["writes"], burst["non_relaxed"]) == ("nic_xmit", 3, 2)
+
+    def test_doorbell_per_packet(self, result):
+        [hint] = hints(result, "doorbell_per_packet")
+        assert (hint["func"], hint["line"]) == ("nic_kick", 5)
+
+    def test_write_in_loop_and_redundant_wmb(self, result):
+        assert [h["line"] for h in hints(result, "write_in_loop")] == [17]
+        assert [h["func"] for h in hints(result, "redundant_wmb")] == ["nic_kick"]
+
+    def test_read_on_hot_path(self, result):
+        assert [h["func"] for h in hints(result, "read_on_hot_path")] == ["nic_isr"]
+
+    def test_xmit_more_suppresses_doorbell(self, tmp_path):
+        source = SOURCE.replace("nic_kick(priv, priv->tail);",
+                                "if (!netdev_xmit_more())\\n        nic_kick(priv, priv->tail);")
+        result = run_analysis(tmp_path, source, "mmio")
+        assert hints(result, "doorbell_per_packet") == []
+
+
+REGS_SOURCE = """
+#define NIC_CTRL      0x00
+#define NIC_STATUS    (NIC_CTRL + 0x4)   /* 中断状态 */
+#define NIC_TX_TAIL   NIC_TX_BASE + 8
+#define NIC_TX_BASE   0x100
+#define NIC_RX_TAIL   0x200
+enum { NIC_IRQ_MASK = NIC_STATUS + 4 };
+
+static netdev_tx_t nic_xmit(struct sk_buff *skb, struct net_device *dev)
+{
+    int i;
+    for (i = 0; i < 4; i++)
+        writel(i, priv->base + NIC_TX_BASE + 4);
+    writel(skb->len, priv->base + NIC_TX_TAIL);
+    writel(1, priv->base + 0x200);
+    return NETDEV_TX_OK;
+}
+
+static irqreturn_t nic_isr(int irq, void *data)
+{
+    u32 status = readl(priv->base + NIC_STATUS);
+    writel_relaxed(status, (priv->base + NIC_STATUS));
+    iowrite32(0, priv->regs[2] + NIC_IRQ_MASK);
+    return IRQ_HANDLED;
+}
+
+static int nic_probe(struct pci_dev *pdev)
+{
+    request_irq(pdev->irq, nic_isr, 0, "nic", priv);
+    writel(BIT(0), priv->base + NIC_CTRL);
+    writel(0, priv->base + REG_Q(3));
+    return 0;
+}
+
+static const struct net_device_ops nic_ops = {
+    .ndo_start_xmit = nic_xmit,
+};
+"""
+
+
+class TestRegisters:
+    """按 #define / 枚举常量解析寄存器偏移"""
+
+    @pytest.fixture
+    def regs(self, tmp_path):
+        return run_analysis(tmp_path, REGS_SOURCE, "mmio", 'regs.c')
+
+    def test_resolved_offsets(self, regs):
+        registers = regs["registers"]
+        status = registers["NIC_STATUS"]
+        assert (status["offset"], status["base"], status["reads"], status["writes"], status["relaxed"]) == \
+            (4, "priv->base", 1, 1, 1)
+        assert registers["NIC_IRQ_MASK"]["base"] == "priv->regs[2]"
+        assert registers["NIC_TX_TAIL"]["offset"] == 0x108
+        # 名字 + 字面量；函数式宏 REG_Q(i) 不能求值，不算寄存器
+        assert registers["NIC_TX_BASE+0x4"]["in_loops"] == 1
+        assert set(registers) == {"NIC_STATUS", "NIC_IRQ_MASK", "NIC_TX_TAIL", "NIC_TX_BASE+0x4",
+                                  "0x200", "NIC_CTRL"}
+        assert regs["summary"]["registers"] == 6
+
+    def test_literal_candidates(self, regs):
+        assert regs["registers"]["0x200"]["candidates"] == ["NIC_RX_TAIL"]
+
+    def test_hot_first(self, regs):
+        registers = list(regs["registers"].items())
+        assert registers[-1][0] == "NIC_CTRL" and registers[-1][1]["hot_entries"] == []
+        xmit = next(p for p in regs["hot_paths"] if p["entry"] == "net_device_ops.ndo_start_xmit")
+        assert xmit["registers"] == ["0x200", "NIC_TX_BASE+0x4", "NIC_TX_TAIL"]
+
+    def test_hint_registers(self, regs):
+        [loop] = hints(regs, "write_in_loop")
+        assert loop["registers"] == ["NIC_TX_BASE+0x4"]
+        [read] = hints(regs, "read_on_hot_path")
+        assert read["registers"] == ["NIC_STATUS"]
+
+
+class TestClassification:
+    """屏障与原子操作的识别"""
+
+    @pytest.mark.parametrize("name", ["wmb", "dma_rmb", "smp_mb__after_atomic", "smp_store_release"])
+    def test_barrier(self, name):
+        assert BARRIER.match(name)
+
+    @pytest.mark.parametrize("name, rmw", [
+        ("atomic_inc", True), ("atomic64_add_return", True), ("test_and_set_bit", True),
+        ("atomic_read", False), ("atomic_set", False), ("atomic_long_read", False),
+    ])
+    def test_atomic(self, name, rmw):
+        assert bool(ATOMIC_RMW.match(name)) == rmw
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+"""
+NAPI 与中断合并审计测试
+"""
+
+import os
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from helpers import analyze_source, run_analysis
+
+
+NAPI_SOURCE = """
+static void nic_clean_tx(struct nic_priv *priv)
+{
+    while (priv->tx_tail != priv->tx_head) {
+        dev_consume_skb_any(priv->tx_skb[priv->tx_tail]);
+        priv->tx_tail++;
+    }
+    netif_wake_queue(priv->dev);
+}
+
+static int nic_rx(struct nic_priv *priv, int limit)
+{
+    int done = 0;
+    while (done < limit && nic_desc_ready(priv)) {
+        struct sk_buff *skb = napi_alloc_skb(&priv->napi, 1536);
+        skb->protocol = eth_type_trans(skb, priv->dev);
+        napi_gro_receive(&priv->napi, skb);
+        done++;
+    }
+    return done;
+}
+
+static int nic_poll(struct napi_struct *napi, int budget)
+{
+    struct nic_priv *priv = container_of(napi, struct nic_priv, napi);
+    int work_done;
+
+    nic_clean_tx(priv);
+    work_done = nic_rx(priv, budget);
+    if (work_done < budget && napi_complete_done(napi, work_done))
+        writel(1, priv->base + IRQ_MASK);
+    return work_done;
+}
+
+static irqreturn_t nic_isr(int irq, void *data)
+{
+    struct nic_priv *priv = data;
+    writel(0, priv->base + IRQ_MASK);
+    napi_schedule(&priv->napi);
+    return IRQ_HANDLED;
+}
+
+static netdev_tx_t nic_xmit(struct sk_buff *skb, struct net_device *dev)
+{
+    return NETDEV_TX_OK;
+}
+
+static int nic_probe(struct pci_dev *pdev)
+{
+    struct nic_priv *priv;
+    netif_napi_add(priv->dev, &priv->napi, nic_poll);
+    request_irq(pdev->irq, nic_isr, 0, "nic", priv);
+    return 0;
+}
+
+static const struct net_device_ops nic_ops = {
+    .ndo_start_xmit = nic_xmit,
+};
+
+static const struct ethtool_ops nic_ethtool_ops = {
+    .get_coalesce = nic_get_coalesce,
+    .set_coalesce = nic_set_coalesce,
+};
+"""
+
+LEGACY_SOURCE = """
+static irqreturn_t old_isr(int irq, void *data)
+{
+    struct net_device *dev = data;
+    struct old_priv *priv = netdev_priv(dev);
+    int status = inw(dev->base_addr + STATUS);
+
+    while (inw(dev->base_addr + RX_STATUS) & RX_READY) {
+        struct sk_buff *skb = dev_alloc_skb(1536);
+        insw(dev->base_addr + DATA, skb_put(skb, 1500), 750);
+        skb->protocol = eth_type_trans(skb, dev);
+        netif_rx(skb);
+    }
+    if (status & TX_DONE) {
+        dev_kfree_skb_irq(priv->tx_skb);
+        netif_wake_queue(dev);
+    }
+    return IRQ_HANDLED;
+}
+
+static int old_open(struct net_device *dev)
+{
+    return request_irq(dev->irq, old_isr, 0, dev->name, dev);
+}
+
+static netdev_tx_t old_xmit(struct sk_buff *skb, struct net_device *dev)
+{
+    return NETDEV_TX_OK;
+}
+
+static const struct net_device_ops old_ops = {
+    .ndo_open = old_open,
+    .ndo_start_xmit = old_xmit,
+};
+"""
+
+
+def analyze(tmp_path, source: str, analyses=("napi",)) -> dict:
+    return analyze_source(tmp_path, source, analyses)
+
+
+@pytest.fixture
+def napi(tmp_path):
+    return analyze(tmp_path, NAPI_SOURCE)["analyses"]["napi"]
+
+
+@pytest.fixture
+def legacy(tmp_path):
+    return analyze(tmp_path, LEGACY_SOURCE)["analyses"]["napi"]
+
+
+class TestRecognition:
+    """netif_napi_add 注册的 poll 函数"""
+
+    def test_poll_is_async_handler(self, tmp_path):
+        result = analyze(tmp_path, NAPI_SOURCE, analyses=())
+        handlers = {(h["handler_type"], h["func_name"]) for h in result["async_handlers"]}
+        assert ("napi", "nic_poll") in handlers
+
+    def test_napi_schedule_binds_poll(self, tmp_path):
+        rearm = analyze(tmp_path, NAPI_SOURCE, analyses=("rearm",))["analyses"]["rearm"]
+        [site] = [s for s in rearm["sites"] if s["call"] == "napi_schedule"]
+        assert site["target"] == "napi:nic_poll"
+        assert "per_interrupt" in site["flags"]
+
+
+class TestNapiDriver:
+    """NAPI 驱动：硬中断只调度 poll"""
+
+    def test_classification(self, napi):
+        assert napi["driver"] == "napi"
+        [irq] = napi["irqs"]
+        assert irq["flags"] == ["defers_to_napi"]
+
+    def test_poll_budget_and_complete(self, napi):
+        [poll] = napi["polls"]
+        assert poll["budget"] == "budget"
+        # 循环在 nic_rx 中，budget 以 limit 参数传入
+        assert "loop" in poll["budget_checks"] and "passed" in poll["budget_checks"]
+        assert poll["complete"] == ["napi_complete_done"]
+        assert poll["rx_delivery"] == ["napi_gro_receive"]
+        assert poll["flags"] == []
+
+    def test_tx_clean_in_poll(self, napi):
+        assert napi["tx_clean_in"] == ["napi:nic_poll"]
+
+    def test_coalescing(self, napi):
+        assert napi["coalescing"]["ethtool"] == {"get_coalesce": "nic_get_coalesce",
+                                                 "set_coalesce": "nic_set_coalesce"}
+        assert napi["findings"] == []
+
+    def test_poll_flags(self, tmp_path):
+        source = NAPI_SOURCE.replace("work_done = nic_rx(priv, budget);", "work_done = nic_rx(priv, 64);") \
+                            .replace("napi_complete_done(napi, work_done)", "napi_complete(napi)") \
+                            .replace("napi_gro_receive(&priv->napi, skb)", "netif_rx(skb)")
+        [poll] = analyze(tmp_path, source)["analyses"]["napi"]["polls"]
+        assert poll["flags"] == ["ignores_budget", "legacy_complete", "netif_rx_in_poll"]
+
+
+class TestLegacyDriver:
+    """legacy 驱动：硬中断中直接收包"""
+
+    def test_classification(self, legacy):
+        assert legacy["driver"] == "legacy"
+        [irq] = legacy["irqs"]
+        assert irq["flags"] == ["rx_in_irq", "packet_loop_in_irq", "tx_clean_in_irq"]
+        assert irq["paths"]["netif_rx"] == ["old_isr", "netif_rx"]
+
+    def test_findings(self, legacy):
+        kinds = [f["kind"] for f in legacy["findings"]]
+        assert kinds == ["packets_in_hardirq", "no_coalescing"]
+
+    def test_mixed(self, tmp_path):
+        source = NAPI_SOURCE.replace("napi_schedule(&priv->napi);",
+                                     "napi_schedule(&priv->napi);\n    nic_clean_tx(priv);")
+        assert analyze(tmp_path, source)["analyses"]["napi"]["driver"] == "mixed"
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+"""
+native 后端测试
+
+native 后端必须与 regex 后端输出完全相同：逐个样例对比 to_dict() 的 JSON。
+扩展未编译（make native）时跳过。
+"""
+
+import glob
+import json
+import os
+import pickle
+import random
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'benchmarks'))
+
+from backends import (
+    BackendRegistry, ParseResult, RegexBackend, get_backend, is_native_available
+)
+from synth_corpus import generate_driver
+import test_backends
+
+ROOT = os.path.join(os.path.dirname(__file__), '..')
+
+SIMPLE_DRIVER = test_backends.SIMPLE_DRIVER
+COMPLEX_CODE = test_backends.TestComplexCode.COMPLEX_CODE
+
+# 扫描器各分支的边界情况
+EDGE_CASES = '''
+typedef unsigned long long u64;
+typedef   int  odd_t ;
+typedef struct __packed { u8 a; u16 b; } __aligned(4) hdr_t;
+typedef union { u32 raw; struct { u16 lo, hi; } w; } reg_t;
+struct ____cacheline_aligned_in_smp ring { u32 head; u32 tail; } __randomize_layout;
+struct __attribute__((packed, aligned(8))) desc { u64 addr; u32 len : 24, flags : 8; };
+struct deep { struct { struct { struct { int x; } c; } b; } a; };  /* 嵌套超过两层: 只匹配到内层 */
+union config_u { u32 v; };
+
+static inline __init int drv_init(void)
+{
+    return bus_register(&drv_bus) ?: misc_register(&drv_misc);
+}
+
+static void __exit drv_exit(void) { misc_deregister(&drv_misc); }
+
+unsigned long
+multi_line_head(struct ring *r,
+                const char *fmt, ...)
+{
+    char c = '{', q = '"', *s = "}\\"(";
+    list_for_each_entry(pos, head, list) {
+        pr_info("%s", fmt);
+    }
+    return strlen(s) + c + q;
+}
+
+int *no_space_before_name(void) { return NULL; }
+static struct ring * ptr_ret (struct ring *r) { return r; }
+void fallback_params(int, char *, struct desc
+                     *d) { }
+
+static const struct file_operations drv_fops = {
+    .owner = THIS_MODULE,
+    .open = drv_open, .release= drv_release,
+    .read =  multi_line_head,
+};
+struct platform_driver drv = { .probe = ptr_ret, .remove = fallback_params };
+module_init(drv_init);
+module_exit( drv_exit );
+static int drv_init(void) { return 0; }   // 重复定义：保留第一次出现的位置
+'''
+
+
+def _json(backend, source: str) -> str:
+    return json.dumps(backend.parse(source).to_dict(), ensure_ascii=False)
+
+
+def _mutations(sources, count: int, seed: int = 7):
+    """随机插入 / 删除括号、引号、注释符号等，覆盖扫描器的失配路径"""
+    rng = random.Random(seed)
+    alphabet = '{}()[];,*/\\"\'\n \t=._#abstructuniontypedefstatic中ü'
+    for _ in range(count):
+        text = rng.choice(sources)
+        if len(text) > 3000:
+            start = rng.randrange(len(text) - 2000)
+            text = text[start:start + 2000]
+        chars = list(text)
+        for _ in range(rng.randrange(1, 16)):
+            pos = rng.randrange(len(chars) + 1)
+            if rng.random() < 0.4 and pos < len(chars):
+                del chars[pos]
+            else:
+                chars.insert(pos, rng.choice(alphabet))
+        yield ''.join(chars)
+
+
+@pytest.fixture(scope='module')
+def backends():
+    from backends import NativeBackend
+    return RegexBackend(), NativeBackend()
+
+
+@pytest.mark.skipif(not is_native_available(), reason="native 扩展未编译（make native）")
+class TestNativeBackend:
+    """native 后端与 regex 后端逐项一致"""
+
+    def test_registered(self):
+        backend = get_backend('native')
+        assert backend.name == 'native'
+        assert RegexBackend().capabilities() <= backend.capabilities()
+        assert BackendRegistry.get_best_available().name in ('native', 'tree-sitter', 'clang')
+
+    @pytest.mark.parametrize('source', [SIMPLE_DRIVER, COMPLEX_CODE, EDGE_CASES, ''],
+                             ids=['simple', 'complex', 'edge', 'empty'])
+    def test_fixtures_identical(self, backends, source):
+        regex, native = backends
+        assert _json(native, source) == _json(regex, source)
+
+    def test_examples_and_synth_identical(self, backends):
+        regex, native = backends
+        sources = [open(f, encoding='utf-8').read()
+                   for f in sorted(glob.glob(os.path.join(ROOT, 'examples', '*', '*.c')))]
+        sources += [generate_driver(seed, 24 * 1024)[0] for seed in range(4)]
+        for source in sources:
+            assert _json(native, source) == _json(regex, source)
+
+    def test_mutations_identical(self, backends):
+        regex, native = backends
+        for source in _mutations([SIMPLE_DRIVER, COMPLEX_CODE, EDGE_CASES], 300):
+            assert _json(native, source) == _json(regex, source), source
+
+    def test_lazy_sections(self, backends):
+        _, native = backends
+        result = native.parse(EDGE_CASES)
+        assert result._functions is None and result._structs is None
+        assert 'drv_init' in result.functions
+        assert result._structs is None  # 只访问函数不会解析结构体成员
+        result.structs = {}
+        assert result.structs == {} and 'config_u' in result.unions
+
+    def test_pickle_materializes(self, backends):
+        regex, native = backends
+        restored = pickle.loads(pickle.dumps(native.parse(SIMPLE_DRIVER)))
+        assert type(restored) is ParseResult
+        assert restored.to_dict() == regex.parse(SIMPLE_DRIVER).to_dict()
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""
+工作队列 / 定时器重新调度分析测试
+"""
+
+import os
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from analysis.rearm import object_key, period_ms
+from helpers import run_analysis
+
+
+SOURCE = """
+static void nic_poll_timer(struct timer_list *t)
+{
+    struct nic_priv *priv = from_timer(priv, t, poll_timer);
+    schedule_work(&priv->stats_work);
+    mod_timer(&priv->poll_timer, jiffies + 1);
+}
+
+static void nic_stats_work(struct work_struct *w)
+{
+    struct nic_priv *priv = container_of(w, struct nic_priv, stats_work);
+    int i;
+    for (i = 0; i < priv->nqueues; i++)
+        queue_work(priv->wq, &priv->ping_work);
+}
+
+static void nic_ping_work(struct work_struct *w)
+{
+    struct nic_priv *priv = container_of(w, struct nic_priv, ping_work);
+    schedule_delayed_work(&priv->pong_work, msecs_to_jiffies(100));
+}
+
+static void nic_pong_work(struct work_struct *w)
+{
+    struct nic_priv *priv = container_of(to_delayed_work(w), struct nic_priv, pong_work);
+    queue_work(priv->wq, &priv->ping_work);
+}
+
+static enum hrtimer_restart nic_hrt(struct hrtimer *t)
+{
+    hrtimer_forward_now(t, ns_to_ktime(50000));
+    return HRTIMER_RESTART;
+}
+
+static irqreturn_t nic_isr(int irq, void *data)
+{
+    struct nic_priv *priv = data;
+    tasklet_schedule(&priv->rx_tasklet);
+    return IRQ_HANDLED;
+}
+
+static void nic_rx_tasklet(unsigned long data)
+{
+}
+
+static int nic_probe(struct pci_dev *pdev)
+{
+    INIT_WORK(&priv->stats_work, nic_stats_work);
+    INIT_WORK(&priv->ping_work, nic_ping_work);
+    INIT_DELAYED_WORK(&priv->pong_work, nic_pong_work);
+    timer_setup(&priv->poll_timer, nic_poll_timer, 0);
+    tasklet_init(&priv->rx_tasklet, nic_rx_tasklet, (unsigned long)priv);
+    priv->hrt.function = nic_hrt;
+    request_irq(pdev->irq, nic_isr, 0, "nic", priv);
+    mod_timer(&priv->poll_timer, jiffies + HZ);
+    return 0;
+}
+"""
+
+
+@pytest.fixture
+def result(tmp_path):
+    return run_analysis(tmp_path, SOURCE, "rearm", hz=250)
+
+
+def site(result, func, call):
+    return next(s for s in result["sites"] if s["func"] == func and s["call"] == call)
+
+
+class TestRearm:
+    """调度图与风暴模式"""
+
+    def test_scheduling_graph(self, result):
+        edges = {(e["from"], e["to"]) for e in result["graph"]["edges"]}
+        assert ("timer:nic_poll_timer", "work:nic_stats_work") in edges
+        assert ("work:nic_stats_work", "work:nic_ping_work") in edges
+        assert ("irq:nic_isr", "tasklet:nic_rx_tasklet") in edges
+        # 不在任何执行上下文中的调用者以函数名表示
+        assert ("nic_probe()", "timer:nic_poll_timer") in edges
+
+    def test_self_rearm_short_period(self, result):
+        s = site(result, "nic_poll_timer", "mod_timer")
+        assert s["flags"] == ["self_rearm", "short_period"]
+        assert s["period_ms"] == 4.0
+
+    def test_probe_arm_not_flagged(self, result):
+        s = site(result, "nic_probe", "mod_timer")
+        assert s["flags"] == [] and s["period_ms"] == 1000.0
+
+    def test_in_loop(self, result):
+        assert "in_loop" in site(result, "nic_stats_work", "queue_work")["flags"]
+
+    def test_cycle(self, result):
+        assert result["cycles"] == [["delayed_work:nic_pong_work", "work:nic_ping_work"]]
+        assert "cycle" in site(result, "nic_pong_work", "queue_work")["flags"]
+        assert "cycle" in site(result, "nic_ping_work", "schedule_delayed_work")["flags"]
+        assert "cycle" not in site(result, "nic_stats_work", "queue_work")["flags"]
+
+    def test_per_interrupt(self, result):
+        assert site(result, "nic_isr", "tasklet_schedule")["flags"] == ["per_interrupt"]
+
+    def test_hrtimer_restart(self, result):
+        [r] = result["hrtimer_restart"]
+        assert r["handler"] == "hrtimer:nic_hrt"
+        assert r["period_ms"] == pytest.approx(0.05)
+        assert "short_period" in r["flags"]
+
+
+class TestHelpers:
+    """对象键与周期换算"""
+
+    @pytest.mark.parametrize("expr, key", [
+        ("&priv->tx_work", "tx_work"),
+        ("&dev->stats.timer", "stats.timer"),
+        ("&my_tasklet", "my_tasklet"),
+    ])
+    def test_object_key(self, expr, key):
+        assert object_key(expr) == key
+
+    @pytest.mark.parametrize("call, args, expected", [
+        ("mod_timer", ["&t", "jiffies + HZ / 10"], 100.0),
+        ("mod_timer", ["&t", "jiffies"], 0.0),
+        ("mod_timer", ["&t", "priv->expires"], None),
+        ("schedule_delayed_work", ["&w", "msecs_to_jiffies(20)"], 20.0),
+        ("hrtimer_start", ["&t", "ktime_set(0, 500000)", "HRTIMER_MODE_REL"], 0.5),
+    ])
+    def test_period(self, call, args, expected):
+        assert period_ms(call, args, 250) == expected
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
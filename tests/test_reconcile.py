@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""
+跨后端对账测试（benchmarks/reconcile_backends.py）
+"""
+
+import os
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'benchmarks'))
+
+from backends import BackendRegistry, RegexBackend, StructField, is_native_available
+from reconcile_backends import align, index_result, reconcile
+
+SOURCE = '''
+struct ring { int head; int tail; };
+
+static int ring_push(struct ring *r) { return ring_kick(r); }
+
+static int ring_poll(struct ring *r)
+{
+    ring_push(r);
+    return ring_kick(r);
+}
+'''
+
+
+class LossyBackend(RegexBackend):
+    """丢掉所有调用边、多报一个字段的假后端"""
+
+    @property
+    def name(self) -> str:
+        return "lossy"
+
+    def parse(self, source_code: str, filename: str = "<string>"):
+        result = super().parse(source_code, filename)
+        for func in result.functions.values():
+            func.calls = []
+        if 'ring' in result.structs:
+            result.structs['ring'].fields.append(StructField(name='bogus', type_name='int'))
+        return result
+
+
+@pytest.fixture
+def lossy(monkeypatch):
+    monkeypatch.setattr(BackendRegistry, '_backends', dict(BackendRegistry._backends))
+    monkeypatch.setattr(BackendRegistry, '_instances', dict(BackendRegistry._instances))
+    BackendRegistry.register(LossyBackend, 'lossy')
+
+
+class TestAlign:
+    """单文件对齐"""
+
+    def test_identical(self):
+        indexed = index_result(RegexBackend().parse(SOURCE))
+        diff = align(indexed, indexed)
+        assert diff["functions"] == {"common": 2, "missing": [], "extra": []}
+        assert diff["calls"]["common"] == 3 and diff["moved"] == []
+
+    def test_missing_extra_moved(self):
+        ref = index_result(RegexBackend().parse(SOURCE))
+        changed = SOURCE.replace('static int ring_push(struct ring *r) { return ring_kick(r); }\n', '')
+        cand = index_result(RegexBackend().parse(changed + 'int extra_fn(void) { return 0; }\n'))
+        diff = align(ref, cand)
+        assert diff["functions"]["missing"] == ['ring_push']
+        assert diff["functions"]["extra"] == ['extra_fn']
+        assert ('ring_push', 'ring_kick') in diff["calls"]["missing"]
+        shifted = align(ref, index_result(RegexBackend().parse('\n\n\n' + SOURCE)))
+        assert [name for name, _, _ in shifted["moved"]] == ['ring_poll', 'ring_push']
+        assert shifted["functions"]["missing"] == shifted["functions"]["extra"] == []
+
+
+class TestReconcile:
+    """矩阵汇总"""
+
+    def test_matrix(self, lossy):
+        items = [('a.c', SOURCE), ('b.c', SOURCE.replace('ring', 'fifo'))]
+        matrix, reports = reconcile(items, ['lossy', 'regex'], examples=2)
+        assert set(matrix["speed"]) == {'regex', 'lossy'}
+        assert matrix["speed"]["regex"]["files"] == 2 and matrix["speed"]["regex"]["mb_per_s"] > 0
+        entry, = matrix["accuracy"]
+        # regex 按优先级排在前面作为参照
+        assert (entry["reference"], entry["candidate"]) == ('regex', 'lossy')
+        assert entry["functions"]["recall"] == 1.0 and entry["functions"]["precision"] == 1.0
+        assert entry["calls"] == {"common": 0, "missing": 6, "extra": 0,
+                                  "recall": 0.0, "precision": 1.0}
+        assert entry["fields"]["extra"] == 1 and entry["fields"]["precision"] == pytest.approx(4 / 5)
+        assert entry["examples"]["calls"]["missing"] == ['a.c: ring_poll->ring_kick',
+                                                        'a.c: ring_poll->ring_push']
+        assert entry["examples"]["fields"]["extra"] == ['a.c: ring.bogus']
+        assert len(reports) == 2 and 'regex|lossy' in reports[0]["pairs"]
+
+    @pytest.mark.skipif(not is_native_available(), reason="native 扩展未编译（make native）")
+    def test_parallel_native(self):
+        items = [(f'f{i}.c', SOURCE.replace('ring', f'ring{i}')) for i in range(6)]
+        matrix, reports = reconcile(items, ['native', 'regex'], jobs=2)
+        entry, = matrix["accuracy"]
+        assert (entry["reference"], entry["candidate"]) == ('regex', 'native')
+        for category in ("functions", "calls", "fields", "enums"):
+            assert entry[category]["missing"] == entry[category]["extra"] == 0
+        assert [r["file"] for r in reports] == [name for name, _ in items]
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
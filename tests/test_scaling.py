@@ -0,0 +1,406 @@
+#!/usr/bin/env python3
+"""
+规模回归测试
+
+在 n、2n、4n、8n 四个规模上测量流水线各部分耗时（统一分析器按 stats 中的
+阶段耗时逐阶段测量），在对数坐标上拟合增长指数，断言接近线性，
+防止二次（或更差）复杂度的写法回到热点路径中。计时测试在繁忙机器上会抖动，
+标记为 slow，默认跳过，用 make test-slow（pytest --run-slow -m slow）运行；
+调用树规模按节点数断言，不依赖计时，始终运行：
+- 行号计算（每次匹配都 content[:pos].count('\\n')）
+- called_by / 异步处理函数的列表去重
+- _infer_var_type 每次赋值都重新搜索全文
+- 调用子树在菱形调用结构上按路径数指数展开
+- 原子上下文睡眠检查按（源 × 路径）而不是在缩点图上按位传播
+- 锁顺序按（临界区 × 调用链）展开而不是查被调函数的摘要
+- 生成的大枚举头文件：枚举常量逐项求值（前项引用、BIT、隐式值）
+"""
+
+import gc
+import math
+import os
+import re
+import sys
+import time
+import pytest
+
+# 添加 src 和 benchmarks 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'benchmarks'))
+
+from backends import RegexBackend
+from backends.regex_backend import extract_defines
+from analysis import ConstantTable
+from core.analyzer import UnifiedAnalyzer
+from core.advanced_analyzer import AdvancedCAnalyzer
+from synth_corpus import generate_driver
+
+
+SIZES = (1, 2, 4, 8)
+# 增长指数上限：线性为 1，二次为 2，留出调度抖动的余量
+MAX_EXPONENT = 1.35
+# 最小规模下耗时低于该值（毫秒）的阶段抖动占主导，不单独拟合（仍计入总耗时）
+MIN_STAGE_MS = 5.0
+
+
+def without_gc(func):
+    """计时期间关闭分代 GC（同 timeit），避免大输入上的 GC 停顿被当成复杂度增长"""
+    def wrapper(*args):
+        gc.collect()
+        gc.disable()
+        try:
+            return func(*args)
+        finally:
+            gc.enable()
+    return wrapper
+
+
+@without_gc
+def best_of(func, arg, repeat: int = 3) -> float:
+    """多次运行取最快一次，降低调度抖动"""
+    best = None
+    for _ in range(repeat):
+        start = time.perf_counter()
+        func(arg)
+        elapsed = time.perf_counter() - start
+        if best is None or elapsed < best:
+            best = elapsed
+    return best
+
+
+def growth_exponent(times) -> float:
+    """最小二乘拟合 log(耗时) = k·log(规模) + c，返回 k"""
+    xs = [math.log(size) for size in SIZES]
+    ys = [math.log(max(t, 1e-6)) for t in times]
+    mx, my = sum(xs) / len(xs), sum(ys) / len(ys)
+    return (sum((x - mx) * (y - my) for x, y in zip(xs, ys))
+            / sum((x - mx) ** 2 for x in xs))
+
+
+def check_growth(label: str, times) -> None:
+    k = growth_exponent(times)
+    steps = ", ".join(f"{b / max(a, 1e-6):.1f}x" for a, b in zip(times, times[1:]))
+    assert k <= MAX_EXPONENT, f"{label}: 耗时增长指数 {k:.2f}（逐级 {steps}）"
+
+
+def assert_linear(func, make, base: int):
+    """断言 func(make(base × k)) 的耗时随 k = 1, 2, 4, 8 近似线性增长"""
+    inputs = [make(base * k) for k in SIZES]
+    func(inputs[0])  # 预热（正则编译缓存等）
+    check_growth(getattr(func, '__name__', 'func'), [best_of(func, arg) for arg in inputs])
+
+
+@without_gc
+def stage_times(run, arg, repeat: int = 3) -> dict:
+    """多次运行，每个阶段取最快一次（毫秒）"""
+    best = {}
+    for _ in range(repeat):
+        for name, ms in run(arg)["stats"]["stages_ms"].items():
+            best[name] = min(ms, best.get(name, ms))
+    return best
+
+
+def assert_stages_linear(run, make, base: int):
+    """
+    逐阶段断言近似线性增长
+
+    run 返回 analyze_file 的结果；按 stats["stages_ms"] 分别拟合每个阶段，
+    阶段之间的二次回归不会被其他阶段的线性耗时掩盖。
+    """
+    inputs = [make(base * k) for k in SIZES]
+    run(inputs[0])  # 预热
+    per_size = [stage_times(run, arg) for arg in inputs]
+    stages = [name for name, ms in per_size[0].items() if ms >= MIN_STAGE_MS]
+    assert stages, "没有可测量的阶段"
+    for name in stages:
+        check_growth(name, [times.get(name, 0.0) for times in per_size])
+    check_growth("total", [sum(times.values()) for times in per_size])
+
+
+def analyze_source(tmp_path, source: str, analyses=None) -> dict:
+    path = tmp_path / 'scale.c'
+    path.write_text(source)
+    return UnifiedAnalyzer('regex', analyses=analyses).analyze_file(str(path))
+
+
+# ==================== 输入构造 ====================
+
+def hub_source(n: int) -> str:
+    """n 个函数都调用同一个 hub 函数（called_by 去重）"""
+    parts = ["static void hub(int x)\n{\n    (void)x;\n}\n"]
+    for i in range(n):
+        parts.append(f"static void caller_{i}(int x)\n{{\n    hub(x);\n    hub(x + 1);\n}}\n")
+    return "\n".join(parts)
+
+
+def async_source(n: int) -> str:
+    """n 个异步处理函数在同一个 probe 里注册（异步处理函数去重）"""
+    parts = []
+    for i in range(n):
+        parts.append(f"static void work_fn_{i}(struct work_struct *w)\n{{\n    (void)w;\n}}\n")
+    parts.append("static int demo_probe(struct demo_priv *priv)\n{")
+    for i in range(n):
+        parts.append(f"    INIT_WORK(&priv->work_{i}, work_fn_{i});")
+        parts.append(f"    INIT_WORK(&priv->work_{i}, work_fn_{i});")
+    parts.append("    return 0;\n}\n")
+    return "\n".join(parts)
+
+
+def assignment_source(n: int) -> str:
+    """n 个函数各自声明局部变量并给函数指针字段赋值（_infer_var_type）"""
+    parts = []
+    for i in range(n):
+        parts.append(f"static void handler_{i}(void)\n{{\n}}\n")
+        parts.append(
+            f"static void setup_{i}(void)\n{{\n"
+            f"    struct demo_ops_{i} *ops_{i} = get_ops();\n"
+            f"    ops_{i}->callback = handler_{i};\n}}\n"
+        )
+    return "\n".join(parts)
+
+
+def ladder_source(levels: int) -> str:
+    """
+    菱形梯子：每层两个函数都调用下一层的两个函数
+
+    从入口出发的路径数是 2^levels，而函数数和调用边数只是线性的。
+    """
+    parts = [f"static void step_{levels}_a(void)\n{{\n}}\n",
+             f"static void step_{levels}_b(void)\n{{\n}}\n"]
+    for k in range(levels - 1, -1, -1):
+        for side in ('a', 'b'):
+            parts.append(
+                f"static void step_{k}_{side}(void)\n{{\n"
+                f"    step_{k + 1}_a();\n    step_{k + 1}_b();\n}}\n"
+            )
+    parts.append("static struct file_operations demo_fops = {\n"
+                 "    .open = step_0_a,\n    .read = step_0_b,\n};\n")
+    return "\n".join(parts)
+
+
+def atomic_fanout_source(n: int) -> str:
+    """n 个中断处理函数共享一条辅助函数链，链尾带 GFP_KERNEL 分配"""
+    parts = []
+    for i in range(n):
+        parts.append(f"static void helper_{i}(void)\n{{\n    helper_{i + 1}();\n}}\n")
+    parts.append(f"static void helper_{n}(void)\n{{\n    kmalloc(8, GFP_KERNEL);\n}}\n")
+    parts.append("static int demo_probe(void)\n{")
+    for i in range(0, n, 10):
+        parts.append(f"    request_irq(irq, isr_{i}, 0, \"demo\", NULL);")
+    parts.append("    return 0;\n}\n")
+    for i in range(0, n, 10):
+        parts.append(f"static irqreturn_t isr_{i}(int irq, void *d)\n{{\n    helper_{i}();\n"
+                     f"    return IRQ_HANDLED;\n}}\n")
+    return "\n".join(parts)
+
+
+def lock_fanout_source(n: int) -> str:
+    """n 个中断处理函数持有同一把锁调用共享的辅助函数链，链尾获取另一把锁"""
+    source = atomic_fanout_source(n).replace("    kmalloc(8, GFP_KERNEL);",
+                                             "    spin_lock(&stats_lock);\n    spin_unlock(&stats_lock);")
+    return re.sub(r'    (helper_\d+\(\);)\n    return IRQ_HANDLED;',
+                  r'    spin_lock(&tx_lock);\n    \1\n    spin_unlock(&tx_lock);\n    return IRQ_HANDLED;',
+                  source)
+
+
+def enum_source(n: int) -> str:
+    """生成的大枚举：隐式值、前项引用、BIT()、带后缀的字面量交替"""
+    parts = ["enum big_regs {"]
+    for i in range(n):
+        kind = i % 4
+        if kind == 0:
+            parts.append(f"    REG_{i},")
+        elif kind == 1:
+            parts.append(f"    REG_{i} = REG_{i - 1} + 2,")
+        elif kind == 2:
+            parts.append(f"    REG_{i} = BIT({i % 60}),")
+        else:
+            parts.append(f"    REG_{i} = 0x{i:x}UL,")
+    parts.append("};\n")
+    return "\n".join(parts)
+
+
+def define_source(n: int) -> str:
+    """寄存器头文件式的大量 #define：字面量、引用后定义的宏、BIT()、函数式宏交替"""
+    lines = []
+    for i in range(n):
+        kind = i % 4
+        if kind == 0:
+            lines.append(f"#define REG_{i} 0x{i * 4:x}")
+        elif kind == 1:
+            lines.append(f"#define REG_{i} (REG_{i + 1} + 4)")
+        elif kind == 2:
+            lines.append(f"#define REG_{i} BIT({i % 60})  /* 位 */")
+        else:
+            lines.append(f"#define REG_{i}(n) (0x{i:x} + (n))")
+    return "\n".join(lines) + "\n"
+
+
+
+def chain_source(length: int, shared_at: int = -1) -> str:
+    """
+    入口依次调用 chain_0 和 shared；chain_k 调用 chain_{k+1}
+
+    shared_at >= 0 时 chain_{shared_at} 也调用 shared（在深处第一次遇到 shared）。
+    """
+    parts = ["static void shared_leaf(void)\n{\n}\n",
+             "static void shared(void)\n{\n    shared_leaf();\n}\n",
+             f"static void chain_{length}(void)\n{{\n}}\n"]
+    for k in range(length - 1, -1, -1):
+        extra = "    shared();\n" if k == shared_at else ""
+        parts.append(f"static void chain_{k}(void)\n{{\n    chain_{k + 1}();\n{extra}}}\n")
+    parts.append("static int demo_open(void)\n{\n    chain_0();\n    shared();\n    return 0;\n}\n")
+    parts.append("static struct file_operations demo_fops = {\n    .open = demo_open,\n};\n")
+    return "\n".join(parts)
+
+
+def walk_nodes(node: dict):
+    yield node
+    for c in node["children"]:
+        yield from walk_nodes(c)
+
+
+def count_nodes(node: dict) -> int:
+    return 1 + sum(count_nodes(c) for c in node["children"])
+
+
+# ==================== 测试 ====================
+
+@pytest.mark.slow
+class TestLinearScaling:
+    """耗时随输入规模线性增长（墙钟计时，默认跳过，make test-slow 运行）"""
+
+    def test_regex_parse_corpus(self):
+        """regex 后端解析合成驱动"""
+        backend = RegexBackend()
+        assert_linear(backend.parse, lambda n: generate_driver(5, n)[0], 32_000)
+
+    def test_pipeline_corpus(self, tmp_path):
+        """统一分析器完整流水线（逐阶段）"""
+        assert_stages_linear(lambda src: analyze_source(tmp_path, src),
+                             lambda n: generate_driver(7, n)[0], 32_000)
+
+    def test_called_by_hub(self):
+        """被大量调用的函数"""
+        backend = RegexBackend()
+        result = backend.parse(hub_source(50))
+        assert len(result.functions["hub"].called_by) == 50
+        assert_linear(backend.parse, hub_source, 1000)
+
+    def test_async_handler_dedupe(self, tmp_path):
+        """大量异步处理函数注册（含重复注册）"""
+        result = analyze_source(tmp_path, async_source(20))
+        assert len(result["async_handlers"]) == 20
+        assert_stages_linear(lambda src: analyze_source(tmp_path, src), async_source, 200)
+
+    def test_infer_var_type(self, tmp_path):
+        """函数指针赋值的变量类型推断"""
+        def run(src):
+            path = tmp_path / 'assign.c'
+            path.write_text(src)
+            return AdvancedCAnalyzer().analyze_file(str(path))
+
+        result = run(assignment_source(10))
+        types = {a["func_name"]: a["struct_type"] for a in result["func_ptr_assignments"]}
+        assert types["handler_3"] == "demo_ops_3"
+        assert_linear(run, assignment_source, 200)
+
+    def test_sleep_in_atomic(self, tmp_path):
+        """原子上下文睡眠检查（源数和链长同时增长）"""
+        def run(src):
+            return analyze_source(tmp_path, src, ["sleep-in-atomic"])
+
+        result = run(atomic_fanout_source(20))
+        violations = result["analyses"]["sleep-in-atomic"]["violations"]
+        assert len(violations) == 2
+        assert violations[0]["path"][-1] == "kmalloc"
+        assert_stages_linear(run, atomic_fanout_source, 80)
+
+    def test_lock_order(self, tmp_path):
+        """锁顺序图（入口数和链长同时增长）"""
+        def run(src):
+            return analyze_source(tmp_path, src, ["lock-order"])
+
+        result = run(lock_fanout_source(20))
+        [edge] = result["analyses"]["lock-order"]["edges"]
+        assert (edge["from"], edge["to"], edge["count"]) == ("tx_lock", "stats_lock", 2)
+        assert_stages_linear(run, lock_fanout_source, 80)
+
+    def test_enum_evaluation(self):
+        """大枚举头文件的提取和常量求值"""
+        def run(src):
+            table = ConstantTable()
+            for enum in RegexBackend().parse_declarations(src).enums.values():
+                table.add_enum(enum)
+            return table
+
+        table = run(enum_source(8))
+        assert [table.get(f"REG_{i}") for i in range(8)] == [0, 2, 4, 0x3, 4, 6, 64, 0x7]
+        assert_linear(run, enum_source, 1000)
+
+    def test_define_evaluation(self):
+        """大量寄存器宏的提取和求值（含前向引用）"""
+        def run(src):
+            table = ConstantTable()
+            table.add_macros(extract_defines(src))
+            return table
+
+        table = run(define_source(8))
+        assert [table.get(f"REG_{i}") for i in range(8)] == [0, 8, 4, None, 0x10, 68, 64, None]
+        assert_linear(run, define_source, 2000)
+
+
+class TestCallTreeSize:
+    """调用树规模与调用图规模成线性关系"""
+
+    @pytest.mark.parametrize("levels", [4, 8, 10])
+    def test_diamond_ladder(self, tmp_path, levels):
+        """菱形调用结构不按路径数展开"""
+        result = analyze_source(tmp_path, ladder_source(levels))
+        trees = result["call_tree"]
+        assert len(trees) == 2
+
+        edges = sum(len(f["calls"]) for f in result["functions"].values())
+        for tree in trees:
+            # 每个函数在一棵树中最多展开一次：节点数 ≤ 入口 + 调用边数
+            assert count_nodes(tree) <= 1 + edges
+
+    def test_reference_nodes(self, tmp_path):
+        """重复出现的函数标记为引用而不是递归"""
+        result = analyze_source(tmp_path, ladder_source(2))
+        tree = result["call_tree"][0]
+        types = set()
+
+        def walk(node):
+            types.add(node["type"])
+            for c in node["children"]:
+                walk(c)
+        walk(tree)
+        assert "reference" in types
+        assert "recursive" not in types
+
+
+class TestCallTreeDepth:
+    """深度上限：按最浅位置展开，截断与递归区分"""
+
+    def test_shallow_occurrence_keeps_callees(self, tmp_path):
+        """shared 先在深处（子节点被截断）出现时，浅处的 shared 仍展开完整"""
+        tree = analyze_source(tmp_path, chain_source(12, shared_at=8))["call_tree"][0]
+        shared = [n for n in walk_nodes(tree) if n["name"] == "shared"]
+        expanded = [n for n in shared if n["type"] == "function"]
+        assert len(expanded) == 1
+        assert [(c["name"], c["type"]) for c in expanded[0]["children"]] == [("shared_leaf", "function")]
+        assert expanded[0] in tree["children"]
+        assert [n["type"] for n in shared if n is not expanded[0]] == ["reference"]
+
+    def test_depth_limit_is_not_recursion(self, tmp_path):
+        tree = analyze_source(tmp_path, chain_source(14))["call_tree"][0]
+        types = {n["name"]: n["type"] for n in walk_nodes(tree)}
+        assert "recursive" not in types.values()
+        assert types["chain_9"] == "function"
+        assert types["chain_10"] == "truncated"
+        assert "chain_11" not in types
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""
+原子上下文睡眠检查测试
+"""
+
+import os
+import sys
+import pytest
+
+# 添加 src 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+
+from backends import RegexBackend
+from analysis import AnalysisContext
+from analysis.callgraph import Condensation
+from analysis.metrics import CallSite
+from analysis.sleep import classify
+from helpers import run_analysis
+
+
+SOURCE = """
+static void nic_log_alloc(struct nic_priv *priv)
+{
+    priv->buf = kmalloc(128, GFP_KERNEL);
+}
+
+static void nic_helper(struct nic_priv *priv)
+{
+    nic_log_alloc(priv);
+    priv->skb = alloc_skb(64, GFP_ATOMIC);
+}
+
+static irqreturn_t nic_isr(int irq, void *data)
+{
+    struct nic_priv *priv = data;
+    nic_helper(priv);
+    return IRQ_HANDLED;
+}
+
+static void nic_timer(struct timer_list *t)
+{
+    struct nic_priv *priv = from_timer(priv, t, timer);
+    mutex_lock(&priv->mutex);
+    mutex_unlock(&priv->mutex);
+}
+
+static void nic_work(struct work_struct *w)
+{
+    struct nic_priv *priv = container_of(w, struct nic_priv, work);
+    unsigned long flags;
+
+    spin_lock_irqsave(&priv->lock, flags);
+    if (priv->dead) {
+        spin_unlock_irqrestore(&priv->lock, flags);
+        return;
+    }
+    msleep(10);
+    spin_unlock_irqrestore(&priv->lock, flags);
+
+    msleep(10);
+    priv->buf = kzalloc(64, GFP_KERNEL);
+}
+
+static netdev_tx_t nic_xmit(struct sk_buff *skb, struct net_device *dev)
+{
+    copy_from_user(NULL, NULL, 0);
+    return NETDEV_TX_OK;
+}
+
+static const struct net_device_ops nic_ops = {
+    .ndo_start_xmit = nic_xmit,
+};
+
+static int nic_probe(struct pci_dev *pdev)
+{
+    INIT_WORK(&priv->work, nic_work);
+    timer_setup(&priv->timer, nic_timer, 0);
+    request_irq(pdev->irq, nic_isr, 0, "nic", priv);
+    return 0;
+}
+"""
+
+
+@pytest.fixture
+def result(tmp_path):
+    return run_analysis(tmp_path, SOURCE, "sleep-in-atomic")
+
+
+def paths(result, source):
+    return [v["path"] for v in result["violations"] if v["source"] == source]
+
+
+class TestSleepInAtomic:
+    """原子上下文到可能睡眠调用的路径"""
+
+    def test_irq_gfp_kernel_witness(self, result):
+        assert paths(result, "irq:nic_isr") == [
+            ["nic_isr", "nic_helper", "nic_log_alloc", "kmalloc"]]
+        v = next(v for v in result["violations"] if v["source"] == "irq:nic_isr")
+        assert v["category"] == "gfp"
+        assert v["reason"] == "GFP_KERNEL"
+
+    def test_gfp_atomic_listed_separately(self, result):
+        allocations = result["atomic_allocations"]
+        assert [a["call"] for a in allocations] == ["alloc_skb"]
+        assert allocations[0]["reason"] == "GFP_ATOMIC"
+
+    def test_unknown_gfp_listed_separately(self, tmp_path):
+        source = SOURCE.replace("priv->skb = alloc_skb(64, GFP_ATOMIC);",
+                                "priv->skb = alloc_skb(64, gfp);\n    priv->rx = dev_alloc_skb(64);")
+        result = run_analysis(tmp_path, source, "sleep-in-atomic")
+        assert [(a["call"], a["reason"]) for a in result["unknown_gfp"]] == [("alloc_skb", "")]
+        assert [(a["call"], a["reason"]) for a in result["atomic_allocations"]] == [("dev_alloc_skb", "GFP_ATOMIC")]
+        assert result["summary"]["unknown_gfp"] == 1
+
+    @pytest.mark.parametrize("flags", ["GFP_DMA", "__GFP_NOWARN"])
+    def test_non_reclaim_mask_in_irq(self, tmp_path, flags):
+        """硬中断里不带回收位的分配不是违规"""
+        source = SOURCE.replace("priv->skb = alloc_skb(64, GFP_ATOMIC);",
+                                f"priv->skb = kmalloc(64, {flags});")
+        result = run_analysis(tmp_path, source, "sleep-in-atomic")
+        # 只剩 nic_log_alloc 里的 GFP_KERNEL 分配
+        assert paths(result, "irq:nic_isr") == [
+            ["nic_isr", "nic_helper", "nic_log_alloc", "kmalloc"]]
+        assert [(a["call"], a["reason"]) for a in result["atomic_allocations"]] == [("kmalloc", flags)]
+
+    def test_timer_knowledge_base_hint(self, result):
+        # mutex_lock 在知识库中标注为"可能睡眠"
+        assert paths(result, "timer:nic_timer") == [["nic_timer", "mutex_lock"]]
+
+    def test_xmit_from_knowledge_base_context(self, result):
+        # ndo_start_xmit 在知识库中标注为"软中断上下文，不可睡眠"
+        assert paths(result, "net_device_ops.ndo_start_xmit") == [["nic_xmit", "copy_from_user"]]
+
+    def test_spinlock_region(self, result):
+        lock_hits = [v for v in result["violations"] if v["source_kind"] == "lock"]
+        # 临界区内的 msleep；解锁之后的 msleep / kzalloc 不报
+        assert [(v["call"], v["path"]) for v in lock_hits] == [("msleep", ["nic_work", "msleep"])]
+        assert lock_hits[0]["source"].startswith("spin_lock_irqsave(&priv->lock) @ nic_work:")
+
+    def test_process_context_not_reported(self, result):
+        assert not any(v["source"].startswith("work:") for v in result["violations"])
+
+
+class TestCondensation:
+    """强连通分量缩点与位集合传播"""
+
+    def test_topological_order(self):
+        graph = {"a": ["b"], "b": ["c", "a"], "c": ["d"], "d": [], "e": ["c"]}
+        cond = Condensation(graph)
+        assert cond.scc_of["a"] == cond.scc_of["b"]
+        order = {f: cond.scc_of[f] for f in graph}
+        assert order["a"] < order["c"] < order["d"]
+        assert order["e"] < order["c"]
+
+    def test_propagate(self):
+        graph = {"a": ["b"], "b": ["c", "a"], "c": ["d"], "d": [], "e": ["c"]}
+        cond = Condensation(graph)
+        bits = cond.propagate({"a": 1, "e": 2})
+        reached = {f: bits[cond.scc_of[f]] for f in graph}
+        assert reached == {"a": 1, "b": 1, "c": 3, "d": 3, "e": 2}
+
+    def test_deep_chain_no_recursion_limit(self):
+        graph = {f"f{i}": [f"f{i + 1}"] for i in range(5000)}
+        graph["f5000"] = []
+        cond = Condensation(graph)
+        bits = cond.propagate({"f0": 1})
+        assert bits[cond.scc_of["f5000"]] == 1
+
+
+class TestClassify:
+    """单个调用点的分类"""
+
+    @pytest.fixture
+    def ctx(self):
+        kb = {"kernel_apis": {"nic_fw_load": {"time_hint": "可能睡眠（等待固件）"}}}
+        return AnalysisContext(RegexBackend().parse(""), "", knowledge_base=kb)
+
+    @pytest.mark.parametrize("name, args, expected", [
+        ("kmalloc", "64, GFP_KERNEL", ("GFP_KERNEL", "gfp")),
+        ("kmalloc", "64, GFP_ATOMIC | __GFP_ZERO", ("GFP_ATOMIC|__GFP_ZERO", "atomic_alloc")),
+        ("kmalloc", "64, flags", ("", "unknown_gfp")),
+        ("napi_alloc_skb", "napi, 64", ("GFP_ATOMIC", "atomic_alloc")),
+        # 不带回收位的字面掩码不会睡眠，不回落到知识库提示
+        ("nic_fw_load", "priv, GFP_DMA", ("GFP_DMA", "atomic_alloc")),
+        ("kmalloc", "64, GFP_DMA", ("GFP_DMA", "atomic_alloc")),
+        ("kmalloc", "64, __GFP_NOWARN", ("__GFP_NOWARN", "atomic_alloc")),
+        ("nic_fw_load", "priv", ("可能睡眠（等待固件）", "sleep")),
+    ])
+    def test_classify(self, ctx, name, args, expected):
+        assert classify(ctx, CallSite(name=name, args=args, line=1, pos=0)) == expected
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""
+合成语料生成器测试
+
+验证生成结果可复现，并且 ground-truth 清单与后端解析结果一致。
+"""
+
+import json
+import os
+import sys
+import pytest
+
+# 添加 src 和 benchmarks 目录到路径
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'src'))
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', 'benchmarks'))
+
+from synth_corpus import (
+    generate_driver, write_corpus, parse_size, DriverGenerator, GeneratorOptions
+)
+from backends import RegexBackend
+
+
+class TestGenerator:
+    """生成器测试"""
+
+    def test_reproducible(self):
+        """同一种子生成相同输出"""
+        a, ma = generate_driver(seed=5, target_bytes=32 * 1024)
+        b, mb = generate_driver(seed=5, target_bytes=32 * 1024)
+        c, _ = generate_driver(seed=6, target_bytes=32 * 1024)
+        assert a == b
+        assert ma == mb
+        assert a != c
+
+    def test_target_size(self):
+        """输出大小接近目标"""
+        for target in (1024, 64 * 1024, 512 * 1024):
+            source, manifest = generate_driver(seed=1, target_bytes=target)
+            assert manifest['bytes'] == len(source)
+            assert len(source) >= target
+            assert len(source) < target * 1.5
+
+    def test_small_target_uses_mini_unit(self):
+        """预算不足一个完整单元时生成精简单元，清单与源码一致"""
+        source, manifest = generate_driver(seed=3, target_bytes=1024)
+        assert len(source) < 2 * 1024
+        assert manifest['struct_ops'] == []
+        assert manifest['async_handlers'] == []
+        result = RegexBackend().parse(source)
+        assert sorted(result.functions) == sorted(manifest['functions'])
+        for name, info in manifest['functions'].items():
+            assert sorted(result.functions[name].calls) == info['calls']
+
+    def test_fanout_depth(self):
+        """扇出和深度参数控制辅助函数数量"""
+        gen = DriverGenerator(seed=1, options=GeneratorOptions(fanout=2, depth=4, cross_calls=0))
+        gen.unit(0)
+        helpers = [n for n in gen.manifest.functions if '_helper_' in n]
+        assert len(helpers) == 1 + 2 + 4 + 8 + 16
+
+    def test_parse_size(self):
+        assert parse_size('1K') == 1024
+        assert parse_size('100M') == 100 * 1024 * 1024
+        assert parse_size('512') == 512
+
+    def test_write_corpus(self, tmp_path):
+        """语料目录包含源文件和清单"""
+        corpus = write_corpus(str(tmp_path), files=3, target_bytes=4096, seed=9)
+        manifest = json.loads((tmp_path / 'manifest.json').read_text())
+        assert sorted(manifest['files']) == sorted(corpus['files'])
+        for name in manifest['files']:
+            assert (tmp_path / name).stat().st_size == manifest['files'][name]['bytes']
+
+
+@pytest.fixture(scope='module')
+def generated():
+    """64KB 合成驱动及其 regex 解析结果"""
+    source, manifest = generate_driver(seed=11, target_bytes=64 * 1024)
+    return RegexBackend().parse(source), manifest
+
+
+class TestManifestAccuracy:
+    """清单与 regex 后端结果对比"""
+
+    def test_functions_and_calls(self, generated):
+        result, manifest = generated
+        found = [n for n in manifest['functions'] if n in result.functions]
+        assert len(found) >= 0.95 * len(manifest['functions'])
+        for name in found:
+            assert sorted(result.functions[name].calls) == manifest['functions'][name]['calls']
+
+    def test_callbacks(self, generated):
+        result, manifest = generated
+        for ops in manifest['struct_ops']:
+            for field_name, func in ops['mappings'].items():
+                assert result.functions[func].callback_context == f"{ops['struct_type']}.{field_name}"
+
+    def test_structs(self, generated):
+        result, manifest = generated
+        for name, fields in manifest['structs'].items():
+            assert name in result.structs
+            parsed = {f.name for f in result.structs[name].fields}
+            assert len(parsed & set(fields)) >= len(fields) - 1
+
+
+if __name__ == '__main__':
+    pytest.main([__file__, '-v'])